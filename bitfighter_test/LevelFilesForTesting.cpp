@@ -86,4 +86,40 @@ string getLevelCodeForEmptyLevelWithBots(const string &botSpec)
    return level;
 }
 
+
+// A sprawling level, much bigger than the area covered by GridDatabase's bucket grid.  Each cell of the map
+// gets a little wall and a handful of items, so we end up with cellsPerSide^2 * 4 objects or so.
+string getLevelCodeForLargeMap(S32 cellsPerSide)
+{
+   string level =
+      "GameType 10 8\n"
+      "LevelName Large Map\n"
+      "LevelDescription Level for testing spatial queries on big maps\n"
+      "LevelCredits Bitfighter Test Cartographer\n"
+      "GridSize 255\n"
+      "Team Bluey 0 0 1\n"
+      "Specials\n"
+      "MinPlayers\n"
+      "MaxPlayers\n"
+      "Spawn 0 0 0\n";
+
+   const S32 cellSize = 8;    // In grid units
+
+   for(S32 x = 0; x < cellsPerSide; x++)
+      for(S32 y = 0; y < cellsPerSide; y++)
+      {
+         string cx = itos(x * cellSize);
+         string cy = itos(y * cellSize);
+         string cx2 = itos(x * cellSize + cellSize / 2);
+         string cy2 = itos(y * cellSize + cellSize / 2);
+
+         level += "BarrierMaker 40 " + cx + " " + cy + " " + cx2 + " " + cy + "\n";
+         level += "RepairItem " + cx2 + " " + cy2 + " 10\n";
+         level += "ResourceItem " + cx + " " + cy2 + "\n";
+         level += "TestItem " + cx2 + " " + cy + "\n";
+      }
+
+   return level;
+}
+
 };
\ No newline at end of file
@@ -6,16 +6,20 @@
 #ifndef _LEVEL_FILES_FOR_TESTING_H_
 #define _LEVEL_FILES_FOR_TESTING_H_
 
+#include "tnlTypes.h"
+
 #include <string>
 
 namespace Zap
 {
 
 using namespace std;
+using namespace TNL;
 
 string getLevelCode1();
 string getLevelCodeForTestingEngineer1();
 string getLevelCodeForEmptyLevelWithBots(const string &botspec);
+string getLevelCodeForLargeMap(S32 cellsPerSide);
 
 };
 
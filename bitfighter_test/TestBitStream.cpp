@@ -0,0 +1,351 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlBitStream.h"
+#include "tnlPlatform.h"
+#include "tnlRandom.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace std;
+using namespace TNL;
+
+class BitStreamTest: public testing::Test
+{
+protected:
+   static const U32 BufferSize = 64;
+
+   // Obviously correct, if slow: one bit at a time, least significant first, in little-endian byte order
+   static void referenceWrite(U8 *buffer, U32 &bitPos, U64 value, U32 bitCount)
+   {
+      for(U32 i = 0; i < bitCount; i++, bitPos++)
+      {
+         if((value >> i) & 1)
+            buffer[bitPos >> 3] |= U8(1 << (bitPos & 0x7));
+         else
+            buffer[bitPos >> 3] &= U8(~(1 << (bitPos & 0x7)));
+      }
+   }
+
+   static U32 randomBits(U32 bitCount)
+   {
+      return bitCount == 32 ? Random::readI() : Random::readI() & ((1u << bitCount) - 1);
+   }
+};
+
+
+// Every write has to land exactly where the old byte-at-a-time code put it, right up to the end of the buffer
+TEST_F(BitStreamTest, matchesWireFormat)
+{
+   for(U32 start = 0; start < 16; start++)
+   {
+      U8 buffer[BufferSize], expected[BufferSize];
+      memset(buffer, 0xAA, BufferSize);        // Bits we never write must survive
+      memset(expected, 0xAA, BufferSize);
+
+      BitStream stream(buffer, BufferSize);
+      stream.setBitPosition(start);
+      U32 bitPos = start;
+
+      Vector<U32> values, counts;
+
+      while(true)
+      {
+         U32 bitCount = Random::readI(0, 32);
+         if(bitPos + bitCount > BufferSize * 8)
+            break;
+
+         U32 value = randomBits(bitCount);
+         stream.writeInt(value, U8(bitCount));
+         referenceWrite(expected, bitPos, value, bitCount);
+
+         values.push_back(value);
+         counts.push_back(bitCount);
+      }
+
+      ASSERT_EQ(bitPos, stream.getBitPosition());
+      for(U32 i = 0; i < BufferSize; i++)
+         ASSERT_EQ(expected[i], buffer[i]) << "start " << start << ", byte " << i;
+
+      stream.setBitPosition(start);
+      for(S32 i = 0; i < values.size(); i++)
+         ASSERT_EQ(values[i], stream.readInt(U8(counts[i])));
+
+      EXPECT_TRUE(stream.isValid());
+   }
+}
+
+
+TEST_F(BitStreamTest, rawBits)
+{
+   U8 source[BufferSize];
+   for(U32 i = 0; i < BufferSize; i++)
+      source[i] = U8(Random::readI());
+
+   // Long and short runs, at every alignment, including ones that end in the last few bytes of the buffer
+   for(U32 start = 0; start < 24; start++)
+      for(U32 bitCount = 1; bitCount + start <= BufferSize * 8 && bitCount <= 8 * 48; bitCount += 13)
+      {
+         U8 buffer[BufferSize], expected[BufferSize];
+         memset(buffer, 0x55, BufferSize);
+         memset(expected, 0x55, BufferSize);
+
+         U32 offset = BufferSize * 8 - bitCount - start;    // Also write flush against the end
+         for(U32 pass = 0; pass < 2; pass++)
+         {
+            U32 pos = pass == 0 ? start : offset;
+
+            BitStream stream(buffer, BufferSize);
+            stream.setBitPosition(pos);
+            stream.writeBits(bitCount, source);
+
+            U32 bitPos = pos;
+            for(U32 i = 0; i < bitCount; i += 8)
+               referenceWrite(expected, bitPos, source[i >> 3], min(8u, bitCount - i));
+
+            ASSERT_EQ(bitPos, stream.getBitPosition());
+            ASSERT_EQ(0, memcmp(expected, buffer, BufferSize)) << "start " << pos << ", bits " << bitCount;
+
+            U8 readBack[BufferSize];
+            stream.setBitPosition(pos);
+            ASSERT_TRUE(stream.readBits(bitCount, readBack));
+            for(U32 i = 0; i < bitCount; i++)
+               ASSERT_EQ((source[i >> 3] >> (i & 0x7)) & 1, (readBack[i >> 3] >> (i & 0x7)) & 1);
+         }
+      }
+}
+
+
+TEST_F(BitStreamTest, overwritesInPlace)
+{
+   U8 buffer[BufferSize];
+   BitStream stream(buffer, BufferSize);
+
+   for(U32 i = 0; i < 20; i++)
+      stream.writeInt(0xFFFFF, 20);
+
+   stream.writeIntAt(0, 9, 27);
+   stream.setBitPosition(0);
+
+   EXPECT_EQ(0xFFFFFu, stream.readInt(20));
+   EXPECT_EQ(0x7Fu, stream.readInt(7));
+   EXPECT_EQ(0u, stream.readInt(9));
+   EXPECT_EQ(0xFu, stream.readInt(4));
+}
+
+
+TEST_F(BitStreamTest, overruns)
+{
+   U8 buffer[8];
+   BitStream stream(buffer, sizeof(buffer));
+
+   stream.writeInt(0x12345, 20);
+   stream.writeInt(0x2345, 20);
+   stream.writeInt(0x345, 20);
+   EXPECT_TRUE(stream.isValid());
+
+   stream.writeInt(0x45, 20);
+   EXPECT_FALSE(stream.isValid());    // Fixed-size buffers can't grow
+
+   stream.clearError();
+   stream.setBitPosition(0);
+   EXPECT_EQ(0x12345u, stream.readInt(20));
+   EXPECT_EQ(0x2345u, stream.readInt(20));
+   EXPECT_EQ(0x345u, stream.readInt(20));
+   EXPECT_EQ(0u, stream.readInt(20));
+   EXPECT_FALSE(stream.isValid());
+
+   // Growable streams grow
+   BitStream growable;
+   for(U32 i = 0; i < 10000; i++)
+      growable.writeInt(i, 17);
+   EXPECT_TRUE(growable.isValid());
+
+   growable.setBitPosition(0);
+   for(U32 i = 0; i < 10000; i++)
+      ASSERT_EQ(i, growable.readInt(17));
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Not really tests -- report throughput for update patterns we send a lot of
+
+// Roughly what Ship::packUpdate() sends for a moving ship: flags, compressed position and velocity, a move, energy
+static void writeShipUpdate(BitStream &stream, U32 i)
+{
+   stream.writeFlag(false);                      // Not exploded
+   stream.writeFlag(false);
+   if(stream.writeFlag(i % 16 == 0))             // Health
+      stream.writeFloat(0.8f, 6);
+   stream.writeFlag(false);
+   stream.writeFlag(false);
+
+   if(stream.writeFlag(true))                    // Position
+   {
+      stream.writeSignedInt(S32(i * 7) & 0x7FF, 18);
+      stream.writeSignedInt(S32(i * 13) & 0x7FF, 18);
+      stream.writeFlag(true);
+      stream.writeInt(i & 0x3FF, 10);
+      stream.writeFloat(0.5f, 8);
+   }
+
+   if(stream.writeFlag(true))                    // Move
+   {
+      stream.writeFloat(0.25f, 8);
+      stream.writeSignedFloat(0.75f, 5);
+      stream.writeSignedFloat(-0.5f, 5);
+      stream.writeFlag(false);
+      stream.writeFlag(false);
+   }
+
+   stream.writeFlag(false);
+   stream.writeFlag(false);
+
+   stream.writeRangedU32(i & 0xFF, 0, 3125);     // Energy
+   stream.writeInt(i & 0x1FF, 9);
+   stream.writeFlag(false);
+   if(stream.writeFlag(i % 4 == 0))
+      stream.writeInt(i & 0xFF, 8);
+   stream.writeRangedU32(i % 3, 0, 3);
+}
+
+
+static void readShipUpdate(BitStream &stream)
+{
+   stream.readFlag();
+   stream.readFlag();
+   if(stream.readFlag())
+      stream.readFloat(6);
+   stream.readFlag();
+   stream.readFlag();
+
+   if(stream.readFlag())
+   {
+      stream.readSignedInt(18);
+      stream.readSignedInt(18);
+      stream.readFlag();
+      stream.readInt(10);
+      stream.readFloat(8);
+   }
+
+   if(stream.readFlag())
+   {
+      stream.readFloat(8);
+      stream.readSignedFloat(5);
+      stream.readSignedFloat(5);
+      stream.readFlag();
+      stream.readFlag();
+   }
+
+   stream.readFlag();
+   stream.readFlag();
+
+   stream.readRangedU32(0, 3125);
+   stream.readInt(9);
+   stream.readFlag();
+   if(stream.readFlag())
+      stream.readInt(8);
+   stream.readRangedU32(0, 3);
+}
+
+
+// What a projectile sends when it's first ghosted: where it is, where it's going, and who fired it
+static void writeProjectileUpdate(BitStream &stream, U32 i)
+{
+   if(stream.writeFlag(true))                    // Initial
+   {
+      stream.writeSignedInt(S32(i * 7) & 0xFFFF, 18);
+      stream.writeSignedInt(S32(i * 11) & 0xFFFF, 18);
+      stream.writeSignedInt(S32(i * 3) & 0x3FF, 12);
+      stream.writeSignedInt(S32(i * 5) & 0x3FF, 12);
+      stream.writeEnum(i % 5, 5);                // Type
+      if(stream.writeFlag(true))
+         stream.writeInt(i & 0x3FF, 10);         // Shooter's ghost index
+   }
+
+   stream.writeFlag(i % 8 == 0);                 // Collided
+   stream.writeFlag(false);                      // Alive
+}
+
+
+static void readProjectileUpdate(BitStream &stream)
+{
+   if(stream.readFlag())
+   {
+      stream.readSignedInt(18);
+      stream.readSignedInt(18);
+      stream.readSignedInt(12);
+      stream.readSignedInt(12);
+      stream.readEnum(5);
+      if(stream.readFlag())
+         stream.readInt(10);
+   }
+
+   stream.readFlag();
+   stream.readFlag();
+}
+
+
+typedef void (*UpdateWriter)(BitStream &stream, U32 i);
+typedef void (*UpdateReader)(BitStream &stream);
+
+static void benchmark(const char *name, UpdateWriter writer, UpdateReader reader)
+{
+   static const U32 PacketSize = 1400;           // About what we send in a packet
+   static const U32 Packets = 20000;
+
+   U8 buffer[PacketSize];
+   U64 bits = 0;
+   U32 updates = 0;
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+
+   for(U32 p = 0; p < Packets; p++)
+   {
+      BitStream stream(buffer, PacketSize);
+      while(stream.getBitSpaceAvailable() > 300)
+         writer(stream, updates++);
+      bits += stream.getBitPosition();
+   }
+
+   F64 writeTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   start = Platform::getHighPrecisionTimerValue();
+   for(U32 p = 0; p < Packets; p++)
+   {
+      BitStream stream(buffer, PacketSize);
+      while(stream.getBitPosition() < PacketSize * 8 - 300)
+         reader(stream);
+   }
+
+   F64 readTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   printf("%s updates: write %.0f Mbit/s, read %.0f Mbit/s (%u updates, %.1f bits each)\n", name,
+          bits / writeTime / 1000, bits / readTime / 1000, updates, F64(bits) / updates);
+}
+
+
+// Not really tests -- these just time packing packets full of updates.  Run them by hand with
+// --gtest_also_run_disabled_tests.
+TEST_F(BitStreamTest, DISABLED_benchmarkShipUpdates)
+{
+   benchmark("Ship", writeShipUpdate, readShipUpdate);
+}
+
+
+TEST_F(BitStreamTest, DISABLED_benchmarkProjectileUpdates)
+{
+   benchmark("Projectile", writeProjectileUpdate, readProjectileUpdate);
+}
+
+
+};
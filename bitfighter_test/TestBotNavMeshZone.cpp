@@ -0,0 +1,237 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotNavMeshZone.h"
+#include "gridDB.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace std;
+
+class NavZoneTest: public testing::Test
+{
+protected:
+   GridDatabase mDatabase;
+   Vector<BotNavMeshZone *> mZones;
+
+   static const S32 ZoneSize = 100;
+
+   void addZone(const Point &corner, F32 width)
+   {
+      BotNavMeshZone *zone = new BotNavMeshZone(mZones.size());
+      zone->disableTriangulation();
+      zone->addVert(corner);
+      zone->addVert(corner + Point(width, 0));
+      zone->addVert(corner + Point(width, ZoneSize));
+      zone->addVert(corner + Point(0, ZoneSize));
+      zone->addToZoneDatabase(&mDatabase);
+
+      mZones.push_back(zone);
+   }
+
+   void link(S32 from, S32 to)
+   {
+      NeighboringZone neighbor;
+      neighbor.zoneID = to;
+      neighbor.center = mZones[to]->getCenter();
+      neighbor.borderCenter = (mZones[from]->getCenter() + mZones[to]->getCenter()) * 0.5f;
+      neighbor.distTo = mZones[from]->getCenter().distanceTo(mZones[to]->getCenter());
+
+      mZones[from]->mNeighbors.push_back(neighbor);
+   }
+
+   void linkBothWays(S32 zone1, S32 zone2)
+   {
+      link(zone1, zone2);
+      link(zone2, zone1);
+   }
+
+   virtual void TearDown()
+   {
+      mZones.deleteAndClear();
+   }
+
+   // Zone whose center is at route[index]
+   S32 zoneAt(const Vector<Point> &route, S32 index)
+   {
+      for(S32 i = 0; i < mZones.size(); i++)
+         if(mZones[i]->getCenter() == route[index])
+            return i;
+
+      return -1;
+   }
+};
+
+
+// A row of square zones, 0 through 3, with a detour (4) above that joins 0 to 3, and
+// zone 5 off on its own:
+//
+//    [    4    ]
+//    [0][1][2][3]          [5]
+//
+class BotNavMeshZoneTest: public NavZoneTest
+{
+protected:
+   virtual void SetUp()
+   {
+      for(S32 i = 0; i < 4; i++)
+         addZone(Point(i * ZoneSize, 0), ZoneSize);
+
+      addZone(Point(0, -ZoneSize), 4 * ZoneSize);
+      addZone(Point(10 * ZoneSize, 0), ZoneSize);
+
+      linkBothWays(0, 1);
+      linkBothWays(1, 2);
+      linkBothWays(2, 3);
+      linkBothWays(0, 4);
+      linkBothWays(4, 3);
+   }
+};
+
+
+// A long row of zones, enough to be split into several clusters
+class ZoneClusterTest: public NavZoneTest
+{
+protected:
+   static const S32 ZoneCount = 300;
+
+   virtual void SetUp()
+   {
+      for(S32 i = 0; i < ZoneCount; i++)
+         addZone(Point(i * ZoneSize, 0), ZoneSize);
+
+      for(S32 i = 1; i < ZoneCount; i++)
+         linkBothWays(i - 1, i);
+   }
+};
+
+
+TEST_F(BotNavMeshZoneTest, findPath)
+{
+   AStar search;
+   Point target(350, 50);
+
+   // Target first, then the target zone's center, then gateways and zone centers back to where
+   // we are, and finally our own zone's center again
+   Vector<Point> path = search.findPath(&mZones, 0, 3, target);
+   ASSERT_EQ(9, path.size());
+   EXPECT_EQ(target, path[0]);
+   EXPECT_EQ(3, zoneAt(path, 1));
+   EXPECT_EQ(2, zoneAt(path, 3));
+   EXPECT_EQ(1, zoneAt(path, 5));
+   EXPECT_EQ(0, zoneAt(path, 7));
+
+   // Same search object can be reused, and knows when there's no way through
+   EXPECT_EQ(0, search.findPath(&mZones, 0, 5, target).size());
+   EXPECT_EQ(9, search.findPath(&mZones, 0, 3, target).size());
+
+   // Blocked zones get routed around
+   mZones[1]->setWalkable(false);
+   path = search.findPath(&mZones, 0, 3, target);
+   ASSERT_EQ(7, path.size());
+   EXPECT_EQ(4, zoneAt(path, 3));
+   mZones[1]->setWalkable(true);
+}
+
+
+TEST_F(BotNavMeshZoneTest, routeCache)
+{
+   ZoneRouteCache cache(2);
+
+   const ZoneRoute &route = cache.findRoute(&mZones, 0, 3);
+   ASSERT_EQ(8, route.points.size());
+   EXPECT_EQ(3, route.endZone);
+   EXPECT_EQ(3, zoneAt(route.points, 0));
+   EXPECT_EQ(0, zoneAt(route.points, 7));
+   EXPECT_EQ(1, cache.getRouteCount());
+
+   // Asking again gives back the cached route
+   EXPECT_EQ(&route, &cache.findRoute(&mZones, 0, 3));
+   EXPECT_EQ(1, cache.getRouteCount());
+
+   // Failures are cached too
+   EXPECT_EQ(0, cache.findRoute(&mZones, 0, 5).points.size());
+   EXPECT_EQ(2, cache.getRouteCount());
+
+   // Full, so the least recently used route (0 -> 3) makes way
+   EXPECT_EQ(8, cache.findRoute(&mZones, 3, 0).points.size());
+   EXPECT_EQ(2, cache.getRouteCount());
+   EXPECT_EQ(0, cache.findRoute(&mZones, 0, 5).points.size());
+   EXPECT_EQ(2, cache.getRouteCount());
+
+   // Changing walkability throws away everything we knew
+   mZones[1]->setWalkable(false);
+   EXPECT_EQ(6, cache.findRoute(&mZones, 3, 0).points.size());
+   EXPECT_EQ(1, cache.getRouteCount());
+
+   mZones[1]->setWalkable(true);
+   EXPECT_EQ(8, cache.findRoute(&mZones, 3, 0).points.size());
+
+   cache.clear();
+   EXPECT_EQ(0, cache.getRouteCount());
+}
+
+
+TEST_F(ZoneClusterTest, corridor)
+{
+   ZoneClusterGraph clusters;
+   clusters.build(&mZones);
+   EXPECT_EQ(5, clusters.getClusterCount());
+
+   // Neighbors share a cluster, or at least the ends of the row don't
+   EXPECT_EQ(clusters.getCluster(0), clusters.getCluster(1));
+   EXPECT_NE(clusters.getCluster(0), clusters.getCluster(ZoneCount - 1));
+
+   ASSERT_TRUE(clusters.planCorridor(0, ZoneCount - 1, 2));
+   EXPECT_TRUE(clusters.isInCorridor(0));
+   EXPECT_FALSE(clusters.isInCorridor(ZoneCount - 1));
+   EXPECT_FALSE(clusters.isCorridorEnd(0));
+
+   // A corridor long enough to reach the target has no end short of it
+   ASSERT_TRUE(clusters.planCorridor(0, ZoneCount - 1, 5));
+   EXPECT_TRUE(clusters.isInCorridor(ZoneCount - 1));
+   EXPECT_FALSE(clusters.isCorridorEnd(ZoneCount - 1));
+}
+
+
+TEST_F(ZoneClusterTest, partialRoutes)
+{
+   ZoneRouteCache cache(ZoneRouteCache::DefaultCapacity, 1);
+   cache.buildClusters(&mZones);
+
+   // Follow the route a piece at a time, the way a bot would
+   S32 start = 0;
+   S32 legs = 0;
+
+   while(start != ZoneCount - 1)
+   {
+      const ZoneRoute &route = cache.findRoute(&mZones, start, ZoneCount - 1);
+      ASSERT_GT(route.points.size(), 0);
+      ASSERT_GT(route.endZone, start);
+
+      EXPECT_EQ(route.endZone, zoneAt(route.points, 0));
+      EXPECT_EQ(start, zoneAt(route.points, route.points.size() - 1));
+
+      start = route.endZone;
+      legs++;
+   }
+
+   EXPECT_GT(legs, 1);
+
+   // Short routes are planned all at once
+   EXPECT_EQ(10, cache.findRoute(&mZones, 0, 10).endZone);
+
+   // With a zone blocked in the part being planned, there's no way through at all
+   mZones[5]->setWalkable(false);
+   EXPECT_EQ(0, cache.findRoute(&mZones, 0, ZoneCount - 1).points.size());
+   EXPECT_GT(cache.findRoute(&mZones, 10, ZoneCount - 1).points.size(), 0);
+   mZones[5]->setWalkable(true);
+}
+
+
+};
@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotZoneMeshCache.h"
+#include "stringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+
+namespace Zap
+{
+
+using namespace std;
+
+class BotZoneMeshCacheTest: public testing::Test
+{
+protected:
+   static const string CacheDir;
+   static const string LevelHash;
+
+   BotZoneMeshInput mInput;
+   BotZoneMesh mMesh;
+
+   virtual void SetUp()
+   {
+      mInput.bounds = Rect(Point(0, 0), Point(1000, 1000));
+
+      Vector<Point> wall;
+      wall.push_back(Point(100, 450));
+      wall.push_back(Point(900, 450));
+      wall.push_back(Point(900, 550));
+      wall.push_back(Point(100, 550));
+      mInput.barrierPolygons.push_back(wall);
+
+      string error;
+      ASSERT_TRUE(BotNavMeshZone::buildMesh(mInput, mMesh, error)) << error;
+   }
+
+   virtual void TearDown()
+   {
+      remove(getFileName().c_str());
+      remove(CacheDir.c_str());
+   }
+
+   static string getFileName()
+   {
+      return joindir(CacheDir, LevelHash + ".zones");
+   }
+};
+
+const string BotZoneMeshCacheTest::CacheDir = "zonecachetest";
+const string BotZoneMeshCacheTest::LevelHash = "0123456789abcdef0123456789abcdef";
+
+
+TEST_F(BotZoneMeshCacheTest, roundTrip)
+{
+   BotZoneMeshCache cache(CacheDir);
+   BotZoneMesh loaded;
+
+   EXPECT_FALSE(cache.load(LevelHash, loaded));    // Nothing there yet
+   ASSERT_TRUE(cache.save(LevelHash, mMesh));
+   ASSERT_TRUE(cache.load(LevelHash, loaded));
+
+   EXPECT_EQ(mInput.getHash(), loaded.inputHash);
+   EXPECT_EQ(mMesh.corePolyStart, loaded.corePolyStart);
+   EXPECT_EQ(mMesh.speedZonePolyStart, loaded.speedZonePolyStart);
+
+   const rcPolyMesh &a = mMesh.mesh;
+   const rcPolyMesh &b = loaded.mesh;
+
+   ASSERT_EQ(a.nvp, b.nvp);
+   ASSERT_EQ(a.nverts, b.nverts);
+   ASSERT_EQ(a.npolys, b.npolys);
+   EXPECT_EQ(a.offsetX, b.offsetX);
+   EXPECT_EQ(a.offsetY, b.offsetY);
+
+   for(S32 i = 0; i < a.nverts * 2; i++)
+      EXPECT_EQ(a.verts[i], b.verts[i]);
+
+   for(S32 i = 0; i < a.npolys * a.nvp; i++)
+      EXPECT_EQ(a.polys[i], b.polys[i]);
+
+   // A different level has nothing cached
+   EXPECT_FALSE(cache.load("fedcba9876543210fedcba9876543210", loaded));
+}
+
+
+TEST_F(BotZoneMeshCacheTest, discardsBadFiles)
+{
+   BotZoneMeshCache cache(CacheDir);
+   BotZoneMesh loaded;
+
+   // Truncated
+   ASSERT_TRUE(cache.save(LevelHash, mMesh));
+   string contents = readFile(getFileName());
+   ASSERT_TRUE(writeFile(getFileName(), contents.substr(0, contents.length() - 1)));
+
+   EXPECT_FALSE(cache.load(LevelHash, loaded));
+   EXPECT_FALSE(fileExists(getFileName()));
+
+   // From some other version
+   ASSERT_TRUE(cache.save(LevelHash, mMesh));
+   contents = readFile(getFileName());
+   contents[4]++;
+   ASSERT_TRUE(writeFile(getFileName(), contents));
+
+   EXPECT_FALSE(cache.load(LevelHash, loaded));
+   EXPECT_FALSE(fileExists(getFileName()));
+
+   // Polys referring to verts that don't exist
+   ASSERT_TRUE(cache.save(LevelHash, mMesh));
+   contents = readFile(getFileName());
+   contents[contents.length() - 2] = '\xfe';
+   contents[contents.length() - 1] = '\xff';
+   ASSERT_TRUE(writeFile(getFileName(), contents));
+
+   EXPECT_FALSE(cache.load(LevelHash, loaded));
+   EXPECT_FALSE(fileExists(getFileName()));
+}
+
+
+// Old meshes make way for new ones once the folder is full
+TEST_F(BotZoneMeshCacheTest, prunesOldFiles)
+{
+   static const S32 MaxFiles = 5;
+   BotZoneMeshCache cache(CacheDir, MaxFiles);
+
+   Vector<string> hashes;
+   for(S32 i = 0; i < MaxFiles * 2; i++)
+   {
+      hashes.push_back(LevelHash.substr(0, 30) + (i < 10 ? "0" : "") + itos(i));
+      ASSERT_TRUE(cache.save(hashes[i], mMesh));
+   }
+
+   const string extensions[] = { "zones" };
+   Vector<string> files;
+   ASSERT_TRUE(getFilesFromFolder(CacheDir, files, extensions, ARRAYSIZE(extensions)));
+   EXPECT_EQ(MaxFiles, files.size());
+
+   // Whatever else went, the one just saved is still there
+   BotZoneMesh loaded;
+   EXPECT_TRUE(cache.load(hashes.last(), loaded));
+
+   for(S32 i = 0; i < hashes.size(); i++)
+      remove(joindir(CacheDir, hashes[i] + ".zones").c_str());
+}
+
+
+TEST_F(BotZoneMeshCacheTest, disabled)
+{
+   BotZoneMeshCache cache("");
+   BotZoneMesh loaded;
+
+   EXPECT_FALSE(cache.save(LevelHash, mMesh));
+   EXPECT_FALSE(cache.load(LevelHash, loaded));
+}
+
+
+};
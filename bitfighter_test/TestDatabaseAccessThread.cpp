@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../master/DatabaseAccessThread.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+namespace Zap
+{
+
+using namespace std;
+using namespace TNL;
+using namespace Master;
+
+static atomic<S32> itemsWritten;
+static S32 entriesFinished;
+static S32 entriesDestroyed;
+
+
+// Stands in for a stats write: takes a while, and is happy to do the work of any others like it
+struct TestWriter : public ThreadEntry
+{
+   S32 mItems;
+
+   TestWriter() { mItems = 1; }
+   ~TestWriter() { entriesDestroyed++; }
+
+   void run()
+   {
+      Platform::sleep(2);
+      itemsWritten += mItems;
+   }
+
+   void finish()
+   {
+      entriesFinished++;
+   }
+
+   bool absorb(ThreadEntry *entry)
+   {
+      TestWriter *writer = dynamic_cast<TestWriter *>(entry);
+      if(!writer)
+         return false;
+
+      mItems += writer->mItems;
+      return true;
+   }
+};
+
+
+struct TestReader : public ThreadEntry
+{
+   ~TestReader() { entriesDestroyed++; }
+
+   void run() { Platform::sleep(1); }
+   void finish() { entriesFinished++; }
+};
+
+
+// Waits for entriesFinished to reach count, for a few seconds at most
+static void finishEntries(DatabaseAccessThread &pool, S32 count)
+{
+   U32 giveUpTime = Platform::getRealMilliseconds() + 5000;
+
+   while(entriesFinished < count && Platform::getRealMilliseconds() < giveUpTime)
+   {
+      pool.idle();
+      Platform::sleep(1);
+   }
+}
+
+
+TEST(DatabaseAccessThreadTest, runsEverything)
+{
+   static const S32 Writers = 500;     // More than the old ring buffer could hold
+   static const S32 Readers = 10;
+
+   itemsWritten = 0;
+   entriesFinished = 0;
+
+   DatabaseAccessThread pool(4);
+   EXPECT_EQ(4u, pool.getThreadCount());
+
+   for(S32 i = 0; i < Writers; i++)
+   {
+      RefPtr<TestWriter> writer = new TestWriter();
+      pool.addEntry(writer);
+
+      if(i % (Writers / Readers) == 0)
+      {
+         RefPtr<TestReader> reader = new TestReader();
+         pool.addEntry(reader);
+      }
+   }
+
+   // Writers that were absorbed don't get finished, so wait for the readers, then for the stragglers
+   finishEntries(pool, Readers);
+   U32 giveUpTime = Platform::getRealMilliseconds() + 5000;
+   while(itemsWritten < Writers && Platform::getRealMilliseconds() < giveUpTime)
+      Platform::sleep(1);
+
+   Platform::sleep(50);
+   pool.idle();
+
+   EXPECT_EQ(Writers, itemsWritten.load());
+   EXPECT_LE(Readers + 1, entriesFinished);
+   EXPECT_GT(Readers + Writers, entriesFinished);      // Some writers should have been batched
+
+   DatabaseAccessStats stats = pool.takeStats();
+   EXPECT_EQ(U32(Readers + Writers), stats.completed);
+   EXPECT_EQ(U32(entriesFinished), stats.batches);
+   EXPECT_EQ(0u, stats.queued);
+   EXPECT_LT(0u, stats.maxQueued);
+   EXPECT_LE(stats.averageLatency, F32(stats.maxLatency));
+
+   // Counting starts afresh
+   stats = pool.takeStats();
+   EXPECT_EQ(0u, stats.completed);
+   EXPECT_EQ(0u, stats.maxQueued);
+}
+
+
+// Anything still queued when we shut down gets run, though not finished
+TEST(DatabaseAccessThreadTest, drainsOnShutdown)
+{
+   itemsWritten = 0;
+   entriesFinished = 0;
+
+   {
+      DatabaseAccessThread pool(2);
+
+      for(S32 i = 0; i < 50; i++)
+      {
+         RefPtr<TestReader> reader = new TestReader();    // Keep the writers apart, so they can't be batched
+         pool.addEntry(reader);
+
+         RefPtr<TestWriter> writer = new TestWriter();
+         pool.addEntry(writer);
+      }
+   }
+
+   EXPECT_EQ(50, itemsWritten.load());
+   EXPECT_EQ(0, entriesFinished);
+}
+
+
+// The pool keeps entries alive while it has them, even once whoever added them has let go, and lets go of them all
+// in the end -- finished, absorbed and drained alike
+TEST(DatabaseAccessThreadTest, releasesEntries)
+{
+   itemsWritten = 0;
+   entriesFinished = 0;
+   entriesDestroyed = 0;
+
+   {
+      DatabaseAccessThread pool(2);
+
+      for(S32 i = 0; i < 100; i++)
+      {
+         pool.addEntry(new TestWriter());
+
+         if(i % 10 == 0)
+            pool.addEntry(new TestReader());
+      }
+
+      EXPECT_EQ(0, entriesDestroyed);
+
+      finishEntries(pool, 5);
+      EXPECT_LE(entriesFinished, entriesDestroyed);
+   }
+
+   EXPECT_EQ(100, itemsWritten.load());
+   EXPECT_EQ(110, entriesDestroyed);
+}
+
+
+TEST(DatabaseAccessThreadTest, noThreads)
+{
+   itemsWritten = 0;
+   entriesFinished = 0;
+
+   DatabaseAccessThread pool(0);
+
+   RefPtr<TestWriter> writer = new TestWriter();
+   pool.addEntry(writer);
+
+   EXPECT_EQ(1, itemsWritten.load());      // Done right away...
+   EXPECT_EQ(0, entriesFinished);
+
+   pool.idle();
+   EXPECT_EQ(1, entriesFinished);          // ...but finished in idle(), as ever
+}
+
+
+};
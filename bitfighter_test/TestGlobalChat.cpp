@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "../master/GlobalChat.h"
+#include "../master/masterInterface.h"
+
+#include "SharedConstants.h"
+
+#include "tnlBitStream.h"
+#include "tnlConnectionStringTable.h"
+#include "tnlHuffmanStringProcessor.h"
+#include "tnlMethodDispatch.h"
+#include "tnlNetConnection.h"
+
+#include "gtest/gtest.h"
+
+namespace Master
+{
+
+using namespace std;
+using namespace TNL;
+
+class GlobalChatTest: public testing::Test
+{
+protected:
+   typedef GlobalChat::NickChunk NickChunk;
+   typedef GlobalChat::ChatChunk ChatChunk;
+
+   static const U32 MaxChunkSize = GlobalChat::MaxChunkSize;
+
+   // Most a packet can hold, less generous room for its headers and the RPC's own
+   static const U32 MaxRpcBits = MaxPreferredPacketDataSize * 8 - MinimumPaddingBits - 64 * 8;
+
+   // Longest there is, and none of it compresses
+   static string longString(U32 length, char c)
+   {
+      return string(length, c);
+   }
+
+   static void buildNickChunks(const Vector<StringTableEntry> &left, const Vector<StringTableEntry> &joined,
+                               Vector<NickChunk> &chunks)
+   {
+      GlobalChat::buildNickChunks(left, joined, chunks);
+   }
+
+   static void addToChatChunks(const StringTableEntry &nick, const string &message, Vector<ChatChunk> &chunks)
+   {
+      GlobalChat::addToChatChunks(nick, message, chunks);
+   }
+
+   // Writes nicks the way the RPC would, plus the string table id each one carries over a real connection
+   static U32 writeNicks(BitStream &stream, Vector<StringTableEntry> &nicks)
+   {
+      Types::write(stream, nicks);
+      return nicks.size() * (ConnectionStringTable::EntryBitSize + 1);
+   }
+};
+
+
+TEST_F(GlobalChatTest, chatChunksFitInAPacket)
+{
+   ASSERT_LE(MaxChunkSize * 8, U32(MaxRpcBits));
+
+   // Every nick and message as long as it can be, in characters that Huffman coding can't shrink
+   StringTableEntry nick(longString(MAX_PLAYER_NAME_LENGTH, '\x7f').c_str());
+   string message = longString(HuffmanStringProcessor::MAX_SENDABLE_LINE_LENGTH, '\x7f');
+
+   Vector<ChatChunk> chunks;
+   for(S32 i = 0; i < 20; i++)
+      addToChatChunks(nick, message, chunks);
+
+   ASSERT_LT(1, chunks.size());
+
+   S32 messages = 0;
+   for(S32 i = 0; i < chunks.size(); i++)
+   {
+      U8 buffer[MaxPacketDataSize * 2];
+      BitStream stream(buffer, sizeof(buffer));
+
+      U32 bits = writeNicks(stream, chunks[i].nicks);
+      Types::write(stream, chunks[i].messages);
+      bits += stream.getBitPosition();
+
+      ASSERT_TRUE(stream.isValid());
+      EXPECT_LE(bits, chunks[i].size * 8);
+      EXPECT_LE(chunks[i].size, U32(MaxChunkSize));
+
+      messages += chunks[i].messages.size();
+   }
+
+   EXPECT_EQ(20, messages);
+}
+
+
+TEST_F(GlobalChatTest, nickChunksFitInAPacket)
+{
+   ASSERT_LE(MaxChunkSize * 8, U32(MaxRpcBits));
+
+   Vector<StringTableEntry> left, joined;
+   for(S32 i = 0; i < 100; i++)
+   {
+      // Different nicks, so the string table can't share them
+      string nick = longString(MAX_PLAYER_NAME_LENGTH, '\x7f');
+      nick[0] = char('A' + i % 26);
+      nick[1] = char('A' + i / 26);
+      left.push_back(StringTableEntry(nick.c_str()));
+
+      nick[2] = 'J';
+      joined.push_back(StringTableEntry(nick.c_str()));
+   }
+
+   Vector<NickChunk> chunks;
+   buildNickChunks(left, joined, chunks);
+
+   S32 leftCount = 0, joinedCount = 0;
+   for(S32 i = 0; i < chunks.size(); i++)
+   {
+      U8 buffer[MaxPacketDataSize * 2];
+      BitStream stream(buffer, sizeof(buffer));
+
+      U32 bits = writeNicks(stream, chunks[i].left);
+      bits += writeNicks(stream, chunks[i].joined);
+      bits += stream.getBitPosition();
+
+      ASSERT_TRUE(stream.isValid());
+      EXPECT_LE(bits, chunks[i].size * 8);
+      EXPECT_LE(chunks[i].size, U32(MaxChunkSize));
+      EXPECT_GE(IP_MESSAGE_ADDRESS_COUNT, chunks[i].left.size() + chunks[i].joined.size());
+
+      // Leaves all go before any joins
+      if(chunks[i].left.size() > 0)
+         EXPECT_EQ(0, joinedCount);
+
+      leftCount += chunks[i].left.size();
+      joinedCount += chunks[i].joined.size();
+   }
+
+   EXPECT_EQ(100, leftCount);
+   EXPECT_EQ(100, joinedCount);
+}
+
+
+};
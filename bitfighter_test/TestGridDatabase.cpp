@@ -0,0 +1,271 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "gridDB.h"
+#include "ServerGame.h"
+#include "BfObject.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace Zap
+{
+
+using namespace std;
+
+class GridDatabaseTest: public testing::Test
+{
+protected:
+   // Build a repeatable set of scope-sized query rects scattered across the world
+   static void makeQueries(const Rect &worldExtents, S32 count, Vector<Rect> &queries)
+   {
+      srand(42);
+
+      const Point scopeSize(1600, 1200);
+
+      for(S32 i = 0; i < count; i++)
+      {
+         F32 fx = F32(rand()) / F32(RAND_MAX);
+         F32 fy = F32(rand()) / F32(RAND_MAX);
+
+         Point center(worldExtents.min.x + fx * worldExtents.getWidth(),
+                      worldExtents.min.y + fy * worldExtents.getHeight());
+
+         Rect rect(center, center);
+         rect.expand(scopeSize * 0.5f);
+         queries.push_back(rect);
+      }
+   }
+
+
+   static void runQuery(GridDatabase *db, const Rect &rect, Vector<DatabaseObject *> &results)
+   {
+      results.clear();
+      db->findObjects((TestFunc)isAnyObjectType, results, rect);
+      std::sort(results.getStlVector().begin(), results.getStlVector().end());
+   }
+
+
+   // Brute force version of runQuery(), to check the indices against
+   static void runQuerySlowly(GridDatabase *db, const Rect &rect, Vector<DatabaseObject *> &results)
+   {
+      results.clear();
+
+      const Vector<DatabaseObject *> *objects = db->findObjects_fast();
+      for(S32 i = 0; i < objects->size(); i++)
+         if(isAnyObjectType(objects->get(i)->getObjectTypeNumber()) && objects->get(i)->getExtent().intersects(rect))
+            results.push_back(objects->get(i));
+
+      std::sort(results.getStlVector().begin(), results.getStlVector().end());
+   }
+
+
+   static F64 timeQueries(GridDatabase *db, const Vector<Rect> &queries, S32 &found)
+   {
+      Vector<DatabaseObject *> results;
+      found = 0;
+
+      S64 start = Platform::getHighPrecisionTimerValue();
+
+      for(S32 i = 0; i < queries.size(); i++)
+      {
+         results.clear();
+         db->findObjects((TestFunc)isAnyObjectType, results, queries[i]);
+         found += results.size();
+      }
+
+      return Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+   }
+
+
+   static void getTestLevels(Vector<string> &levelCodes)
+   {
+      levelCodes.push_back(getLevelCode1());
+      levelCodes.push_back(getLevelCodeForTestingEngineer1());
+      levelCodes.push_back(getLevelCodeForLargeMap(20));
+      levelCodes.push_back(getLevelCodeForLargeMap(60));
+   }
+};
+
+
+// Both indices should always return the same objects
+TEST_F(GridDatabaseTest, indicesAgree)
+{
+   Vector<string> levelCodes;
+   getTestLevels(levelCodes);
+
+   for(S32 i = 0; i < levelCodes.size(); i++)
+   {
+      ServerGame *game = newServerGame();
+      GridDatabase *db = game->getGameObjDatabase();
+      game->loadLevelFromString(levelCodes[i], db);
+
+      Vector<Rect> queries;
+      makeQueries(db->getExtents(), 200, queries);
+
+      Vector<DatabaseObject *> gridResults, treeResults, expected;
+
+      db->setSpatialIndexType(GridDatabase::BucketGridIndex);
+      for(S32 j = 0; j < queries.size(); j++)
+      {
+         runQuery(db, queries[j], gridResults);
+         db->setSpatialIndexType(GridDatabase::AABBTreeIndex);
+         runQuery(db, queries[j], treeResults);
+         db->setSpatialIndexType(GridDatabase::BucketGridIndex);
+         runQuerySlowly(db, queries[j], expected);
+
+         ASSERT_EQ(expected.size(), gridResults.size()) << "Level " << i << ", query " << j;
+         ASSERT_EQ(expected.size(), treeResults.size()) << "Level " << i << ", query " << j;
+
+         for(S32 k = 0; k < expected.size(); k++)
+         {
+            EXPECT_EQ(expected[k], gridResults[k]);
+            EXPECT_EQ(expected[k], treeResults[k]);
+         }
+      }
+
+      // Now move everything around a bit, and make sure the tree keeps up
+      db->setSpatialIndexType(GridDatabase::AABBTreeIndex);
+      Vector<DatabaseObject *> objects = *db->findObjects_fast();
+      for(S32 j = 0; j < objects.size(); j++)
+      {
+         Rect extent = objects[j]->getExtent();
+         extent.offset(Point(F32(j % 7) * 50, F32(j % 11) * -80));
+         objects[j]->setExtent(extent);
+      }
+
+      for(S32 j = 0; j < queries.size(); j++)
+      {
+         runQuery(db, queries[j], treeResults);
+         runQuerySlowly(db, queries[j], expected);
+
+         ASSERT_EQ(expected.size(), treeResults.size()) << "Level " << i << ", query " << j;
+         for(S32 k = 0; k < expected.size(); k++)
+            EXPECT_EQ(expected[k], treeResults[k]);
+      }
+
+      delete game;
+   }
+}
+
+
+// Queries that accumulate over several overlapping searches should never report the same object twice
+TEST_F(GridDatabaseTest, queryAccumulatesWithoutDuplicates)
+{
+   ServerGame *game = newServerGame();
+   GridDatabase *db = game->getGameObjDatabase();
+   game->loadLevelFromString(getLevelCodeForLargeMap(20), db);
+
+   Vector<Rect> queries;
+   makeQueries(db->getExtents(), 50, queries);
+
+   GridDatabase::SpatialIndexType indexTypes[] = { GridDatabase::BucketGridIndex, GridDatabase::AABBTreeIndex };
+
+   for(S32 i = 0; i < S32(ARRAYSIZE(indexTypes)); i++)
+   {
+      db->setSpatialIndexType(indexTypes[i]);
+
+      DatabaseQuery query;
+      Vector<DatabaseObject *> expected, found;
+
+      for(S32 j = 0; j < queries.size(); j++)
+      {
+         Vector<DatabaseObject *> results;
+         runQuerySlowly(db, queries[j], results);
+         for(S32 k = 0; k < results.size(); k++)
+            expected.push_back(results[k]);
+
+         db->findObjects((TestFunc)isAnyObjectType, query, queries[j]);
+      }
+
+      std::sort(expected.getStlVector().begin(), expected.getStlVector().end());
+      expected.getStlVector().erase(std::unique(expected.getStlVector().begin(), expected.getStlVector().end()),
+                                    expected.getStlVector().end());
+
+      EXPECT_GT(expected.size(), S32(DatabaseQuery::InlineCapacity));    // Make sure we've exercised the overflow storage
+
+      query.toVector(found);
+      std::sort(found.getStlVector().begin(), found.getStlVector().end());
+
+      ASSERT_EQ(expected.size(), found.size());
+      for(S32 j = 0; j < expected.size(); j++)
+         EXPECT_EQ(expected[j], found[j]);
+
+      // Copies should hold the same results, and still know what they've already seen
+      DatabaseQuery copy(query);
+      ASSERT_EQ(query.size(), copy.size());
+      db->findObjects((TestFunc)isAnyObjectType, copy, queries[0]);
+      EXPECT_EQ(query.size(), copy.size());
+
+      query.clear();
+      EXPECT_TRUE(query.isEmpty());
+   }
+
+   delete game;
+}
+
+
+// Big levels should get the tree, small ones should stick with the grid
+TEST_F(GridDatabaseTest, chooseSpatialIndexType)
+{
+   ServerGame *game = newServerGame();
+   GridDatabase *db = game->getGameObjDatabase();
+
+   game->loadLevelFromString(getLevelCode1(), db);
+   db->chooseSpatialIndexType();
+   EXPECT_EQ(GridDatabase::BucketGridIndex, db->getSpatialIndexType());
+
+   db->removeEverythingFromDatabase();
+
+   game->loadLevelFromString(getLevelCodeForLargeMap(20), db);
+   db->chooseSpatialIndexType();
+   EXPECT_EQ(GridDatabase::AABBTreeIndex, db->getSpatialIndexType());
+
+   delete game;
+}
+
+
+// Not really a test -- compares query times for the two indices on our test levels.  indicesAgree checks they find the
+// same things; run this one by hand with --gtest_also_run_disabled_tests.
+TEST_F(GridDatabaseTest, DISABLED_benchmarkIndices)
+{
+   Vector<string> levelCodes;
+   getTestLevels(levelCodes);
+
+   for(S32 i = 0; i < levelCodes.size(); i++)
+   {
+      ServerGame *game = newServerGame();
+      GridDatabase *db = game->getGameObjDatabase();
+      game->loadLevelFromString(levelCodes[i], db);
+
+      Vector<Rect> queries;
+      makeQueries(db->getExtents(), 20000, queries);
+
+      S32 gridFound, treeFound;
+
+      db->setSpatialIndexType(GridDatabase::BucketGridIndex);
+      F64 gridTime = timeQueries(db, queries, gridFound);
+
+      db->setSpatialIndexType(GridDatabase::AABBTreeIndex);
+      F64 treeTime = timeQueries(db, queries, treeFound);
+
+      EXPECT_EQ(gridFound, treeFound);
+
+      printf("Level %d (%d objects, %s): grid %.2f ms, tree %.2f ms for %d queries\n", i, db->getObjectCount(),
+             db->getExtents().toString().c_str(), gridTime, treeTime, queries.size());
+
+      delete game;
+   }
+}
+
+
+};
@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "HeadlessRenderer.h"
+#include "gameObjectRender.h"
+#include "Colors.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+class HeadlessRendererTest: public testing::Test
+{
+protected:
+   HeadlessRenderer *mRenderer;
+
+   virtual void SetUp()
+   {
+      // The test runner makes one of these for everybody
+      mRenderer = dynamic_cast<HeadlessRenderer *>(&Renderer::get());
+      ASSERT_TRUE(mRenderer != NULL);
+      mRenderer->reset();
+   }
+};
+
+
+TEST_F(HeadlessRendererTest, recordsCommands)
+{
+   Vector<Point> square;
+   square.push_back(Point(0, 0));
+   square.push_back(Point(10, 0));
+   square.push_back(Point(10, 10));
+   square.push_back(Point(0, 10));
+
+   renderPolygonOutline(&square, &Colors::red, 1, 3);
+
+   const RenderStats &stats = mRenderer->getStats();
+   EXPECT_EQ(1, stats.drawCalls);
+   EXPECT_EQ(4, stats.vertices);
+   EXPECT_EQ(4 * 2 * sizeof(F32), stats.bytesUploaded);
+   EXPECT_EQ(3, stats.stateChanges);      // Color, then line width there and back again
+
+   const Vector<RenderCommand> &commands = mRenderer->getCommands();
+   ASSERT_EQ(4, commands.size());
+   EXPECT_EQ(RenderState::Color, commands[0].state);
+   EXPECT_EQ(RenderState::LineWidth, commands[1].state);
+   EXPECT_EQ(RenderCommandType::Draw, commands[2].type);
+   EXPECT_EQ(RenderType::LineLoop, commands[2].primitive);
+   EXPECT_EQ(4, commands[2].vertexCount);
+   EXPECT_EQ(RenderState::LineWidth, commands[3].state);
+
+   // Setting things to the way they already are still counts, but is marked as such
+   Renderer &r = Renderer::get();
+
+   mRenderer->reset();
+   r.setColor(Colors::blue);
+   r.setColor(Colors::blue);
+   EXPECT_EQ(2, mRenderer->getStats().stateChanges);
+   EXPECT_EQ(1, mRenderer->getStats().redundantStateChanges);
+   EXPECT_FALSE(mRenderer->getCommands()[0].redundant);
+   EXPECT_TRUE(mRenderer->getCommands()[1].redundant);
+
+   // Stats alone
+   mRenderer->reset();
+   mRenderer->setRecordCommands(false);
+   renderPolygonOutline(&square);
+   EXPECT_EQ(0, mRenderer->getCommands().size());
+   EXPECT_EQ(1, mRenderer->getStats().drawCalls);
+   mRenderer->setRecordCommands(true);
+}
+
+
+TEST_F(HeadlessRendererTest, tracksMatrices)
+{
+   Renderer &r = Renderer::get();
+
+   F32 before[16], after[16], moved[16];
+   r.getMatrix(MatrixType::ModelView, before);
+
+   r.pushMatrix();
+   r.translate(Point(100, 50));
+   r.getMatrix(MatrixType::ModelView, moved);
+   r.popMatrix();
+
+   r.getMatrix(MatrixType::ModelView, after);
+
+   EXPECT_EQ(before[12] + 100, moved[12]);
+   EXPECT_EQ(before[13] + 50, moved[13]);
+   EXPECT_EQ(0, memcmp(before, after, sizeof(before)));
+   EXPECT_EQ(3, mRenderer->getStats().matrixOperations);
+
+   // Render code should leave the matrix the way it found it
+   renderFlag(Point(20, 20), &Colors::blue);
+   r.getMatrix(MatrixType::ModelView, after);
+   EXPECT_EQ(0, memcmp(before, after, sizeof(before)));
+   EXPECT_GT(mRenderer->getStats().drawCalls, 0);
+}
+
+
+};
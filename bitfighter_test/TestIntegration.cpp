@@ -8,6 +8,7 @@
 #include "ClientGame.h"
 #include "ServerGame.h"
 #include "GameManager.h"
+#include "gameNetInterface.h"
 #include "Teleporter.h"
 #include "PickupItem.h"
 #include "barrier.h"
@@ -258,4 +259,100 @@ TEST(IntegrationTest, LevelReadingAndItemPropagation)
    }
 }   
 
+
+// Writing packets on worker threads should get the same objects to the clients as writing them one at a time
+TEST(IntegrationTest, ParallelPacketWriting)
+{
+   GamePair gamePair(getLevelCode1(), 3);
+
+   const Vector<ClientGame *> *clientGames = GameManager::getClientGames();
+   ServerGame *serverGame = GameManager::getServerGame();
+
+   serverGame->getNetInterface()->setPacketWriterThreadCount(2);
+   EXPECT_EQ(U32(2), serverGame->getNetInterface()->getPacketWriterThreadCount());
+
+   GamePair::idle(10, 5);
+
+   Vector<DatabaseObject *> fillVector;
+
+   for(S32 i = 0; i < clientGames->size(); i++)
+   {
+      SCOPED_TRACE("i = " + itos(i));
+      ClientGame *clientGame = clientGames->get(i);
+
+      fillVector.clear();
+      clientGame->getGameObjDatabase()->findObjects(TestItemTypeNumber, fillVector);
+      ASSERT_EQ(1, fillVector.size());
+      EXPECT_TRUE(fillVector[0]->getCentroid() == Point(255, 255));
+
+      fillVector.clear();
+      clientGame->getGameObjDatabase()->findObjects(BarrierTypeNumber, fillVector);
+      EXPECT_EQ(1, fillVector.size());
+
+      checkTeleporter(clientGame, "1275, 1275 | 2550, 2550", 1);
+   }
+
+   // Changes should keep flowing
+   fillVector.clear();
+   serverGame->getGameObjDatabase()->findObjects(TeleporterTypeNumber, fillVector);
+   ASSERT_EQ(1, fillVector.size());
+   Teleporter *teleporter = static_cast<Teleporter *>(fillVector[0]);
+
+   Point pts[] = { Point(30, 50) };
+   Vector<Point> geom(pts, ARRAYSIZE(pts));
+   teleporter->doSetGeom(geom);
+   GamePair::idle(10, 5);
+
+   for(S32 i = 0; i < clientGames->size(); i++)
+   {
+      SCOPED_TRACE("After move, i = " + itos(i));
+      checkTeleporter(clientGames->get(i), "30, 50 | 2550, 2550", 1);
+   }
+
+   // And we should be able to go back to writing them on this thread
+   serverGame->getNetInterface()->setPacketWriterThreadCount(0);
+   EXPECT_EQ(U32(0), serverGame->getNetInterface()->getPacketWriterThreadCount());
+   GamePair::idle(10, 5);
+}
+
+
+// Several clients joining a server that already writes on worker threads have their first packets, and the CRCs and
+// Huffman coded strings in them, written at the same time
+TEST(IntegrationTest, ParallelFirstPackets)
+{
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   settings->getIniSettings()->packetWriterThreads = 4;
+
+   GamePair gamePair(settings, getLevelCode1());
+
+   ServerGame *serverGame = GameManager::getServerGame();
+   ASSERT_EQ(U32(4), serverGame->getNetInterface()->getPacketWriterThreadCount());
+
+   for(S32 i = 0; i < 6; i++)
+      gamePair.addClient("TestPlayer" + itos(i));
+
+   GamePair::idle(10, 5);
+
+   const Vector<ClientGame *> *clientGames = GameManager::getClientGames();
+   ASSERT_EQ(6, clientGames->size());
+
+   Vector<DatabaseObject *> fillVector;
+
+   for(S32 i = 0; i < clientGames->size(); i++)
+   {
+      SCOPED_TRACE("i = " + itos(i));
+      ClientGame *clientGame = clientGames->get(i);
+
+      ASSERT_TRUE(clientGame->getConnectionToServer() != NULL);
+      EXPECT_TRUE(clientGame->getConnectionToServer()->isEstablished());
+      EXPECT_EQ("Test Level", clientGame->getGameType()->getLevelName());
+      EXPECT_STREQ("Bluey", clientGame->getTeam(0)->getName().getString());
+
+      fillVector.clear();
+      clientGame->getGameObjDatabase()->findObjects(TestItemTypeNumber, fillVector);
+      EXPECT_EQ(1, fillVector.size());
+   }
+}
+
+
 };
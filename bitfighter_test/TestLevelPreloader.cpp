@@ -0,0 +1,166 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelPreloader.h"
+#include "game.h"
+#include "stringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+
+namespace Zap
+{
+
+class LevelPreloaderTest: public testing::Test
+{
+protected:
+   static const string LevelFile;
+
+   BotZoneMeshInput mInput;
+
+   virtual void SetUp()
+   {
+      // One wall across the middle of the level
+      mInput.bounds = Rect(Point(0, 0), Point(1000, 1000));
+
+      Vector<Point> wall;
+      wall.push_back(Point(100, 450));
+      wall.push_back(Point(900, 450));
+      wall.push_back(Point(900, 550));
+      wall.push_back(Point(100, 550));
+      mInput.barrierPolygons.push_back(wall);
+
+      ASSERT_TRUE(writeFile(LevelFile, "LevelFormat 2\nGameType 10 8\nLevelName Preloaded\nBarrierMaker 100 100 500 900 500\n"));
+   }
+
+   virtual void TearDown()
+   {
+      remove(LevelFile.c_str());
+   }
+
+   // Lets the worker finish reading, but leaves the level for takeLevel()
+   static void waitForPreload(LevelPreloader &preloader)
+   {
+      preloader.mJobDone.wait();
+      preloader.mJobDone.increment();
+   }
+};
+
+const string LevelPreloaderTest::LevelFile = "preloadertest.level";
+
+
+TEST_F(LevelPreloaderTest, readsAndMeshes)
+{
+   LevelPreloader preloader(NULL);
+   PreloadedLevel level;
+
+   // Never seen this level before, so there's no geometry to mesh
+   preloader.preload(3, LevelFile);
+   ASSERT_TRUE(preloader.takeLevel(3, LevelFile, level));
+   EXPECT_EQ(readFile(LevelFile), level.contents);
+   EXPECT_EQ(Game::md5.getHashFromFile(LevelFile), level.hash);
+   EXPECT_TRUE(level.mesh == NULL);
+
+   // Now we have
+   preloader.rememberMeshInput(LevelFile, level.hash, mInput);
+   preloader.preload(3, LevelFile);
+   ASSERT_TRUE(preloader.takeLevel(3, LevelFile, level));
+   ASSERT_TRUE(level.mesh != NULL);
+   EXPECT_EQ(mInput.getHash(), level.mesh->inputHash);
+
+   BotZoneMesh mesh;
+   string error;
+   ASSERT_TRUE(BotNavMeshZone::buildMesh(mInput, mesh, error));
+   EXPECT_EQ(mesh.mesh.npolys, level.mesh->mesh.npolys);
+   EXPECT_EQ(mesh.mesh.nverts, level.mesh->mesh.nverts);
+
+   // Only hands over what was asked for
+   preloader.preload(3, LevelFile);
+   EXPECT_FALSE(preloader.takeLevel(4, LevelFile, level));
+   EXPECT_FALSE(preloader.takeLevel(3, "otherfile.level", level));
+   EXPECT_TRUE(preloader.takeLevel(3, LevelFile, level));
+}
+
+
+TEST_F(LevelPreloaderTest, ignoresChangedLevels)
+{
+   LevelPreloader preloader(NULL);
+   PreloadedLevel level;
+
+   preloader.rememberMeshInput(LevelFile, Game::md5.getHashFromFile(LevelFile), mInput);
+
+   // Level changed on disk since it was last played; its old geometry is no use
+   ASSERT_TRUE(writeFile(LevelFile, "\n", true));
+
+   preloader.preload(0, LevelFile);
+   ASSERT_TRUE(preloader.takeLevel(0, LevelFile, level));
+   EXPECT_EQ(readFile(LevelFile), level.contents);
+   EXPECT_TRUE(level.mesh == NULL);
+
+   // Missing files are left to the level source to complain about
+   preloader.preload(0, "nosuchfile.level");
+   EXPECT_FALSE(preloader.takeLevel(0, "nosuchfile.level", level));
+}
+
+
+// Files replaced after they were preloaded, by an upload say, have to be read again
+TEST_F(LevelPreloaderTest, ignoresLevelsReplacedSincePreloading)
+{
+   LevelPreloader preloader(NULL);
+   PreloadedLevel level;
+
+   preloader.preload(0, LevelFile);
+   ASSERT_TRUE(preloader.takeLevel(0, LevelFile, level));
+
+   preloader.preload(0, LevelFile);
+   waitForPreload(preloader);
+   ASSERT_TRUE(writeFile(LevelFile, "LevelFormat 2\nGameType 10 8\nLevelName Replaced\n"));
+   EXPECT_FALSE(preloader.takeLevel(0, LevelFile, level));
+   EXPECT_EQ("", level.contents);
+
+   // Preloading it again picks up the new version
+   preloader.preload(0, LevelFile);
+   ASSERT_TRUE(preloader.takeLevel(0, LevelFile, level));
+   EXPECT_EQ(readFile(LevelFile), level.contents);
+
+   // Deleted ones can't be handed over either
+   preloader.preload(0, LevelFile);
+   waitForPreload(preloader);
+   remove(LevelFile.c_str());
+   EXPECT_FALSE(preloader.takeLevel(0, LevelFile, level));
+}
+
+
+TEST_F(LevelPreloaderTest, usesCache)
+{
+   const string cacheDir = "preloadertestcache";
+   const string levelHash = Game::md5.getHashFromFile(LevelFile);
+
+   BotZoneMeshCache cache(cacheDir);
+   PreloadedLevel level;
+
+   {
+      // Meshes get saved...
+      LevelPreloader preloader(&cache);
+      preloader.rememberMeshInput(LevelFile, levelHash, mInput);
+      preloader.preload(0, LevelFile);
+      ASSERT_TRUE(preloader.takeLevel(0, LevelFile, level));
+      ASSERT_TRUE(level.mesh != NULL);
+   }
+
+   // ...so a preloader that has never seen the level before can still find one
+   LevelPreloader preloader(&cache);
+   preloader.preload(0, LevelFile);
+   ASSERT_TRUE(preloader.takeLevel(0, LevelFile, level));
+   ASSERT_TRUE(level.mesh != NULL);
+   EXPECT_EQ(mInput.getHash(), level.mesh->inputHash);
+
+   remove(joindir(cacheDir, levelHash + ".zones").c_str());
+   remove(cacheDir.c_str());
+}
+
+
+};
@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "projectile.h"
+#include "ServerGame.h"
+#include "gameType.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static const S32 ProjectileCount = 600;
+static const U32 TickLength = 33;
+
+// Spreads projectiles over the given fraction of the map, heading every which way
+static void fireProjectiles(ServerGame *game, F32 spread, S32 seed, Vector<Projectile *> &projectiles)
+{
+   GridDatabase *database = game->getGameObjDatabase();
+   const Rect &extents = database->getExtents();
+
+   for(S32 i = 0; i < ProjectileCount; i++)
+   {
+      Point pos(extents.min.x + extents.getWidth()  * spread * F32((i * 7919 + seed * 104729) % 1000) / 1000,
+                extents.min.y + extents.getHeight() * spread * F32((i * 6271 + seed * 3571)   % 1000) / 1000);
+
+      F32 angle = F32((i * 131 + seed) % 628) / 100;
+      WeaponType weapon = (i % 3 == 0) ? WeaponBounce : (i % 3 == 1) ? WeaponPhaser : WeaponTriple;
+
+      Projectile *projectile = new Projectile(weapon, pos, Point(cos(angle), sin(angle)) * 600, NULL);
+      projectile->addToGame(game, database);
+      projectiles.push_back(projectile);
+   }
+}
+
+
+// Moves the projectiles the way the game does; with batch false, each moves itself when it's idled
+static void runTick(ServerGame *game, const Vector<Projectile *> &projectiles, bool batch)
+{
+   if(batch)
+      Projectile::moveAll(game->getGameObjDatabase()->findObjects_fast(BulletTypeNumber), TickLength);
+
+   for(S32 i = 0; i < projectiles.size(); i++)
+   {
+      Move move = projectiles[i]->getCurrentMove();
+      move.time = TickLength;
+      projectiles[i]->setCurrentMove(move);
+      projectiles[i]->idle(BfObject::ServerIdleMainLoop);
+   }
+}
+
+
+static void removeProjectiles(Vector<Projectile *> &projectiles)
+{
+   for(S32 i = 0; i < projectiles.size(); i++)
+      projectiles[i]->removeFromGame(true);
+
+   projectiles.clear();
+}
+
+
+// Moving projectiles together, as the game does, ends up in exactly the same place as moving them one at a time
+TEST(ProjectileTest, moveAllMatchesIdle)
+{
+   ServerGame *games[2] = { newServerGame(), newServerGame() };
+
+   for(S32 i = 0; i < 2; i++)
+      games[i]->loadLevelFromString(getLevelCodeForLargeMap(4), games[i]->getGameObjDatabase());
+
+   const F32 spreads[] = { 1, 0.2f, 0.05f };
+
+   for(U32 s = 0; s < ARRAYSIZE(spreads); s++)
+   {
+      Vector<Projectile *> projectiles[2];
+
+      for(S32 i = 0; i < 2; i++)
+         fireProjectiles(games[i], spreads[s], s, projectiles[i]);
+
+      S32 hits = 0;
+
+      for(S32 tick = 0; tick < 30; tick++)
+      {
+         runTick(games[0], projectiles[0], false);
+         runTick(games[1], projectiles[1], true);
+
+         for(S32 i = 0; i < ProjectileCount; i++)
+         {
+            Projectile *scalar = projectiles[0][i];
+            Projectile *batched = projectiles[1][i];
+
+            ASSERT_EQ(scalar->getPos(), batched->getPos()) << "Projectile " << i << ", tick " << tick;
+            ASSERT_EQ(scalar->mCollided, batched->mCollided) << "Projectile " << i << ", tick " << tick;
+            ASSERT_EQ(scalar->mTimeRemaining, batched->mTimeRemaining) << "Projectile " << i << ", tick " << tick;
+
+            if(scalar->mCollided)
+               hits++;
+         }
+      }
+
+      EXPECT_LT(0, hits) << "Nothing hit anything; not much of a test";
+
+      for(S32 i = 0; i < 2; i++)
+         removeProjectiles(projectiles[i]);
+   }
+
+   for(S32 i = 0; i < 2; i++)
+      delete games[i];
+}
+
+
+// Not really a test -- compares moving projectiles one at a time with moving them together.  Run it by hand with
+// --gtest_also_run_disabled_tests.
+TEST(ProjectileTest, DISABLED_benchmark)
+{
+   ServerGame *game = newServerGame();
+   game->loadLevelFromString(getLevelCodeForLargeMap(4), game->getGameObjDatabase());
+
+   const F32 spreads[] = { 1, 0.2f, 0.05f };
+   static const S32 Rounds = 20;
+   static const S32 Ticks = 30;
+
+   for(U32 s = 0; s < ARRAYSIZE(spreads); s++)
+   {
+      F64 time[2] = { 0, 0 };
+
+      for(S32 batch = 0; batch < 2; batch++)
+         for(S32 round = 0; round < Rounds; round++)
+         {
+            Vector<Projectile *> projectiles;
+            fireProjectiles(game, spreads[s], round, projectiles);
+
+            S64 start = Platform::getHighPrecisionTimerValue();
+
+            for(S32 tick = 0; tick < Ticks; tick++)
+               runTick(game, projectiles, batch != 0);
+
+            time[batch] += Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+            removeProjectiles(projectiles);
+         }
+
+      printf("%d projectiles over %.0f%% of the map: one at a time %.3f ms per tick, together %.3f ms per tick\n",
+             ProjectileCount, spreads[s] * 100, time[0] / (Rounds * Ticks), time[1] / (Rounds * Ticks));
+   }
+
+   delete game;
+}
+
+
+};
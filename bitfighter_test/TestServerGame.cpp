@@ -6,6 +6,13 @@
 #include "gameType.h"
 #include "ServerGame.h"
 #include "EngineeredItem.h"
+#include "ArenaThread.h"
+#include "EventManager.h"
+#include "GameManager.h"
+#include "SystemFunctions.h"
+#include "LuaScriptRunner.h"
+#include "gameNetInterface.h"
+#include "LevelFilesForTesting.h"
 
 #include "TestUtils.h"
 
@@ -165,4 +172,54 @@ TEST(ServerGameTest, LoadoutManagementTests)
 }
 
 
+
+// A dedicated server hosting several games runs each one after the first on a thread of its own, with its own socket
+TEST(ServerGameTest, Arenas)
+{
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   settings->getIniSettings()->arenas = 3;
+   settings->getIniSettings()->hostaddr = "IP:Any:38100";
+
+   LuaScriptRunner::startLua(settings->getFolderManager()->luaDir);
+
+   LevelSourcePtr levelSource = LevelSourcePtr(new StringLevelSource(getLevelCode1()));
+   initHosting(settings, levelSource, true, true);
+
+   ServerGame *firstArena = GameManager::getServerGame();
+   ASSERT_TRUE(firstArena != NULL);
+   ASSERT_TRUE(firstArena->startHosting());
+
+   EventManager *eventManager = EventManager::get();
+
+   hostArenas(firstArena);
+
+   const Vector<ArenaThread *> *arenas = GameManager::getArenas();
+   ASSERT_EQ(2, arenas->size());
+   EXPECT_EQ(2, GameManager::getArenaThreadCount());     // Which is what /loadini checks before touching the settings
+   EXPECT_EQ(38100, firstArena->getNetInterface()->getSocket().getBoundAddress().port);
+
+   for(S32 i = 0; i < arenas->size(); i++)
+      EXPECT_EQ(38101 + i, arenas->get(i)->getPort());
+
+   // This thread carries on with its own game while the others run theirs
+   for(S32 i = 0; i < 10; i++)
+      GameManager::idleServerGame(10);
+
+   EXPECT_EQ(firstArena, GameManager::getServerGame());
+   EXPECT_EQ(eventManager, EventManager::get());
+
+   string reason;
+   for(S32 i = 0; i < arenas->size(); i++)
+      EXPECT_FALSE(arenas->get(i)->isReadyToShutdown(reason));
+
+   GameManager::deleteServerGame();     // Stops the other arenas, and waits for them to clean up
+   EXPECT_EQ(0, GameManager::getArenas()->size());
+   EXPECT_EQ(0, GameManager::getArenaThreadCount());
+   EXPECT_TRUE(GameManager::getServerGame() == NULL);
+
+   LuaScriptRunner::clearScriptCache();
+   LuaScriptRunner::shutdown();
+}
+
+
 };
@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlUDP.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+static const S32 PacketCount = 100;    // Several batches' worth
+
+// Sends PacketCount numbered packets from one loopback socket to another, and checks they all arrive intact
+static void sendAndReceive(bool batched)
+{
+   Socket sender(Address(IPProtocol, Address::Any, 0));
+   Socket receiver(Address(IPProtocol, Address::Any, 0), Socket::DefaultBufferSize, 256 * 1024);
+   ASSERT_TRUE(sender.isValid() && receiver.isValid());
+
+   sender.setBatchedIO(batched);
+   receiver.setBatchedIO(batched);
+
+   Address destination("127.0.0.1");
+   destination.port = receiver.getBoundAddress().port;
+
+   for(S32 i = 0; i < PacketCount; i++)
+   {
+      U8 packet[64];
+      memset(packet, i, sizeof(packet));
+      ASSERT_EQ(NoError, sender.sendto(destination, packet, 1 + i % sizeof(packet)));
+   }
+
+   sender.flushSends();
+
+   Vector<bool> seen;
+   seen.resize(PacketCount);
+   for(S32 i = 0; i < PacketCount; i++)
+      seen[i] = false;
+
+   S32 received = 0;
+   U32 giveUpTime = Platform::getRealMilliseconds() + 2000;
+
+   while(received < PacketCount && Platform::getRealMilliseconds() < giveUpTime)
+   {
+      Address from;
+      U8 packet[MaxPacketDataSize];
+      S32 size;
+
+      if(receiver.recvfrom(&from, packet, sizeof(packet), &size) != NoError)
+      {
+         Platform::sleep(1);
+         continue;
+      }
+
+      S32 index = packet[0];
+      ASSERT_LT(index, PacketCount);
+      EXPECT_EQ(1 + index % 64, size);
+      EXPECT_EQ(sender.getBoundAddress().port, from.port);
+      EXPECT_FALSE(seen[index]);
+
+      seen[index] = true;
+      received++;
+   }
+
+   EXPECT_EQ(PacketCount, received);
+}
+
+
+TEST(SocketTest, unbatched)
+{
+   sendAndReceive(false);
+}
+
+
+TEST(SocketTest, batched)
+{
+   sendAndReceive(true);
+}
+
+
+// Nothing there: we should wait out the timeout, and not much longer.  Something there: we should say so at once.
+static void waitForPacket(bool batched)
+{
+   Socket sender(Address(IPProtocol, Address::Any, 0));
+   Socket receiver(Address(IPProtocol, Address::Any, 0));
+   ASSERT_TRUE(sender.isValid() && receiver.isValid());
+
+   receiver.setBatchedIO(batched);
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   EXPECT_FALSE(receiver.waitForPacket(20000));
+   F64 waited = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+   EXPECT_GE(waited, 19.0);
+   EXPECT_LT(waited, 500.0);
+
+   EXPECT_FALSE(receiver.waitForPacket(0));
+
+   Address destination("127.0.0.1");
+   destination.port = receiver.getBoundAddress().port;
+
+   U8 packet[16] = { 0 };
+   ASSERT_EQ(NoError, sender.sendto(destination, packet, sizeof(packet)));
+   ASSERT_EQ(NoError, sender.sendto(destination, packet, sizeof(packet)));
+
+   EXPECT_TRUE(receiver.waitForPacket(2000000));
+
+   // Whether they came in one batch or not, the second is still there to be read after the first
+   Address from;
+   U8 buffer[MaxPacketDataSize];
+   S32 size;
+   ASSERT_EQ(NoError, receiver.recvfrom(&from, buffer, sizeof(buffer), &size));
+
+   EXPECT_TRUE(receiver.waitForPacket(2000000));
+   ASSERT_EQ(NoError, receiver.recvfrom(&from, buffer, sizeof(buffer), &size));
+
+   EXPECT_FALSE(receiver.waitForPacket(0));
+}
+
+
+TEST(SocketTest, waitForPacket)
+{
+   waitForPacket(false);
+   waitForPacket(true);
+}
+
+
+TEST(SocketTest, batchingAvailability)
+{
+   Socket udp(Address(IPProtocol, Address::Any, 0));
+   Socket tcp(Address(TCPProtocol, Address::Any, 0));
+
+#ifdef TNL_OS_LINUX
+   EXPECT_TRUE(udp.setBatchedIO(true));
+#else
+   EXPECT_FALSE(udp.setBatchedIO(true));
+#endif
+
+   EXPECT_FALSE(tcp.setBatchedIO(true));
+
+   EXPECT_FALSE(udp.setBatchedIO(false));
+   EXPECT_FALSE(udp.isBatchedIO());
+}
+
+
+};
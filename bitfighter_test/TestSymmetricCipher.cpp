@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlSymmetricCipher.h"
+#include "tnlPlatform.h"
+#include "tnlRandom.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+class SymmetricCipherTest: public testing::Test
+{
+protected:
+   static const U32 PacketSize = 1400;       // About the most we send in a packet
+
+   U8 mKey[SymmetricCipher::KeySize];
+   U8 mInitVector[SymmetricCipher::BlockSize];
+
+   virtual void SetUp()
+   {
+      Random::read(mKey, sizeof(mKey));
+      Random::read(mInitVector, sizeof(mInitVector));
+   }
+
+   virtual void TearDown()
+   {
+      SymmetricCipher::setHardwareAESEnabled(true);
+   }
+
+   // Obviously correct, if slow: the cipher as it was, a byte at a time, straight from libtomcrypt
+   struct ReferenceCipher
+   {
+      symmetric_key key;
+      U32 initVector[4];
+      U8 pad[16];
+      U32 padLen;
+
+      ReferenceCipher(const U8 *symmetricKey, const U8 *iv)
+      {
+         rijndael_setup(symmetricKey, 16, 0, &key);
+         memcpy(initVector, iv, 16);
+         rijndael_ecb_encrypt(iv, pad, &key);
+         padLen = 0;
+      }
+
+      void setupCounter(U32 c1, U32 c2, U32 c3, U32 c4)
+      {
+         U32 counter[4];
+         counter[0] = convertHostToLEndian(convertLEndianToHost(initVector[0]) + c1);
+         counter[1] = convertHostToLEndian(convertLEndianToHost(initVector[1]) + c2);
+         counter[2] = convertHostToLEndian(convertLEndianToHost(initVector[2]) + c3);
+         counter[3] = convertHostToLEndian(convertLEndianToHost(initVector[3]) + c4);
+         rijndael_ecb_encrypt((U8 *)counter, pad, &key);
+         padLen = 0;
+      }
+
+      void encrypt(const U8 *plainText, U8 *cipherText, U32 len)
+      {
+         while(len-- > 0)
+         {
+            if(padLen == 16)
+            {
+               rijndael_ecb_encrypt(pad, pad, &key);
+               padLen = 0;
+            }
+            U8 encryptedChar = *plainText++ ^ pad[padLen];
+            pad[padLen++] = *cipherText++ = encryptedChar;
+         }
+      }
+   };
+
+   // Encrypts packets of all sorts of sizes, a piece at a time, and compares with the reference
+   void checkMatchesReference()
+   {
+      SymmetricCipher cipher(mKey, mInitVector);
+      ReferenceCipher reference(mKey, mInitVector);
+
+      for(U32 packet = 0; packet < 200; packet++)
+      {
+         U8 plainText[PacketSize], cipherText[PacketSize], expected[PacketSize];
+         U32 len = Random::readI(0, PacketSize);
+         Random::read(plainText, len);
+
+         cipher.setupCounter(packet, packet * 3, packet & 1, 0);
+         reference.setupCounter(packet, packet * 3, packet & 1, 0);
+
+         for(U32 done = 0; done < len; )
+         {
+            U32 count = getMin((U32)Random::readI(1, 100), len - done);
+            cipher.encrypt(plainText + done, cipherText + done, count);
+            done += count;
+         }
+
+         reference.encrypt(plainText, expected, len);
+         ASSERT_EQ(0, memcmp(expected, cipherText, len)) << "Packet " << packet << " of " << len << " bytes";
+      }
+   }
+};
+
+
+// FIPS-197 appendix C.1: with the IV as the plain text, the first pad is the AES of it
+TEST_F(SymmetricCipherTest, knownAnswer)
+{
+   const U8 key[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+   const U8 iv[16]  = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+   const U8 aes[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+   for(S32 hardware = 0; hardware < 2; hardware++)
+   {
+      SymmetricCipher::setHardwareAESEnabled(hardware != 0);
+
+      SymmetricCipher cipher(key, iv);
+      U8 zeros[16] = { 0 };
+      U8 out[16];
+      cipher.encrypt(zeros, out, sizeof(out));
+
+      EXPECT_EQ(0, memcmp(aes, out, sizeof(out))) << (hardware ? "With" : "Without") << " AES instructions";
+   }
+}
+
+
+TEST_F(SymmetricCipherTest, matchesReference)
+{
+   SymmetricCipher::setHardwareAESEnabled(false);
+   checkMatchesReference();
+
+   if(SymmetricCipher::setHardwareAESEnabled(true))      // Without AES instructions, there's only the portable code
+      checkMatchesReference();
+}
+
+
+// Decrypting in place, in pieces of any size, gets us back where we started
+TEST_F(SymmetricCipherTest, roundTrip)
+{
+   for(S32 hardware = 0; hardware < 2; hardware++)
+   {
+      SymmetricCipher::setHardwareAESEnabled(hardware != 0);
+
+      SymmetricCipher sender(mKey, mInitVector);
+      SymmetricCipher receiver(mKey, mInitVector);
+
+      for(U32 packet = 0; packet < 200; packet++)
+      {
+         U8 plainText[PacketSize], buffer[PacketSize];
+         U32 len = Random::readI(0, PacketSize);
+         Random::read(plainText, len);
+
+         sender.setupCounter(packet, 0, 0, 0);
+         sender.encrypt(plainText, buffer, len);
+
+         receiver.setupCounter(packet, 0, 0, 0);
+         for(U32 done = 0; done < len; )
+         {
+            U32 count = getMin((U32)Random::readI(1, 300), len - done);
+            receiver.decrypt(buffer + done, buffer + done, count);
+            done += count;
+         }
+
+         ASSERT_EQ(0, memcmp(plainText, buffer, len)) << "Packet " << packet << " of " << len << " bytes";
+      }
+   }
+}
+
+
+static void benchmark(const char *name, const U8 *key, const U8 *initVector)
+{
+   static const U32 PacketSize = 1400;
+   static const U32 Packets = 20000;
+
+   SymmetricCipher cipher(key, initVector);
+   U8 buffer[PacketSize];
+   memset(buffer, 0, sizeof(buffer));
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   for(U32 p = 0; p < Packets; p++)
+   {
+      cipher.setupCounter(p, 0, 0, 0);
+      cipher.encrypt(buffer, buffer, PacketSize);
+   }
+   F64 encryptTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   start = Platform::getHighPrecisionTimerValue();
+   for(U32 p = 0; p < Packets; p++)
+   {
+      cipher.setupCounter(p, 0, 0, 0);
+      cipher.decrypt(buffer, buffer, PacketSize);
+   }
+   F64 decryptTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   F64 megabytes = F64(PacketSize) * Packets / (1024 * 1024);
+   printf("%s: encrypt %.0f MB/s, decrypt %.0f MB/s\n", name, megabytes / encryptTime * 1000, megabytes / decryptTime * 1000);
+}
+
+
+// Not really a test -- compares the two ways of doing AES.  Run it by hand with --gtest_also_run_disabled_tests.
+TEST_F(SymmetricCipherTest, DISABLED_benchmark)
+{
+   SymmetricCipher::setHardwareAESEnabled(false);
+   benchmark("libtomcrypt AES", mKey, mInitVector);
+
+   if(SymmetricCipher::setHardwareAESEnabled(true))
+      benchmark("AES instructions", mKey, mInitVector);
+}
+
+
+};
@@ -0,0 +1,283 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "WallCollisionTree.h"
+#include "gridDB.h"
+#include "ServerGame.h"
+#include "BfObject.h"
+#include "barrier.h"
+#include "moveObject.h"     // For ActualState
+#include "GeomUtils.h"
+#include "stringUtils.h"
+
+#include "TestUtils.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace std;
+
+class WallCollisionTreeTest: public testing::Test
+{
+protected:
+   static const S32 CellsPerSide = 12;
+   static const S32 CellSize = 6;      // In grid units
+
+   ServerGame *mGame;
+   GridDatabase *mDatabase;
+   Rect mExtents;
+
+   // Rings of round polywalls, many-sided like the ones people draw, with line walls between them
+   static string getLevelCode()
+   {
+      string level =
+         "GameType 10 8\n"
+         "LevelName Round Walls\n"
+         "GridSize 255\n"
+         "Team Bluey 0 0 1\n"
+         "Spawn 0 0 0\n";
+
+      for(S32 x = 0; x < CellsPerSide; x++)
+         for(S32 y = 0; y < CellsPerSide; y++)
+         {
+            level += "PolyWall";
+
+            for(S32 i = 0; i < 24; i++)
+            {
+               F32 angle = F32(i) * FloatTau / 24;
+               level += " " + ftos(x * CellSize + 1.5f * cos(angle), 3) + " " + ftos(y * CellSize + 1.5f * sin(angle), 3);
+            }
+
+            level += "\n";
+            level += "BarrierMaker 40 " + itos(x * CellSize + 3) + " " + itos(y * CellSize - 2) + " " +
+                                          itos(x * CellSize + 3) + " " + itos(y * CellSize + 2) + "\n";
+         }
+
+      return level;
+   }
+
+   virtual void SetUp()
+   {
+      srand(1234);
+
+      mGame = newServerGame();
+      mDatabase = mGame->getGameObjDatabase();
+      mGame->loadLevelFromString(getLevelCode(), mDatabase);
+      mExtents = mDatabase->getExtents();
+   }
+
+   virtual void TearDown()
+   {
+      delete mGame;
+   }
+
+   Point randomPoint() const
+   {
+      return Point(mExtents.min.x + F32(rand()) / F32(RAND_MAX) * mExtents.getWidth(),
+                   mExtents.min.y + F32(rand()) / F32(RAND_MAX) * mExtents.getHeight());
+   }
+
+   static Point randomDelta(F32 maxLength)
+   {
+      F32 angle = F32(rand()) / F32(RAND_MAX) * FloatTau;
+      F32 length = F32(rand()) / F32(RAND_MAX) * maxLength;
+
+      return Point(cos(angle), sin(angle)) * length;
+   }
+
+   // What MoveObject::findFirstCollision() did before there was a tree: every Barrier nearby, each in turn
+   DatabaseObject *findFirstSweptCircleHitSlowly(const Point &begin, const Point &delta, F32 radius, F32 &fraction, Point &point)
+   {
+      Rect queryRect(begin, begin + delta);
+      queryRect.expand(Point(radius, radius));
+
+      Vector<DatabaseObject *> walls;
+      mDatabase->findObjects(BarrierTypeNumber, walls, queryRect);
+
+      DatabaseObject *hitWall = NULL;
+
+      for(S32 i = 0; i < walls.size(); i++)
+      {
+         const Vector<Point> *poly = walls[i]->getCollisionPoly();
+         Point cp;
+         F32 f;
+
+         if(PolygonSweptCircleIntersect(&poly->first(), poly->size(), begin, delta, radius, cp, f) && cp != begin)
+            if(!hitWall || f < fraction)
+            {
+               hitWall = walls[i];
+               fraction = f;
+               point = cp;
+            }
+      }
+
+      return hitWall;
+   }
+};
+
+
+TEST_F(WallCollisionTreeTest, sweptCircleMatchesPolygonTests)
+{
+   WallCollisionTree *tree = mDatabase->getWallCollisionTree();
+
+   ASSERT_EQ(2 * CellsPerSide * CellsPerSide, tree->getWallCount());
+   ASSERT_EQ(CellsPerSide * CellsPerSide * (24 + 4), tree->getEdgeCount());
+
+   S32 hits = 0;
+
+   for(S32 i = 0; i < 20000; i++)
+   {
+      Point begin = randomPoint();
+      Point delta = randomDelta(400);
+      F32 radius = (i % 2 == 0) ? 24.f : 10.f;      // Ship, and something smaller
+
+      F32 fraction, expectedFraction;
+      Point point, expectedPoint;
+
+      DatabaseObject *wall = tree->findFirstSweptCircleHit(begin, delta, radius, fraction, point);
+      DatabaseObject *expectedWall = findFirstSweptCircleHitSlowly(begin, delta, radius, expectedFraction, expectedPoint);
+
+      ASSERT_EQ(expectedWall != NULL, wall != NULL) << "Sweep " << i;
+
+      if(wall)
+      {
+         hits++;
+         ASSERT_EQ(expectedFraction, fraction) << "Sweep " << i;
+
+         if(wall == expectedWall)      // They could be different if two walls are hit at exactly the same time
+            ASSERT_EQ(expectedPoint, point) << "Sweep " << i;
+      }
+   }
+
+   EXPECT_LT(1000, hits);
+}
+
+
+TEST_F(WallCollisionTreeTest, rayMatchesFindObjectLOS)
+{
+   WallCollisionTree *tree = mDatabase->getWallCollisionTree();
+
+   S32 hits = 0;
+
+   for(S32 i = 0; i < 20000; i++)
+   {
+      Point start = randomPoint();
+      Point end = start + randomDelta(1500);
+
+      F32 time, expectedTime;
+      Point normal, expectedNormal;
+
+      DatabaseObject *wall = tree->findFirstRayHit(start, end, time, normal);
+      DatabaseObject *expectedWall = mDatabase->findObjectLOS((TestFunc)isWallType, ActualState, start, end,
+                                                              expectedTime, expectedNormal);
+
+      ASSERT_EQ(expectedWall != NULL, wall != NULL) << "Ray " << i;
+      ASSERT_EQ(wall == NULL, mDatabase->pointCanSeePoint(start, end)) << "Ray " << i;
+
+      if(wall)
+      {
+         hits++;
+         ASSERT_EQ(expectedTime, time) << "Ray " << i;
+
+         if(wall == expectedWall)
+            ASSERT_EQ(expectedNormal, normal) << "Ray " << i;
+      }
+   }
+
+   EXPECT_LT(1000, hits);
+}
+
+
+// Walls added or removed mid-game, by scripts, say, get picked up the next time the tree is asked for
+TEST_F(WallCollisionTreeTest, rebuiltWhenWallsChange)
+{
+   WallCollisionTree *tree = mDatabase->getWallCollisionTree();
+   S32 wallCount = tree->getWallCount();
+
+   // Between the first two columns of walls, where nothing is in the way
+   Point start(CellSize * 255 * 0.625f, -CellSize * 255 * 0.5f);
+   Point end(CellSize * 255 * 0.625f, CellSize * 255 * 1.5f);
+   EXPECT_TRUE(mDatabase->pointCanSeePoint(start, end));
+
+   Vector<Point> points;
+   points.push_back(Point(start.x - 100, 0));
+   points.push_back(Point(start.x + 100, 0));
+
+   WallRec wallRec(50, false, Vector<F32>());
+   wallRec.verts.push_back(points[0].x);
+   wallRec.verts.push_back(points[0].y);
+   wallRec.verts.push_back(points[1].x);
+   wallRec.verts.push_back(points[1].y);
+   ASSERT_TRUE(wallRec.constructWalls(mGame));
+
+   EXPECT_FALSE(mDatabase->pointCanSeePoint(start, end));      // Tree isn't up to date, so this is done the old way
+   EXPECT_EQ(wallCount + 1, mDatabase->getWallCollisionTree()->getWallCount());
+   EXPECT_FALSE(mDatabase->pointCanSeePoint(start, end));
+
+   F32 time;
+   Point normal;
+   BfObject *wall = static_cast<BfObject *>(mDatabase->getWallCollisionTree()->findFirstRayHit(start, end, time, normal));
+   ASSERT_TRUE(wall != NULL);
+   EXPECT_EQ(BarrierTypeNumber, wall->getObjectTypeNumber());
+
+   // Walls that have their collisions turned off don't count
+   wall->disableCollision();
+   EXPECT_TRUE(mDatabase->pointCanSeePoint(start, end));
+   wall->enableCollision();
+
+   wall->deleteObject();
+   mGame->processDeleteList(1000);     // Actually get rid of it
+
+   EXPECT_EQ(wallCount, mDatabase->getWallCollisionTree()->getWallCount());
+   EXPECT_TRUE(mDatabase->pointCanSeePoint(start, end));
+}
+
+
+// Not really a test -- compares the tree with testing each wall in turn.  Run it by hand with
+// --gtest_also_run_disabled_tests.
+TEST_F(WallCollisionTreeTest, DISABLED_benchmark)
+{
+   static const S32 Sweeps = 200000;
+
+   Vector<Point> begins, deltas;
+   for(S32 i = 0; i < Sweeps; i++)
+   {
+      begins.push_back(randomPoint());
+      deltas.push_back(randomDelta(30));     // About as far as a ship goes in a tick
+   }
+
+   WallCollisionTree *tree = mDatabase->getWallCollisionTree();
+   F32 fraction;
+   Point point;
+   S32 hits[2] = { 0, 0 };
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Sweeps; i++)
+      if(findFirstSweptCircleHitSlowly(begins[i], deltas[i], 24, fraction, point))
+         hits[0]++;
+   F64 slowTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Sweeps; i++)
+      if(tree->findFirstSweptCircleHit(begins[i], deltas[i], 24, fraction, point))
+         hits[1]++;
+   F64 treeTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   EXPECT_EQ(hits[0], hits[1]);
+
+   printf("%d ship-sized sweeps among %d walls: each wall in turn %.0f ms, wall tree %.0f ms\n",
+          Sweeps, tree->getWallCount(), slowTime, treeTime);
+}
+
+
+};
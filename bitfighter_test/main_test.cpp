@@ -9,6 +9,7 @@
 
 #include "DisplayManager.h"
 #include "FontManager.h"
+#include "HeadlessRenderer.h"
 #include "tnlLog.h"
 
 #include "stringUtils.h"
@@ -68,8 +69,10 @@ int main(int argc, char **argv)
 
 
    DisplayManager::initialize();
+   HeadlessRenderer::create();      // Lets tests run render code without a GPU
    int returnvalue = RUN_ALL_TESTS();
    FontManager::cleanup();
+   Renderer::shutdown();
    DisplayManager::cleanup();
    return returnvalue;
 }
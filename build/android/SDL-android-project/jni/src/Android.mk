@@ -31,6 +31,7 @@ $(ZAP_PATH)/controlObjectConnection.cpp \
 $(ZAP_PATH)/CoreGame.cpp \
 $(ZAP_PATH)/CTFGame.cpp \
 $(ZAP_PATH)/dataConnection.cpp \
+$(ZAP_PATH)/DynamicAABBTree.cpp \
 $(ZAP_PATH)/EditorPlugin.cpp \
 $(ZAP_PATH)/EngineeredItem.cpp \
 $(ZAP_PATH)/EventManager.cpp \
@@ -94,6 +95,7 @@ $(ZAP_PATH)/teamInfo.cpp \
 $(ZAP_PATH)/teleporter.cpp \
 $(ZAP_PATH)/textItem.cpp \
 $(ZAP_PATH)/Timer.cpp \
+$(ZAP_PATH)/WallCollisionTree.cpp \
 $(ZAP_PATH)/WallSegmentManager.cpp \
 $(ZAP_PATH)/WeaponInfo.cpp \
 $(ZAP_PATH)/Zone.cpp \
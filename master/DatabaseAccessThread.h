@@ -9,6 +9,9 @@
 
 #include "tnlThread.h"
 #include "tnlLog.h"
+#include "tnlPlatform.h"
+
+#include <deque>
 
 namespace Master
 {
@@ -20,107 +23,300 @@ public:
 
    virtual void run() = 0;    // runs on seperate thread
    virtual void finish() {};  // finishes the entry on primary thread after "run()" is done to avoid 2 threads crashing in to the same network TNL and others.
+
+   // Offered the entries queued right behind this one, on a worker thread, with the queue locked.  Return true to take
+   // on entry's work and do it in this entry's run(); entry will then be dropped without being run or finished.
+   // Lets a burst of small writes share one trip to the database.
+   virtual bool absorb(ThreadEntry *entry) { return false; }
+};
+
+
+// How well the database is keeping up
+struct DatabaseAccessStats
+{
+   U32 queued;             // Entries waiting for a worker right now
+   U32 maxQueued;          // Most entries that were ever waiting at once
+   U32 completed;          // Entries run, absorbed ones included...
+   U32 batches;            // ...in this many calls to run()
+   F32 averageLatency;     // Ms from addEntry() until the entry has been run
+   U32 maxLatency;
 };
 
-class DatabaseAccessThread : public TNL::Thread
+
+// Runs entries on a pool of worker threads, then finishes them on the primary thread in idle().  Entries are started in
+// the order they were added, but with more than one worker, may finish in any order.
+//
+// RefPtrData's count isn't thread safe, so the workers only ever see raw pointers.  addEntry() takes a reference on the
+// primary thread to keep each entry alive while it is in our hands, and idle() gives it back, again on the primary thread.
+class DatabaseAccessThread
 {
 private:
-   U32 mEntryStart;
-   U32 mEntryThread;
-   U32 mEntryEnd;
+   class Worker : public TNL::Thread
+   {
+      DatabaseAccessThread *mPool;
+
+   public:
+      Worker(DatabaseAccessThread *pool) { mPool = pool; }
+      U32 run() { mPool->work(); return 0; }
+   };
 
-   bool mRunning;
-   bool mThreadActive;
+   struct QueuedEntry
+   {
+      ThreadEntry *entry;
+      U32 queuedTime;
+   };
 
-   static const U32 mEntrySize = 128;
+   static const U32 MaxBatchSize = 64;             // Most entries one run() will be asked to absorb
+   static const U32 QueueWarningDepth = 256;       // Complain every time the queue grows by this many entries
 
-   RefPtr<ThreadEntry> mEntry[mEntrySize];
+   Vector<TNL::Thread *> mWorkers;
+   bool mShuttingDown;
 
-public:
-   DatabaseAccessThread() // Constructor
+   // Protected by mLock
+   std::deque<QueuedEntry> mQueue;
+   Vector<ThreadEntry *> mFinished;                // Run, awaiting finish() on the primary thread
+   Vector<ThreadEntry *> mAbsorbed;                // Done by other entries, awaiting release on the primary thread
+
+   U32 mMaxQueued;
+   U32 mCompleted;
+   U32 mBatches;
+   U64 mTotalLatency;
+   U32 mMaxLatency;
+
+   TNL::Mutex mLock;
+   TNL::Semaphore mWorkAvailable;                  // Incremented once per entry added, and once per worker at shutdown
+   TNL::Semaphore mWorkerDone;
+
+
+   void recordLatency(U32 queuedTime, U32 now)
    {
-      mEntryStart = 0;
-      mEntryThread = 0;
-      mEntryEnd = 0;
+      U32 latency = now - queuedTime;
 
-      mRunning = true;
-      mThreadActive = false;
+      mTotalLatency += latency;
+      mCompleted++;
+
+      if(latency > mMaxLatency)
+         mMaxLatency = latency;
    }
 
 
-   void addEntry(ThreadEntry *entry)
+   // Worker thread
+   void work()
    {
-      U32 entryEnd = mEntryEnd + 1;
-
-      if(entryEnd >= mEntrySize)
-         entryEnd = 0;
+      Vector<U32> queuedTimes;
 
-      if(entryEnd == mEntryStart)      // Too many entries
+      for(;;)
       {
-         logprintf(LogConsumer::LogError, "Database thread overloaded - database access too slow?");
-         return;
-      }
+         mWorkAvailable.wait();
 
-      mEntry[mEntryEnd] = entry;
-      mEntryEnd = entryEnd;
-      if(!mThreadActive)
-      {
-         mThreadActive = true;
-         start();
+         mLock.lock();
+
+         if(mQueue.empty())      // Nothing left for us -- either we're shutting down, or the entry was absorbed
+         {
+            bool shuttingDown = mShuttingDown;
+            mLock.unlock();
+
+            if(shuttingDown)
+               break;
+
+            continue;
+         }
+
+         ThreadEntry *entry = mQueue.front().entry;
+         queuedTimes.clear();
+         queuedTimes.push_back(mQueue.front().queuedTime);
+         mQueue.pop_front();
+
+         while(!mQueue.empty() && queuedTimes.size() < (S32)MaxBatchSize && entry->absorb(mQueue.front().entry))
+         {
+            queuedTimes.push_back(mQueue.front().queuedTime);
+            mAbsorbed.push_back(mQueue.front().entry);
+            mQueue.pop_front();
+         }
+
+         mLock.unlock();
+
+         entry->run();
+
+         U32 now = Platform::getRealMilliseconds();
+
+         mLock.lock();
+
+         for(S32 i = 0; i < queuedTimes.size(); i++)
+            recordLatency(queuedTimes[i], now);
+
+         mBatches++;
+         mFinished.push_back(entry);
+
+         mLock.unlock();
       }
+
+      // Last thing we touch -- we may be destroyed as soon as this is signalled
+      mWorkerDone.increment();
    }
 
 
-   U32 run()
+public:
+   explicit DatabaseAccessThread(U32 threadCount = 1) :      // Constructor
+      mWorkAvailable(0, U32_MAX >> 1)
    {
-      mThreadActive = true;
-      while(mRunning)
+      mShuttingDown = false;
+
+      mMaxQueued = 0;
+      mCompleted = 0;
+      mBatches = 0;
+      mTotalLatency = 0;
+      mMaxLatency = 0;
+
+#ifdef TNL_NO_THREADS
+      threadCount = 0;     // Thread::start() would run our worker loop right here, and never return
+#endif
+
+      for(U32 i = 0; i < threadCount; i++)
       {
-         if(mEntryThread != mEntryEnd)
+         Worker *worker = new Worker(this);
+
+         if(!worker->start())
          {
-            mEntry[mEntryThread]->run();
-            mEntryThread++;
-            if(mEntryThread >= mEntrySize)
-               mEntryThread = 0;
+            delete worker;
+            logprintf(LogConsumer::LogError, "Could only start %d of %d database threads", i, threadCount);
+            break;
          }
-         else
-            Platform::sleep(50);
+
+         mWorkers.push_back(worker);
       }
+   }
 
-      mThreadActive = false;
 
-      return 0;
+   // Entries still in the queue are run before we return, so nothing already accepted is lost; none are finished,
+   // as whatever they would report back to may be gone by now
+   ~DatabaseAccessThread()
+   {
+      mLock.lock();
+      mShuttingDown = true;
+      mLock.unlock();
+
+      mWorkAvailable.increment(mWorkers.size());
+
+      for(S32 i = 0; i < mWorkers.size(); i++)
+         mWorkerDone.wait();
+
+      for(S32 i = 0; i < mWorkers.size(); i++)
+         delete mWorkers[i];
+
+      for(S32 i = 0; i < mFinished.size(); i++)
+         mFinished[i]->decRef();
+
+      for(S32 i = 0; i < mAbsorbed.size(); i++)
+         mAbsorbed[i]->decRef();
    }
 
 
-   void idle()
+   U32 getThreadCount() const
+   {
+      return mWorkers.size();
+   }
+
+
+   // The queue has no limit; if the database can't keep up, we'd rather use memory than lose work.  Call on the primary
+   // thread.
+   void addEntry(ThreadEntry *entry)
    {
-      while(mEntryStart != mEntryThread)
+      U32 now = Platform::getRealMilliseconds();
+
+      entry->incRef();              // Given back in idle()
+
+      if(mWorkers.size() == 0)      // No threads, so do it now
       {
-         mEntry[mEntryStart]->finish();
-         mEntry[mEntryStart].set(NULL);  // RefPtr, we can just set to NULL and it will delete itself
-         mEntryStart++;
+         entry->run();
+
+         mLock.lock();
+         recordLatency(now, Platform::getRealMilliseconds());
+         mBatches++;
+         mFinished.push_back(entry);
+         mLock.unlock();
 
-         if(mEntryStart >= mEntrySize)
-            mEntryStart = 0;
+         return;
       }
+
+      QueuedEntry queuedEntry;
+      queuedEntry.entry = entry;
+      queuedEntry.queuedTime = now;
+
+      mLock.lock();
+
+      mQueue.push_back(queuedEntry);
+      U32 queued = (U32)mQueue.size();
+
+      if(queued > mMaxQueued)
+         mMaxQueued = queued;
+
+      mLock.unlock();
+
+      if(queued % QueueWarningDepth == 0)
+         logprintf(LogConsumer::LogWarning, "Database queue is %d entries deep - database access too slow?", queued);
+
+      mWorkAvailable.increment();
    }
 
-   void terminate()
+
+   // Call on the primary thread
+   void idle()
    {
-      mRunning = false;
-      while(mThreadActive)
-         Platform::sleep(50);
+      mLock.lock();
+
+      if(mFinished.size() == 0 && mAbsorbed.size() == 0)
+      {
+         mLock.unlock();
+         return;
+      }
+
+      Vector<ThreadEntry *> finished = mFinished;
+      Vector<ThreadEntry *> absorbed = mAbsorbed;
+      mFinished.clear();
+      mAbsorbed.clear();
+
+      mLock.unlock();
+
+      // finish() may well add more entries, so we do this unlocked
+      for(S32 i = 0; i < finished.size(); i++)
+      {
+         finished[i]->finish();
+         finished[i]->decRef();
+      }
+
+      for(S32 i = 0; i < absorbed.size(); i++)
+         absorbed[i]->decRef();
    }
 
-   ~DatabaseAccessThread()
+
+   // Returns our metrics since the last call, and starts counting afresh
+   DatabaseAccessStats takeStats()
    {
-      terminate();
-   }
+      DatabaseAccessStats stats;
 
+      mLock.lock();
+
+      stats.queued = (U32)mQueue.size();
+      stats.maxQueued = mMaxQueued;
+      stats.completed = mCompleted;
+      stats.batches = mBatches;
+      stats.averageLatency = mCompleted > 0 ? F32(mTotalLatency) / mCompleted : 0;
+      stats.maxLatency = mMaxLatency;
+
+      mMaxQueued = stats.queued;
+      mCompleted = 0;
+      mBatches = 0;
+      mTotalLatency = 0;
+      mMaxLatency = 0;
+
+      mLock.unlock();
+
+      return stats;
+   }
 };
 
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,338 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "GlobalChat.h"
+
+#include "MasterServerConnection.h"
+
+#include "../zap/Intervals.h"
+
+#include <set>
+
+namespace Master
+{
+
+static const S32 MaxNicksPerMessage = IP_MESSAGE_ADDRESS_COUNT;
+
+
+// Most bytes a string can take up in an RPC: writeString() sends it uncompressed when Huffman coding wouldn't make it
+// any smaller, after a couple of bytes of flags and length
+static U32 getMaxEncodedSize(const string &str)
+{
+   return (U32)str.length() + 2;
+}
+
+
+// Nicks also carry their string table id
+static U32 getMaxEncodedSize(const StringTableEntry &nick)
+{
+   return getMaxEncodedSize(string(nick.getString())) + 2;
+}
+
+
+// Leaves go first, so a message never has any joins before its leaves
+void GlobalChat::buildNickChunks(const Vector<StringTableEntry> &left, const Vector<StringTableEntry> &joined,
+                                 Vector<NickChunk> &chunks)
+{
+   S32 total = left.size() + joined.size();
+
+   for(S32 i = 0; i < total; i++)
+   {
+      const StringTableEntry &nick = i < left.size() ? left[i] : joined[i - left.size()];
+      U32 size = getMaxEncodedSize(nick);
+
+      if(chunks.size() == 0 || chunks.last().left.size() + chunks.last().joined.size() == MaxNicksPerMessage ||
+            chunks.last().size + size > MaxChunkSize)
+      {
+         chunks.push_back(NickChunk());
+         chunks.last().size = 2;          // Both vectors' lengths
+      }
+
+      if(i < left.size())
+         chunks.last().left.push_back(nick);
+      else
+         chunks.last().joined.push_back(nick);
+
+      chunks.last().size += size;
+   }
+}
+
+
+void GlobalChat::sendNickChanges(MasterServerConnection *recipient, const Vector<StringTableEntry> &left,
+                                 const Vector<StringTableEntry> &joined, const Vector<NickChunk> &chunks)
+{
+   if(recipient->supports024Rpcs())
+   {
+      for(S32 i = 0; i < chunks.size(); i++)
+         recipient->m2cGlobalChatChanged(chunks[i].left, chunks[i].joined);
+   }
+   else     // Older clients get one at a time
+   {
+      for(S32 i = 0; i < left.size(); i++)
+         recipient->m2cPlayerLeftGlobalChat(left[i]);
+
+      for(S32 i = 0; i < joined.size(); i++)
+         recipient->m2cPlayerJoinedGlobalChat(joined[i]);
+   }
+}
+
+
+void GlobalChat::addToChatChunks(const StringTableEntry &nick, const string &message, Vector<ChatChunk> &chunks)
+{
+   U32 size = getMaxEncodedSize(nick) + getMaxEncodedSize(message);
+
+   if(chunks.size() == 0 || chunks.last().size + size > MaxChunkSize)
+   {
+      chunks.push_back(ChatChunk());
+      chunks.last().size = 2;             // Both vectors' lengths
+   }
+
+   chunks.last().nicks.push_back(nick);
+   chunks.last().messages.push_back(message);
+   chunks.last().size += size;
+}
+
+
+void GlobalChat::sendChatChunks(MasterServerConnection *recipient, const Vector<ChatChunk> &chunks)
+{
+   bool batched = recipient->supports024Rpcs();
+
+   for(S32 i = 0; i < chunks.size(); i++)
+   {
+      if(batched)
+         recipient->m2cSendChats(chunks[i].nicks, chunks[i].messages);
+      else
+         for(S32 j = 0; j < chunks[i].messages.size(); j++)
+            recipient->m2cSendChat(chunks[i].nicks[j], false, chunks[i].messages[j].c_str());
+   }
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+GlobalChat::GlobalChat(const Vector<MasterServerConnection *> *clientList)
+{
+   mClientList = clientList;
+}
+
+
+void GlobalChat::join(MasterServerConnection *client)
+{
+   // Tell them who's here, to avoid a blank name list if they quickly leave and join.  We leave out anyone whose
+   // arrival hasn't been announced yet; they'll hear about them along with everyone else.
+   Vector<StringTableEntry> nicks;
+
+   for(map<S32, MasterServerConnection *>::const_iterator it = mMembers.begin(); it != mMembers.end(); it++)
+      if(it->second != client && mPendingJoins.find(it->first) == mPendingJoins.end())
+         nicks.push_back(it->second->mPlayerOrServerName);
+
+   if(nicks.size() > 0)
+      client->m2cPlayersInGlobalChat(nicks);
+
+   if(client->mIsIgnoredFromList)                  // Don't list name in lobby, either
+      return;
+
+   client->mLeaveGlobalChatTimer = 0;              // Don't continue with delayed chat leave
+   if(client->isInGlobalChat)                      // Already in global chat
+      return;
+
+   client->isInGlobalChat = true;
+   mMembers[client->getClientId()] = client;
+   mPendingJoins[client->getClientId()] = client->mPlayerOrServerName;
+}
+
+
+// Using delayed leave, to avoid quickly join / leave problem
+void GlobalChat::leave(MasterServerConnection *client)
+{
+   if(!client->isInGlobalChat)
+      return;
+
+   // "-20" make up for inaccurate getRealMilliseconds going backwards by 1 or 2 milliseconds
+   client->mLeaveGlobalChatTimer = Platform::getRealMilliseconds() - 20;
+   mLeaving.push_back(client);
+}
+
+
+void GlobalChat::leaveNow(MasterServerConnection *client)
+{
+   removeMember(client);
+}
+
+
+// Everyone else sees them leave under their old name, and join under the new one
+void GlobalChat::rename(MasterServerConnection *client, const StringTableEntry &newNick)
+{
+   if(!client->isInGlobalChat)
+      return;
+
+   map<S32, StringTableEntry>::iterator it = mPendingJoins.find(client->getClientId());
+
+   if(it != mPendingJoins.end())          // Nobody has heard of the old name yet
+   {
+      it->second = newNick;
+      return;
+   }
+
+   MembershipChange change;
+   change.clientId = client->getClientId();
+   change.nick = client->mPlayerOrServerName;
+   mPendingLeaves.push_back(change);
+
+   mPendingJoins[client->getClientId()] = newNick;
+}
+
+
+void GlobalChat::relayMessage(MasterServerConnection *sender, const char *message)
+{
+   ChatMessage chatMessage;
+   chatMessage.clientId = sender->getClientId();
+   chatMessage.nick = sender->mPlayerOrServerName;
+   chatMessage.message = message;
+
+   mPendingMessages.push_back(chatMessage);
+}
+
+
+void GlobalChat::removeMember(MasterServerConnection *member)
+{
+   if(!member->isInGlobalChat)
+      return;
+
+   member->isInGlobalChat = false;
+   member->mLeaveGlobalChatTimer = 0;
+
+   S32 clientId = member->getClientId();
+   mMembers.erase(clientId);
+
+   // Either nobody was told they'd arrived, or they were renamed, and are already leaving under their old name
+   if(mPendingJoins.erase(clientId) > 0)
+      return;
+
+   MembershipChange change;
+   change.clientId = clientId;
+   change.nick = member->mPlayerOrServerName;
+   mPendingLeaves.push_back(change);
+}
+
+
+void GlobalChat::idle(U32 currentTime)
+{
+   // Process any delayed leaves
+   for(S32 i = mLeaving.size() - 1; i >= 0; i--)
+   {
+      MasterServerConnection *client = mLeaving[i];
+
+      if(!client || client->mLeaveGlobalChatTimer == 0)
+         mLeaving.erase_fast(i);
+
+      else if(currentTime - client->mLeaveGlobalChatTimer > (U32)ONE_SECOND)
+      {
+         removeMember(client);
+         mLeaving.erase_fast(i);
+      }
+   }
+
+   sendMembershipChanges();
+   sendMessages();
+}
+
+
+void GlobalChat::sendMembershipChanges()
+{
+   if(mPendingLeaves.size() == 0 && mPendingJoins.size() == 0)
+      return;
+
+   Vector<StringTableEntry> left, joined;
+   left.reserve(mPendingLeaves.size());
+   joined.reserve((S32)mPendingJoins.size());
+
+   for(S32 i = 0; i < mPendingLeaves.size(); i++)
+      left.push_back(mPendingLeaves[i].nick);
+
+   for(map<S32, StringTableEntry>::const_iterator it = mPendingJoins.begin(); it != mPendingJoins.end(); it++)
+      joined.push_back(it->second);
+
+   Vector<NickChunk> chunks;
+   buildNickChunks(left, joined, chunks);
+
+   for(map<S32, MasterServerConnection *>::const_iterator it = mMembers.begin(); it != mMembers.end(); it++)
+   {
+      // Members who just joined or were renamed don't need to hear about themselves.  Everyone who left is no
+      // longer a member, so everyone else gets the same thing.
+      if(mPendingJoins.find(it->first) == mPendingJoins.end())
+      {
+         sendNickChanges(it->second, left, joined, chunks);
+         continue;
+      }
+
+      Vector<StringTableEntry> theirLeft, theirJoined;
+
+      for(S32 i = 0; i < mPendingLeaves.size(); i++)
+         if(mPendingLeaves[i].clientId != it->first)
+            theirLeft.push_back(mPendingLeaves[i].nick);
+
+      for(map<S32, StringTableEntry>::const_iterator join = mPendingJoins.begin(); join != mPendingJoins.end(); join++)
+         if(join->first != it->first)
+            theirJoined.push_back(join->second);
+
+      Vector<NickChunk> theirChunks;
+      buildNickChunks(theirLeft, theirJoined, theirChunks);
+      sendNickChanges(it->second, theirLeft, theirJoined, theirChunks);
+   }
+
+   mPendingLeaves.clear();
+   mPendingJoins.clear();
+}
+
+
+// Chat goes to every client, in the lobby or not, except whoever sent it
+void GlobalChat::sendMessages()
+{
+   if(mPendingMessages.size() == 0)
+      return;
+
+   Vector<ChatChunk> chunks;
+   set<S32> senders;
+
+   for(S32 i = 0; i < mPendingMessages.size(); i++)
+   {
+      addToChatChunks(mPendingMessages[i].nick, mPendingMessages[i].message, chunks);
+      senders.insert(mPendingMessages[i].clientId);
+   }
+
+   for(S32 i = 0; i < mClientList->size(); i++)
+   {
+      MasterServerConnection *client = mClientList->get(i);
+      S32 clientId = client->getClientId();
+
+      if(senders.find(clientId) == senders.end())
+      {
+         sendChatChunks(client, chunks);
+         continue;
+      }
+
+      Vector<ChatChunk> theirChunks;
+
+      for(S32 j = 0; j < mPendingMessages.size(); j++)
+         if(mPendingMessages[j].clientId != clientId)
+            addToChatChunks(mPendingMessages[j].nick, mPendingMessages[j].message, theirChunks);
+
+      sendChatChunks(client, theirChunks);
+   }
+
+   mPendingMessages.clear();
+}
+
+
+S32 GlobalChat::getMemberCount() const
+{
+   return (S32)mMembers.size();
+}
+
+
+}
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _GLOBAL_CHAT_H_
+#define _GLOBAL_CHAT_H_
+
+#include "tnlNetBase.h"
+#include "tnlNetStringTable.h"
+#include "tnlVector.h"
+
+#include <map>
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Master
+{
+
+class MasterServerConnection;
+
+
+// Keeps track of who is in global chat, and tells everyone about comings, goings, and messages.  Rather than sending
+// each of those to every client as it happens, we save them up and send them all at once in sendChanges(), so a rush
+// of players arriving or leaving costs each client a message or two per tick rather than one per player.
+class GlobalChat
+{
+private:
+   struct MembershipChange
+   {
+      S32 clientId;                       // Who joined or left; they don't need telling themselves
+      StringTableEntry nick;
+   };
+
+   struct ChatMessage
+   {
+      S32 clientId;                       // Who sent it; they won't get it back
+      StringTableEntry nick;
+      string message;
+   };
+
+   // m2cGlobalChatChanged and m2cSendChats aren't BigData RPCs, so each has to fit in a single packet.  We fill them
+   // up to this many bytes, as sent in the worst case, leaving room for the packet's headers.
+   static const U32 MaxChunkSize = 400;
+
+   // One m2cGlobalChatChanged worth of nicks
+   struct NickChunk
+   {
+      Vector<StringTableEntry> left;
+      Vector<StringTableEntry> joined;
+      U32 size;                           // Most bytes it could take up on the wire
+   };
+
+   // One m2cSendChats worth of messages
+   struct ChatChunk
+   {
+      Vector<StringTableEntry> nicks;
+      Vector<string> messages;
+      U32 size;                           // Likewise
+   };
+
+   const Vector<MasterServerConnection *> *mClientList;     // Everyone who gets chat messages
+
+   map<S32, MasterServerConnection *> mMembers;             // Client id -> member, for everyone in chat
+   Vector<SafePtr<MasterServerConnection> > mLeaving;       // Members who have asked to leave, but not yet left
+
+   // Not yet sent.  Clients apply leaves before joins, so a member who changes name leaves under the old one, and
+   // joins under the new.
+   Vector<MembershipChange> mPendingLeaves;
+   map<S32, StringTableEntry> mPendingJoins;                // Client id -> nick to announce
+   Vector<ChatMessage> mPendingMessages;
+
+   static void buildNickChunks(const Vector<StringTableEntry> &left, const Vector<StringTableEntry> &joined,
+                               Vector<NickChunk> &chunks);
+   static void sendNickChanges(MasterServerConnection *recipient, const Vector<StringTableEntry> &left,
+                               const Vector<StringTableEntry> &joined, const Vector<NickChunk> &chunks);
+
+   static void addToChatChunks(const StringTableEntry &nick, const string &message, Vector<ChatChunk> &chunks);
+   static void sendChatChunks(MasterServerConnection *recipient, const Vector<ChatChunk> &chunks);
+
+   void removeMember(MasterServerConnection *member);
+
+   void sendMembershipChanges();
+   void sendMessages();
+
+   friend class GlobalChatTest;
+
+public:
+   explicit GlobalChat(const Vector<MasterServerConnection *> *clientList);    // Constructor
+
+   void join(MasterServerConnection *client);
+   void leave(MasterServerConnection *client);      // Leaves after a second, unless client joins again first
+   void leaveNow(MasterServerConnection *client);   // For when client disconnects
+   void rename(MasterServerConnection *client, const StringTableEntry &newNick);
+
+   void relayMessage(MasterServerConnection *sender, const char *message);
+
+   void idle(U32 currentTime);                      // Deal with delayed leaves, and send everything we've saved up
+
+   S32 getMemberCount() const;
+};
+
+}
+
+#endif
@@ -61,6 +61,7 @@ MasterServerConnection::MasterServerConnection()
    setIsConnectionToClient();
    setIsAdaptive();
    isInGlobalChat = false;
+   mLeaveGlobalChatTimer = 0;
    mAuthenticated = false;
    mIsDebugClient = false;
    mIsIgnoredFromList = false;
@@ -76,14 +77,7 @@ MasterServerConnection::MasterServerConnection()
 MasterServerConnection::~MasterServerConnection()
 {
    // If we're in global chat, announce to anyone else in global chat that we are leaving
-   if(isInGlobalChat)
-   {
-      const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-      for(S32 i = 0; i < clientList->size(); i++)
-         if(clientList->get(i)->isInGlobalChat && clientList->get(i) != this)
-            clientList->get(i)->m2cPlayerLeftGlobalChat(mPlayerOrServerName);
-   }
+   mMaster->getGlobalChat()->leaveNow(this);
 
 
    // Remove this from the client/server lists
@@ -264,21 +258,7 @@ void MasterServerConnection::processAutentication(StringTableEntry newName, PHPB
 
       if(mPlayerOrServerName != newName)
       {
-         if(isInGlobalChat)         // Need to tell clients new name, in case of delayed authentication
-         {
-            const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-            for(S32 i = 0; i < clientList->size(); i++)
-            {
-               MasterServerConnection *client = clientList->get(i);
-
-               if(client != this && client->isInGlobalChat)
-               {
-                  client->m2cPlayerLeftGlobalChat(mPlayerOrServerName);
-                  client->m2cPlayerJoinedGlobalChat(newName);
-               }
-            }
-         }
+         mMaster->getGlobalChat()->rename(this, newName);    // Need to tell clients new name, in case of delayed authentication
          mPlayerOrServerName = newName;
       }
 
@@ -331,54 +311,19 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mQueryHostServers, (U32 que
 }
 void MasterServerConnection::c2mQueryServersOption(U32 queryId, bool hostonly)
 {
-   Vector<IPAddress> addresses(IP_MESSAGE_ADDRESS_COUNT);
-   Vector<S32> serverIdList(IP_MESSAGE_ADDRESS_COUNT);
-
-   Vector<StringTableEntry> serverNames(IP_MESSAGE_ADDRESS_COUNT);
-
-   const Vector<MasterServerConnection *> *serverList = mMaster->getServerList();
-
-   for(S32 i = 0; i < serverList->size(); i++)
-   {
-      // Hide hidden servers
-      if(serverList->get(i)->mIsIgnoredFromList)
-         continue;
-
-      // Skip servers with incompatible versions
-      if(serverList->get(i)->mCSProtocolVersion != mCSProtocolVersion)
-         continue;
-
-      // Skip servers with host mode
-      if(((serverList->get(i)->mInfoFlags & HostModeFlag) != 0) != hostonly)
-         continue;
+   mMaster->getServerListCache()->sendServerList(this, queryId, hostonly);
+}
 
-      // Add us to the results list
-      addresses.push_back(serverList->get(i)->getNetAddress().toIPAddress());
-      serverIdList.push_back(serverList->get(i)->getClientId());
-	  serverNames.push_back(serverList->get(i)->mPlayerOrServerName);
 
-      // If we get a packet's worth, send it to the client and empty our buffer...
-      if(addresses.size() == IP_MESSAGE_ADDRESS_COUNT)
-      {
-         sendM2cQueryServersResponse(queryId, addresses, serverIdList, serverNames);
-         addresses.clear();
-         serverIdList.clear();
-		 serverNames.clear();
-      }
-   }
+TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSubscribeServerList, (U32 queryId, bool hostOnly))
+{
+   mMaster->getServerListCache()->subscribe(this, queryId, hostOnly);
+}
 
-   // Send the final packet
-   sendM2cQueryServersResponse(queryId, addresses, serverIdList, serverNames);
 
-   // If we sent any with the previous message, send another list with no servers
-   if(addresses.size())
-   {
-      addresses.clear();
-      serverIdList.clear();
-	  serverNames.clear();
-
-      sendM2cQueryServersResponse(queryId, addresses, serverIdList, serverNames);
-   }
+TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mUnsubscribeServerList, ())
+{
+   mMaster->getServerListCache()->unsubscribe(this);
 }
 
 
@@ -397,6 +342,12 @@ void MasterServerConnection::sendM2cQueryServersResponse(U32 queryId, const Vect
 }
 
 
+void MasterServerConnection::sendServerListChanges(U32 queryId, const ServerListChunk &added, const Vector<S32> &removedServerIds)
+{
+   m2cServerListChanged(queryId, added.addresses, added.serverIds, added.serverNames, removedServerIds);
+}
+
+
 void MasterServerConnection::setMasterServer(MasterServer *master)
 {
    mMaster = master;
@@ -506,6 +457,20 @@ static bool listClient(MasterServerConnection *client)
 }
 
 
+// This server's entry in the JSON file.  Most servers don't change between writes, so we hang on to it until they do.
+const string &MasterServerConnection::getServerJson()
+{
+   if(mServerJson == "")
+      mServerJson = "\n\t\t{\n\t\t\t\"serverName\": \"" + sanitizeForJson(mPlayerOrServerName.getString()) +
+                    "\",\n\t\t\t\"protocolVersion\": " + itos(mCSProtocolVersion) +
+                    ",\n\t\t\t\"currentLevelName\": \"" + sanitizeForJson(mLevelName.getString()) +
+                    "\",\n\t\t\t\"currentLevelType\": \"" + sanitizeForJson(mLevelType.getString()) +
+                    "\",\n\t\t\t\"playerCount\": " + itos(mPlayerCount) + "\n\t\t}";
+
+   return mServerJson;
+}
+
+
 // Write a current count of clients/servers for display on a website, using JSON format
 // This gets updated whenever we gain or lose a server, at most every 5 seconds (currently)
 void MasterServerConnection::writeClientServerList_JSON()
@@ -520,64 +485,66 @@ void MasterServerConnection::writeClientServerList_JSON()
    S32 playerCount = 0;
    S32 serverCount = 0;
 
-   FILE *f = fopen(jsonfile.c_str(), "w");
-   if(f)
-   {
-      // First the servers
-      fprintf(f, "{\n\t\"servers\": [");
+   // Build it all up, then write it in one go
+   string json = "{\n\t\"servers\": [";
 
-      const Vector<MasterServerConnection *> *serverList = mMaster->getServerList();
+   // First the servers
+   const Vector<MasterServerConnection *> *serverList = mMaster->getServerList();
 
-      for(S32 i = 0; i < serverList->size(); i++)
-      {
-         MasterServerConnection *server = serverList->get(i);
+   for(S32 i = 0; i < serverList->size(); i++)
+   {
+      MasterServerConnection *server = serverList->get(i);
 
-         if(server->mIsIgnoredFromList)
-            continue;
+      if(server->mIsIgnoredFromList)
+         continue;
 
-         fprintf(f, "%s\n\t\t{\n\t\t\t\"serverName\": \"%s\",\n\t\t\t\"protocolVersion\": %d,\n\t\t\t\"currentLevelName\": \"%s\",\n\t\t\t\"currentLevelType\": \"%s\",\n\t\t\t\"playerCount\": %d\n\t\t}",
-                     first ? "" : ", ", sanitizeForJson(server->mPlayerOrServerName.getString()).c_str(),
-                     server->mCSProtocolVersion, server->mLevelName.getString(), server->mLevelType.getString(), server->mPlayerCount);
-         playerCount += server->mPlayerCount;
-         serverCount++;
-         first = false;
-      }
+      if(!first)
+         json += ", ";
 
-      // Next the player names      // "players": [ "chris", "colin", "fred", "george", "Peter99" ],
-      fprintf(f, "\n\t],\n\t\"players\": [");
-      first = true;
+      json += server->getServerJson();
+      playerCount += server->mPlayerCount;
+      serverCount++;
+      first = false;
+   }
+
+   // Next the player names      // "players": [ "chris", "colin", "fred", "george", "Peter99" ],
+   json += "\n\t],\n\t\"players\": [";
+   first = true;
 
-      const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
+   const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
 
-      for(S32 i = 0; i < clientList->size(); i++)
+   for(S32 i = 0; i < clientList->size(); i++)
+   {
+      if(listClient(clientList->get(i)))
       {
-         if(listClient(clientList->get(i)))
-         {
-            fprintf(f, "%s\"%s\"", first ? "" : ", ", sanitizeForJson(clientList->get(i)->mPlayerOrServerName.getString()).c_str());
-            first = false;
-         }
+         json += string(first ? "" : ", ") + "\"" + sanitizeForJson(clientList->get(i)->mPlayerOrServerName.getString()) + "\"";
+         first = false;
       }
+   }
 
-      // Authentication status      // "authenticated": [ true, false, false, true, true ],
-      fprintf(f, "],\n\t\"authenticated\": [");
-      first = true;
+   // Authentication status      // "authenticated": [ true, false, false, true, true ],
+   json += "],\n\t\"authenticated\": [";
+   first = true;
 
-      for(S32 i = 0; i < clientList->size(); i++)
+   for(S32 i = 0; i < clientList->size(); i++)
+   {
+      if(listClient(clientList->get(i)))
       {
-         if(listClient(clientList->get(i)))
-         {
-            fprintf(f, "%s%s", first ? "" : ", ", clientList->get(i)->mAuthenticated ? "true" : "false");
-            first = false;
-         }
+         json += string(first ? "" : ", ") + (clientList->get(i)->mAuthenticated ? "true" : "false");
+         first = false;
       }
+   }
 
-      // Finally, the player and server counts
-      fprintf(f, "],\n\t\"serverCount\": %d,\n\t\"playerCount\": %d,\n", serverCount, playerCount);
+   // Finally, the player and server counts
+   json += "],\n\t\"serverCount\": " + itos(serverCount) + ",\n\t\"playerCount\": " + itos(playerCount) + ",\n";
 
-      // And the message-of-the-day
-      fprintf(f, "\t\"motd\": \"%s\"\n}\n", sanitizeForJson(mMaster->getSettings()->getMotd().c_str()).c_str());
+   // And the message-of-the-day
+   json += "\t\"motd\": \"" + sanitizeForJson(mMaster->getSettings()->getMotd().c_str()) + "\"\n}\n";
 
-      fflush(f);
+   FILE *f = fopen(jsonfile.c_str(), "w");
+   if(f)
+   {
+      fwrite(json.c_str(), 1, json.length(), f);
       fclose(f);
    }
    else
@@ -753,6 +720,9 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, s2mUpdateServerStatus, (Strin
       mMaxPlayers  = maxPlayers;
       mInfoFlags   = infoFlags;
 
+      mServerJson.clear();
+      mMaster->getServerListCache()->updateServer(this);    // In case it's switched into or out of host mode
+
       // Check to ensure we're not getting flooded with these requests
       checkActivityTime(FOUR_SECONDS);
 
@@ -798,7 +768,7 @@ void MasterServerConnection::processIsAuthenticated(GameStats *gameStats)
 
 struct AddGameReport : public MasterThreadEntry
 {
-   GameStats mStats;
+   Vector<GameStats> mStats;
 
    AddGameReport(const MasterSettings *settings) : MasterThreadEntry(settings) { }    // Quickie constructor
 
@@ -808,6 +778,20 @@ struct AddGameReport : public MasterThreadEntry
       // Will fail if compiled without database support and gWriteStatsToDatabase is true
       databaseWriter.insertStats(mStats);
    }
+
+   // Reports that pile up behind us get written in the same transaction
+   bool absorb(ThreadEntry *entry)
+   {
+      AddGameReport *report = dynamic_cast<AddGameReport *>(entry);
+
+      if(!report || report->mSettings != mSettings)
+         return false;
+
+      for(S32 i = 0; i < report->mStats.size(); i++)
+         mStats.push_back(report->mStats[i]);
+
+      return true;
+   }
 };
 
 void MasterServerConnection::writeStatisticsToDb(VersionedGameStats &stats)
@@ -831,7 +815,7 @@ void MasterServerConnection::writeStatisticsToDb(VersionedGameStats &stats)
    processStatsResults(gameStats);
 
    RefPtr<AddGameReport> gameReport = new AddGameReport(mMaster->getSettings());
-   gameReport->mStats = *gameStats;  // copy so we keep data during a thread
+   gameReport->mStats.push_back(*gameStats);  // copy so we keep data during a thread
    mMaster->getDatabaseAccessThread()->addEntry(gameReport);
 }
 
@@ -1725,46 +1709,13 @@ void MasterServerConnection::onConnectionEstablished()
 
 TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mJoinGlobalChat, ())
 {
-   Vector<StringTableEntry> names;
-
-   const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-   for(S32 i = 0; i < clientList->size(); i++)
-      if(clientList->get(i) != this && clientList->get(i)->isInGlobalChat)
-         names.push_back(clientList->get(i)->mPlayerOrServerName);
-
-   if(names.size() > 0)
-      m2cPlayersInGlobalChat(names);   // Send to this client, to avoid blank name list of quickly leave/join
-
-   if(mIsIgnoredFromList)              // don't list name in lobby, too.
-      return;
-
-   mLeaveGlobalChatTimer = 0;          // don't continue with delayed chat leave.
-   if(isInGlobalChat)                  // Already in Global Chat
-      return;
-
-   isInGlobalChat = true;
-
-   for(S32 i = 0; i < clientList->size(); i++)
-      if(clientList->get(i) != this && clientList->get(i)->isInGlobalChat)
-         clientList->get(i)->m2cPlayerJoinedGlobalChat(mPlayerOrServerName);
+   mMaster->getGlobalChat()->join(this);
 }
 
 
 TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mLeaveGlobalChat, ())
 {
-   if(!isInGlobalChat)  // was not in Global Chat
-      return;
-
-   // using delayed leave, to avoid quickly join / leave problem.
-   mLeaveGlobalChatTimer = Platform::getRealMilliseconds() - 20; // "-20" make up for inaccurate getRealMilliseconds going backwards by 1 or 2 milliseconds.
-   gLeaveChatTimerList.push_back(this);
-
-   //isInGlobalChat = false;
-   //Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-   //for(S32 i = 0; i < clientList->size(); i++)
-   //   if (clientList->get(i) != this && clientList->get(i)->isInGlobalChat)
-   //      clientList->get(i)->m2cPlayerLeftGlobalChat(mPlayerOrServerName);
+   mMaster->getGlobalChat()->leave(this);
 }
 
 
@@ -1804,6 +1755,7 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
                if(server->getNetAddress().isEqualAddress(addr) && (addr.port == 0 || addr.port == server->getNetAddress().port))
                {
                   server->mIsIgnoredFromList = true;
+                  mMaster->getServerListCache()->updateServer(server);
                   m2cSendChat(server->mPlayerOrServerName, true, "dropped");
                   droppedServer = true;
                }
@@ -1823,6 +1775,7 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
                {
                   broughtBackServer = true;
                   serverList->get(i)->mIsIgnoredFromList = false;
+                  mMaster->getServerListCache()->updateServer(serverList->get(i));
                   m2cSendChat(serverList->get(i)->mPlayerOrServerName, true, "servers restored");
                }
             if(!broughtBackServer)
@@ -1933,17 +1886,9 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
    mChatTooFast = false;
 
 
-   // Now relay the chat to all connected clients
+   // Now relay the chat to all connected clients, except self
    if(!badCommand && !isPrivate)
-   {
-      const  Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-      for(S32 i = 0; i < clientList->size(); i++)
-      {
-         if(clientList->get(i) != this)    // ...except self!
-            clientList->get(i)->m2cSendChat(mPlayerOrServerName, isPrivate, message);
-      }
-   }
+      mMaster->getGlobalChat()->relayMessage(this, message.getString());
 
 
    // Log F5 chat messages
@@ -1958,6 +1903,8 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, s2mChangeName, (StringTableEn
    if(mConnectionType == MasterConnectionTypeServer)  // server only, don't want clients to rename yet (client names need to authenticate)
    {
       mPlayerOrServerName = name;
+      mServerJson.clear();
+      mMaster->getServerListCache()->updateServer(this);
       mMaster->writeJsonNow();  // update server name in ".json"
    }
 }
@@ -1970,7 +1917,6 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, s2mServerDescription, (String
 TNL_IMPLEMENT_NETCONNECTION(MasterServerConnection, NetClassGroupMaster, true);
 
 Vector< GameConnectRequest* > MasterServerConnection::gConnectList;
-Vector<SafePtr<MasterServerConnection> > MasterServerConnection::gLeaveChatTimerList;
 
 
 }
@@ -9,6 +9,7 @@
 
 #include "GameConnectRequest.h"
 #include "masterInterface.h"
+#include "ServerListCache.h"
 
 #include "../zap/ChatCheck.h"
 #include "../zap/Intervals.h"
@@ -116,13 +117,16 @@ private:
    MasterConnectionType mConnectionType;
    static MasterServer *mMaster;
 
+   string mServerJson;                 // This server's entry in the JSON file, built when needed; empty if out of date
+   const string &getServerJson();
+
+public:
    void sendM2cQueryServersResponse(U32 queryId, const Vector<IPAddress> &addresses,
 	                                             const Vector<S32> &serverIdList,
 	                                             const Vector<StringTableEntry> &serverNames);
+   void sendServerListChanges(U32 queryId, const ServerListChunk &added, const Vector<S32> &removedServerIds);
 
 
-public:
-
    ///
 public:
    static Vector<GameConnectRequest *> gConnectList;
@@ -173,7 +177,6 @@ public:
    StringTableEntry mAutoDetectStr;             // Player's joystick autodetect string, for research purposes
 
 public:
-   static Vector<SafePtr<MasterServerConnection> > gLeaveChatTimerList;
    U32 mLeaveGlobalChatTimer;
    bool mChatTooFast;
 
@@ -213,6 +216,10 @@ public:
    TNL_DECLARE_RPC_OVERRIDE(c2mQueryHostServers, (U32 queryId));
    void c2mQueryServersOption(U32 queryId, bool hostonly);
 
+   // Newer clients subscribe instead, and are sent changes to the list as they happen
+   TNL_DECLARE_RPC_OVERRIDE(c2mSubscribeServerList, (U32 queryId, bool hostOnly));
+   TNL_DECLARE_RPC_OVERRIDE(c2mUnsubscribeServerList, ());
+
    /// checkActivityTime validates that this particular connection is
    /// not issuing too many requests at once in an attempt to DOS
    /// by flooding either the master server or any other server
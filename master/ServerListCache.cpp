@@ -0,0 +1,275 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "ServerListCache.h"
+
+#include "MasterServerConnection.h"
+
+#include "../zap/SharedConstants.h"    // For HostModeFlag
+
+namespace Master
+{
+
+// Updates the server if it's already listed
+void ServerListCache::ServerList::add(const IPAddress &address, S32 serverId, const StringTableEntry &serverName)
+{
+   S32 index = find(serverId);
+
+   if(index == -1)
+   {
+      if(chunks.size() == 0 || chunks.last().addresses.size() == IP_MESSAGE_ADDRESS_COUNT)
+         chunks.push_back(ServerListChunk());
+
+      ServerListChunk &chunk = chunks.last();
+      positions[serverId] = (chunks.size() - 1) * IP_MESSAGE_ADDRESS_COUNT + chunk.addresses.size();
+
+      chunk.addresses.push_back(address);
+      chunk.serverIds.push_back(serverId);
+      chunk.serverNames.push_back(serverName);
+   }
+   else
+   {
+      ServerListChunk &chunk = chunks[index / IP_MESSAGE_ADDRESS_COUNT];
+      S32 i = index % IP_MESSAGE_ADDRESS_COUNT;
+
+      chunk.addresses[i] = address;
+      chunk.serverNames[i] = serverName;
+   }
+}
+
+
+// Fills the gap with the last server on the list, so the chunks stay packed
+void ServerListCache::ServerList::remove(S32 serverId)
+{
+   S32 index = find(serverId);
+
+   if(index == -1)
+      return;
+
+   ServerListChunk &last = chunks.last();
+   S32 lastIndex = (chunks.size() - 1) * IP_MESSAGE_ADDRESS_COUNT + last.addresses.size() - 1;
+
+   if(index != lastIndex)
+   {
+      ServerListChunk &chunk = chunks[index / IP_MESSAGE_ADDRESS_COUNT];
+      S32 i = index % IP_MESSAGE_ADDRESS_COUNT;
+
+      chunk.addresses[i] = last.addresses.last();
+      chunk.serverIds[i] = last.serverIds.last();
+      chunk.serverNames[i] = last.serverNames.last();
+
+      positions[chunk.serverIds[i]] = index;
+   }
+
+   last.addresses.pop_back();
+   last.serverIds.pop_back();
+   last.serverNames.pop_back();
+
+   if(last.addresses.size() == 0)
+      chunks.pop_back();
+
+   positions.erase(serverId);
+}
+
+
+S32 ServerListCache::ServerList::find(S32 serverId) const
+{
+   map<S32, S32>::const_iterator it = positions.find(serverId);
+   return it == positions.end() ? -1 : it->second;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+ServerListCache::ListKey ServerListCache::getKey(const MasterServerConnection *server)
+{
+   return ListKey(server->mCSProtocolVersion, (server->mInfoFlags & HostModeFlag) != 0);
+}
+
+
+bool ServerListCache::isListed(const MasterServerConnection *server)
+{
+   return !server->mIsIgnoredFromList;
+}
+
+
+void ServerListCache::removeFromList(S32 serverId)
+{
+   map<S32, ListedServer>::iterator it = mListedServers.find(serverId);
+
+   if(it == mListedServers.end())
+      return;
+
+   ServerList &list = mLists[it->second.key];
+   list.remove(serverId);
+
+   list.pendingAdds.erase(serverId);
+   list.pendingRemoves.insert(serverId);
+
+   mListedServers.erase(it);
+}
+
+
+// Puts the server on the right list, or takes it off if it shouldn't be listed
+void ServerListCache::updateServer(MasterServerConnection *server)
+{
+   S32 serverId = server->getClientId();
+
+   if(!isListed(server))
+   {
+      removeFromList(serverId);
+      return;
+   }
+
+   ListKey key = getKey(server);
+   map<S32, ListedServer>::iterator it = mListedServers.find(serverId);
+
+   if(it != mListedServers.end())
+   {
+      if(it->second.key == key && it->second.name == server->mPlayerOrServerName)
+         return;     // Nothing anyone can see has changed
+
+      if(it->second.key != key)
+         removeFromList(serverId);
+   }
+
+   ListedServer &listed = mListedServers[serverId];
+   listed.key = key;
+   listed.name = server->mPlayerOrServerName;
+
+   ServerList &list = mLists[key];
+   list.add(server->getNetAddress().toIPAddress(), serverId, server->mPlayerOrServerName);
+
+   list.pendingRemoves.erase(serverId);
+   list.pendingAdds.insert(serverId);
+}
+
+
+void ServerListCache::removeServer(MasterServerConnection *server)
+{
+   removeFromList(server->getClientId());
+}
+
+
+// Sends the whole list, a chunk at a time, followed by an empty chunk to say that's all
+void ServerListCache::sendServerList(MasterServerConnection *client, U32 queryId, bool hostOnly)
+{
+   map<ListKey, ServerList>::const_iterator it = mLists.find(ListKey(client->mCSProtocolVersion, hostOnly));
+
+   if(it != mLists.end())
+   {
+      const Vector<ServerListChunk> &chunks = it->second.chunks;
+
+      for(S32 i = 0; i < chunks.size(); i++)
+         client->sendM2cQueryServersResponse(queryId, chunks[i].addresses, chunks[i].serverIds, chunks[i].serverNames);
+   }
+
+   ServerListChunk empty;
+   client->sendM2cQueryServersResponse(queryId, empty.addresses, empty.serverIds, empty.serverNames);
+}
+
+
+// Sends the client the list, then keeps it up to date until it unsubscribes, subscribes to another list, or goes away
+void ServerListCache::subscribe(MasterServerConnection *client, U32 queryId, bool hostOnly)
+{
+   unsubscribe(client);
+
+   sendServerList(client, queryId, hostOnly);
+
+   Subscriber subscriber;
+   subscriber.client = client;
+   subscriber.queryId = queryId;
+
+   mLists[ListKey(client->mCSProtocolVersion, hostOnly)].subscribers.push_back(subscriber);
+}
+
+
+void ServerListCache::unsubscribe(MasterServerConnection *client)
+{
+   for(map<ListKey, ServerList>::iterator it = mLists.begin(); it != mLists.end(); it++)
+   {
+      Vector<Subscriber> &subscribers = it->second.subscribers;
+
+      for(S32 i = subscribers.size() - 1; i >= 0; i--)
+         if(subscribers[i].client == client)
+            subscribers.erase_fast(i);
+   }
+}
+
+
+void ServerListCache::sendChanges(ServerList &list)
+{
+   // Forget subscribers that have disconnected
+   for(S32 i = list.subscribers.size() - 1; i >= 0; i--)
+      if(list.subscribers[i].client.isNull())
+         list.subscribers.erase_fast(i);
+
+   if(list.subscribers.size() > 0)
+   {
+      Vector<ServerListChunk> added;
+      Vector<Vector<S32> > removed;
+
+      for(set<S32>::const_iterator it = list.pendingAdds.begin(); it != list.pendingAdds.end(); it++)
+      {
+         S32 index = list.find(*it);
+         TNLAssert(index != -1, "Pending server should be listed!");
+
+         if(added.size() == 0 || added.last().addresses.size() == IP_MESSAGE_ADDRESS_COUNT)
+            added.push_back(ServerListChunk());
+
+         const ServerListChunk &chunk = list.chunks[index / IP_MESSAGE_ADDRESS_COUNT];
+         S32 i = index % IP_MESSAGE_ADDRESS_COUNT;
+
+         added.last().addresses.push_back(chunk.addresses[i]);
+         added.last().serverIds.push_back(chunk.serverIds[i]);
+         added.last().serverNames.push_back(chunk.serverNames[i]);
+      }
+
+      for(set<S32>::const_iterator it = list.pendingRemoves.begin(); it != list.pendingRemoves.end(); it++)
+      {
+         if(removed.size() == 0 || removed.last().size() == IP_MESSAGE_ADDRESS_COUNT)
+            removed.push_back(Vector<S32>());
+
+         removed.last().push_back(*it);
+      }
+
+      S32 messages = max(added.size(), removed.size());
+      ServerListChunk noneAdded;
+      Vector<S32> noneRemoved;
+
+      for(S32 i = 0; i < list.subscribers.size(); i++)
+         for(S32 j = 0; j < messages; j++)
+            list.subscribers[i].client->sendServerListChanges(list.subscribers[i].queryId,
+                                                              j < added.size()   ? added[j]   : noneAdded,
+                                                              j < removed.size() ? removed[j] : noneRemoved);
+   }
+
+   list.pendingAdds.clear();
+   list.pendingRemoves.clear();
+}
+
+
+// Changes are sent all at once, rather than as they happen, so a burst of them only costs each subscriber one message
+void ServerListCache::sendChanges()
+{
+   for(map<ListKey, ServerList>::iterator it = mLists.begin(); it != mLists.end(); it++)
+      if(it->second.pendingAdds.size() > 0 || it->second.pendingRemoves.size() > 0)
+         sendChanges(it->second);
+}
+
+
+S32 ServerListCache::getServerCount(U32 csProtocolVersion, bool hostOnly) const
+{
+   map<ListKey, ServerList>::const_iterator it = mLists.find(ListKey(csProtocolVersion, hostOnly));
+
+   if(it == mLists.end() || it->second.chunks.size() == 0)
+      return 0;
+
+   return (it->second.chunks.size() - 1) * IP_MESSAGE_ADDRESS_COUNT + it->second.chunks.last().addresses.size();
+}
+
+
+}
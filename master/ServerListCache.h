@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _SERVER_LIST_CACHE_H_
+#define _SERVER_LIST_CACHE_H_
+
+#include "tnlNetBase.h"
+#include "tnlNetStringTable.h"
+#include "tnlUDP.h"
+#include "tnlVector.h"
+
+#include <map>
+#include <set>
+
+using namespace std;
+using namespace TNL;
+
+namespace Master
+{
+
+class MasterServerConnection;
+
+
+// One message's worth of servers, in the form the query response RPCs take them
+struct ServerListChunk
+{
+   Vector<IPAddress> addresses;
+   Vector<S32> serverIds;
+   Vector<StringTableEntry> serverNames;
+};
+
+
+// Keeps the server list each kind of client gets to see ready to send, so answering a query doesn't mean looking at
+// every server we know about.  Lists are updated as servers come, go, and change; clients that support it subscribe,
+// and are sent just what changed.
+class ServerListCache
+{
+private:
+   // Which list a server belongs on: clients only see servers running their protocol, and either host-on-server
+   // servers, or regular ones
+   typedef pair<U32, bool> ListKey;
+
+   struct Subscriber
+   {
+      SafePtr<MasterServerConnection> client;
+      U32 queryId;
+   };
+
+   struct ServerList
+   {
+      Vector<ServerListChunk> chunks;              // All full but the last, which is never empty
+      map<S32, S32> positions;                     // Server id -> index over all chunks
+
+      // Changes not yet sent to subscribers.  A server id is in one or the other, never both, so it doesn't matter
+      // what order the client applies them in.
+      set<S32> pendingAdds;                        // Servers to add, or replace; details come from the list when we send
+      set<S32> pendingRemoves;
+
+      Vector<Subscriber> subscribers;
+
+      void add(const IPAddress &address, S32 serverId, const StringTableEntry &serverName);
+      void remove(S32 serverId);
+      S32 find(S32 serverId) const;                // Index over all chunks, or -1 if not listed
+   };
+
+   struct ListedServer
+   {
+      ListKey key;
+      StringTableEntry name;
+   };
+
+   map<ListKey, ServerList> mLists;
+   map<S32, ListedServer> mListedServers;          // Server id -> where it's listed, and as what
+
+   static ListKey getKey(const MasterServerConnection *server);
+   static bool isListed(const MasterServerConnection *server);
+
+   void removeFromList(S32 serverId);
+   void sendChanges(ServerList &list);
+
+public:
+   void updateServer(MasterServerConnection *server);    // Call when a server arrives, or anything in ListKey changes
+   void removeServer(MasterServerConnection *server);
+
+   void sendServerList(MasterServerConnection *client, U32 queryId, bool hostOnly);
+   void subscribe(MasterServerConnection *client, U32 queryId, bool hostOnly);
+   void unsubscribe(MasterServerConnection *client);
+
+   void sendChanges();                             // Send subscribers anything that changed since last time
+
+   S32 getServerCount(U32 csProtocolVersion, bool hostOnly) const;
+};
+
+}
+
+#endif
@@ -93,31 +93,39 @@ void DatabaseWriter::initialize(const char *server, const char *db, const char *
 #endif
 
 
+// Everything for one player goes in one statement -- INSERT ... SELECT ... UNION ALL works with MySQL as well as with
+// SQLite versions too old to take several rows of VALUES
 static void insertStatsLoadout(const DbQuery &query, U64 playerId, const Vector<LoadoutStats> loadoutStats)
 {
+   if(loadoutStats.size() == 0)
+      return;
+
+   string sql = "INSERT INTO stats_player_loadout(stats_player_id, loadout) ";
+
    for(S32 i = 0; i < loadoutStats.size(); i++)
-   {
-         string sql = "INSERT INTO stats_player_loadout(stats_player_id, loadout) "
-                       "VALUES(" + itos(playerId) + ", " + itos(loadoutStats[i].loadoutHash) + ");";
+      sql += string(i == 0 ? "" : " UNION ALL ") + 
+             "SELECT " + itos(playerId) + ", " + itos(loadoutStats[i].loadoutHash);
 
-         query.runQuery(sql);
-   }
+   query.runQuery(sql + ";");
 }
 
 
 static void insertStatsShots(const DbQuery &query, U64 playerId, const Vector<WeaponStats> weaponStats)
 {
+   string sql;
+
    for(S32 i = 0; i < weaponStats.size(); i++)
    {
       if(weaponStats[i].shots > 0)
       {
-         string sql = "INSERT INTO stats_player_shots(stats_player_id, weapon, shots, shots_struck) "
-                       "VALUES(" + itos(playerId) + ", '" + WeaponInfo::getWeaponName(weaponStats[i].weaponType) + "', " + 
-                                  itos(weaponStats[i].shots) + ", " + itos(weaponStats[i].hits) + ");";
-         
-         query.runQuery(sql);
+         sql += string(sql == "" ? "INSERT INTO stats_player_shots(stats_player_id, weapon, shots, shots_struck) " : " UNION ALL ") +
+                "SELECT " + itos(playerId) + ", '" + WeaponInfo::getWeaponName(weaponStats[i].weaponType) + "', " + 
+                            itos(weaponStats[i].shots) + ", " + itos(weaponStats[i].hits);
       }
    }
+
+   if(sql != "")
+      query.runQuery(sql + ";");
 }
 
 
@@ -275,20 +283,55 @@ U64 DatabaseWriter::getServerIDFromCache(const string &serverName, const string
 
 
 void DatabaseWriter::insertStats(const GameStats &gameStats) 
+{
+   Vector<GameStats> games;
+   games.push_back(gameStats);
+
+   insertStats(games);
+}
+
+
+// Writes all the games in one transaction, on one connection; committing a few dozen rows at a time is a lot kinder
+// to the database than committing them one by one
+void DatabaseWriter::insertStats(const Vector<GameStats> &games) 
 {
    DbQuery query(mDb, mServer, mUser, mPassword);
 
+   if(!query.isValid)
+      return;
+
    try
    {
-      if(query.isValid)
+      // Take SQLite's write lock up front; two deferred transactions that both read, then write, can't both proceed
+      query.runQuery(query.sqliteDb ? "BEGIN IMMEDIATE;" : "BEGIN;");
+   }
+   catch(const Exception &ex) 
+   {
+      logprintf("[%s] Failure writing stats to database: %s", getTimeStamp().c_str(), ex.what());
+      return;
+   }
+
+   // A game that fails to write shouldn't take the rest of the batch down with it
+   for(S32 i = 0; i < games.size(); i++)
+   {
+      try
       {
-         U64 serverId = getServerID(query, gameStats.serverName, gameStats.serverIP);
-         insertStatsGame(query, &gameStats, serverId);
+         U64 serverId = getServerID(query, games[i].serverName, games[i].serverIP);
+         insertStatsGame(query, &games[i], serverId);
       }
+      catch(const Exception &ex) 
+      {
+         logprintf("[%s] Failure writing stats to database: %s", getTimeStamp().c_str(), ex.what());
+      }
+   }
+
+   try
+   {
+      query.runQuery("COMMIT;");
    }
    catch(const Exception &ex) 
    {
-      logprintf("[%s] Failure writing stats to database: %s", getTimeStamp().c_str(), ex.what());
+      logprintf("[%s] Failure committing stats to database: %s", getTimeStamp().c_str(), ex.what());
    }
 }
 
@@ -597,6 +640,8 @@ void DatabaseWriter::setDumpSql(bool dump)
 
 bool DbQuery::dumpSql = false;
 
+static const S32 SqliteBusyTimeout = 5000;   // Ms to wait for a lock held by another connection before giving up
+
 
 // Constructor
 DbQuery::DbQuery(const char *db, const char *server, const char *user, const char *password)
@@ -631,8 +676,11 @@ DbQuery::DbQuery(const char *db, const char *server, const char *user, const cha
       {
          logprintf("ERROR: Can't open stats database %s: %s", db, sqlite3_errmsg(sqliteDb));
          sqlite3_close(sqliteDb);
+         sqliteDb = NULL;
          isValid = false;
       }
+      else
+         sqlite3_busy_timeout(sqliteDb, SqliteBusyTimeout);    // Other database threads may be writing
 }
 
 // Destructor
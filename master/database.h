@@ -119,6 +119,7 @@ public:
    void setDumpSql(bool dump);
 
    void insertStats(const GameStats &gameStats);
+   void insertStats(const Vector<GameStats> &games);
    void insertAchievement(U8 achievementId, const StringTableEntry &playerNick, const string &serverName, const string &serverIP);
    void insertLevelInfo(const string &hash, const string &levelName, const string &creator, 
                         const string &gameType, bool hasLevelGen, U8 teamCount, S32 winningScore, S32 gameDurationInSeconds);
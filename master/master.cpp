@@ -52,6 +52,9 @@ MasterSettings::MasterSettings(const string &iniFile)
    mSettings.add(new Setting<string>("StatsDatabaseUsername",                  "",             "stats_database_username",              "stats"));
    mSettings.add(new Setting<string>("StatsDatabasePassword",                  "",             "stats_database_password",              "stats"));
 
+   // With more than one, writes can finish out of order, and MySQL can end up with duplicate server and level rows
+   mSettings.add(new Setting<U32>   ("DatabaseThreads",                        1,              "database_threads",                     "stats"));
+
    // GameJolt settings
    mSettings.add(new Setting<YesNo> ("UseGameJolt",                            Yes,            "UseGameJolt",                          "GameJolt"));
    mSettings.add(new Setting<string>("GameJoltSecret",                         "",             "GameJoltSecret",                       "GameJolt"));
@@ -184,7 +187,8 @@ string MasterSettings::getMotd(U32 clientBuildVersion) const
 ////////////////////////////////////////
 
 // Constructor
-MasterServer::MasterServer(MasterSettings *settings)
+MasterServer::MasterServer(MasterSettings *settings) :
+   mGlobalChat(&mClientList)
 {
    mSettings = settings;
 
@@ -200,7 +204,8 @@ MasterServer::MasterServer(MasterSettings *settings)
 
    mJsonWritingSuspended = false;
    
-   mDatabaseAccessThread = new DatabaseAccessThread();    // Deleted in destructor
+   // Deleted in destructor.  Only read at startup; changing the thread count takes a restart.
+   mDatabaseAccessThread = new DatabaseAccessThread(getMax(settings->getVal<U32>("DatabaseThreads"), 1u));
 
    MasterServerConnection::setMasterServer(this);
 }
@@ -271,6 +276,7 @@ const Vector<MasterServerConnection *> *MasterServer::getClientList() const
 void MasterServer::addServer(MasterServerConnection *server)
 {
    mServerList.push_back(server);
+   mServerListCache.updateServer(server);
 }
 
 
@@ -283,6 +289,7 @@ void MasterServer::addClient(MasterServerConnection *client)
 void MasterServer::removeServer(S32 index)
 {
    TNLAssert(index >= 0 && index < mServerList.size(), "Index out of range!");
+   mServerListCache.removeServer(mServerList[index]);
    mServerList.erase_fast(index);
 }
 
@@ -316,6 +323,7 @@ void MasterServer::idle(const U32 timeDelta)
    if(mCleanupTimer.update(timeDelta))
    {
       MasterServerConnection::removeOldEntriesFromRatingsCache();    //<== need non-static access
+      logDatabaseStats();
       mCleanupTimer.reset();
    }
 
@@ -364,31 +372,23 @@ void MasterServer::idle(const U32 timeDelta)
       }
    }
 
-   // Process any delayed disconnects; we use this to avoid repeating and flooding join / leave messages
-   for(S32 i = MasterServerConnection::gLeaveChatTimerList.size() - 1; i >= 0; i--)
-   {
-      MasterServerConnection *c = MasterServerConnection::gLeaveChatTimerList[i];      
+   // Process any delayed leaves, and tell everyone in global chat what's been happening
+   mGlobalChat.idle(currentTime);
 
-      if(!c || c->mLeaveGlobalChatTimer == 0)
-         MasterServerConnection::gLeaveChatTimerList.erase(i);                         
-      else
-      {
-         if(currentTime - c->mLeaveGlobalChatTimer > (U32)ONE_SECOND)
-         {
-            c->isInGlobalChat = false;
+   mDatabaseAccessThread->idle();
 
-            const Vector<MasterServerConnection *> *clientList = getClientList();
+   mServerListCache.sendChanges();
+}
 
-            for(S32 j = 0; j < clientList->size(); j++)
-               if(clientList->get(j) != c && clientList->get(j)->isInGlobalChat)
-                  clientList->get(j)->m2cPlayerLeftGlobalChat(c->mPlayerOrServerName);
 
-            MasterServerConnection::gLeaveChatTimerList.erase(i);
-         }
-      }
-   }
+// Lets us see whether the database is keeping up, and how close it's coming to not keeping up
+void MasterServer::logDatabaseStats()
+{
+   DatabaseAccessStats stats = mDatabaseAccessThread->takeStats();
 
-   mDatabaseAccessThread->idle();
+   logprintf("[%s] Database: %d entries in %d batches on %d threads, latency avg %.1f ms, max %d ms; queue %d, max %d", 
+             getTimeStamp().c_str(), stats.completed, stats.batches, mDatabaseAccessThread->getThreadCount(), 
+             stats.averageLatency, stats.maxLatency, stats.queued, stats.maxQueued);
 }
 
 
@@ -397,5 +397,17 @@ DatabaseAccessThread *MasterServer::getDatabaseAccessThread()
    return mDatabaseAccessThread;
 }
 
+
+ServerListCache *MasterServer::getServerListCache()
+{
+   return &mServerListCache;
+}
+
+
+GlobalChat *MasterServer::getGlobalChat()
+{
+   return &mGlobalChat;
+}
+
 }  // namespace
 
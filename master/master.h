@@ -6,6 +6,8 @@
 #include "masterInterface.h"
 
 #include "MasterServerConnection.h"
+#include "ServerListCache.h"
+#include "GlobalChat.h"
 
 #include "../zap/IniFile.h"
 
@@ -87,7 +89,11 @@ private:
    Vector<MasterServerConnection *> mServerList;
    Vector<MasterServerConnection *> mClientList;
 
+   ServerListCache mServerListCache;
+   GlobalChat mGlobalChat;
+
    NetInterface *createNetInterface() const;
+   void logDatabaseStats();
 
 public:
    MasterServer(MasterSettings *settings);      // Constructor
@@ -106,6 +112,8 @@ public:
 
    NetInterface *getNetInterface() const;
    DatabaseAccessThread *getDatabaseAccessThread();
+   ServerListCache *getServerListCache();
+   GlobalChat *getGlobalChat();
    void writeJsonDelayed();
    void writeJsonNow();
 
@@ -31,6 +31,7 @@ static const S32 M_RPC_019  = 3;
 static const S32 M_RPC_019a = 4;
 static const S32 M_RPC_019d = 5;
 static const S32 M_RPC_023  = 6;
+static const S32 M_RPC_024  = 7;
 
 TNL_IMPLEMENT_RPC(MasterServerInterface, c2mQueryServers,
    (U32 queryId), (queryId),
@@ -253,5 +254,35 @@ TNL_IMPLEMENT_RPC(MasterServerInterface, s2mServerDescription,
    (descr),
    NetClassGroupMasterMask, RPCGuaranteedOrderedBigData, RPCDirClientToServer, M_RPC_PRE_017) {}
 
+TNL_IMPLEMENT_RPC(MasterServerInterface, c2mSubscribeServerList,
+   (U32 queryId, bool hostOnly), (queryId, hostOnly),
+   NetClassGroupMasterMask, RPCGuaranteedOrdered, RPCDirClientToServer, M_RPC_024) {}
+
+TNL_IMPLEMENT_RPC(MasterServerInterface, c2mUnsubscribeServerList,
+   (), (),
+   NetClassGroupMasterMask, RPCGuaranteedOrdered, RPCDirClientToServer, M_RPC_024) {}
+
+TNL_IMPLEMENT_RPC(MasterServerInterface, m2cServerListChanged,
+   (U32 queryId, Vector<IPAddress> ipList, Vector<S32> serverIdList, Vector<StringTableEntry> serverNames, Vector<S32> removedServerIds),
+   (queryId, ipList, serverIdList, serverNames, removedServerIds),
+   NetClassGroupMasterMask, RPCGuaranteedOrdered, RPCDirServerToClient, M_RPC_024) {}
+
+TNL_IMPLEMENT_RPC(MasterServerInterface, m2cGlobalChatChanged,
+   (Vector<StringTableEntry> leftNicks, Vector<StringTableEntry> joinedNicks),
+   (leftNicks, joinedNicks),
+   NetClassGroupMasterMask, RPCGuaranteedOrdered, RPCDirServerToClient, M_RPC_024) {}
+
+TNL_IMPLEMENT_RPC(MasterServerInterface, m2cSendChats,
+   (Vector<StringTableEntry> playerNicks, Vector<string> messages),
+   (playerNicks, messages),
+   NetClassGroupMasterMask, RPCGuaranteedOrdered, RPCDirServerToClient, M_RPC_024) {}
+
+
+// The two ends of a connection agree on the newest RPCs they both know about when they connect
+bool MasterServerInterface::supports024Rpcs()
+{
+   return getEventClassVersion() >= (U32)M_RPC_024;
+}
+
 
 }
\ No newline at end of file
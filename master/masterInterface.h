@@ -182,6 +182,21 @@ public:
    TNL_DECLARE_RPC(s2mChangeName, (StringTableEntry name));         // when server changes name using /setservname
    TNL_DECLARE_RPC(s2mServerDescription, (StringTableEntry descr)); // when server changes using /setservdescr
 
+   // 024 version: rather than asking for the whole list every few seconds, clients subscribe to it.  The master sends
+   // the list with m2cQueryServersResponse_023, as for c2mQueryServers, then m2cServerListChanged whenever servers come,
+   // go, or change, until the client unsubscribes.  The client applies removedServerIds, then adds (or replaces) the
+   // servers in ipList -- a server will never be in both.
+   TNL_DECLARE_RPC(c2mSubscribeServerList, (U32 queryId, bool hostOnly));
+   TNL_DECLARE_RPC(c2mUnsubscribeServerList, ());
+   TNL_DECLARE_RPC(m2cServerListChanged, (U32 queryId, Vector<IPAddress> ipList, Vector<S32> serverIdList, 
+                                          Vector<StringTableEntry> serverNames, Vector<S32> removedServerIds));
+
+   // 024 version: joins, leaves, and chat messages are saved up and sent a batch at a time.  In m2cGlobalChatChanged,
+   // the client removes leftNicks before adding joinedNicks.
+   TNL_DECLARE_RPC(m2cGlobalChatChanged, (Vector<StringTableEntry> leftNicks, Vector<StringTableEntry> joinedNicks));
+   TNL_DECLARE_RPC(m2cSendChats, (Vector<StringTableEntry> playerNicks, Vector<string> messages));
+
+   bool supports024Rpcs();     // True if the other end knows about the 024 RPCs
 };
 
 }
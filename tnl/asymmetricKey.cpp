@@ -43,7 +43,7 @@ enum {
    StaticCryptoBufferSize = 2048,
 };
 
-static U8 staticCryptoBuffer[StaticCryptoBufferSize];
+static TNL_THREAD_LOCAL U8 staticCryptoBuffer[StaticCryptoBufferSize];     // Per-thread, as arenas may make keys at once
 
 AsymmetricKey::AsymmetricKey(U32 keySize)
 {
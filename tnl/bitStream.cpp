@@ -32,9 +32,74 @@
 #include <tomcrypt.h>
 
 #include <math.h>
+#include <string.h>
 
 namespace TNL {
 
+//----------------------------------------------------------------------------
+// Word-at-a-time helpers.  Bits are stored least significant first, in little-endian byte order, so any run of up to
+// 57 bits can be read with one unaligned 64-bit load at the byte it starts in.  Writes treat the buffer as an array of
+// 64-bit words instead, and update the one or two words the bits land in: a write's load then picks up the previous
+// write's store straight from the CPU's store buffer, where an overlapping load at some other offset would have to
+// wait for that store to reach the cache.  Callers must make sure both words lie inside the buffer; see
+// BitStream::wordFits().
+
+enum {
+   WordBytes = sizeof(U64),
+   ChunkBytes = 7,                  ///< Whole bytes moved per word by writeBits() and readBits(), leaving room for the shift
+   ChunkBits = ChunkBytes << 3,
+};
+
+static inline U64 loadWord(const U8 *src)
+{
+   U64 word;
+   memcpy(&word, src, WordBytes);
+   return convertLEndianToHost(word);
+}
+
+static inline void storeWord(U8 *dest, U64 word)
+{
+   word = convertHostToLEndian(word);
+   memcpy(dest, &word, WordBytes);
+}
+
+/// Replaces bitCount (<= 57) bits of buffer, starting at bitPos, with the low bits of value.  Neighboring bits are left
+/// alone, as writeIntAt() and setBit() rely on.
+static inline void putBits(U8 *buffer, U32 bitPos, U64 value, U32 bitCount)
+{
+   U8 *dest = buffer + ((bitPos >> 6) << 3);
+   U32 shift = bitPos & 0x3F;
+   U64 mask = (U64(1) << bitCount) - 1;
+
+   value &= mask;
+   storeWord(dest, (loadWord(dest) & ~(mask << shift)) | (value << shift));
+
+   if(shift + bitCount > 64)
+      storeWord(dest + WordBytes, (loadWord(dest + WordBytes) & ~(mask >> (64 - shift))) | (value >> (64 - shift)));
+}
+
+/// Returns bits of buffer starting at bitPos; at least the low 57 are valid
+static inline U64 getBits(const U8 *buffer, U32 bitPos)
+{
+   return loadWord(buffer + (bitPos >> 3)) >> (bitPos & 0x7);
+}
+
+/// Reads up to 8 bytes of little-endian data that may be unaligned, or shorter than a word
+static inline U64 loadPartialWord(const void *src, U32 byteCount)
+{
+   U64 word = 0;
+   memcpy(&word, src, byteCount);
+   return convertLEndianToHost(word);
+}
+
+static inline void storePartialWord(void *dest, U64 word, U32 byteCount)
+{
+   word = convertHostToLEndian(word);
+   memcpy(dest, &word, byteCount);
+}
+
+//----------------------------------------------------------------------------
+
 void BitStream::setMaxSizes(U32 maxReadSize, U32 maxWriteSize)
 {
    maxReadBitNum = maxReadSize << 3;
@@ -99,10 +164,30 @@ bool BitStream::writeBits(U32 bitCount, const void *bitPtr)
       if(!resizeBits(bitCount + bitNum - maxWriteBitNum))
          return false;
 
+   const U8 *sourcePtr = (U8 *) bitPtr;
+
+   // Seven bytes at a time, for as long as there's a whole word of buffer left
+   for(; bitCount >= ChunkBits && wordFits(bitNum); bitCount -= ChunkBits)
+   {
+      putBits(getBuffer(), bitNum, loadPartialWord(sourcePtr, ChunkBytes), ChunkBits);
+      sourcePtr += ChunkBytes;
+      bitNum += ChunkBits;
+   }
+
+   if(!bitCount)
+      return true;
+
+   if(wordFits(bitNum))
+   {
+      putBits(getBuffer(), bitNum, loadPartialWord(sourcePtr, (bitCount + 7) >> 3), bitCount);
+      bitNum += bitCount;
+      return true;
+   }
+
+   // We're in the last few bytes of the buffer, where a word load would run off the end; go a byte at a time
    U32 upShift  = bitNum & 0x7;
    U32 downShift= 8 - upShift;
 
-   const U8 *sourcePtr = (U8 *) bitPtr;
    U8 *destPtr = getBuffer() + (bitNum >> 3);
 
    // if this write is for <= 1 byte, and it will all fit in the
@@ -170,11 +255,30 @@ bool BitStream::readBits(U32 bitCount, void *bitPtr)
       return false;
    }
 
+   U8 *destPtr = (U8 *) bitPtr;
+
+   // Same deal as writeBits().  Like the byte loop below, fills the last byte of destPtr with whatever follows in the
+   // stream, rather than zeroes.
+   for(; bitCount >= ChunkBits && wordFits(bitNum); bitCount -= ChunkBits)
+   {
+      storePartialWord(destPtr, getBits(getBuffer(), bitNum), ChunkBytes);
+      destPtr += ChunkBytes;
+      bitNum += ChunkBits;
+   }
+
+   if(!bitCount)
+      return true;
+
+   if(wordFits(bitNum))
+   {
+      storePartialWord(destPtr, getBits(getBuffer(), bitNum), (bitCount + 7) >> 3);
+      bitNum += bitCount;
+      return true;
+   }
+
    U8 *sourcePtr = getBuffer() + (bitNum >> 3);
    U32 byteCount = (bitCount + 7) >> 3;
 
-   U8 *destPtr = (U8 *) bitPtr;
-
    U32 downShift = bitNum & 0x7;
    U32 upShift = 8 - downShift;
 
@@ -224,19 +328,6 @@ bool BitStream::testBit(U32 bitCount)
    return (*(getBuffer() + (bitCount >> 3)) & (1 << (bitCount & 0x7))) != 0;
 }
 
-bool BitStream::writeFlag(bool val)
-{
-   if(bitNum + 1 > maxWriteBitNum)
-      if(!resizeBits(1))
-         return false;
-   if(val)
-      *(getBuffer() + (bitNum >> 3)) |= (1 << (bitNum & 0x7));
-   else
-      *(getBuffer() + (bitNum >> 3)) &= ~(1 << (bitNum & 0x7));
-   bitNum++;
-   return (val);
-}
-
 bool BitStream::write(const ByteBuffer *theBuffer)
 {
    U32 size = theBuffer->getBufferSize();
@@ -258,6 +349,15 @@ bool BitStream::read(ByteBuffer *theBuffer)
 U32 BitStream::readInt(U8 bitCount)
 {
    TNLAssert(bitCount <= 32, "bitCount must be less then 32, for 64 bit, use readInt64");
+
+   // Fast path for everything but the end of the buffer
+   if(bitCount + bitNum <= maxReadBitNum && wordFits(bitNum))
+   {
+      U64 bits = getBits(getBuffer(), bitNum);
+      bitNum += bitCount;
+      return U32(bits & ((U64(1) << bitCount) - 1));
+   }
+
    U32 ret = 0;
    readBits(bitCount, &ret);
    ret = convertLEndianToHost(ret);
@@ -290,6 +390,15 @@ U64 BitStream::readInt64(U8 bitCount)
 void BitStream::writeInt(U32 val, U8 bitCount)
 {
    TNLAssert(bitCount <= 32, "bitCount must be less then 32, for 64 bit, use writeInt64");
+
+   // Fast path for everything but the end of the buffer
+   if(bitCount + bitNum <= maxWriteBitNum && wordFits(bitNum))
+   {
+      putBits(getBuffer(), bitNum, val, bitCount);
+      bitNum += bitCount;
+      return;
+   }
+
    val = convertHostToLEndian(val);
    writeBits(bitCount, &val);
 }
@@ -163,12 +163,12 @@ RefPtr<ByteBuffer> ByteBuffer::computeMD5Hash(U32 len) const
    return ret;
 }
 
-U32 ByteBuffer::calculateCRC(U32 start, U32 end, U32 crcVal) const
+// Filled in before main() runs, so packets can be checksummed from any number of threads without a race to build it
+static struct CRCTable
 {
-   static U32 crcTable[256];
-   static bool crcTableValid = false;
+   U32 values[256];
 
-   if(!crcTableValid)
+   CRCTable()
    {
       U32 val;
 
@@ -182,11 +182,13 @@ U32 ByteBuffer::calculateCRC(U32 start, U32 end, U32 crcVal) const
             else
                val = val >> 1;
          }
-         crcTable[i] = val;
+         values[i] = val;
       }
-      crcTableValid = true;
    }
-   
+} crcTable;
+
+U32 ByteBuffer::calculateCRC(U32 start, U32 end, U32 crcVal) const
+{
    if(start >= mBufSize)
       return 0;
    if(end > mBufSize)
@@ -195,7 +197,7 @@ U32 ByteBuffer::calculateCRC(U32 start, U32 end, U32 crcVal) const
    // now calculate the crc
    const U8 * buf = getBuffer();
    for(U32 i = start; i < end; i++)
-      crcVal = crcTable[(crcVal ^ buf[i]) & 0xff] ^ (crcVal >> 8);
+      crcVal = crcTable.values[(crcVal ^ buf[i]) & 0xff] ^ (crcVal >> 8);
    return(crcVal);
 }
 
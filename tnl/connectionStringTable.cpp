@@ -28,12 +28,36 @@
 
 #include "tnlEventConnection.h"
 #include "tnlBitStream.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
 //--------------------------------------------------------------------
 static ClassChunker<ConnectionStringTable::PacketEntry> packetEntryFreeList(4096);
 
+// Entries are taken while writing packets, which connections can do on worker threads
+static Mutex &getPacketEntryLock()
+{
+   static Mutex packetEntryLock;
+   return packetEntryLock;
+}
+
+static ConnectionStringTable::PacketEntry *allocPacketEntry()
+{
+   getPacketEntryLock().lock();
+   ConnectionStringTable::PacketEntry *entry = packetEntryFreeList.alloc();
+   getPacketEntryLock().unlock();
+
+   return entry;
+}
+
+static void freePacketEntry(ConnectionStringTable::PacketEntry *entry)
+{
+   getPacketEntryLock().lock();
+   packetEntryFreeList.free(entry);
+   getPacketEntryLock().unlock();
+}
+
 ConnectionStringTable::ConnectionStringTable(NetConnection *parent)
 {
    mParent = parent;
@@ -96,7 +120,7 @@ void ConnectionStringTable::writeStringTableEntry(BitStream *stream, StringTable
    if(!stream->writeFlag(sendEntry->receiveConfirmed))
    {
       stream->writeString(sendEntry->string.getString());
-      PacketEntry *entry = packetEntryFreeList.alloc();
+      PacketEntry *entry = allocPacketEntry();
 
       entry->stringTableEntry = sendEntry;
       entry->string = sendEntry->string;
@@ -133,7 +157,7 @@ void ConnectionStringTable::packetReceived(PacketList *note)
       PacketEntry *next = walk->nextInPacket;
       if(walk->stringTableEntry->string == walk->string)
          walk->stringTableEntry->receiveConfirmed = true;
-      packetEntryFreeList.free(walk);
+      freePacketEntry(walk);
       walk = next;
    }
 }
@@ -144,7 +168,7 @@ void ConnectionStringTable::packetDropped(PacketList *note)
    while(walk)
    {
       PacketEntry *next = walk->nextInPacket;
-      packetEntryFreeList.free(walk);
+      freePacketEntry(walk);
       walk = next;
    }
 }
@@ -163,8 +187,14 @@ void ConnectionStringTable::packetRewind(PacketList *note, PacketEntry *p_entry)
    while(walk)
    {
       PacketEntry *next = walk->nextInPacket;
-      packetEntryFreeList.free(walk);
+      freePacketEntry(walk);
       walk = next;
    }
 }
+
+void ConnectionStringTable::resetReceiveConfirmations()
+{
+   for(U32 i = 0; i < EntryCount; i++)
+      mEntryTable[i].receiveConfirmed = false;
+}
 };
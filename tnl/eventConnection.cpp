@@ -29,11 +29,35 @@
 #include "tnlBitStream.h"
 #include "tnlLog.h"
 #include "tnlNetInterface.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
 ClassChunker<EventConnection::EventNote> EventConnection::mEventNoteChunker;
 
+// Packet writer threads drop events that will never fit in a packet, so the chunker is shared between threads
+static Mutex &getEventNoteLock()
+{
+   static Mutex eventNoteLock;
+   return eventNoteLock;
+}
+
+EventConnection::EventNote *EventConnection::allocEventNote()
+{
+   getEventNoteLock().lock();
+   EventNote *note = mEventNoteChunker.alloc();
+   getEventNoteLock().unlock();
+
+   return note;
+}
+
+void EventConnection::freeEventNote(EventNote *note)
+{
+   getEventNoteLock().lock();
+   mEventNoteChunker.free(note);
+   getEventNoteLock().unlock();
+}
+
 EventConnection::EventConnection()
 {
    // Event management data:
@@ -48,6 +72,7 @@ EventConnection::EventConnection()
    mNextRecvEventSeq = FirstValidSendEventSeq;
    mLastAckedEventSeq = -1;
    mEventClassCount = 0;
+   mEventClassVersion = 0;
    mEventClassBitSize = 0;
    mTNLDataBuffer = NULL;
 }
@@ -70,7 +95,7 @@ void EventConnection::clearSendEvents()
       mNotifyEventList = temp->mNextEvent;
       
       temp->mEvent->notifyDelivered(this, true);
-      mEventNoteChunker.free(temp);
+      freeEventNote(temp);
    }
    while(mUnorderedSendEventQueueHead)
    {
@@ -78,7 +103,7 @@ void EventConnection::clearSendEvents()
       mUnorderedSendEventQueueHead = temp->mNextEvent;
       
       temp->mEvent->notifyDelivered(this, true);
-      mEventNoteChunker.free(temp);
+      freeEventNote(temp);
    }
    while(mSendEventQueueHead)
    {
@@ -86,7 +111,7 @@ void EventConnection::clearSendEvents()
       mSendEventQueueHead = temp->mNextEvent;
       
       temp->mEvent->notifyDelivered(this, true);
-      mEventNoteChunker.free(temp);
+      freeEventNote(temp);
    }
    mNextSendEventSeq = FirstValidSendEventSeq;
 }
@@ -97,11 +122,22 @@ void EventConnection::clearRecvEvents()
    {
       EventNote *temp = mWaitSeqEvents;
       mWaitSeqEvents = temp->mNextEvent;
-      mEventNoteChunker.free(temp);
+      freeEventNote(temp);
    }
    mNextRecvEventSeq = FirstValidSendEventSeq;
    if(mTNLDataBuffer)
       delete mTNLDataBuffer;
+   mTNLDataBuffer = NULL;
+}
+
+bool EventConnection::restartEventSequence()
+{
+   if(mSendEventQueueHead || mUnorderedSendEventQueueHead || mNotifyEventList)
+      return false;
+
+   mNextSendEventSeq = FirstValidSendEventSeq;
+   mLastAckedEventSeq = FirstValidSendEventSeq - 1;
+   return true;
 }
 
 void EventConnection::writeConnectRequest(BitStream *stream)
@@ -181,6 +217,9 @@ bool EventConnection::readConnectAccept(BitStream *stream, NetConnection::Termin
       return false;
    }
 
+   if(mEventClassCount > 0)
+      mEventClassVersion = NetClassRep::getClass(getNetClassGroup(), NetClassTypeEvent, mEventClassCount-1)->getClassVersion();
+
    mEventClassBitSize = getNextBinLog2(mEventClassCount);
 
    clearSendEvents();
@@ -240,7 +279,7 @@ void EventConnection::packetDropped(PacketNotify *pnotify)
             // it was _not_ delivered and blast it.
             walk->mEvent->notifyDelivered(this, false);
             temp = walk->mNextEvent;
-            mEventNoteChunker.free(walk);
+            freeEventNote(walk);
             walk = temp;
       }
    }
@@ -261,7 +300,7 @@ void EventConnection::packetReceived(PacketNotify *pnotify)
       if(walk->mEvent->mGuaranteeType != NetEvent::GuaranteedOrdered)
       {
          walk->mEvent->notifyDelivered(this, true);
-         mEventNoteChunker.free(walk);
+         freeEventNote(walk);
          walk = next;
       }
       else
@@ -281,7 +320,7 @@ void EventConnection::packetReceived(PacketNotify *pnotify)
       EventNote *next = mNotifyEventList->mNextEvent;
       logprintf(LogConsumer::LogEventConnection, "EventConnection %s: NotifyDelivered - %d", getNetAddressString(), mNotifyEventList->mSeqCount);
       mNotifyEventList->mEvent->notifyDelivered(this, true);
-      mEventNoteChunker.free(mNotifyEventList);
+      freeEventNote(mNotifyEventList);
       mNotifyEventList = next;
    }
 }
@@ -340,7 +379,7 @@ void EventConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
             mUnorderedSendEventQueueHead = ev->mNextEvent;
             ev->mNextEvent = NULL;
             ev->mEvent->notifyDelivered(this, false);
-            mEventNoteChunker.free(ev);
+            freeEventNote(ev);
             bstream->setBitPosition(start - 1);
             bstream->clearError();
             break;
@@ -419,7 +458,7 @@ void EventConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
             mSendEventQueueHead = ev->mNextEvent;
             ev->mNextEvent = NULL;
             ev->mEvent->notifyDelivered(this, false);
-            mEventNoteChunker.free(ev);
+            freeEventNote(ev);
             bstream->setBitPosition(eventStart);
             bstream->clearError();
             break;
@@ -495,7 +534,7 @@ void EventConnection::readPacket(BitStream *bstream)
       if(seq < mNextRecvEventSeq)
          seq += 128;
       
-      EventNote *note = mEventNoteChunker.alloc();
+      EventNote *note = allocEventNote();
       note->mEvent = evt;
       note->mSeqCount = seq;
       logprintf(LogConsumer::LogEventConnection, "EventConnection %s: RecvdGuaranteed %d", getNetAddressString(), seq);
@@ -515,7 +554,7 @@ void EventConnection::readPacket(BitStream *bstream)
       
       logprintf(LogConsumer::LogEventConnection, "EventConnection %s: ProcessGuaranteed %d", getNetAddressString(), temp->mSeqCount);
       processEvent(temp->mEvent);
-      mEventNoteChunker.free(temp);
+      freeEventNote(temp);
       if(mErrorBuffer[0])
          return;
    }
@@ -539,7 +578,7 @@ bool EventConnection::postNetEvent(NetEvent *theEvent)
 
    theEvent->notifyPosted(this);
 
-   EventNote *event = mEventNoteChunker.alloc();
+   EventNote *event = allocEventNote();
    event->mEvent = theEvent;
    event->mNextEvent = NULL;
 
@@ -587,7 +626,7 @@ bool EventConnection::postNetEvent(NetEvent *theEvent)
             s2rTNLSendDataParts(1, ByteBufferPtr(bytebuffer));
          }
       }
-      mEventNoteChunker.free(event);
+      freeEventNote(event);
    }
    else
    {
@@ -30,9 +30,20 @@
 #include "tnlNetBase.h"
 #include "tnlNetObject.h"
 #include "tnlNetInterface.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
+// Guards every NetObject's list of GhostInfos, which is shared by all the connections ghosting it,
+// so connections can run scope queries and write packets on different threads
+static Mutex &getObjectRefLock()
+{
+   static Mutex objectRefLock;
+   return objectRefLock;
+}
+
+bool GhostConnection::mProfilingEnabled = false;
+
 GhostConnection::GhostConnection()
 {
    // ghost management data:
@@ -182,14 +193,50 @@ void GhostConnection::packetReceived(PacketNotify *pnotify)
    }
 }
 
-static S32 QSORT_CALLBACK UQECompare(const void *a,const void *b)
+// The ghosts awaiting update are kept as a binary max-heap on priority while a packet
+// is written, so only the ones that actually make it into the packet get ordered.
+// These helpers keep each GhostInfo's arrayIndex in step with its position.
+static void siftDownGhost(GhostInfo **heap, S32 count, S32 index)
 {
-   GhostInfo *ga = *((GhostInfo **) a);
-   GhostInfo *gb = *((GhostInfo **) b);
+   GhostInfo *info = heap[index];
+   for(;;)
+   {
+      S32 child = index * 2 + 1;
+      if(child >= count)
+         break;
+      if(child + 1 < count && heap[child + 1]->priority > heap[child]->priority)
+         child++;
+      if(heap[child]->priority <= info->priority)
+         break;
+
+      heap[index] = heap[child];
+      heap[index]->arrayIndex = index;
+      index = child;
+   }
+   heap[index] = info;
+   info->arrayIndex = index;
+}
 
-   F32 ret = ga->priority - gb->priority;
-   return (ret < 0) ? -1 : ((ret > 0) ? 1 : 0);
-} 
+static void buildGhostHeap(GhostInfo **heap, S32 count)
+{
+   for(S32 i = count / 2 - 1; i >= 0; i--)
+      siftDownGhost(heap, count, i);
+}
+
+// Shrinks the heap by one and moves the highest priority ghost into the slot just past its end
+static GhostInfo *popGhostHeap(GhostInfo **heap, S32 &count)
+{
+   count--;
+   GhostInfo *top = heap[0];
+   if(count > 0)
+   {
+      heap[0] = heap[count];
+      siftDownGhost(heap, count, 0);
+   }
+   heap[count] = top;
+   top->arrayIndex = count;
+   return top;
+}
 
 void GhostConnection::prepareWritePacket()
 {
@@ -264,8 +311,8 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
 
    // 2. call scoped objects' priority functions if the flag set is nonzero
    //    A removed ghost is assumed to have a high priority
-   // 3. call updates based on sorted priority until the packet is
-   //    full.  set flags to zero for all updated objects
+   // 3. call updates in priority order until the packet is full.
+   //    set flags to zero for all updated objects
 
    GhostInfo *walk;
 
@@ -301,11 +348,13 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
          walk->priority = 0;
    }
    GhostRef *updateList = NULL;
-   if(mGhostZeroUpdateIndex != 0)
-      qsort(&mGhostArray[0], mGhostZeroUpdateIndex, sizeof(GhostInfo *), UQECompare);
-   // reset the array indices...
-   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
-      mGhostArray[i]->arrayIndex = i;
+
+   // Heapify is linear, and each ghost we pull off it costs log n, so we don't pay to
+   // sort the ghosts that won't fit in this packet.  Ghosts pulled off the heap land just
+   // past its end, in [heapSize, mGhostZeroUpdateIndex), so ghostPushToZero() below only
+   // ever swaps with ghosts we have already dealt with.
+   S32 heapSize = mGhostZeroUpdateIndex;
+   buildGhostHeap(mGhostArray.address(), heapSize);
 
    U8 sendSize = 0;
    while(maxIndex != 0)
@@ -321,9 +370,9 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
 
    U32 count = 0;
    bool have_something_to_send = bstream->getBitPosition() >= 256;
-   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0 && !bstream->isFull(); i--)
+   while(heapSize > 0 && !bstream->isFull())
    {
-      GhostInfo *walk = mGhostArray[i];
+      GhostInfo *walk = popGhostHeap(mGhostArray.address(), heapSize);
       if(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting))
          continue;
 
@@ -356,8 +405,20 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
             NetObject::mIsInitialUpdate = true;
          }
          // update the object
+         bool profiling = mProfilingEnabled;
+         S64 packStart = profiling ? Platform::getHighPrecisionTimerValue() : 0;
+
          retMask = walk->obj->packUpdate(this, updateMask, bstream);
 
+         if(profiling)
+         {
+            S64 packTime = Platform::getHighPrecisionTimerValue() - packStart;
+            U32 bitCount = bstream->getBitPosition() - startPos;
+
+            walk->obj->getClassRep()->addGhostProfileUpdate(updateMask, bitCount, packTime);
+            mGhostProfile.addUpdate(updateMask, bitCount, packTime);
+         }
+
          if(NetObject::mIsInitialUpdate)
          {
             NetObject::mIsInitialUpdate = false;
@@ -565,12 +626,14 @@ void GhostConnection::detachObject(GhostInfo *info)
    }
    if(info->obj)
    {
+      getObjectRefLock().lock();
       if(info->prevObjectRef)
          info->prevObjectRef->nextObjectRef = info->nextObjectRef;
       else
          info->obj->mFirstObjectRef = info->nextObjectRef;
       if(info->nextObjectRef)
          info->nextObjectRef->prevObjectRef = info->prevObjectRef;
+      getObjectRefLock().unlock();
       // remove it from the lookup table
       
       U32 id = info->obj->getHashId();
@@ -708,11 +771,13 @@ void GhostConnection::objectInScope(NetObject *obj)
 
    giptr->connection = this;
 
+   getObjectRefLock().lock();
    giptr->nextObjectRef = obj->mFirstObjectRef;
    if(obj->mFirstObjectRef)
       obj->mFirstObjectRef->prevObjectRef = giptr;
    giptr->prevObjectRef = NULL;
    obj->mFirstObjectRef = giptr;
+   getObjectRefLock().unlock();
    
    giptr->nextLookupInfo = mGhostLookupTable[index];
    mGhostLookupTable[index] = giptr;
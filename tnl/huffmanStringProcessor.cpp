@@ -78,6 +78,13 @@ namespace HuffmanStringProcessor {
 //Vector<HuffmanStringProcessor::HuffNode> HuffmanStringProcessor::mHuffNodes;
 //Vector<HuffmanStringProcessor::HuffLeaf> HuffmanStringProcessor::mHuffLeaves;
 
+// Builds the tables before main() runs, rather than the first time a string is sent, as strings can be written from
+// several packet writer threads at once.  Has to come after mHuffNodes and mHuffLeaves, so they're constructed first.
+static struct HuffTableBuilder
+{
+   HuffTableBuilder() { HuffmanStringProcessor::buildTables(); }
+} huffTableBuilder;
+
 
 void HuffmanStringProcessor::buildTables()
 {
@@ -194,8 +201,7 @@ S16 HuffmanStringProcessor::determineIndex(HuffWrap& rWrap)
 
 bool HuffmanStringProcessor::readHuffBuffer(BitStream* pStream, char* out_pBuffer)
 {
-   if (mTablesBuilt == false)
-      buildTables();
+   TNLAssert(mTablesBuilt, "Huffman tables should have been built at startup!");
 
    if (pStream->readFlag()) {
       U32 len = pStream->readInt(8);
@@ -233,8 +239,7 @@ bool HuffmanStringProcessor::writeHuffBuffer(BitStream* pStream, const char* out
       return true;
    }
 
-   if (mTablesBuilt == false)
-      buildTables();
+   TNLAssert(mTablesBuilt, "Huffman tables should have been built at startup!");
 
    U32 len = out_pBuffer ? strlen(out_pBuffer) : 0;
    TNLAssertV(len <= MAX_SENDABLE_LINE_LENGTH, ("String \"%s\" TOO long for writeString", out_pBuffer));
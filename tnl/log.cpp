@@ -26,6 +26,7 @@
 
 #include "tnlLog.h"
 #include "tnlDataChunker.h"
+#include "tnlPlatform.h"
 #include "../zap/oglconsole.h"   // For logging to the console
 #include <time.h>
 #include <string.h>
@@ -101,8 +102,8 @@ void LogConsumer::logString(LogConsumer::MsgType msgType, std::string message)
 
 
 // Create reusable buffer for our logging functions.  Make it big because when we use datadumper 
-// in a script, some messages can get very long
-static char msg[1024 * 8];
+// in a script, some messages can get very long.  One per thread, so threads don't trample each other's messages.
+static TNL_THREAD_LOCAL char msg[1024 * 8];
 
 
 void LogConsumer::logprintf(const char *format, ...)
@@ -264,13 +265,13 @@ std::string getTimeStamp()
 {
   static const U32 TIMESIZE = 40;
   time_t rawtime;
-  struct tm * timeinfo;
+  struct tm timeinfo;
   char buffer[TIMESIZE];
 
   time ( &rawtime );
-  timeinfo = localtime ( &rawtime );
+  Platform::getLocalTime(rawtime, timeinfo);
 
-  strftime(buffer, TIMESIZE, "%Y-%m-%d %a %H:%M:%S", timeinfo);
+  strftime(buffer, TIMESIZE, "%Y-%m-%d %a %H:%M:%S", &timeinfo);
 
   return(std::string(buffer));   
 }
@@ -281,13 +282,13 @@ std::string getShortTimeStamp()
 {
   static const U32 TIMESIZE = 40;
   time_t rawtime;
-  struct tm * timeinfo;
+  struct tm timeinfo;
   char buffer[TIMESIZE];
 
   time ( &rawtime );
-  timeinfo = localtime ( &rawtime );
+  Platform::getLocalTime(rawtime, timeinfo);
 
-  strftime(buffer, TIMESIZE, "%H:%M", timeinfo);
+  strftime(buffer, TIMESIZE, "%H:%M", &timeinfo);
 
   return(std::string(buffer));     
 }
@@ -28,6 +28,7 @@
 #include "tnlNetBase.h"
 #include "tnlVector.h"
 #include "tnlLog.h"
+#include "tnlThread.h"
 
 namespace TNL
 {
@@ -41,6 +42,56 @@ U32 NetClassRep::mClassCRC[NetClassGroupCount] = {INITIAL_CRC_VALUE, };
 
 bool NetClassRep::mInitialized = false;
 
+GhostUpdateProfile::GhostUpdateProfile()
+{
+   clear();
+}
+
+void GhostUpdateProfile::clear()
+{
+   updateCount = 0;
+   bitsUsed = 0;
+   packTime = 0;
+
+   for(U32 i = 0; i < MaskBitCount; i++)
+   {
+      maskBitUpdateCount[i] = 0;
+      maskBitBitsUsed[i] = 0;
+   }
+}
+
+void GhostUpdateProfile::addUpdate(U32 updateMask, U32 bitCount, S64 time)
+{
+   updateCount++;
+   bitsUsed += bitCount;
+   packTime += time;
+
+   for(U32 i = 0; updateMask; i++, updateMask >>= 1)
+      if(updateMask & 1)
+      {
+         maskBitUpdateCount[i]++;
+         maskBitBitsUsed[i] += bitCount;
+      }
+}
+
+void GhostUpdateProfile::add(const GhostUpdateProfile &other)
+{
+   updateCount += other.updateCount;
+   bitsUsed += other.bitsUsed;
+   packTime += other.packTime;
+
+   for(U32 i = 0; i < MaskBitCount; i++)
+   {
+      maskBitUpdateCount[i] += other.maskBitUpdateCount[i];
+      maskBitBitsUsed[i] += other.maskBitBitsUsed[i];
+   }
+}
+
+F64 GhostUpdateProfile::getPackMilliseconds() const
+{
+   return Platform::getHighPrecisionMilliseconds(packTime);
+}
+
 NetClassRep::NetClassRep()
 {
    mInitialUpdateCount = 0;
@@ -49,6 +100,53 @@ NetClassRep::NetClassRep()
    mPartialUpdateBitsUsed = 0;
 }
 
+// Update stats are shared by every connection, which may be writing packets on different threads
+static Mutex &getUpdateStatsLock()
+{
+   static Mutex updateStatsLock;
+   return updateStatsLock;
+}
+
+void NetClassRep::addInitialUpdate(U32 bitCount)
+{
+   getUpdateStatsLock().lock();
+   mInitialUpdateCount++;
+   mInitialUpdateBitsUsed += bitCount;
+   getUpdateStatsLock().unlock();
+}
+
+void NetClassRep::addPartialUpdate(U32 bitCount)
+{
+   getUpdateStatsLock().lock();
+   mPartialUpdateCount++;
+   mPartialUpdateBitsUsed += bitCount;
+   getUpdateStatsLock().unlock();
+}
+
+void NetClassRep::addGhostProfileUpdate(U32 updateMask, U32 bitCount, S64 time)
+{
+   getUpdateStatsLock().lock();
+   mGhostProfile.addUpdate(updateMask, bitCount, time);
+   getUpdateStatsLock().unlock();
+}
+
+GhostUpdateProfile NetClassRep::getGhostProfile() const
+{
+   getUpdateStatsLock().lock();
+   GhostUpdateProfile profile = mGhostProfile;
+   getUpdateStatsLock().unlock();
+
+   return profile;
+}
+
+void NetClassRep::resetGhostProfiles()
+{
+   getUpdateStatsLock().lock();
+   for(NetClassRep *walk = mClassLinkList; walk; walk = walk->mNextClass)
+      walk->mGhostProfile.clear();
+   getUpdateStatsLock().unlock();
+}
+
 Object* NetClassRep::create(const char* className)
 {
    TNLAssert(mInitialized, "creating an object before NetClassRep::initialize.");
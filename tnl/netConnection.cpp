@@ -205,7 +205,7 @@ void NetConnection::keepAlive()
 
 //--------------------------------------------------------------------
 
-char NetConnection::mErrorBuffer[256];
+TNL_THREAD_LOCAL char NetConnection::mErrorBuffer[256];
 
 void NetConnection::setLastError(const char *fmt, ...)
 {
@@ -676,6 +676,15 @@ void NetConnection::handleNotify(U32 sequence, bool recvd)
 //--------------------------------------------------------------------
 
 void NetConnection::checkPacketSend(bool force, U32 curTime)
+{
+   if(!isPacketSendDue(force, curTime))
+      return;
+
+   PacketStream stream(mCurrentPacketSendSize);
+   sendPendingPacket(writePendingPacket(&stream, curTime), &stream);
+}
+
+bool NetConnection::isPacketSendDue(bool force, U32 curTime)
 {
    U32 delay = mCurrentPacketSendPeriod;
 
@@ -689,13 +698,18 @@ void NetConnection::checkPacketSend(bool force, U32 curTime)
             delay *= (mLastSendSeq - mHighestAckedSeq - 5) * 2;
 
          if(curTime - mLastUpdateTime + mSendDelayCredit < delay)
-            return;
+            return false;
       
          mSendDelayCredit = curTime - (mLastUpdateTime + delay - mSendDelayCredit);
          if(mSendDelayCredit > 1000)
             mSendDelayCredit = 1000;
       }
    }
+   return true;
+}
+
+NetConnection::PendingPacketType NetConnection::writePendingPacket(PacketStream *stream, U32 curTime)
+{
    prepareWritePacket();
    if(windowFull() || !isDataToTransmit())
    {
@@ -717,17 +731,24 @@ void NetConnection::checkPacketSend(bool force, U32 curTime)
          {         
             mLastSeqRecvdAck = mLastSeqRecvd;
             mLastAckTime = curTime;
-            sendAckPacket();
+            return PendingAck;
          }
       }
-      return;
+      return PendingNothing;
    }
-   PacketStream stream(mCurrentPacketSendSize);
    mLastUpdateTime = curTime;
 
-   writeRawPacket(&stream, DataPacket);   
+   writeRawPacket(stream, DataPacket);   
 
-   sendPacket(&stream);
+   return PendingData;
+}
+
+void NetConnection::sendPendingPacket(PendingPacketType type, PacketStream *stream)
+{
+   if(type == PendingAck)
+      sendAckPacket();
+   else if(type == PendingData)
+      sendPacket(stream);
 }
 
 bool NetConnection::windowFull()
@@ -33,6 +33,7 @@
 #include "tnlNetObject.h"
 #include "tnlClientPuzzle.h"
 #include "tnlCertificate.h"
+#include "tnlThread.h"
 #include <tomcrypt.h>
 
 
@@ -57,6 +58,7 @@ NetInterface::NetInterface(const Address &bindAddress) : mSocket(bindAddress)
       mConnectionHashTable[i] = NULL;
    mSendPacketList = NULL;
    mCurrentTime = Platform::getRealMilliseconds();
+   mPacketWriterPool = NULL;
 }
 
 NetInterface::~NetInterface()
@@ -74,6 +76,7 @@ NetInterface::~NetInterface()
       free(mSendPacketList);
       mSendPacketList = next;
    }
+   delete mPacketWriterPool;
 }
 
 Address NetInterface::getFirstBoundInterfaceAddress()
@@ -322,6 +325,70 @@ void NetInterface::addConnection(NetConnection *conn)
 // NetInterface timeout and packet send processing
 //-----------------------------------------------------------------------------
 
+void NetInterface::setPacketWriterThreadCount(U32 threadCount)
+{
+   if(threadCount == getPacketWriterThreadCount())
+      return;
+
+   delete mPacketWriterPool;
+   mPacketWriterPool = threadCount ? new WorkerPool(threadCount) : NULL;
+}
+
+U32 NetInterface::getPacketWriterThreadCount() const
+{
+   return mPacketWriterPool ? mPacketWriterPool->getThreadCount() : 0;
+}
+
+bool NetInterface::setBatchedIO(bool enabled)
+{
+   return mSocket.setBatchedIO(enabled);
+}
+
+void NetInterface::writePendingPacket(void *netInterface, U32 index)
+{
+   NetInterface *theInterface = static_cast<NetInterface *>(netInterface);
+   PendingPacket &packet = theInterface->mPendingPackets[index];
+
+   packet.type = packet.connection->writePendingPacket(packet.stream, theInterface->getCurrentTime());
+}
+
+// Each connection's scope query and packet writing only touches that connection and the objects it
+// ghosts, so those can be spread across the pool.  Deciding who's due, and the actual sending, stay
+// on this thread, and the sends happen in the same order as checkPacketSend() would have done them.
+// Nothing else runs while the pool is busy, so the game world holds still for the whole batch.
+void NetInterface::writeAndSendPacketsInParallel()
+{
+   mPendingPackets.clear();
+
+   for(S32 i = 0; i < mConnectionList.size(); i++)
+   {
+      NetConnection *conn = mConnectionList[i];
+      if(!conn->isPacketSendDue(false, getCurrentTime()))
+         continue;
+
+      mPendingPackets.resize(mPendingPackets.size() + 1);
+      PendingPacket &packet = mPendingPackets.last();
+      packet.connection = conn;
+      packet.type = NetConnection::PendingNothing;
+      packet.stream = new PacketStream(conn->mCurrentPacketSendSize);
+   }
+
+   mPacketWriterPool->run(writePendingPacket, this, mPendingPackets.size());
+
+   for(S32 i = 0; i < mPendingPackets.size(); i++)
+   {
+      PendingPacket &packet = mPendingPackets[i];
+
+      // An earlier send may have caused this connection to be dropped
+      if(packet.connection->getConnectionState() == NetConnection::Connected)
+         packet.connection->sendPendingPacket(packet.type, packet.stream);
+
+      delete packet.stream;
+   }
+
+   mPendingPackets.clear();     // Release our references to the connections
+}
+
 void NetInterface::processConnections()
 {
    mCurrentTime = Platform::getRealMilliseconds();
@@ -353,8 +420,11 @@ void NetInterface::processConnections()
    }
 
    NetObject::collapseDirtyList(); // collapse all the mask bits...
-   for(S32 i = 0; i < mConnectionList.size(); i++)
-      mConnectionList[i]->checkPacketSend(false, getCurrentTime());
+   if(mPacketWriterPool)
+      writeAndSendPacketsInParallel();
+   else
+      for(S32 i = 0; i < mConnectionList.size(); i++)
+         mConnectionList[i]->checkPacketSend(false, getCurrentTime());
 
    if(U32(getCurrentTime() - mLastTimeoutCheckTime) > TimeoutCheckInterval)
    {
@@ -439,6 +509,8 @@ void NetInterface::processConnections()
          break;
       }
    }
+
+   mSocket.flushSends();
 }
 
 //-----------------------------------------------------------------------------
@@ -456,6 +528,8 @@ void NetInterface::checkIncomingPackets()
    // read out all the available packets:
    while((error = stream.recvfrom(mSocket, &sourceAddress)) == NoError)
       processPacket(sourceAddress, &stream);
+
+   mSocket.flushSends();      // Replies to handshakes and info requests
 }
 
 void NetInterface::processPacket(const Address &sourceAddress, BitStream *pStream)
@@ -31,9 +31,9 @@
 
 namespace TNL {
 
-GhostConnection *NetObject::mRPCSourceConnection = NULL;
-GhostConnection *NetObject::mRPCDestConnection = NULL;
-bool NetObject::mIsInitialUpdate = false;
+TNL_THREAD_LOCAL GhostConnection *NetObject::mRPCSourceConnection = NULL;
+TNL_THREAD_LOCAL GhostConnection *NetObject::mRPCDestConnection = NULL;
+TNL_THREAD_LOCAL bool NetObject::mIsInitialUpdate = false;
 
 NetObject::NetObject()
 {
@@ -72,7 +72,7 @@ NetObject::~NetObject()
    }
 }
 
-NetObject *NetObject::mDirtyList = NULL;
+TNL_THREAD_LOCAL NetObject *NetObject::mDirtyList = NULL;
 
 void NetObject::setMaskBits(U32 orMask)
 {
@@ -30,6 +30,7 @@
 #include "tnlNetStringTable.h"
 #include "tnlDataChunker.h"
 #include "tnlNetInterface.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
@@ -110,6 +111,21 @@ void initToLowerTable()
    sgToLowerTableInit = false;
 }
 
+// Serializes access to the table, so StringTableEntries can be created, copied and destroyed from
+// packet writer threads.  Never deleted, since entries in other static objects may outlive any
+// static we could put it in.
+Mutex &getTableLock()
+{
+   static Mutex *tableLock = new Mutex;
+   return *tableLock;
+}
+
+struct TableLock
+{
+   TableLock()  { getTableLock().lock(); }
+   ~TableLock() { getTableLock().unlock(); }
+};
+
 } // namespace {}
 
 U32 hashString(const char* str)
@@ -228,6 +244,7 @@ void validate()
 
 StringTableEntryId insertn(const char* val, S32 len, const bool caseSens)
 {
+   TableLock lock;
    if(!val || !*val || len == 0)
       return 0;
    if(!mBuckets)
@@ -293,6 +310,7 @@ StringTableEntryId insertn(const char* val, S32 len, const bool caseSens)
 //--------------------------------------
 StringTableEntryId lookup(const char* val, const bool  caseSens)
 {
+   TableLock lock;
    StringTableEntryId *walk;
    Node *stringNode;
    U32 key = hashString(val);
@@ -311,6 +329,7 @@ StringTableEntryId lookup(const char* val, const bool  caseSens)
 //--------------------------------------
 StringTableEntryId lookupn(const char* val, S32 len, const bool  caseSens)
 {
+   TableLock lock;
    StringTableEntryId *walk;
    Node *stringNode;
    U32 key = hashStringn(val, len);
@@ -396,11 +415,13 @@ void compact()
 
 void incRef(StringTableEntryId index)
 {
+   TableLock lock;
     mNodeList[index]->refCount++;
 }
 
 void decRef(StringTableEntryId index)
 {
+   TableLock lock;
    Node *theNode = mNodeList[index];
    if(--theNode->refCount)
       return;
@@ -435,6 +456,8 @@ const char *getString(StringTableEntryId index)
    if(!index)
       return "";
 
+   TableLock lock;
+
    return mNodeList[index]->stringData;
 }
 
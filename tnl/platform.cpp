@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <signal.h>
 #include <sys/time.h>
+#include <time.h>
 
 #endif
 
@@ -414,6 +415,8 @@ U32 x86UNIXGetTickCountMicro()
    return uSecs;
 }
 
+// Counts nanoseconds on the monotonic clock where there is one, so intervals come out right to well under a
+// millisecond, and don't jump when someone sets the system clock.  Otherwise, falls back to milliseconds of wall time.
 class UnixTimer
 {
    public:
@@ -422,11 +425,16 @@ class UnixTimer
       }
       S64 getCurrentTime()
       {
-         return x86UNIXGetTickCount();
+#ifdef CLOCK_MONOTONIC
+         timespec t;
+         if(::clock_gettime(CLOCK_MONOTONIC, &t) == 0)
+            return S64(t.tv_sec) * 1000000000 + t.tv_nsec;
+#endif
+         return S64(x86UNIXGetTickCount()) * 1000000;
       }
       F64 convertToMS(S64 delta)
       {
-         return F64(delta);
+         return F64(delta) / 1000000;
       }
 };
 
@@ -476,6 +484,15 @@ bool Platform::AlertRetry(const char *windowTitle, const char *message)
 
 #endif
 
+void Platform::getLocalTime(time_t time, tm &result)
+{
+#if defined (TNL_OS_WIN32)
+   localtime_s(&result, &time);
+#else
+   localtime_r(&time, &result);
+#endif
+}
+
 /*
 char *strdup(const char *src)
 {
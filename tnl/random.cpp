@@ -28,6 +28,7 @@
 #include "tnl.h"
 #include "tnlRandom.h"
 #include "tnlJournal.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
@@ -37,6 +38,13 @@ static bool initialized = false;
 static prng_state prng;
 static U32 entropyAdded = 0;
 
+// The generator is shared by every thread, including those of servers hosting several arenas
+static Mutex &getRandomLock()
+{
+   static Mutex randomLock;
+   return randomLock;
+}
+
 static void initialize()
 {
    initialized = true;
@@ -46,8 +54,10 @@ static void initialize()
 
 void *getState()                                      // Doesn't seem to be called
 {
+   getRandomLock().lock();
    if(!initialized)
       initialize();
+   getRandomLock().unlock();
 
    return &prng;
 }
@@ -56,6 +66,8 @@ void *getState()                                      // Doesn't seem to be call
 // Needs at least 16 bytes of entropy to be effective.  Can call repeated times to accumulate entropy.
 void addEntropy(const U8 *randomData, U32 dataLen)    
 {
+   getRandomLock().lock();
+
    if(!initialized)
       initialize();
    yarrow_add_entropy(randomData, dataLen, &prng);
@@ -66,14 +78,20 @@ void addEntropy(const U8 *randomData, U32 dataLen)
       yarrow_ready(&prng);
       entropyAdded = 0;
    }
+
+   getRandomLock().unlock();
 }
 
 void read(U8 *outBuffer, U32 randomLen)
 {
+   getRandomLock().lock();
+
    if(!initialized)
       initialize();
 
    yarrow_read(outBuffer, randomLen, &prng);
+
+   getRandomLock().unlock();
 }
 
 U32 readI()
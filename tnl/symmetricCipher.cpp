@@ -28,14 +28,165 @@
 #include "tnlSymmetricCipher.h"
 #include "tnlByteBuffer.h"
 
+#if defined(TNL_CPU_X86) && (defined(TNL_COMPILER_VISUALC) || defined(__GNUC__))
+#  define TNL_AES_NI
+#  include <wmmintrin.h>
+#  ifdef TNL_COMPILER_VISUALC
+#     include <intrin.h>
+#     define TNL_AES_TARGET
+#  else
+#     include <cpuid.h>
+#     define TNL_AES_TARGET __attribute__((target("aes,sse2")))   // So we needn't build everything with -maes
+#  endif
+#elif defined(TNL_CPU_ARM64) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#  define TNL_AES_ARMV8
+#  include <arm_neon.h>
+#endif
+
 namespace TNL {
 
-SymmetricCipher::SymmetricCipher(const U8 symmetricKey[SymmetricCipher::KeySize], const U8 initVector[SymmetricCipher::BlockSize])
+#if defined(TNL_AES_NI)
+
+static bool cpuHasAES()
+{
+#  ifdef TNL_COMPILER_VISUALC
+   int info[4];
+   __cpuid(info, 1);
+   return (info[2] & (1 << 25)) != 0;
+#  else
+   unsigned int eax, ebx, ecx, edx;
+   return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES) != 0;
+#  endif
+}
+
+
+// Four blocks at a time where we can, as each instruction takes several cycles to produce its result, but the CPU
+// can be working on several at once
+TNL_AES_TARGET static void encryptBlocksAESNI(const U8 *roundKeys, U32 rounds, const U8 *in, U8 *out, U32 blockCount)
+{
+   __m128i keys[SymmetricCipher::MaxRounds + 1];
+   for(U32 r = 0; r <= rounds; r++)
+      keys[r] = _mm_loadu_si128((const __m128i *)(roundKeys + r * 16));
+
+   U32 i = 0;
+   for(; i + 4 <= blockCount; i += 4)
+   {
+      __m128i b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + (i + 0) * 16)), keys[0]);
+      __m128i b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + (i + 1) * 16)), keys[0]);
+      __m128i b2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + (i + 2) * 16)), keys[0]);
+      __m128i b3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + (i + 3) * 16)), keys[0]);
+
+      for(U32 r = 1; r < rounds; r++)
+      {
+         b0 = _mm_aesenc_si128(b0, keys[r]);
+         b1 = _mm_aesenc_si128(b1, keys[r]);
+         b2 = _mm_aesenc_si128(b2, keys[r]);
+         b3 = _mm_aesenc_si128(b3, keys[r]);
+      }
+
+      _mm_storeu_si128((__m128i *)(out + (i + 0) * 16), _mm_aesenclast_si128(b0, keys[rounds]));
+      _mm_storeu_si128((__m128i *)(out + (i + 1) * 16), _mm_aesenclast_si128(b1, keys[rounds]));
+      _mm_storeu_si128((__m128i *)(out + (i + 2) * 16), _mm_aesenclast_si128(b2, keys[rounds]));
+      _mm_storeu_si128((__m128i *)(out + (i + 3) * 16), _mm_aesenclast_si128(b3, keys[rounds]));
+   }
+
+   for(; i < blockCount; i++)
+   {
+      __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + i * 16)), keys[0]);
+
+      for(U32 r = 1; r < rounds; r++)
+         b = _mm_aesenc_si128(b, keys[r]);
+
+      _mm_storeu_si128((__m128i *)(out + i * 16), _mm_aesenclast_si128(b, keys[rounds]));
+   }
+}
+
+#elif defined(TNL_AES_ARMV8)
+
+static bool cpuHasAES()
+{
+   return true;      // We were only built this way because the target CPU is known to have them
+}
+
+
+// vaeseq_u8 does AddRoundKey before SubBytes and ShiftRows, rather than after, so the key schedule lines up one
+// round later than for AES-NI
+static void encryptBlocksARMv8(const U8 *roundKeys, U32 rounds, const U8 *in, U8 *out, U32 blockCount)
+{
+   for(U32 i = 0; i < blockCount; i++)
+   {
+      uint8x16_t b = vld1q_u8(in + i * 16);
+
+      for(U32 r = 0; r < rounds - 1; r++)
+         b = vaesmcq_u8(vaeseq_u8(b, vld1q_u8(roundKeys + r * 16)));
+
+      b = vaeseq_u8(b, vld1q_u8(roundKeys + (rounds - 1) * 16));
+      vst1q_u8(out + i * 16, veorq_u8(b, vld1q_u8(roundKeys + rounds * 16)));
+   }
+}
+
+#else
+
+static bool cpuHasAES()
+{
+   return false;
+}
+
+#endif
+
+
+bool SymmetricCipher::smUseHardwareAES = cpuHasAES();
+
+bool SymmetricCipher::isHardwareAESAvailable()
+{
+   return cpuHasAES();
+}
+
+bool SymmetricCipher::setHardwareAESEnabled(bool enabled)
+{
+   smUseHardwareAES = enabled && cpuHasAES();
+   return smUseHardwareAES;
+}
+
+
+void SymmetricCipher::setupKey(const U8 symmetricKey[KeySize])
 {
    rijndael_setup(symmetricKey, KeySize, 0, &mSymmetricKey);
+
+   mUseHardwareAES = smUseHardwareAES;
+
+   // libtomcrypt keeps the schedule as big-endian words; the AES instructions want the bytes in order
+   U32 words = (mSymmetricKey.rijndael.Nr + 1) * (BlockSize >> 2);
+   for(U32 i = 0; i < words; i++)
+      STORE32H(mSymmetricKey.rijndael.eK[i], mRoundKeys + i * 4);
+}
+
+void SymmetricCipher::encryptBlocks(const U8 *in, U8 *out, U32 blockCount)
+{
+#if defined(TNL_AES_NI)
+   if(mUseHardwareAES)
+   {
+      encryptBlocksAESNI(mRoundKeys, mSymmetricKey.rijndael.Nr, in, out, blockCount);
+      return;
+   }
+#elif defined(TNL_AES_ARMV8)
+   if(mUseHardwareAES)
+   {
+      encryptBlocksARMv8(mRoundKeys, mSymmetricKey.rijndael.Nr, in, out, blockCount);
+      return;
+   }
+#endif
+
+   for(U32 i = 0; i < blockCount; i++)
+      rijndael_ecb_encrypt(in + i * BlockSize, out + i * BlockSize, &mSymmetricKey);
+}
+
+SymmetricCipher::SymmetricCipher(const U8 symmetricKey[SymmetricCipher::KeySize], const U8 initVector[SymmetricCipher::BlockSize])
+{
+   setupKey(symmetricKey);
    memcpy(mInitVector, initVector, BlockSize);
    memcpy(mCounter, initVector, BlockSize);
-   rijndael_ecb_encrypt((U8 *) mCounter, mPad, &mSymmetricKey);
+   encryptBlocks((U8 *) mCounter, mPad, 1);
    mPadLen = 0;
 }
 
@@ -45,16 +196,16 @@ SymmetricCipher::SymmetricCipher(const ByteBuffer *theByteBuffer)
    {
       U8 buffer[KeySize];
       memset(buffer, 0, KeySize);
-      rijndael_setup(buffer, KeySize, 0, &mSymmetricKey);
+      setupKey(buffer);
       memcpy(mInitVector, buffer, BlockSize);
    }
    else
    {
-      rijndael_setup(theByteBuffer->getBuffer(), KeySize, 0, &mSymmetricKey);
+      setupKey(theByteBuffer->getBuffer());
       memcpy(mInitVector, theByteBuffer->getBuffer() + KeySize, BlockSize);
    }
    memcpy(mCounter, mInitVector, BlockSize);
-   rijndael_ecb_encrypt((U8 *) mCounter, mPad, &mSymmetricKey);
+   encryptBlocks((U8 *) mCounter, mPad, 1);
    mPadLen = 0;
 }
 
@@ -65,37 +216,93 @@ void SymmetricCipher::setupCounter(U32 counterValue1, U32 counterValue2, U32 cou
    mCounter[2] = convertHostToLEndian(convertLEndianToHost(mInitVector[2]) + counterValue3);
    mCounter[3] = convertHostToLEndian(convertLEndianToHost(mInitVector[3]) + counterValue4);
 
-   rijndael_ecb_encrypt((U8 *) mCounter, mPad, &mSymmetricKey);
+   encryptBlocks((U8 *) mCounter, mPad, 1);
    mPadLen = 0;
 }
 
+// Each pad is the previous block of cipher text, encrypted, so we can't work out the next until we've finished this one
 void SymmetricCipher::encrypt(const U8 *plainText, U8 *cipherText, U32 len)
 {
-   while(len-- > 0)
+   while(len > 0)
    {
       if(mPadLen == BlockSize)
       {
          // we've reached the end of the pad, so compute a new pad
-         rijndael_ecb_encrypt(mPad, mPad, &mSymmetricKey);
+         encryptBlocks(mPad, mPad, 1);
          mPadLen = 0;
       }
-      U8 encryptedChar = *plainText++ ^ mPad[mPadLen];
-      mPad[mPadLen++] = *cipherText++ = encryptedChar;
+
+      U32 count = getMin(len, U32(BlockSize) - mPadLen);
+
+      if(count == BlockSize)     // A whole block -- the usual case -- can be done a word at a time
+      {
+         U64 text[2], pad[2];
+         memcpy(text, plainText, BlockSize);
+         memcpy(pad, mPad, BlockSize);
+         pad[0] ^= text[0];
+         pad[1] ^= text[1];
+         memcpy(mPad, pad, BlockSize);
+         memcpy(cipherText, pad, BlockSize);
+      }
+      else
+      {
+         for(U32 i = 0; i < count; i++)
+         {
+            U8 encryptedChar = plainText[i] ^ mPad[mPadLen + i];
+            mPad[mPadLen + i] = cipherText[i] = encryptedChar;
+         }
+      }
+
+      plainText += count;
+      cipherText += count;
+      mPadLen += count;
+      len -= count;
    }
 }
 
+// Here we have all the cipher text up front, so we can work out the pads for several blocks at once
 void SymmetricCipher::decrypt(const U8 *cipherText, U8 *plainText, U32 len)
 {
-   while(len-- > 0)
+   static const U32 BatchBlocks = 8;
+
+   // First use up what's left of the current pad
+   U32 count = getMin(len, U32(BlockSize) - mPadLen);
+   for(U32 i = 0; i < count; i++)
    {
-      if(mPadLen == BlockSize)
-      {
-         rijndael_ecb_encrypt(mPad, mPad, &mSymmetricKey);
-         mPadLen = 0;
-      }
-      U8 encryptedChar = *cipherText++;
-      *plainText++ = encryptedChar ^ mPad[mPadLen];
-      mPad[mPadLen++] = encryptedChar;
+      U8 encryptedChar = cipherText[i];
+      plainText[i] = encryptedChar ^ mPad[mPadLen + i];
+      mPad[mPadLen + i] = encryptedChar;
+   }
+
+   cipherText += count;
+   plainText += count;
+   mPadLen += count;
+   len -= count;
+
+   U8 pads[BatchBlocks * BlockSize];
+
+   while(len > 0)
+   {
+      U32 blocks = getMin((len + BlockSize - 1) / BlockSize, BatchBlocks);
+      U32 bytes = getMin(len, blocks * BlockSize);
+      U32 lastBlockStart = (blocks - 1) * BlockSize;
+
+      // The first pad comes from the last block we did, which is in mPad; the rest from the blocks before them here.
+      // Everything we need from cipherText gets copied before we write to plainText, as they may be the same.
+      memcpy(pads, mPad, BlockSize);
+      memcpy(pads + BlockSize, cipherText, lastBlockStart);
+      encryptBlocks(pads, pads, blocks);
+
+      mPadLen = bytes - lastBlockStart;
+      memcpy(mPad, pads + lastBlockStart, BlockSize);
+      memcpy(mPad, cipherText + lastBlockStart, mPadLen);
+
+      for(U32 i = 0; i < bytes; i++)
+         plainText[i] = cipherText[i] ^ pads[i];
+
+      cipherText += bytes;
+      plainText += bytes;
+      len -= bytes;
    }
 }
 
@@ -335,4 +335,120 @@ void ThreadQueue::dispatchResponseCalls()
    unlock();
 }
 
+//-----------------------------------------------------------------------------
+
+WorkerPool::WorkerThread::WorkerThread(WorkerPool *pool)
+{
+   mPool = pool;
+}
+
+U32 WorkerPool::WorkerThread::run()
+{
+   WorkerPool *pool = mPool;
+
+   for(;;)
+   {
+      pool->mWorkAvailable.wait();
+
+      // Read under the lock so we see the flag set by the destructor
+      pool->mLock.lock();
+      bool shuttingDown = pool->mShuttingDown;
+      pool->mLock.unlock();
+
+      if(!shuttingDown)
+         pool->runJobs();
+
+      // Last thing we touch -- the pool may be destroyed as soon as this is signalled
+      pool->mWorkerFinished.increment();
+
+      if(shuttingDown)
+         return 0;
+   }
+}
+
+WorkerPool::WorkerPool(U32 threadCount)
+{
+   mJobFunction = NULL;
+   mJobContext = NULL;
+   mJobCount = 0;
+   mNextJob = 0;
+   mShuttingDown = false;
+
+#ifdef TNL_NO_THREADS
+   threadCount = 0;     // Thread::start() would run our worker loop on this thread, and never return
+#endif
+
+   for(U32 i = 0; i < threadCount; i++)
+   {
+      Thread *theThread = new WorkerThread(this);
+      mThreads.push_back(theThread);
+      theThread->start();
+   }
+}
+
+WorkerPool::~WorkerPool()
+{
+   mLock.lock();
+   mShuttingDown = true;
+   mLock.unlock();
+
+   mWorkAvailable.increment(mThreads.size());
+
+   for(S32 i = 0; i < mThreads.size(); i++)
+      mWorkerFinished.wait();
+
+   for(S32 i = 0; i < mThreads.size(); i++)
+      delete mThreads[i];
+}
+
+U32 WorkerPool::getThreadCount() const
+{
+   return mThreads.size();
+}
+
+void WorkerPool::runJobs()
+{
+   for(;;)
+   {
+      mLock.lock();
+      if(mNextJob >= mJobCount)
+      {
+         mLock.unlock();
+         return;
+      }
+      U32 index = mNextJob++;
+      mLock.unlock();
+
+      mJobFunction(mJobContext, index);
+   }
+}
+
+void WorkerPool::run(JobFunction jobFunction, void *context, U32 jobCount)
+{
+   if(jobCount == 0)
+      return;
+
+   mLock.lock();
+   mJobFunction = jobFunction;
+   mJobContext = context;
+   mJobCount = jobCount;
+   mNextJob = 0;
+   mLock.unlock();
+
+   // Don't bother waking more workers than there are jobs for them to do; we'll take one ourselves
+   U32 workers = getMin(U32(mThreads.size()), jobCount - 1);
+   mWorkAvailable.increment(workers);
+
+   runJobs();
+
+   for(U32 i = 0; i < workers; i++)
+      mWorkerFinished.wait();
+
+   mLock.lock();
+   mJobFunction = NULL;
+   mJobContext = NULL;
+   mJobCount = 0;
+   mLock.unlock();
+}
+
 };
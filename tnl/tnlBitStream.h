@@ -81,6 +81,9 @@ protected:
    char mStringBuffer[256];
 
    bool resizeBits(U32 numBitsNeeded);
+
+   /// Can the two 64-bit words holding the bits from bitPosition on be loaded without running off the end of the buffer?
+   bool wordFits(U32 bitPosition) const { return ((bitPosition >> 6) + 2) * sizeof(U64) <= getBufferSize(); }
 public:
 
    /// @name Constructors
@@ -354,6 +357,19 @@ inline bool BitStream::readFlag()
    bitNum++;
    return ret;
 }
+
+inline bool BitStream::writeFlag(bool val)
+{
+   if(bitNum + 1 > maxWriteBitNum)
+      if(!resizeBits(1))
+         return false;
+   if(val)
+      *(getBuffer() + (bitNum >> 3)) |= (1 << (bitNum & 0x7));
+   else
+      *(getBuffer() + (bitNum >> 3)) &= ~(1 << (bitNum & 0x7));
+   bitNum++;
+   return (val);
+}
 //extern void logprintf(const char *format, ...);
 
 inline void BitStream::writeIntAt(U32 value, U8 bitCount, U32 bitPosition)
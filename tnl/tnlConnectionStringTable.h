@@ -101,6 +101,9 @@ public:
    void packetReceived(PacketList *note);
    void packetDropped(PacketList *note);
    void packetRewind(PacketList *note, PacketEntry *p_entry);
+
+   /// Forget which strings the other side has, so each one is sent in full the next time it's used
+   void resetReceiveConfirmations();
 };
 
 };
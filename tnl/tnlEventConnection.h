@@ -82,6 +82,11 @@ protected:
    void clearSendEvents();
    void clearRecvEvents();
 
+   /// Starts numbering ordered events from the beginning again, as on a new connection.  Only possible when
+   /// every event posted so far has been sent and acknowledged; returns false otherwise.  The receiving side
+   /// does the same with clearRecvEvents() at the matching point in the stream.
+   bool restartEventSequence();
+
    enum DebugConstants
    {
       DebugChecksum = 0xF00DBAAD,
@@ -117,6 +122,9 @@ protected:
 private:
    static ClassChunker<EventNote> mEventNoteChunker; ///< Quick memory allocator for net event notes
 
+   static EventNote *allocEventNote();       ///< Takes a note from mEventNoteChunker; safe from packet writer threads
+   static void freeEventNote(EventNote *note);
+
    EventNote *mSendEventQueueHead;          ///< Head of the list of events to be sent to the remote host
    EventNote *mSendEventQueueTail;          ///< Tail of the list of events to be sent to the remote host.  New events are tagged on to the end of this list
    EventNote *mUnorderedSendEventQueueHead; ///< Head of the list of events sent without ordering information
@@ -136,7 +144,7 @@ private:
 protected:
    U32 mEventClassCount;      ///< Number of NetEvent classes supported by this connection
    U32 mEventClassBitSize;    ///< Bit field width of NetEvent class count.  i.e. how many bits needed to represent all classes?
-   U32 mEventClassVersion;    ///< The highest version number of events on this connection.  --> assigned, but never read
+   U32 mEventClassVersion;    ///< The highest version number of events on this connection.
 
    /// Writes the NetEvent class count into the stream, so that the remote
    /// host can negotiate a class count for the connection
@@ -168,6 +168,9 @@ protected:
 
    U32 mGhostClassCount;
    U32 mGhostClassBitSize;
+
+   static bool mProfilingEnabled;      ///< Are ghost updates being profiled?
+   GhostUpdateProfile mGhostProfile;   ///< Updates written on this connection while profiling was on
 public:
    GhostConnection();
    ~GhostConnection();
@@ -181,6 +184,15 @@ public:
    /// Returns the sequence number of this ghosting session.
    U32 getGhostingSequence() { return mGhostingSequence; }
 
+   /// Turns profiling of ghost updates on or off for all connections.  While it is on, the bits
+   /// and time used by each update are recorded against the object's NetClassRep and this connection.
+   static void setProfilingEnabled(bool enabled) { mProfilingEnabled = enabled; }
+   static bool isProfilingEnabled() { return mProfilingEnabled; }
+
+   /// Returns the ghost updates written on this connection while profiling was on.
+   const GhostUpdateProfile &getGhostProfile() const { return mGhostProfile; }
+   void resetGhostProfile() { mGhostProfile.clear(); }
+
    enum GhostConstants {
       ID_BIT_SIZE = 4,
       ID_BIT_OFFSET = 3,
@@ -105,6 +105,36 @@ enum NetClassMask {
 
 class Object;
 
+/// Bits and CPU time spent writing ghost updates, gathered while ghost profiling is
+/// on (see GhostConnection::setProfilingEnabled()).  One is kept for each NetClassRep
+/// and one for each GhostConnection.
+struct GhostUpdateProfile
+{
+   enum {
+      MaskBitCount = 32,   ///< Number of bits in an update mask
+   };
+
+   U32 updateCount;        ///< Number of updates written
+   U64 bitsUsed;           ///< Bits written by packUpdate
+   S64 packTime;           ///< Time spent in packUpdate, in high precision timer ticks
+
+   U32 maskBitUpdateCount[MaskBitCount];  ///< Number of updates whose mask included each bit
+   U64 maskBitBitsUsed[MaskBitCount];     ///< Bits written by the updates whose mask included each bit
+
+   GhostUpdateProfile();
+   void clear();
+
+   /// Records one update.  packUpdate doesn't say which of its bits went with which part of
+   /// the mask, so the whole update is charged to each bit set in updateMask.
+   void addUpdate(U32 updateMask, U32 bitCount, S64 time);
+
+   /// Adds the contents of another profile to this one.
+   void add(const GhostUpdateProfile &other);
+
+   /// Returns packTime in milliseconds.
+   F64 getPackMilliseconds() const;
+};
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 
@@ -210,6 +240,8 @@ protected:
    U32 mInitialUpdateCount;    ///< Number of objects of this class constructed over a connection.
    U32 mPartialUpdateCount;    ///< Number of objects of this class updated over a connection.
 
+   GhostUpdateProfile mGhostProfile;   ///< Updates of objects of this class written while ghost profiling was on.
+
    /// Next declared NetClassRep.
    ///
    /// These are stored in a linked list built by the macro constructs.
@@ -241,19 +273,17 @@ public:
    S32 getClassVersion() const;                    ///< Returns the version of this class.
    const char *getClassName() const;               ///< Returns the string class name.
 
-   /// Records bits used in the initial update of objects of this class.
-   void addInitialUpdate(U32 bitCount)
-   {
-      mInitialUpdateCount++;
-      mInitialUpdateBitsUsed += bitCount;
-   }
+   /// Records bits used in the initial update of objects of this class.  Safe to call from packet writer threads.
+   void addInitialUpdate(U32 bitCount);
 
-   /// Records bits used in a partial update of an object of this class.
-   void addPartialUpdate(U32 bitCount)
-   {
-      mPartialUpdateCount++;
-      mPartialUpdateBitsUsed += bitCount;
-   }
+   /// Records bits used in a partial update of an object of this class.  Safe to call from packet writer threads.
+   void addPartialUpdate(U32 bitCount);
+
+   /// Records an update of an object of this class written while ghost profiling is on.  Safe to call from packet writer threads.
+   void addGhostProfileUpdate(U32 updateMask, U32 bitCount, S64 time);
+
+   /// Returns a copy of the ghost profile for this class.
+   GhostUpdateProfile getGhostProfile() const;
 
    virtual Object *create() const = 0;             ///< Creates an instance of the class this represents.
 
@@ -283,6 +313,9 @@ public:
 
    /// Logs the bit usage information of all the NetClassReps
    static void logBitUsage();
+
+   /// Clears the ghost profiles of all the NetClassReps
+   static void resetGhostProfiles();
 };
 
 inline U32 NetClassRep::getClassId(NetClassGroup classGroup) const
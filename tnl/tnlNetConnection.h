@@ -466,7 +466,7 @@ public:
    U32 mConnectLastSendTime; ///< The send time of the last challenge or connect request.
 
 protected:
-   static char mErrorBuffer[256]; ///< String buffer that errors are written into
+   static TNL_THREAD_LOCAL char mErrorBuffer[256]; ///< String buffer that errors are written into.  Per-thread, for servers hosting arenas on several threads.
 public:
    static char *getErrorBuffer() { return mErrorBuffer; } ///< returns the current error buffer
    static void setLastError(const char *fmt,...);         ///< Sets an error string and notifies the currently processing connection that it should terminate.
@@ -559,6 +559,32 @@ public:
    /// If force is true and there is space in the window, it will always send a packet.
    void checkPacketSend(bool force, U32 currentTime);
 
+   /// What writePendingPacket() found needs sending.
+   enum PendingPacketType {
+      PendingNothing,   ///< Nothing to send this time around
+      PendingAck,       ///< Only an ack; it gets written when sendPendingPacket() sends it
+      PendingData,      ///< A data packet, already written into the stream
+   };
+
+   /// @name Split packet sending
+   ///
+   /// checkPacketSend() broken into its three steps, so NetInterface can write packets for several
+   /// connections at once.  isPacketSendDue() and sendPendingPacket() must be called from the main
+   /// thread; writePendingPacket() may be called from a worker thread, provided nothing else touches
+   /// this connection, and the objects it ghosts are not modified, until it returns.
+   /// @{
+
+   /// Returns true if it's time to send a packet to the remote host.
+   bool isPacketSendDue(bool force, U32 currentTime);
+
+   /// Runs the scope query and writes the next data packet into stream, but doesn't send anything.
+   PendingPacketType writePendingPacket(PacketStream *stream, U32 currentTime);
+
+   /// Sends what writePendingPacket() came up with.
+   void sendPendingPacket(PendingPacketType type, PacketStream *stream);
+
+   /// @}
+
    /// Connection state flags for a NetConnection instance.  If this list is modifed, please check if netInterface.cpp needs updates as well
    enum NetConnectionState {
       NotConnected=0,            ///< Initial state of a NetConnection instance - not connected
@@ -51,6 +51,7 @@ namespace TNL {
 
 class AsymmetricKey;
 class Certificate;
+class WorkerPool;
 struct ConnectionParameters;
 
 /// NetInterface class.
@@ -213,6 +214,22 @@ protected:
    };
    DelaySendPacket *mSendPacketList; /// List of delayed packets pending to send.
 
+   /// A packet written on mPacketWriterPool, waiting to be sent from the main thread.
+   struct PendingPacket
+   {
+      RefPtr<NetConnection> connection;         /// Held so sending an earlier packet can't delete it out from under us
+      NetConnection::PendingPacketType type;
+      PacketStream *stream;
+   };
+   WorkerPool *mPacketWriterPool;            /// NULL unless packets are being written in parallel; see setPacketWriterThreadCount()
+   Vector<PendingPacket> mPendingPackets;
+
+   /// WorkerPool job for writing mPendingPackets[index].
+   static void writePendingPacket(void *netInterface, U32 index);
+
+   /// Replaces the checkPacketSend() loop in processConnections() when mPacketWriterPool is in use.
+   void writeAndSendPacketsInParallel();
+
    enum NetInterfaceConstants {
       ChallengeRetryCount = 4,     /// Number of times to send connect challenge requests before giving up.
       ChallengeRetryTime = 2500,   /// Timeout interval in milliseconds before retrying connect challenge.
@@ -375,6 +392,21 @@ public:
    /// and pending connections.
    void processConnections();
 
+   /// Writes packets for all connections at once on a pool of threadCount worker threads, then
+   /// sends them in connection order from the calling thread.  Zero turns this off, and writes
+   /// and sends each packet in turn.  While this is on, NetObject::performScopeQuery(),
+   /// getUpdatePriority() and packUpdate() may run for several connections simultaneously, so
+   /// they must not modify anything shared between connections.
+   void setPacketWriterThreadCount(U32 threadCount);
+
+   /// Returns the number of packet writer threads, or zero if packets are written one at a time.
+   U32 getPacketWriterThreadCount() const;
+
+   /// Sends and receives packets in batches, where the platform can; see Socket::setBatchedIO().
+   /// Anything sent is queued until the end of the next checkIncomingPackets() or processConnections()
+   /// call.  Returns whether batching is now on.
+   bool setBatchedIO(bool enabled);
+
    /// Returns the list of connections on this NetInterface.
    Vector<NetConnection *> &getConnectionList() { return mConnectionList; }
 
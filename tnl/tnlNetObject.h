@@ -210,11 +210,11 @@ class NetObject : public Object
    NetObject *mNextDirtyList;
    U32 mDirtyMaskBits;
 
-   static NetObject *mDirtyList;
+   static TNL_THREAD_LOCAL NetObject *mDirtyList;   ///< Per-thread, so servers can host arenas on several threads
    U32 mNetIndex;              ///< The index of this ghost on the other side of the connection.
    GhostInfo *mFirstObjectRef; ///< Head of the linked list of GhostInfos for this object.
 
-   static bool mIsInitialUpdate; ///< Managed by GhostConnection - set to true when this is an initial update
+   static TNL_THREAD_LOCAL bool mIsInitialUpdate; ///< Managed by GhostConnection - set to true when this is an initial update.  Per-thread so connections can write packets in parallel.
    SafePtr<NetObject> mServerObject; ///< Direct pointer to the parent object on the server if it is a local connection
    GhostConnection *mOwningConnection; ///< The connection that owns this ghost, if it's a ghost
 protected:
@@ -229,10 +229,10 @@ protected:
    BitSet32 mNetFlags;  ///< Flags field describing this object, from NetFlag.
 
    /// RPC method source connection
-   static GhostConnection *mRPCSourceConnection;
+   static TNL_THREAD_LOCAL GhostConnection *mRPCSourceConnection;
 
    /// NetObject RPC method destination connection.
-   static GhostConnection *mRPCDestConnection;
+   static TNL_THREAD_LOCAL GhostConnection *mRPCDestConnection;
 
    /// Returns true if this pack/unpackUpdate is the initial one for the object
    bool isInitialUpdate() { return mIsInitialUpdate; }
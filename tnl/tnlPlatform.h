@@ -31,6 +31,8 @@
 #include "tnlTypes.h"
 #endif
 
+#include <time.h>
+
 namespace TNL {
 
 /// Platform specific functionality is gathered here to enable easier porting.
@@ -80,6 +82,9 @@ namespace Platform
    /// Put the process to sleep for the specified millisecond interva.
    void sleep(U32 msCount);
 
+   /// Breaks time down into local time, like localtime(), but safe to call from any thread.
+   void getLocalTime(time_t time, tm &result);
+
    /// checks the status of the memory allocation heap
    bool checkHeap();
 };
@@ -40,13 +40,17 @@ namespace TNL
 class ByteBuffer;
 
 /// Class for symmetric encryption of data across a connection.  Internally it uses
-/// the libtomcrypt AES algorithm to encrypt the data.
+/// the libtomcrypt AES algorithm to encrypt the data, in 128 bit cipher feedback mode.
+///
+/// Where the CPU has AES instructions (AES-NI on x86, the ARMv8 crypto extensions), we
+/// use them instead of libtomcrypt's portable code; the output is the same either way.
 class SymmetricCipher : public Object
 {
 public:
    enum {
       BlockSize = 16,
       KeySize = 16,
+      MaxRounds = 14,
    };
 private:
    U32 mCounter[BlockSize >> 2];
@@ -54,6 +58,14 @@ private:
    U8 mPad[BlockSize];
    symmetric_key mSymmetricKey;
    U32 mPadLen;
+
+   bool mUseHardwareAES;
+   U8 mRoundKeys[(MaxRounds + 1) * BlockSize];  ///< mSymmetricKey's encryption key schedule, as bytes, for the AES instructions
+
+   static bool smUseHardwareAES;
+
+   void setupKey(const U8 symmetricKey[KeySize]);
+   void encryptBlocks(const U8 *in, U8 *out, U32 blockCount);
 public:
    SymmetricCipher(const U8 symmetricKey[KeySize], const U8 initVector[BlockSize]);
    SymmetricCipher(const ByteBuffer *theByteBuffer);
@@ -61,6 +73,13 @@ public:
    void setupCounter(U32 counterValue1, U32 counterValue2, U32 counterValue3, U32 counterValue4);
    void encrypt(const U8 *plainText, U8 *cipherText, U32 len);
    void decrypt(const U8 *cipherText, U8 *plainText, U32 len);
+
+   /// Returns true if this CPU has AES instructions we know how to use.
+   static bool isHardwareAESAvailable();
+
+   /// Turns use of the AES instructions on or off for ciphers created from now on; it's
+   /// on by default where available.  Returns whether it's now on.
+   static bool setHardwareAESEnabled(bool enabled);
 };
 
 };
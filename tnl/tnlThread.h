@@ -200,6 +200,55 @@ public:
    void dispatchResponseCalls();
 };
 
+/// Fork/join pool of worker threads.  run() splits a batch of independent jobs
+/// between the workers and the calling thread, and doesn't return until every
+/// job is finished, so to the caller a batch looks like an ordinary function call.
+///
+/// With a thread count of zero (or when TNL_NO_THREADS is defined) the calling
+/// thread runs every job itself.
+class WorkerPool : public Object
+{
+public:
+   /// Function run once for each job in a batch; index is in [0, jobCount).
+   typedef void (*JobFunction)(void *context, U32 index);
+
+private:
+   class WorkerThread : public Thread
+   {
+      WorkerPool *mPool;
+      public:
+      WorkerThread(WorkerPool *);
+      U32 run();
+   };
+   friend class WorkerThread;
+
+   Vector<Thread *> mThreads;
+
+   JobFunction mJobFunction;  ///< Current batch; only valid while run() is executing
+   void *mJobContext;
+   U32 mJobCount;
+   U32 mNextJob;              ///< Next job to hand out, protected by mLock
+
+   bool mShuttingDown;
+
+   Semaphore mWorkAvailable;  ///< Incremented once per worker when a batch starts
+   Semaphore mWorkerFinished; ///< Incremented by each worker when it runs out of jobs
+   Mutex mLock;
+
+   void runJobs();            ///< Runs jobs from the current batch until there are none left
+
+public:
+   /// WorkerPool constructor.  threadCount specifies the number of worker threads that will be created.
+   WorkerPool(U32 threadCount);
+   ~WorkerPool();
+
+   U32 getThreadCount() const;
+
+   /// Calls jobFunction(context, i) for each i in [0, jobCount), spread across the worker
+   /// threads, and returns when they have all completed.  Only call this from one thread at a time.
+   void run(JobFunction jobFunction, void *context, U32 jobCount);
+};
+
 /// Declares a ThreadQueue method on a subclass of ThreadQueue.
 #define TNL_DECLARE_THREADQ_METHOD(func, args) \
    void func args; \
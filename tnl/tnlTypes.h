@@ -202,6 +202,14 @@ typedef unsigned long long  U64;  ///< Compiler independent unsigned 64-bit inte
 #  error "TNL: Unknown Compiler"
 #endif
 
+/// Storage class for static variables that need a separate copy on each thread.  Only use
+/// this with POD types -- neither compiler will run constructors for them.
+#if defined(TNL_COMPILER_VISUALC)
+#  define TNL_THREAD_LOCAL __declspec(thread)
+#else
+#  define TNL_THREAD_LOCAL __thread
+#endif
+
 
 
 //------------------------------------------------------------------------------
@@ -147,8 +147,11 @@ enum NetError {
 /// The Socket class encapsulates a platform's network socket.
 class Socket
 {
+   struct BatchedIO;
+
    S32 mPlatformSocket;    ///< The OS-level socket
    U32 mTransportProtocol; ///< The transport type this socket uses.
+   BatchedIO *mBatch;      ///< NULL unless batched IO is on; see setBatchedIO()
 public:
    enum {
       DefaultBufferSize = 32768, ///< The default send and receive buffer sizes
@@ -177,6 +180,19 @@ public:
    /// @param   bytesRead       Specifies the number of bytes which were actually in the packet.
    NetError recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *bytesRead);
 
+   /// Moves many packets per system call instead of one, where the platform allows it (currently Linux, with
+   /// recvmmsg() and sendmmsg()).  recvfrom() then hands out packets from a batch read earlier, and sendto()
+   /// queues packets until a batch is full or flushSends() is called.  Returns whether batching is now on; it
+   /// is never on for TCP sockets, or while journaling.  Turning batching off drops any packets received but
+   /// not yet handed out.
+   bool setBatchedIO(bool enabled);
+
+   /// Returns true if packets are being sent and received in batches.
+   bool isBatchedIO() const { return mBatch != NULL; }
+
+   /// Sends any packets sendto() has queued up.  Does nothing unless batching is on.
+   void flushSends();
+
    /// Returns the Address corresponding to this socket, as bound on the local machine.
    Address getBoundAddress();
 
@@ -189,6 +205,10 @@ public:
    virtual NetError send(const U8 *buffer, S32 bufferSize);
 
    bool isWritable(U32 timeout = 0);
+
+   /// Waits up to timeoutMicroseconds for a packet to arrive, and returns true as soon as there is one to read.
+   /// Returns false if the time ran out, or straight away if timeoutMicroseconds is 0 and nothing is waiting.
+   bool waitForPacket(U32 timeoutMicroseconds);
 };
 
 //inline void read(BitStream &s, IPAddress *val)
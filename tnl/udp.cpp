@@ -26,6 +26,7 @@
 
 #include "tnl.h"
 #include "tnlJournal.h"
+#include "tnlThread.h"
 
 #if defined ( TNL_OS_XBOX )
 
@@ -94,6 +95,10 @@ typedef in_addr IN_ADDR;
 
 #define closesocket close
 
+#if defined(TNL_OS_LINUX)
+#define TNL_BATCHED_IO     // recvmmsg() and sendmmsg()
+#endif
+
 #else
 
 #endif
@@ -113,8 +118,17 @@ namespace TNL {
 static NetError getLastError();
 static S32 initCount = 0;
 
+// Sockets get opened and names looked up on several threads at once, each arena of a server having its own
+static Mutex &getInitLock()
+{
+   static Mutex initLock;
+   return initLock;
+}
+
 static bool init()
 {
+   getInitLock().lock();
+
    bool success = true;
 #if defined ( TNL_OS_WIN32 )
    if(!initCount)
@@ -150,11 +164,15 @@ static bool init()
 
 #endif
    initCount++;
+
+   getInitLock().unlock();
    return success;
 }
 
 static void shutdown()
 {
+   getInitLock().lock();
+
    initCount--;
 #ifdef TNL_OS_WIN32
    if(!initCount)
@@ -162,6 +180,8 @@ static void shutdown()
       WSACleanup();
    }
 #endif
+
+   getInitLock().unlock();
 }
 
 static void TNLToSocketAddress(const Address &address, SOCKADDR *sockAddr, socklen_t *addressSize)
@@ -188,6 +208,85 @@ static void TNLToSocketAddress(const Address &address, SOCKADDR *sockAddr, sockl
 #endif
 }
 
+static void SocketToTNLAddress(const SOCKADDR *sockAddr, Address *address);
+
+#ifdef TNL_BATCHED_IO
+
+/// Packets on their way in or out, and the headers recvmmsg() and sendmmsg() need for them.  Each header points
+/// at its own address and data slot, which never move, so only the lengths need setting for each call.
+struct Socket::BatchedIO
+{
+   enum {
+      BatchSize = 32,
+   };
+
+   struct Queue
+   {
+      mmsghdr headers[BatchSize];
+      iovec vecs[BatchSize];
+      SOCKADDR addresses[BatchSize];
+      U8 data[BatchSize][MaxPacketDataSize];
+
+      Queue()
+      {
+         memset(headers, 0, sizeof(headers));
+         for(S32 i = 0; i < BatchSize; i++)
+         {
+            vecs[i].iov_base = data[i];
+            vecs[i].iov_len = MaxPacketDataSize;
+            headers[i].msg_hdr.msg_iov = &vecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+            headers[i].msg_hdr.msg_name = &addresses[i];
+            headers[i].msg_hdr.msg_namelen = sizeof(SOCKADDR);
+         }
+      }
+   };
+
+   Queue in;
+   S32 inCount;      ///< Packets in the last batch read
+   S32 inNext;       ///< Next of those to hand out
+
+   Queue out;
+   S32 outCount;     ///< Packets waiting to be sent
+
+   BatchedIO() : inCount(0), inNext(0), outCount(0) { }
+
+   /// Reads as many packets as are waiting, up to BatchSize.  Returns false if there were none.
+   bool receive(S32 platformSocket)
+   {
+      for(S32 i = 0; i < BatchSize; i++)
+         in.headers[i].msg_hdr.msg_namelen = sizeof(SOCKADDR);
+
+      S32 count = recvmmsg(platformSocket, in.headers, BatchSize, MSG_DONTWAIT, NULL);
+
+      inNext = 0;
+      inCount = count > 0 ? count : 0;
+      return inCount > 0;
+   }
+
+   /// Sends everything queued.  Packets the system won't take are dropped, just as sendto() would have dropped them.
+   void send(S32 platformSocket)
+   {
+      for(S32 sent = 0; sent < outCount; )
+      {
+         S32 result = sendmmsg(platformSocket, out.headers + sent, outCount - sent, 0);
+
+         if(result > 0)
+            sent += result;
+         else if(errno != EINTR)
+            sent++;
+      }
+
+      outCount = 0;
+   }
+};
+
+#else
+
+struct Socket::BatchedIO { };
+
+#endif
+
 static void SocketToTNLAddress(const SOCKADDR *sockAddr, Address *address)
 {
    if(sockAddr->sa_family == AF_INET)
@@ -222,6 +321,7 @@ Socket::Socket(const Address &bindAddress, U32 sendBufferSize, U32 recvBufferSiz
    init();
    mPlatformSocket = INVALID_SOCKET;
    mTransportProtocol = bindAddress.transport;
+   mBatch = NULL;
 
    const char *socketType;
 
@@ -331,11 +431,36 @@ Socket::~Socket()
 
    TNL_JOURNAL_WRITE_BLOCK(Socket::~Socket, ;)
 
+   setBatchedIO(false);    // Sends anything still queued
+
    if(mPlatformSocket != INVALID_SOCKET)
       closesocket(mPlatformSocket);
    shutdown();
 }
 
+bool Socket::setBatchedIO(bool enabled)
+{
+#ifdef TNL_BATCHED_IO
+   if(enabled && !mBatch && isValid() && mTransportProtocol != TCPProtocol && Journal::getCurrentMode() == Journal::Inactive)
+      mBatch = new BatchedIO;
+   else if(!enabled && mBatch)
+   {
+      flushSends();
+      delete mBatch;
+      mBatch = NULL;
+   }
+#endif
+   return mBatch != NULL;
+}
+
+void Socket::flushSends()
+{
+#ifdef TNL_BATCHED_IO
+   if(mBatch && mBatch->outCount > 0)
+      mBatch->send(mPlatformSocket);
+#endif
+}
+
 NetError Socket::sendto(const Address &address, const U8 *buffer, S32 bufferSize)
 {
    TNL_JOURNAL_READ_BLOCK(Socket::sendto,
@@ -348,6 +473,23 @@ NetError Socket::sendto(const Address &address, const U8 *buffer, S32 bufferSize
    if(address.transport != mTransportProtocol)
       return InvalidPacketProtocol;
 
+#ifdef TNL_BATCHED_IO
+   if(mBatch && bufferSize <= S32(MaxPacketDataSize))
+   {
+      S32 index = mBatch->outCount++;
+      mmsghdr &header = mBatch->out.headers[index];
+
+      TNLToSocketAddress(address, &mBatch->out.addresses[index], &header.msg_hdr.msg_namelen);
+      memcpy(mBatch->out.data[index], buffer, bufferSize);
+      mBatch->out.vecs[index].iov_len = bufferSize;
+
+      if(mBatch->outCount == BatchedIO::BatchSize)
+         flushSends();
+
+      return NoError;
+   }
+#endif
+
    SOCKADDR destAddress;
    socklen_t addressSize;
 
@@ -384,6 +526,22 @@ NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *out
    socklen_t addrLen = sizeof(sa);
    S32 bytesRead = SOCKET_ERROR;
 
+#ifdef TNL_BATCHED_IO
+   if(mBatch)
+   {
+      if(mBatch->inNext == mBatch->inCount && !mBatch->receive(mPlatformSocket))
+         return WouldBlock;
+
+      S32 index = mBatch->inNext++;
+
+      *outSize = getMin(S32(mBatch->in.headers[index].msg_len), bufferSize);
+      memcpy(buffer, mBatch->in.data[index], *outSize);
+      SocketToTNLAddress(&mBatch->in.addresses[index], address);
+
+      return NoError;      // No journaling with batches; see setBatchedIO()
+   }
+#endif
+
    bytesRead = ::recvfrom(mPlatformSocket, (char *) buffer, bufferSize, 0, &sa, &addrLen);
    if(bytesRead == SOCKET_ERROR)
    {
@@ -482,6 +640,42 @@ bool Socket::isWritable(U32 timeoutMillis)
    return FD_ISSET(mPlatformSocket, &fds);
 }
 
+bool Socket::waitForPacket(U32 timeoutMicroseconds)
+{
+#ifdef TNL_BATCHED_IO
+   if(mBatch && mBatch->inNext < mBatch->inCount)     // Read earlier, and not handed out yet
+      return true;
+#endif
+
+#if defined(TNL_OS_LINUX)
+   // ppoll() takes a timespec, so unlike poll() we aren't rounded to the millisecond, and unlike select() we don't
+   // care how high the descriptor number is
+   pollfd fd;
+   fd.fd = mPlatformSocket;
+   fd.events = POLLIN;
+   fd.revents = 0;
+
+   timespec timeout;
+   timeout.tv_sec = timeoutMicroseconds / 1000000;
+   timeout.tv_nsec = (timeoutMicroseconds % 1000000) * 1000;
+
+   return ::ppoll(&fd, 1, &timeout, NULL) > 0 && (fd.revents & POLLIN);
+#else
+   fd_set fds;
+   FD_ZERO(&fds);
+   FD_SET(mPlatformSocket, &fds);
+
+   timeval timeout;
+   timeout.tv_sec = timeoutMicroseconds / 1000000;
+   timeout.tv_usec = timeoutMicroseconds % 1000000;
+
+   if(::select(mPlatformSocket + 1, &fds, 0, 0, &timeout) == SOCKET_ERROR)
+      return false;
+
+   return FD_ISSET(mPlatformSocket, &fds);
+#endif
+}
+
 #if defined ( TNL_OS_WIN32 )
 void Socket::getInterfaceAddresses(Vector<Address> *addressVector)
 {
@@ -858,7 +1052,7 @@ bool Address::set(const char *addressString)
 
 const char *Address::toString() const
 {
-   static char addressBuffer[256];
+   static TNL_THREAD_LOCAL char addressBuffer[256];     // Per-thread, so connections can log from packet writer threads
    if(transport == IPProtocol)
    {
       SOCKADDR_IN ipAddr;
@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "ArenaThread.h"
+
+#include "EventManager.h"
+#include "GameManager.h"
+#include "GameSettings.h"
+#include "LevelSource.h"
+#include "LuaScriptRunner.h"
+#include "ServerGame.h"
+#include "gameNetInterface.h"
+
+#include "tnlLog.h"
+#include "tnlPlatform.h"
+
+#include <math.h>
+
+namespace Zap
+{
+
+// Constructor
+TickGrid::TickGrid()
+{
+   mStartTime = Platform::getHighPrecisionTimerValue();
+   mLastTickTime = 0;
+   mReportedTime = 0;
+}
+
+
+bool TickGrid::tick(const ServerGame *game, U32 &deltaT, U32 &timeout)
+{
+   static const F64 SuspendedTickPeriod = 40;    // ms; the less often we tick, the less power an empty server uses
+   static const F64 MaxTicksBehind = 5;
+
+   U32 maxFPS = game->getSettings()->getIniSettings()->maxDedicatedFPS;
+   F64 tickPeriod = game->isSuspended() ? SuspendedTickPeriod : 1000.0 / maxFPS;
+
+   F64 now = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - mStartTime);
+   F64 nextTickTime = mLastTickTime + tickPeriod;
+
+   if(now < nextTickTime)
+   {
+      timeout = U32(ceil((nextTickTime - now) * 1000));    // us
+      return false;
+   }
+
+   mLastTickTime = nextTickTime;
+   if(now - mLastTickTime > MaxTicksBehind * tickPeriod)
+      mLastTickTime = now;
+
+   // The game counts in whole ms; the fraction left over is carried over to the next tick
+   deltaT = U32(now - mReportedTime);
+   mReportedTime += deltaT;
+
+   if(deltaT > 5000)       // Same sanity check as idle(); we were probably stopped in a debugger
+      deltaT = 10;
+
+   return true;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+ArenaThread::ArenaThread(S32 index, const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource)
+{
+   mIndex = index;
+   mAddress = address;
+   mSettings = settings;
+   mLevelSource = levelSource;
+
+   mThreaded = false;
+   mHosting = false;
+   mPort = 0;
+
+   mStopNow = false;
+   mReadyToShutdown = false;
+}
+
+
+// Destructor
+ArenaThread::~ArenaThread()
+{
+   if(!mThreaded)
+      return;
+
+   mStopNow.store(true);
+   mDone.wait();
+}
+
+
+bool ArenaThread::startHosting()
+{
+#ifdef TNL_NO_THREADS
+   logprintf(LogConsumer::LogError, "Arena %d needs a thread of its own, and this build has no threads", mIndex + 1);
+   return false;
+#else
+   mThreaded = start();
+
+   if(!mThreaded)
+   {
+      logprintf(LogConsumer::LogError, "Failed to create thread for arena %d", mIndex + 1);
+      return false;
+   }
+
+   mStarted.wait();
+   return mHosting;
+#endif
+}
+
+
+U16 ArenaThread::getPort() const
+{
+   return mPort;
+}
+
+
+bool ArenaThread::isReadyToShutdown(string &reason) const
+{
+   if(!mReadyToShutdown.load())
+      return false;
+
+   reason = mShutdownReason;
+   return true;
+}
+
+
+// Arena's thread
+U32 ArenaThread::run()
+{
+   LuaScriptRunner::startLua(mSettings->getFolderManager()->luaDir);     // This thread's own "L"
+
+   ServerGame *game = new ServerGame(mAddress, mSettings, mLevelSource, false, true);
+   GameManager::setServerGame(game);
+   game->setReadyToConnectToMaster(true);
+
+   mHosting = game->startHosting();
+   mPort = game->getNetInterface()->getSocket().getBoundAddress().port;
+   mStarted.increment();
+
+   TickGrid tickGrid;
+
+   while(mHosting && !mStopNow.load())
+   {
+      U32 deltaT, timeout;
+
+      if(!tickGrid.tick(game, deltaT, timeout))
+      {
+         if(game->getNetInterface()->getSocket().waitForPacket(timeout))
+            game->getNetInterface()->checkIncomingPackets();
+
+         continue;
+      }
+
+      string reason;
+      if(!mReadyToShutdown.load() && game->isReadyToShutdown(deltaT, reason))
+      {
+         mShutdownReason = reason;
+         mReadyToShutdown.store(true);    // The main thread will shut the whole server down, us included
+      }
+
+      game->idle(deltaT);
+   }
+
+   GameManager::deleteServerGame();
+
+   EventManager::shutdown();
+   LuaScriptRunner::clearScriptCache();
+   LuaScriptRunner::shutdown();
+
+   mDone.increment();
+   return 0;
+}
+
+
+}
@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _ARENA_THREAD_H_
+#define _ARENA_THREAD_H_
+
+#include "tnlThread.h"
+#include "tnlNetBase.h"
+#include "tnlUDP.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+class ServerGame;
+class GameSettings;
+class LevelSource;
+
+typedef shared_ptr<GameSettings> GameSettingsPtr;
+typedef shared_ptr<LevelSource> LevelSourcePtr;
+
+
+// Dedicated servers lay their ticks out on a fixed grid, timed with the high-precision timer, so one late tick doesn't
+// push back all the ones after it.  If we fall too far behind to catch up, we start a new grid from where we are.
+class TickGrid
+{
+private:
+   S64 mStartTime;
+   F64 mLastTickTime;         // ms since mStartTime; where the grid has got to
+   F64 mReportedTime;         // How much of that time the game has been told about, in whole ms
+
+public:
+   TickGrid();                // Constructor
+
+   // If game is due a tick, returns true and sets deltaT to how many ms to idle it for.  Otherwise returns false and
+   // sets timeout to the number of microseconds until it is.
+   bool tick(const ServerGame *game, U32 &deltaT, U32 &timeout);
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// A dedicated server hosting more than one arena runs the first on the main thread, and each of the others on a thread
+// of its own.  The thread creates its game, Lua and EventManager, and runs them the way dedicatedServerLoop() runs
+// the first arena, until it's told to stop.  Each arena has its own copy of the level list, since admins can change
+// it from within a game, and connects to the master on its own.
+class ArenaThread : public Thread
+{
+private:
+   S32 mIndex;
+   Address mAddress;
+   GameSettingsPtr mSettings;
+   LevelSourcePtr mLevelSource;
+
+   bool mThreaded;               // False if we couldn't start a thread
+   bool mHosting;                // Whether the game got going; set before mStarted is signalled
+   U16 mPort;                    // Port the game is listening on, likewise
+
+   atomic<bool> mStopNow;
+   atomic<bool> mReadyToShutdown;
+   string mShutdownReason;       // Written before mReadyToShutdown is set, and never again after
+
+   TNL::Semaphore mStarted;
+   TNL::Semaphore mDone;
+
+public:
+   ArenaThread(S32 index, const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource);  // Constructor
+   virtual ~ArenaThread();       // Destructor -- stops the game, and waits for the thread to finish
+
+   bool startHosting();          // Returns once the game is up, or has failed to start
+   U16 getPort() const;
+
+   // Like ServerGame::isReadyToShutdown(), but safe to call from the main thread
+   bool isReadyToShutdown(string &reason) const;
+
+   U32 run();
+};
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include "stringUtils.h"
 
 #include "tnlLog.h"
+#include "tnlPlatform.h"
 
 #include <chrono>
 #include <ctime>
@@ -52,9 +53,12 @@ string timeNowToISOString()
    // Get current time
    time_t now = system_clock::to_time_t(system_clock::now());
 
+   tm local;
+   Platform::getLocalTime(now, local);
+
    // Convert to ISO string
    char buf[sizeof "11111111T111111"];
-   strftime(buf, sizeof buf, "%Y%m%dT%H%M%S", localtime(&now));
+   strftime(buf, sizeof buf, "%Y%m%dT%H%M%S", &local);
 
    return string(buf);
 }
@@ -90,7 +94,9 @@ void BanList::addToBanList(const Address &address, S32 durationMinutes, bool non
    banItem.nickname = nonAuthenticatedOnly ? "*NonAuthenticated" : "*";
    banItem.startDateTime = timeNowToISOString();
 
+   mLock.lock();
    serverBanList.push_back(banItem);
+   mLock.unlock();
 }
 
 void BanList::addPlayerNameToBanList(const char *playerName, S32 durationMinutes)
@@ -101,7 +107,9 @@ void BanList::addPlayerNameToBanList(const char *playerName, S32 durationMinutes
    banItem.nickname = playerName;
    banItem.startDateTime = timeNowToISOString();
 
+   mLock.lock();
    serverBanList.push_back(banItem);
+   mLock.unlock();
 }
 
 
@@ -189,6 +197,9 @@ bool BanList::isBanned(const Address &address, const string &nickname, bool isAu
 {
    string addressString = addressToString(address);
    auto currentTime = system_clock::now();
+   bool banned = false;
+
+   mLock.lock();
 
    for (S32 i = 0; i < serverBanList.size(); i++)
    {
@@ -217,10 +228,13 @@ bool BanList::isBanned(const Address &address, const string &nickname, bool isAu
 
       // If we get here, that means nickname and IP address matched and we are still in the
       // ban allotted time period
-      return true;
+      banned = true;
+      break;
    }
 
-   return false;
+   mLock.unlock();
+
+   return banned;
 }
 
 
@@ -251,8 +265,11 @@ S32 BanList::getDefaultBanDuration()
 Vector<string> BanList::banListToString()
 {
    Vector<string> banList;
+
+   mLock.lock();
    for(S32 i = 0; i < serverBanList.size(); i++)
       banList.push_back(banItemToString(&serverBanList[i]));
+   mLock.unlock();
 
    return banList;
 }
@@ -260,12 +277,16 @@ Vector<string> BanList::banListToString()
 
 void BanList::loadBanList(const Vector<string> &banItemList)
 {
+   mLock.lock();
+
    serverBanList.clear();  // Clear old list for /loadini command.
    for(S32 i = 0; i < banItemList.size(); i++)
       if(!processBanListLine(banItemList[i]))
          logprintf("Ban list item on line %d is malformed: %s", i+1, banItemList[i].c_str());
       else
          logprintf("Loading ban: %s", banItemList[i].c_str());
+
+   mLock.unlock();
 }
 
 
@@ -273,33 +294,42 @@ void BanList::kickHost(const Address &address)
 {
    KickedHost h;
    h.address = address;
-   h.kickTimeRemaining = kickDurationMilliseconds;
+   h.kickEndTime = Platform::getRealMilliseconds() + kickDurationMilliseconds;
+
+   mLock.lock();
    serverKickList.push_back(h);
+   mLock.unlock();
 }
 
 
 bool BanList::isAddressKicked(const Address &address)
 {
-   for(S32 i = 0; i < serverKickList.size(); i++)
-      if(address.isEqualAddress(serverKickList[i].address))
-         return true;
+   bool kicked = false;
+
+   mLock.lock();
+   for(S32 i = 0; i < serverKickList.size() && !kicked; i++)
+      kicked = address.isEqualAddress(serverKickList[i].address);
+   mLock.unlock();
 
-   return false;
+   return kicked;
 }
 
 
-void BanList::updateKickList(U32 timeElapsed)
+void BanList::updateKickList()
 {
+   U32 now = Platform::getRealMilliseconds();
+
+   mLock.lock();
+
    for(S32 i = 0; i < serverKickList.size(); )
    {
-      if(serverKickList[i].kickTimeRemaining < timeElapsed)
+      if(S32(serverKickList[i].kickEndTime - now) < 0)
          serverKickList.erase_fast(i);
       else
-      {
-         serverKickList[i].kickTimeRemaining -= timeElapsed;
          i++;
-      }
    }
+
+   mLock.unlock();
 }
 
 
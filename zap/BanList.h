@@ -8,6 +8,7 @@
 
 #include "tnlTypes.h"
 #include "tnlUDP.h"
+#include "tnlThread.h"
 
 #include <string>
 
@@ -30,7 +31,7 @@ private:
 
    struct KickedHost {
       Address address;
-      U32 kickTimeRemaining;
+      U32 kickEndTime;        // Real time, so arenas sharing the list don't each count it down
    };
 
    Vector<BanItem> serverBanList;
@@ -42,6 +43,8 @@ private:
    S32 defaultBanDurationMinutes;
    S32 kickDurationMilliseconds;
 
+   Mutex mLock;            // Arenas hosted on other threads share our lists
+
    bool processBanListLine(const string &line);
    string banItemToString(BanItem *banItem);
 
@@ -65,7 +68,7 @@ public:
 
    void kickHost(const Address &address);       // Add an address to kick list
    bool isAddressKicked(const Address &address);   // Check if address is on the kick list
-   void updateKickList(U32 timeElapsed);              // Check if kick time has expired and update the kick list
+   void updateKickList();                             // Check if kick time has expired and update the kick list
 };
 
 } /* namespace Zap */
@@ -391,7 +391,7 @@ F32 EditorObject::getEditorRadius(F32 currentScale)
 
 static S32 getNextDefaultId() 
 {
-   static S32 nextId = 0;
+   static TNL_THREAD_LOCAL S32 nextId = 0;
    nextId--;
    return nextId;
 }
@@ -443,7 +443,7 @@ void BfObject::assignNewUserAssignedId()
 // to which wall, even as walls are being moved around, and wall edits are undone/redone.
 void BfObject::assignNewSerialNumber()
 {
-   static S32 mNextSerialNumber = 0;
+   static TNL_THREAD_LOCAL S32 mNextSerialNumber = 0;
 
    mSerialNumber = mNextSerialNumber++;
 }
@@ -14,6 +14,8 @@
 #include "speedZone.h"
 #include "GeomUtils.h"
 #include "MathUtils.h"
+#include "stringUtils.h"
+#include "md5wrapper.h"
 
 #include "tnlLog.h"
 
@@ -48,6 +50,8 @@ const S32 BotNavMeshZone::BufferRadius = Ship::CollisionRadius;  // Radius to bu
 const S32 BotNavMeshZone::LevelZoneBuffer = MAX(BufferRadius * 2, 50);
 const F32 BotNavMeshZone::CoreTraversalCost = 1000;
 
+TNL_THREAD_LOCAL U32 BotNavMeshZone::mWalkabilityVersion = 0;
+
 // Constructor
 BotNavMeshZone::BotNavMeshZone(S32 id)
 {
@@ -138,10 +142,19 @@ bool BotNavMeshZone::getWalkable()
 
 void BotNavMeshZone::setWalkable(bool canWalk)
 {
+   if(canWalk != mWalkable)
+      mWalkabilityVersion++;     // Any route found so far may now be wrong
+
    mWalkable = canWalk;
 }
 
 
+U32 BotNavMeshZone::getWalkabilityVersion()
+{
+   return mWalkabilityVersion;
+}
+
+
 struct rcEdge
 {
    unsigned short vert[2];    // from, to verts
@@ -314,7 +327,7 @@ bool BotNavMeshZone::buildConnectionsRecastStyle(const Vector<BotNavMeshZone *>
 }
 
 
-static Vector<DatabaseObject *> zones;
+static thread_local Vector<DatabaseObject *> zones;
 
 // Returns index of zone containing specified point
 static BotNavMeshZone *findZoneTouchingCircle(const GridDatabase *botZoneDatabase, const Point &centerPoint, F32 radius)
@@ -703,69 +716,160 @@ static bool meshArea(const PolyTree &polytree, const Rect &levelBounds,
 }
 
 
+static void appendPolygons(string &bytes, const Vector<Vector<Point> > &polygons)
+{
+   S32 count = polygons.size();
+   bytes.append((const char *)&count, sizeof(count));
+
+   for(S32 i = 0; i < polygons.size(); i++)
+   {
+      count = polygons[i].size();
+      bytes.append((const char *)&count, sizeof(count));
+      bytes.append((const char *)polygons[i].address(), polygons[i].size() * sizeof(Point));
+   }
+}
+
+
+string BotZoneMeshInput::getHash() const
+{
+   string bytes;
+
+   bytes.append((const char *)&bounds.min, sizeof(Point));
+   bytes.append((const char *)&bounds.max, sizeof(Point));
+
+   appendPolygons(bytes, barrierPolygons);
+   appendPolygons(bytes, blockingPolygons);
+   appendPolygons(bytes, corePolygons);
+   appendPolygons(bytes, speedZonePolygons);
+
+   md5wrapper md5;
+   return md5.getHashFromString(bytes);
+}
+
+
 // Server only
 // Use the Triangle library to create zones.  Aggregate triangles with Recast
 bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
                                        const Rect *worldExtents, bool triangulateZones)
 {
-   // Start by finding all objects that'll matter for meshing the level
+   BotZoneMeshInput input;
+   gatherMeshInput(gameObjDatabase, worldExtents, input);
 
-   // Teleporters form extra connections
-   fillVector.clear();
-   gameObjDatabase->findObjects(TeleporterTypeNumber, fillVector);
+   BotZoneMesh mesh;
+   string error;
 
-   Vector<pair<Point, const Vector<Point> *> > teleporterData(fillVector.size());
-   pair<Point, const Vector<Point> *> teldat;
-
-   for(S32 i = 0; i < fillVector.size(); i++)
+   if(!buildMesh(input, mesh, error))
    {
-      Teleporter *teleporter = static_cast<Teleporter *>(fillVector[i]);
-
-      teldat.first  = teleporter->getPos();
-      teldat.second = teleporter->getDestList();
+      // Clearing this also clears the botZoneDatabase
+      allZones->deleteAndClear();
 
-      teleporterData.push_back(teldat);
+      logprintf(LogConsumer::LogLevelError, "%s", error.c_str());
+      return false;
    }
 
-   // So do speedzones
-   Vector<DatabaseObject *> speedZoneList;
-   gameObjDatabase->findObjects(SpeedZoneTypeNumber, speedZoneList);
+   buildZonesFromMesh(botZoneDatabase, gameObjDatabase, allZones, mesh, input, triangulateZones);
+   return true;
+}
 
-   // Cores can be destroyed and open up new paths - need special handling
-   Vector<DatabaseObject *> coreList;
-   gameObjDatabase->findObjects(CoreTypeNumber, coreList);
 
+// Start by finding all objects that'll matter for meshing the level
+void BotNavMeshZone::gatherMeshInput(GridDatabase *gameObjDatabase, const Rect *worldExtents, BotZoneMeshInput &input)
+{
+   input.bounds = *worldExtents;
 
-   // Get our parameters together
+   // Walls
    Vector<DatabaseObject *> barrierList;
    gameObjDatabase->findObjects((TestFunc)isWallType, barrierList, *worldExtents);
 
+   input.barrierPolygons.clear();
+   for(S32 i = 0; i < barrierList.size(); i++)
+   {
+      if(barrierList[i]->getObjectTypeNumber() != BarrierTypeNumber)
+         continue;
+
+      input.barrierPolygons.push_back(*static_cast<Barrier *>(barrierList[i])->getCollisionPoly());
+   }
+
+   // Add turrets
    Vector<DatabaseObject *> turretList;
    gameObjDatabase->findObjects(TurretTypeNumber, turretList, *worldExtents);
 
+   input.blockingPolygons.clear();
+   for(S32 i = 0; i < turretList.size(); i++)
+   {
+      if(turretList[i]->getObjectTypeNumber() != TurretTypeNumber)
+         continue;
+
+      input.blockingPolygons.push_back(Vector<Point>());
+      static_cast<Turret *>(turretList[i])->getBufferForBotZone(BufferRadius, input.blockingPolygons.last());
+   }
+
+   // Add forcefield projectors
    Vector<DatabaseObject *> forceFieldProjectorList;
    gameObjDatabase->findObjects(ForceFieldProjectorTypeNumber, forceFieldProjectorList, *worldExtents);
 
+   for(S32 i = 0; i < forceFieldProjectorList.size(); i++)
+   {
+      if(forceFieldProjectorList[i]->getObjectTypeNumber() != ForceFieldProjectorTypeNumber)
+         continue;
+
+      input.blockingPolygons.push_back(Vector<Point>());
+      static_cast<ForceFieldProjector *>(forceFieldProjectorList[i])->getBufferForBotZone(BufferRadius, input.blockingPolygons.last());
+   }
+
+   // The next items are special items that need to be meshed, but must be
+   // excluded from initial mesh for various reasons
+
+   // Add Cores - they are destructible
+   Vector<DatabaseObject *> coreList;
+   gameObjDatabase->findObjects(CoreTypeNumber, coreList);
+
+   // Increase buffer radius a little to handle the spinning corners
+   F32 coreBufferRadius = BufferRadius + 5;
 
+   input.corePolygons.clear();
+   for(S32 i = 0; i < coreList.size(); i++)
+   {
+      input.corePolygons.push_back(Vector<Point>());
+      static_cast<CoreItem *>(coreList[i])->getBufferForBotZone(coreBufferRadius, input.corePolygons.last());
+   }
 
+   // Add SpeedZones - they are one-way like areas
+   Vector<DatabaseObject *> speedZoneList;
+   gameObjDatabase->findObjects(SpeedZoneTypeNumber, speedZoneList);
+
+   input.speedZonePolygons.clear();
+   for(S32 i = 0; i < speedZoneList.size(); i++)
+   {
+      input.speedZonePolygons.push_back(Vector<Point>());
+      static_cast<SpeedZone *>(speedZoneList[i])->getBufferForBotZone(BufferRadius, input.speedZonePolygons.last());
+   }
+}
+
+
+// Turns the level into a Recast mesh.  Touches nothing but its arguments, so can be run on any thread.  Returns
+// false, with a description of what went wrong in error, if the level couldn't be meshed.
+bool BotNavMeshZone::buildMesh(const BotZoneMeshInput &input, BotZoneMesh &mesh, string &error)
+{
 #ifdef LOG_TIMER
    U32 starttime = Platform::getRealMilliseconds();
 #endif
 
-   Rect bounds(worldExtents);      // Modifiable copy
-   // allZones is a Vector cache of all zones held in memory by the server to
-   // be used by Robots without having to call the grid database
-   //
-   // Clearing this here *also* clears the botZoneDatabase and is required before
-   // repopulating it below
-   allZones->deleteAndClear();
+   // In case mesh has been used before
+   rcFree(mesh.mesh.verts);
+   rcFree(mesh.mesh.polys);
+   rcFree(mesh.mesh.adjacency);
+   mesh.mesh = rcPolyMesh();
+
+   mesh.inputHash = input.getHash();
 
+   Rect bounds(input.bounds);      // Modifiable copy
    bounds.expandToInt(Point(LevelZoneBuffer, LevelZoneBuffer));      // Provide a little breathing room
 
    // Make sure level isn't too big for zone generation, which uses 16 bit ints
    if(bounds.getHeight() >= (F32)U16_MAX || bounds.getWidth() >= (F32)U16_MAX)
    {
-      logprintf(LogConsumer::LogLevelError, "Level too big for zone generation! (max allowed dimension is %d)", U16_MAX);
+      error = "Level too big for zone generation! (max allowed dimension is " + itos(U16_MAX) + ")";
       return false;
    }
 
@@ -779,13 +883,16 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
 
 
    // First merge all barrier polygons
-   if(barrierList.size() > 0)
+   if(input.barrierPolygons.size() > 0)
    {
+      Vector<const Vector<Point> *> barrierPolygons;
+      for(S32 i = 0; i < input.barrierPolygons.size(); i++)
+         barrierPolygons.push_back(&input.barrierPolygons[i]);
+
       Vector<Vector<Point> > barrierInputPolygons;
-      bool unionSucceeded = Barrier::unionBarriers(barrierList,  barrierInputPolygons);
-      if(!unionSucceeded)
+      if(!mergePolys(barrierPolygons, barrierInputPolygons))
       {
-         logprintf(LogConsumer::LogLevelError, "Barriers failed to merge for bot zones!", U16_MAX);
+         error = "Barriers failed to merge for bot zones!";
          return false;
       }
 
@@ -793,59 +900,12 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
       offsetPolygons(barrierInputPolygons, blockingPolygons, BufferRadius);
    }
 
-   // Add turrets
-   for (S32 i = 0; i < turretList.size(); i++)
-   {
-      if(turretList[i]->getObjectTypeNumber() != TurretTypeNumber)
-         continue;
+   // Then turrets and forcefield projectors
+   for(S32 i = 0; i < input.blockingPolygons.size(); i++)
+      blockingPolygons.push_back(input.blockingPolygons[i]);
 
-      Turret *turret = static_cast<Turret *>(turretList[i]);
-
-      blockingPolygons.push_back(Vector<Point>());
-      turret->getBufferForBotZone(BufferRadius, blockingPolygons.last());
-   }
-
-   // Add forcefield projectors
-   for (S32 i = 0; i < forceFieldProjectorList.size(); i++)
-   {
-      if(forceFieldProjectorList[i]->getObjectTypeNumber() != ForceFieldProjectorTypeNumber)
-         continue;
-
-      ForceFieldProjector *forceFieldProjector = static_cast<ForceFieldProjector *>(forceFieldProjectorList[i]);
-
-      blockingPolygons.push_back(Vector<Point>());
-
-      forceFieldProjector->getBufferForBotZone(BufferRadius, blockingPolygons.last());
-   }
-
-
-   // The next items are special items that need to be meshed, but must be
-   // excluded from initial mesh for various reasons
-
-   // Add Cores - they are destructible
-   Vector<Vector<Point> > corePolygons;
-
-   // Increase buffer radius a little to handle the spinning corners
-   F32 coreBufferRadius = BufferRadius + 5;
-
-   for (S32 i = 0; i < coreList.size(); i++)
-   {
-      CoreItem *core = static_cast<CoreItem *>(coreList[i]);
-
-      corePolygons.push_back(Vector<Point>());
-      core->getBufferForBotZone(coreBufferRadius, corePolygons.last());
-   }
-
-   // Add SpeedZones - they are one-way like areas
-   Vector<Vector<Point> > speedZonePolygons;
-
-   for (S32 i = 0; i < speedZoneList.size(); i++)
-   {
-      SpeedZone *speedZone = static_cast<SpeedZone *>(speedZoneList[i]);
-
-      speedZonePolygons.push_back(Vector<Point>());
-      speedZone->getBufferForBotZone(BufferRadius, speedZonePolygons.last());
-   }
+   const Vector<Vector<Point> > &corePolygons = input.corePolygons;
+   const Vector<Vector<Point> > &speedZonePolygons = input.speedZonePolygons;
 
    bool hasCores = corePolygons.size() > 0;
    bool hasSpeedZones = speedZonePolygons.size() > 0;
@@ -900,7 +960,7 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    // Any failures
    if(!clipSuccess)
    {
-      logprintf(LogConsumer::LogLevelError, "Clipper failed to generate input polygons for bot zones!");
+      error = "Clipper failed to generate input polygons for bot zones!";
       return false;
    }
 
@@ -925,15 +985,14 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    // Any failures
    if(!meshSuccess)
    {
-      logprintf(LogConsumer::LogLevelError, "Bot zone mesh failed to generate!");
+      error = "Bot zone mesh failed to generate!";
       return false;
    }
 
    // Merge meshes
-   rcPolyMesh mesh;
    // Reapply bounds
-   mesh.offsetX = -1 * (int)round(bounds.min.x);
-   mesh.offsetY = -1 * (int)round(bounds.min.y);
+   mesh.mesh.offsetX = -1 * (int)round(bounds.min.x);
+   mesh.mesh.offsetY = -1 * (int)round(bounds.min.y);
 
    // Build up references to send to the merge method
    const S32 meshCount = 3;
@@ -944,25 +1003,70 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
    meshes[2] = &szMesh;
 
    // Do the merge
-   bool mergeSuccess = rcMergePolyMeshes(meshes, meshCount, mesh);
+   bool mergeSuccess = rcMergePolyMeshes(meshes, meshCount, mesh.mesh);
 
    if(!mergeSuccess)
    {
-      logprintf(LogConsumer::LogLevelError, "Bot zone mesh failed to merge!");
+      error = "Bot zone mesh failed to merge!";
       return false;
    }
 
 
    // Save what index the special zones start at in the Recast merged mesh.
    // This will be used later to modify zone connections
-   S32  coreRecastPolyStartIdx = levelMesh.npolys;
-   S32    szRecastPolyStartIdx = levelMesh.npolys + coreMesh.npolys;
+   mesh.corePolyStart      = levelMesh.npolys;
+   mesh.speedZonePolyStart = levelMesh.npolys + coreMesh.npolys;
 
 
 #ifdef LOG_TIMER
    U32 done2 = Platform::getRealMilliseconds();  // poly2tri and Recast done
+   logprintf("Timings: %d %d", done1-starttime, done2-done1);
 #endif
 
+   return true;
+}
+
+
+// Turns mesh into zones, and links them up
+void BotNavMeshZone::buildZonesFromMesh(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
+                                        BotZoneMesh &zoneMesh, const BotZoneMeshInput &input, bool triangulateZones)
+{
+#ifdef LOG_TIMER
+   U32 starttime = Platform::getRealMilliseconds();
+#endif
+
+   // allZones is a Vector cache of all zones held in memory by the server to
+   // be used by Robots without having to call the grid database
+   //
+   // Clearing this here *also* clears the botZoneDatabase and is required before
+   // repopulating it below
+   allZones->deleteAndClear();
+
+   // Teleporters form extra connections
+   fillVector.clear();
+   gameObjDatabase->findObjects(TeleporterTypeNumber, fillVector);
+
+   Vector<pair<Point, const Vector<Point> *> > teleporterData(fillVector.size());
+   pair<Point, const Vector<Point> *> teldat;
+
+   for(S32 i = 0; i < fillVector.size(); i++)
+   {
+      Teleporter *teleporter = static_cast<Teleporter *>(fillVector[i]);
+
+      teldat.first  = teleporter->getPos();
+      teldat.second = teleporter->getDestList();
+
+      teleporterData.push_back(teldat);
+   }
+
+   // So do speedzones
+   Vector<DatabaseObject *> speedZoneList;
+   gameObjDatabase->findObjects(SpeedZoneTypeNumber, speedZoneList);
+
+   rcPolyMesh &mesh = zoneMesh.mesh;
+   S32 coreRecastPolyStartIdx = zoneMesh.corePolyStart;
+   S32   szRecastPolyStartIdx = zoneMesh.speedZonePolyStart;
+
    // If Recast succeeded, our triangles were successfully aggregatedinto zones,
    // but will need further polishing.
 
@@ -1042,16 +1146,14 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase *botZoneDatabase, GridDataba
       S32 szBotZoneStartId = polyToZoneMap[szRecastPolyStartIdx];
 
       linkConnectionsSpeedZones(gameObjDatabase, botZoneDatabase, allZones,
-            speedZoneList, speedZonePolygons, szBotZoneStartId);
+            speedZoneList, input.speedZonePolygons, szBotZoneStartId);
    }
 
 #ifdef LOG_TIMER
-   U32 done3 = Platform::getRealMilliseconds();  // Done
+   U32 done = Platform::getRealMilliseconds();
    logprintf("Built %d zones!", botZoneDatabase->getObjectCount());
-   logprintf("Timings: %d %d %d", done1-starttime, done2-done1, done3-done2);
+   logprintf("Timing: %d", done-starttime);
 #endif
-
-   return true;
 }
 
 
@@ -1077,41 +1179,107 @@ F32 AStar::heuristic(const Vector<BotNavMeshZone *> *zones, S32 fromZone, S32 to
 }
 
 
-// Returns a path, including the startZone and targetZone 
+// Constructor
+AStar::AStar()
+{
+   mOnClosedList = 0;
+   mOnOpenList = 0;
+}
+
+
+// Make sure our lists can hold zoneCount zones, and start a fresh search
+void AStar::prepare(S32 zoneCount)
+{
+   if(mWhichList.size() < zoneCount + 1)
+   {
+      // Item ids and heap positions run from 0 and 1 respectively, up to the number of zones
+      mWhichList.resize(zoneCount + 1);
+      mOpenList.resize(zoneCount + 2);
+      mOpenZone.resize(zoneCount + 1);
+      mParentZones.resize(zoneCount + 1);
+      mFcost.resize(zoneCount + 1);
+      mGcost.resize(zoneCount + 1);
+      mHcost.resize(zoneCount + 1);
+
+      mOnClosedList = U16_MAX;      // Force mWhichList to be cleared below, including any newly added entries
+   }
+
+   // This block here lets us repeatedly reuse the whichList array without resetting it or recreating it
+   // which, for larger numbers of zones should be a real time saver.  It's not clear if it is particularly
+   // more efficient for the zone counts we typically see in Bitfighter levels.
+   if(mOnClosedList > U16_MAX - 3 ) // Reset whichList when we've run out of headroom
+   {
+      for(S32 i = 0; i < mWhichList.size(); i++) 
+         mWhichList[i] = 0;
+      mOnClosedList = 0;   
+   }
+   mOnClosedList = mOnClosedList + 2; // Changing the values of onOpenList and onClosed list is faster than redimming whichList() array
+   mOnOpenList = mOnClosedList - 1;
+}
+
+
+// Returns a path, including the startZone and targetZone, with the target itself first
 Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Point &target)
 {
-   // Because of these variables...
-   static U16 onClosedList = 0;
-   static U16 onOpenList;
+   Vector<Point> path;
+
+   if(!findRoute(zones, startZone, targetZone, path))
+      return path;
+
+   path.insert(0, target);    // First point is the actual target itself
+   return path;
+}
+
+
+// Fills route with the center of each zone from targetZone back to startZone, and the gateways between them.
+// Returns false, leaving route empty, if there's no way to get there.
+bool AStar::findRoute(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, Vector<Point> &route)
+{
+   return search(zones, startZone, targetZone, NULL, route) >= 0;
+}
+
+
+// As above, but only through the corridor last planned by clusters.  If the corridor stops short of the
+// target, so does the route, at the first zone we come to in the corridor's last cluster.  endZone is
+// set to the zone the route actually reaches.
+bool AStar::findRoute(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, 
+                      const ZoneClusterGraph &clusters, Vector<Point> &route, U16 &endZone)
+{
+   S32 reachedZone = search(zones, startZone, targetZone, &clusters, route);
+   if(reachedZone < 0)
+      return false;
 
-   // ...these arrays can be reused without further initialization
-   static U16 whichList[MAX_ZONES];       // Record whether a zone is on the open or closed list
-   static S16 openList[MAX_ZONES + 1]; 
-   static S16 openZone[MAX_ZONES]; 
-   static S16 parentZones[MAX_ZONES]; 
+   endZone = (U16)reachedZone;
+   return true;
+}
 
-   static F32 Fcost[MAX_ZONES];   
-   static F32 Gcost[MAX_ZONES];    
-   static F32 Hcost[MAX_ZONES];   
 
+// Does the work for findRoute(), returning the zone the route ends at, or -1 if there's no route.  With
+// clusters, zones outside its corridor are ignored.
+S32 AStar::search(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, 
+                  const ZoneClusterGraph *clusters, Vector<Point> &route)
+{
    S16 numberOfOpenListItems = 0;
    bool foundPath;
 
    S32 newOpenListItemID = 0;         // Used for creating new IDs for zones to make heap work
 
-   Vector<Point> path;
+   route.clear();
+   prepare(zones->size());
 
-   // This block here lets us repeatedly reuse the whichList array without resetting it or recreating it
-   // which, for larger numbers of zones should be a real time saver.  It's not clear if it is particularly
-   // more efficient for the zone counts we typically see in Bitfighter levels.
-   if(onClosedList > U16_MAX - 3 ) // Reset whichList when we've run out of headroom
-   {
-      for(S32 i = 0; i < MAX_ZONES; i++) 
-         whichList[i] = 0;
-      onClosedList = 0;   
-   }
-   onClosedList = onClosedList + 2; // Changing the values of onOpenList and onClosed list is faster than redimming whichList() array
-   onOpenList = onClosedList - 1;
+   // Local aliases, to keep the search itself readable
+   U16 *whichList   = mWhichList.address();
+   S16 *openList    = mOpenList.address();
+   S16 *openZone    = mOpenZone.address();
+   S16 *parentZones = mParentZones.address();
+   F32 *Fcost       = mFcost.address();
+   F32 *Gcost       = mGcost.address();
+   F32 *Hcost       = mHcost.address();
+
+   const U16 onClosedList = mOnClosedList;
+   const U16 onOpenList   = mOnOpenList;
+
+   S32 endZone = targetZone;     // Unless a partial corridor has us stop sooner
 
    Gcost[startZone] = 0;         // That's the cost of going from the startZone to the startZone!
    Fcost[0] = Hcost[0] = heuristic(zones, startZone, targetZone);
@@ -1135,7 +1303,7 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
          //   Since the list is a binary heap, this will be the lowest F cost cell on the open list.
          S32 parentZone = openZone[openList[1]];
 
-         if(parentZone == targetZone)
+         if(parentZone == endZone)
          {
             foundPath = true; 
             break;
@@ -1188,11 +1356,11 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
          // Add these adjacent child squares to the open list
          //   for later consideration if appropriate.
 
-         Vector<NeighboringZone> neighboringZones = zones->get(parentZone)->mNeighbors;
+         const Vector<NeighboringZone> &neighboringZones = zones->get(parentZone)->mNeighbors;
 
          for(S32 a = 0; a < neighboringZones.size(); a++)
          {
-            NeighboringZone zone = neighboringZones[a];
+            const NeighboringZone &zone = neighboringZones[a];
             S32 zoneID = zone.zoneID;
 
             //   Check if zone is already on the closed list (items on the closed list have
@@ -1200,6 +1368,13 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
             if(whichList[zoneID] == onClosedList) 
                continue;
 
+            // Zones that are currently blocked can't be part of any path
+            if(!zones->get(zoneID)->getWalkable())
+               continue;
+
+            if(clusters && !clusters->isInCorridor(zoneID))
+               continue;
+
             //   Add zone to the open list if it's not already on it
             TNLAssert(newOpenListItemID < MAX_ZONES, "Too many nav zones... try increasing MAX_ZONES!");
             if(whichList[zoneID] != onOpenList && newOpenListItemID < MAX_ZONES) 
@@ -1230,6 +1405,10 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
                // Finally, put zone on the open list
                whichList[zoneID] = onOpenList;
                numberOfOpenListItems++;
+
+               // Any zone in the last cluster of a partial corridor will do
+               if(clusters && clusters->isCorridorEnd(zoneID))
+                  endZone = zoneID;
             }
 
             // If zone is already on the open list, check to see if this 
@@ -1279,7 +1458,7 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
       }  
 
       // If target is added to open list then path has been found.
-      if(whichList[targetZone] == onOpenList)
+      if(whichList[endZone] == onOpenList)
       {
          foundPath = true; 
          break;
@@ -1289,8 +1468,8 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
    // Save the path if it exists
    if(!foundPath)
    {      
-      TNLAssert(path.size() == 0, "Expected empty path!");
-      return path;
+      TNLAssert(route.size() == 0, "Expected empty route!");
+      return -1;
    }
 
    // Working backwards from the target to the starting location by checking
@@ -1303,20 +1482,19 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
    // will help keep the robot from getting hung up on blocked but technically visible
    // paths, such as when we are trying to fly around a protruding wall stub.
 
-   path.push_back(target);                               // First point is the actual target itself
-   path.push_back(zones->get(targetZone)->getCenter());  // Second is the center of the target's zone
+   route.push_back(zones->get(endZone)->getCenter());     // First is the center of the target's zone
       
-   S32 zone = targetZone;
+   S32 zone = endZone;
 
    while(zone != startZone)
    {
-      path.push_back(findGateway(zones, parentZones[zone], zone));   // Don't switch findGateway arguments, some path is one way (teleporters).
+      route.push_back(findGateway(zones, parentZones[zone], zone));  // Don't switch findGateway arguments, some path is one way (teleporters).
       zone = parentZones[zone];                                      // Find the parent of the current cell
-      path.push_back(zones->get(zone)->getCenter());
+      route.push_back(zones->get(zone)->getCenter());
    }
 
-   path.push_back(zones->get(startZone)->getCenter());
-   return path;
+   route.push_back(zones->get(startZone)->getCenter());
+   return endZone;
 }
 
 
@@ -1330,6 +1508,366 @@ Point AStar::findGateway(const Vector<BotNavMeshZone *> *zones, S32 zone1, S32 z
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+ZoneClusterGraph::ZoneClusterGraph()
+{
+   mCorridorComplete = false;
+}
+
+
+// Groups zones into square cells of roughly zonesPerCluster zones each, and links cells wherever their zones meet.
+// Zones in a cell don't have to be connected to each other, so a corridor is only a good guess; if AStar can't
+// get through one, the caller has to fall back to a full search.
+void ZoneClusterGraph::build(const Vector<BotNavMeshZone *> *zones, S32 zonesPerCluster)
+{
+   clear();
+
+   S32 zoneCount = zones->size();
+   if(zoneCount == 0)
+      return;
+
+   Rect extents(zones->get(0)->getCenter(), zones->get(0)->getCenter());
+   for(S32 i = 1; i < zoneCount; i++)
+      extents.unionPoint(zones->get(i)->getCenter());
+
+   F32 width = extents.getWidth();
+   F32 height = extents.getHeight();
+
+   // Size cells to hold zonesPerCluster zones on average; the second term covers long, thin levels
+   F32 cellSize = sqrt(width * height * zonesPerCluster / zoneCount);
+   cellSize = max(cellSize, max(width, height) * zonesPerCluster / zoneCount);
+   cellSize = max(cellSize, 1.0f);
+
+   S32 cols = S32(width / cellSize) + 1;
+   S32 rows = S32(height / cellSize) + 1;
+
+   Vector<S32> cellClusters;
+   cellClusters.resize(cols * rows);
+   for(S32 i = 0; i < cellClusters.size(); i++)
+      cellClusters[i] = -1;
+
+   // Only cells with zones in them get a cluster
+   Vector<S32> clusterSizes;
+   mZoneClusters.resize(zoneCount);
+
+   for(S32 i = 0; i < zoneCount; i++)
+   {
+      Point center = zones->get(i)->getCenter();
+      S32 col = min(S32((center.x - extents.min.x) / cellSize), cols - 1);
+      S32 row = min(S32((center.y - extents.min.y) / cellSize), rows - 1);
+      S32 &cluster = cellClusters[row * cols + col];
+
+      if(cluster < 0)
+      {
+         cluster = mClusters.size();
+         mClusters.push_back(Cluster());
+         mClusters.last().center = Point(0, 0);
+         clusterSizes.push_back(0);
+      }
+
+      mZoneClusters[i] = (U16)cluster;
+      mClusters[cluster].center += center;
+      clusterSizes[cluster]++;
+   }
+
+   for(S32 i = 0; i < mClusters.size(); i++)
+      mClusters[i].center /= (F32)clusterSizes[i];
+
+   // Links follow NeighboringZones, so one-way connections such as teleporters stay one-way
+   for(S32 i = 0; i < zoneCount; i++)
+   {
+      U16 fromCluster = mZoneClusters[i];
+      Point from = zones->get(i)->getCenter();
+      const Vector<NeighboringZone> &neighbors = zones->get(i)->mNeighbors;
+
+      for(S32 j = 0; j < neighbors.size(); j++)
+      {
+         U16 toCluster = mZoneClusters[neighbors[j].zoneID];
+         if(toCluster == fromCluster)
+            continue;
+
+         F32 cost = mClusters[fromCluster].center.distanceTo(from) + neighbors[j].distTo +
+                    neighbors[j].center.distanceTo(mClusters[toCluster].center);
+
+         addLink(fromCluster, toCluster, cost);
+      }
+   }
+
+   mInCorridor.resize(mClusters.size());
+   for(S32 i = 0; i < mInCorridor.size(); i++)
+      mInCorridor[i] = false;
+
+   mCost.resize(mClusters.size());
+   mParent.resize(mClusters.size());
+   mState.resize(mClusters.size());
+}
+
+
+// Keep only the cheapest link between any two clusters
+void ZoneClusterGraph::addLink(U16 fromCluster, U16 toCluster, F32 cost)
+{
+   Vector<ClusterLink> &links = mClusters[fromCluster].links;
+
+   for(S32 i = 0; i < links.size(); i++)
+      if(links[i].cluster == toCluster)
+      {
+         links[i].cost = min(links[i].cost, cost);
+         return;
+      }
+
+   ClusterLink link;
+   link.cluster = toCluster;
+   link.cost = cost;
+   links.push_back(link);
+}
+
+
+void ZoneClusterGraph::clear()
+{
+   mZoneClusters.clear();
+   mClusters.clear();
+   mCorridor.clear();
+   mInCorridor.clear();
+   mCorridorComplete = false;
+}
+
+
+S32 ZoneClusterGraph::getClusterCount() const
+{
+   return mClusters.size();
+}
+
+
+U16 ZoneClusterGraph::getCluster(S32 zone) const
+{
+   return mZoneClusters[zone];
+}
+
+
+void ZoneClusterGraph::clearCorridor()
+{
+   for(S32 i = 0; i < mCorridor.size(); i++)
+      mInCorridor[mCorridor[i]] = false;
+
+   mCorridor.clear();
+   mCorridorComplete = false;
+}
+
+
+// Finds the cheapest way through the clusters from startZone's to targetZone's, and keeps the first maxClusters
+// of it (at least two) as the corridor for AStar.  Returns false if the clusters aren't connected at all, in
+// which case neither are the zones.
+//
+// There are only a few hundred clusters even on the biggest levels, so a plain scan for the cheapest open
+// cluster is quick enough.
+bool ZoneClusterGraph::planCorridor(S32 startZone, S32 targetZone, S32 maxClusters)
+{
+   enum { Unvisited, Open, Closed };
+
+   clearCorridor();
+
+   S32 startCluster = mZoneClusters[startZone];
+   S32 targetCluster = mZoneClusters[targetZone];
+   const Point &targetCenter = mClusters[targetCluster].center;
+
+   for(S32 i = 0; i < mClusters.size(); i++)
+      mState[i] = Unvisited;
+
+   Vector<S32> open;
+   open.push_back(startCluster);
+   mCost[startCluster] = 0;
+   mParent[startCluster] = -1;
+   mState[startCluster] = Open;
+
+   bool found = false;
+
+   while(open.size() > 0)
+   {
+      S32 best = 0;
+      F32 bestScore = F32_MAX;
+      for(S32 i = 0; i < open.size(); i++)
+      {
+         F32 score = mCost[open[i]] + mClusters[open[i]].center.distanceTo(targetCenter);
+         if(score < bestScore)
+         {
+            bestScore = score;
+            best = i;
+         }
+      }
+
+      S32 cluster = open[best];
+      open.erase_fast(best);
+
+      if(cluster == targetCluster)
+      {
+         found = true;
+         break;
+      }
+
+      mState[cluster] = Closed;
+
+      const Vector<ClusterLink> &links = mClusters[cluster].links;
+      for(S32 i = 0; i < links.size(); i++)
+      {
+         S32 next = links[i].cluster;
+         F32 cost = mCost[cluster] + links[i].cost;
+
+         if(mState[next] == Closed || (mState[next] == Open && cost >= mCost[next]))
+            continue;
+
+         if(mState[next] == Unvisited)
+            open.push_back(next);
+
+         mState[next] = Open;
+         mCost[next] = cost;
+         mParent[next] = cluster;
+      }
+   }
+
+   if(!found)
+      return false;
+
+   // Walk back from the target, then flip so the corridor runs from the start
+   for(S32 cluster = targetCluster; cluster >= 0; cluster = mParent[cluster])
+      mCorridor.push_back(cluster);
+
+   mCorridor.reverse();
+
+   maxClusters = max(maxClusters, 2);
+   mCorridorComplete = mCorridor.size() <= maxClusters;
+   if(!mCorridorComplete)
+      mCorridor.resize(maxClusters);
+
+   for(S32 i = 0; i < mCorridor.size(); i++)
+      mInCorridor[mCorridor[i]] = true;
+
+   return true;
+}
+
+
+bool ZoneClusterGraph::isInCorridor(S32 zone) const
+{
+   return mInCorridor[mZoneClusters[zone]];
+}
+
+
+// True if zone is in the last cluster of a corridor that stops short of the target
+bool ZoneClusterGraph::isCorridorEnd(S32 zone) const
+{
+   return !mCorridorComplete && mZoneClusters[zone] == mCorridor.last();
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+ZoneRouteCache::ZoneRouteCache(U32 capacity, S32 hierarchyMinZones)
+{
+   mCapacity = capacity;
+   mWalkabilityVersion = BotNavMeshZone::getWalkabilityVersion();
+   mHierarchyMinZones = hierarchyMinZones;
+}
+
+
+// Call whenever the zones themselves are rebuilt.  Big levels get a cluster graph, so routes through them
+// can be planned a piece at a time.
+void ZoneRouteCache::buildClusters(const Vector<BotNavMeshZone *> *zones)
+{
+   clear();
+
+   if(zones->size() >= mHierarchyMinZones)
+      mClusters.build(zones);
+   else
+      mClusters.clear();
+}
+
+
+U32 ZoneRouteCache::makeKey(U16 startZone, U16 targetZone)
+{
+   return (U32(startZone) << 16) | targetZone;
+}
+
+
+// Returns a route from startZone towards targetZone -- empty if there is none -- searching only if we haven't
+// seen this pair of zones recently.  The reference is good until the next call.
+const ZoneRoute &ZoneRouteCache::findRoute(const Vector<BotNavMeshZone *> *zones, U16 startZone, U16 targetZone)
+{
+   if(mWalkabilityVersion != BotNavMeshZone::getWalkabilityVersion())
+   {
+      clear();
+      mWalkabilityVersion = BotNavMeshZone::getWalkabilityVersion();
+   }
+
+   U32 key = makeKey(startZone, targetZone);
+
+   map<U32, RouteList::iterator>::iterator found = mRouteIndex.find(key);
+   if(found != mRouteIndex.end())
+   {
+      mRoutes.splice(mRoutes.begin(), mRoutes, found->second);    // Now the most recently used
+      return found->second->second;
+   }
+
+   // Not found, so search, reusing the least recently used route if we're full
+   if(mRoutes.size() >= mCapacity && mRoutes.size() > 0)
+   {
+      mRouteIndex.erase(mRoutes.back().first);
+      mRoutes.splice(mRoutes.begin(), mRoutes, --mRoutes.end());
+   }
+   else
+      mRoutes.push_front(Route());
+
+   Route &route = mRoutes.front();
+   route.first = key;
+   search(zones, startZone, targetZone, route.second);   // Cache failures too, so we don't keep retrying them
+
+   mRouteIndex[key] = mRoutes.begin();
+
+   return route.second;
+}
+
+
+// With clusters, plan through the first few clusters on the way and let the bot come back for the rest when
+// it gets there.  That way each search only looks at a few hundred zones, however big the level is.
+void ZoneRouteCache::search(const Vector<BotNavMeshZone *> *zones, U16 startZone, U16 targetZone, ZoneRoute &route)
+{
+   route.endZone = targetZone;
+
+   if(mClusters.getClusterCount() > 0 && mClusters.getCluster(startZone) != mClusters.getCluster(targetZone))
+   {
+      if(!mClusters.planCorridor(startZone, targetZone, CorridorClusters))
+      {
+         route.points.clear();      // Clusters aren't connected, so there's no way through
+         return;
+      }
+
+      if(mSearch.findRoute(zones, startZone, targetZone, mClusters, route.points, route.endZone))
+         return;
+
+      // Blocked zones, or a cluster split by walls, can close a corridor that looked open; search everything
+   }
+
+   mSearch.findRoute(zones, startZone, targetZone, route.points);
+}
+
+
+// Call whenever the zones themselves are rebuilt
+void ZoneRouteCache::clear()
+{
+   mRoutes.clear();
+   mRouteIndex.clear();
+}
+
+
+S32 ZoneRouteCache::getRouteCount() const
+{
+   return (S32)mRoutes.size();
+}
+
+
 };
 
 
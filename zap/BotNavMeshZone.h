@@ -9,6 +9,9 @@
 #include "gridDB.h"            // Parent
 #include "../recast/Recast.h"  // for rcPolyMesh;
 
+#include <list>
+#include <map>
+
 namespace Zap
 {
 
@@ -41,6 +44,33 @@ public:
 
 class ServerGame;
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Everything about a level that goes into its mesh, copied out of the game so the meshing itself can
+// be done off the game thread
+struct BotZoneMeshInput
+{
+   Rect bounds;                                 // World extents
+   Vector<Vector<Point> > barrierPolygons;      // Collision polys of every barrier, not yet merged
+   Vector<Vector<Point> > blockingPolygons;     // Buffers around turrets and forcefield projectors
+   Vector<Vector<Point> > corePolygons;
+   Vector<Vector<Point> > speedZonePolygons;
+
+   string getHash() const;    // Same geometry, same hash
+};
+
+
+// A level's mesh, before it gets turned into zones
+struct BotZoneMesh
+{
+   rcPolyMesh mesh;
+   S32 corePolyStart;         // Polys before this are ordinary floor; cores come next, then speedzones
+   S32 speedZonePolyStart;
+   string inputHash;          // Hash of the BotZoneMeshInput this was built from
+};
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -52,6 +82,8 @@ private:
    U16 mZoneId;                              // Unique ID for each zone
    bool mWalkable;                           // Flag for if this zone can currently be traversed
 
+   static TNL_THREAD_LOCAL U32 mWalkabilityVersion;    // Changes whenever any of this thread's zones' walkability does
+
    static void populateZoneList(GridDatabase *mBotZoneDatabase, Vector<BotNavMeshZone *> *allZones);  // Populates allZones
 
 public:
@@ -78,6 +110,7 @@ public:
    U16 getZoneId();
    bool getWalkable();
    void setWalkable(bool canWalk);
+   static U32 getWalkabilityVersion();
 
    Vector<NeighboringZone> mNeighbors;       // List of other zones this zone touches, only populated on server
    Vector<Border> mNeighborRenderPoints;     // Only populated on client
@@ -86,6 +119,12 @@ public:
    static bool buildBotMeshZones(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
                                  const Rect *worldExtents, bool triangulateZones);
 
+   // buildBotMeshZones() in three steps; only the middle one, which does the heavy lifting, is safe to run on another thread
+   static void gatherMeshInput(GridDatabase *gameObjDatabase, const Rect *worldExtents, BotZoneMeshInput &input);
+   static bool buildMesh(const BotZoneMeshInput &input, BotZoneMesh &mesh, string &error);
+   static void buildZonesFromMesh(GridDatabase *botZoneDatabase, GridDatabase *gameObjDatabase, Vector<BotNavMeshZone *> *allZones,
+                                  BotZoneMesh &mesh, const BotZoneMeshInput &input, bool triangulateZones);
+
    static bool buildConnectionsRecastStyle(const Vector<BotNavMeshZone *> *allZones,
          rcPolyMesh &mesh, const Vector<S32> &polyToZoneMap, S32 coreRecastPolyStartIdx,
          S32 szRecastPolyStartIdx);
@@ -95,15 +134,146 @@ public:
 ////////////////////////////////////////
 ////////////////////////////////////////
 
+class ZoneClusterGraph;
+
+// Each AStar keeps its own open and closed lists, so separate instances can search at the
+// same time.  Reuse an instance where possible; its lists are only reallocated when the
+// zone count grows.
 class AStar
 {
 private:
+   // Bumping these effectively clears mWhichList without touching it
+   U16 mOnClosedList;
+   U16 mOnOpenList;
+
+   Vector<U16> mWhichList;       // Records whether a zone is on the open or closed list, indexed by zone
+   Vector<S16> mOpenList;        // Binary heap of open list item ids, starting at index 1
+   Vector<S16> mOpenZone;        // Zone for each open list item id
+   Vector<S16> mParentZones;     // Indexed by zone
+
+   Vector<F32> mFcost;           // Indexed by open list item id
+   Vector<F32> mGcost;           // Indexed by zone
+   Vector<F32> mHcost;           // Indexed by open list item id
+
+   void prepare(S32 zoneCount);
+
+   S32 search(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, 
+              const ZoneClusterGraph *clusters, Vector<Point> &route);
+
    static F32 heuristic(const Vector<BotNavMeshZone *> *zones, S32 fromZone, S32 toZone);
    static Point findGateway(const Vector<BotNavMeshZone *> *zones, S32 zone1, S32 zone2);
 
 public:
-   static Vector<Point> findPath (const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Point &target);
-   
+   AStar();    // Constructor
+
+   bool findRoute(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, Vector<Point> &route);
+   bool findRoute(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, 
+                  const ZoneClusterGraph &clusters, Vector<Point> &route, U16 &endZone);
+   Vector<Point> findPath(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Point &target);
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Coarse map of the nav mesh for big levels.  Zones are grouped into clusters by position, and
+// clusters are linked wherever one of their zones neighbors a zone in the other.  Planning a
+// corridor of clusters first lets AStar ignore every zone that isn't in it.
+class ZoneClusterGraph
+{
+private:
+   struct ClusterLink
+   {
+      U16 cluster;
+      F32 cost;      // Cheapest way from our center to theirs through any pair of neighboring zones
+   };
+
+   struct Cluster
+   {
+      Point center;                 // Average of the centers of our zones
+      Vector<ClusterLink> links;
+   };
+
+   Vector<U16> mZoneClusters;       // Cluster of each zone
+   Vector<Cluster> mClusters;
+
+   Vector<U16> mCorridor;           // Clusters from the start of the last planned corridor onwards
+   Vector<bool> mInCorridor;        // Indexed by cluster
+   bool mCorridorComplete;          // True if mCorridor reaches the target's cluster
+
+   // Cluster search scratch space, indexed by cluster
+   Vector<F32> mCost;
+   Vector<S32> mParent;
+   Vector<U8> mState;
+
+   void addLink(U16 fromCluster, U16 toCluster, F32 cost);
+   void clearCorridor();
+
+public:
+   static const S32 DefaultZonesPerCluster = 64;
+
+   ZoneClusterGraph();     // Constructor
+
+   void build(const Vector<BotNavMeshZone *> *zones, S32 zonesPerCluster = DefaultZonesPerCluster);
+   void clear();
+
+   S32 getClusterCount() const;
+   U16 getCluster(S32 zone) const;
+
+   bool planCorridor(S32 startZone, S32 targetZone, S32 maxClusters);
+   bool isInCorridor(S32 zone) const;
+   bool isCorridorEnd(S32 zone) const;
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// A route from ZoneRouteCache: zone centers and gateways from endZone back to the start, laid out as
+// by AStar::findRoute().  On big levels only the first few clusters' worth of a route are planned, so
+// endZone may fall short of the target; plan from endZone onwards once the bot gets there.
+struct ZoneRoute
+{
+   Vector<Point> points;      // Empty if there's no way through
+   U16 endZone;
+};
+
+
+// Remembers recently found zone-to-zone routes, so bots headed for the same place don't each
+// repeat the same search.  Once full, the least recently used route is dropped.  All routes
+// are forgotten when any zone's walkability changes.
+class ZoneRouteCache
+{
+private:
+   typedef pair<U32, ZoneRoute> Route;             // Key from makeKey(), and the route itself
+   typedef list<Route> RouteList;
+
+   RouteList mRoutes;                              // Most recently used first
+   map<U32, RouteList::iterator> mRouteIndex;      // Where each key is in mRoutes
+
+   U32 mCapacity;
+   U32 mWalkabilityVersion;                        // Version of zone walkability our routes were found with
+
+   S32 mHierarchyMinZones;
+   ZoneClusterGraph mClusters;                     // Empty unless the level has at least mHierarchyMinZones zones
+
+   AStar mSearch;
+
+   static U32 makeKey(U16 startZone, U16 targetZone);
+   void search(const Vector<BotNavMeshZone *> *zones, U16 startZone, U16 targetZone, ZoneRoute &route);
+
+public:
+   static const U32 DefaultCapacity = 1024;
+   static const S32 DefaultHierarchyMinZones = 1000;
+   static const S32 CorridorClusters = 3;          // Clusters planned zone-by-zone per route, including the start's
+
+   explicit ZoneRouteCache(U32 capacity = DefaultCapacity, S32 hierarchyMinZones = DefaultHierarchyMinZones);    // Constructor
+
+   void buildClusters(const Vector<BotNavMeshZone *> *zones);
+   const ZoneRoute &findRoute(const Vector<BotNavMeshZone *> *zones, U16 startZone, U16 targetZone);
+
+   void clear();
+   S32 getRouteCount() const;
 };
 
 
@@ -0,0 +1,252 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotZoneMeshCache.h"
+
+#include "stringUtils.h"
+
+#include "../recast/RecastAlloc.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace Zap
+{
+
+// File layout, all little-endian:
+//    magic, version, input hash (32 chars), offsetX, offsetY, nvp, nverts, npolys, corePolyStart, speedZonePolyStart,
+//    verts (2 U16s each), polys (nvp U16s each)
+static const U32 CacheMagic = 0x435A4642;   // "BFZC"
+static const U32 HashLength = 32;
+static const U32 HeaderSize = 4 + 4 + HashLength + 7 * 4;
+static const S32 MaxVertsPerPoly = 32;
+
+static void writeU32(U8 *dest, U32 value)
+{
+   dest[0] = U8(value);
+   dest[1] = U8(value >> 8);
+   dest[2] = U8(value >> 16);
+   dest[3] = U8(value >> 24);
+}
+
+
+static U32 readU32(const U8 *src)
+{
+   return U32(src[0]) | (U32(src[1]) << 8) | (U32(src[2]) << 16) | (U32(src[3]) << 24);
+}
+
+
+struct CacheFile
+{
+   string filename;
+   S64 modTime;
+
+   bool operator<(const CacheFile &other) const
+   {
+      return modTime < other.modTime || (modTime == other.modTime && filename < other.filename);
+   }
+};
+
+
+// Constructor
+BotZoneMeshCache::BotZoneMeshCache(const string &dir, S32 maxFiles)
+{
+   mMaxFiles = maxFiles;
+
+   if(dir != "" && makeSureFolderExists(dir))
+      mDir = dir;
+}
+
+
+string BotZoneMeshCache::getFileName(const string &levelHash) const
+{
+   return joindir(mDir, levelHash + ".zones");
+}
+
+
+// Returns false, and leaves mesh alone, if we don't have the level, or what we have is no good
+bool BotZoneMeshCache::load(const string &levelHash, BotZoneMesh &mesh) const
+{
+   if(mDir == "" || levelHash == "")
+      return false;
+
+   string filename = getFileName(levelHash);
+   FILE *f = fopen(filename.c_str(), "rb");
+   if(!f)
+      return false;
+
+   Vector<U8> data;
+   U8 buffer[4096];
+   size_t size;
+
+   while((size = fread(buffer, 1, sizeof(buffer), f)) > 0)
+   {
+      S32 oldSize = data.size();
+      data.resize(oldSize + S32(size));
+      memcpy(&data[oldSize], buffer, size);
+   }
+
+   fclose(f);
+
+   bool valid = data.size() >= S32(HeaderSize) && readU32(&data[0]) == CacheMagic && readU32(&data[4]) == Version;
+
+   S32 nvp = 0, nverts = 0, npolys = 0, corePolyStart = 0, speedZonePolyStart = 0;
+
+   if(valid)
+   {
+      const U8 *header = &data[8 + HashLength];
+      nvp                = S32(readU32(header + 8));
+      nverts             = S32(readU32(header + 12));
+      npolys             = S32(readU32(header + 16));
+      corePolyStart      = S32(readU32(header + 20));
+      speedZonePolyStart = S32(readU32(header + 24));
+
+      valid = nvp > 0 && nvp <= MaxVertsPerPoly && nverts >= 0 && nverts <= U16_MAX && npolys >= 0 && npolys <= U16_MAX &&
+              corePolyStart >= 0 && corePolyStart <= speedZonePolyStart && speedZonePolyStart <= npolys &&
+              data.size() == S32(HeaderSize) + (nverts * 2 + npolys * nvp) * S32(sizeof(U16));
+   }
+
+   const U8 *verts = valid ? &data[0] + HeaderSize : NULL;
+   const U8 *polys = valid ? verts + nverts * 2 * sizeof(U16) : NULL;
+
+   // Every poly has to refer to verts we have, or zone building will go wandering off the end of the array
+   for(S32 i = 0; valid && i < npolys * nvp; i++)
+   {
+      U16 index = U16(polys[i * 2] | (polys[i * 2 + 1] << 8));
+      valid = (index == RC_MESH_NULL_IDX || index < nverts);
+   }
+
+   if(!valid)
+   {
+      remove(filename.c_str());
+      return false;
+   }
+
+   rcPolyMesh &polyMesh = mesh.mesh;
+
+   rcFree(polyMesh.verts);
+   rcFree(polyMesh.polys);
+   rcFree(polyMesh.adjacency);
+
+   polyMesh.verts = (U16 *)rcAlloc(sizeof(U16) * (nverts * 2 + 1), RC_ALLOC_PERM);   // + 1 so we never ask for nothing
+   polyMesh.polys = (U16 *)rcAlloc(sizeof(U16) * (npolys * nvp + 1), RC_ALLOC_PERM);
+   polyMesh.adjacency = NULL;
+
+   for(S32 i = 0; i < nverts * 2; i++)
+      polyMesh.verts[i] = U16(verts[i * 2] | (verts[i * 2 + 1] << 8));
+
+   for(S32 i = 0; i < npolys * nvp; i++)
+      polyMesh.polys[i] = U16(polys[i * 2] | (polys[i * 2 + 1] << 8));
+
+   const U8 *header = &data[8 + HashLength];
+
+   polyMesh.offsetX  = S32(readU32(header));
+   polyMesh.offsetY  = S32(readU32(header + 4));
+   polyMesh.nvp      = nvp;
+   polyMesh.nverts   = nverts;
+   polyMesh.npolys   = npolys;
+   polyMesh.maxpolys = npolys;
+
+   mesh.corePolyStart = corePolyStart;
+   mesh.speedZonePolyStart = speedZonePolyStart;
+   mesh.inputHash.assign((const char *)&data[8], HashLength);
+
+   return true;
+}
+
+
+bool BotZoneMeshCache::save(const string &levelHash, const BotZoneMesh &mesh) const
+{
+   if(mDir == "" || levelHash == "" || mesh.inputHash.length() != HashLength)
+      return false;
+
+   const rcPolyMesh &polyMesh = mesh.mesh;
+
+   Vector<U8> data;
+   data.resize(HeaderSize + (polyMesh.nverts * 2 + polyMesh.npolys * polyMesh.nvp) * sizeof(U16));
+
+   writeU32(&data[0], CacheMagic);
+   writeU32(&data[4], Version);
+   memcpy(&data[8], mesh.inputHash.c_str(), HashLength);
+
+   U8 *header = &data[8 + HashLength];
+   writeU32(header,      U32(polyMesh.offsetX));
+   writeU32(header + 4,  U32(polyMesh.offsetY));
+   writeU32(header + 8,  U32(polyMesh.nvp));
+   writeU32(header + 12, U32(polyMesh.nverts));
+   writeU32(header + 16, U32(polyMesh.npolys));
+   writeU32(header + 20, U32(mesh.corePolyStart));
+   writeU32(header + 24, U32(mesh.speedZonePolyStart));
+
+   U8 *dest = &data[0] + HeaderSize;
+
+   for(S32 i = 0; i < polyMesh.nverts * 2; i++, dest += 2)
+   {
+      dest[0] = U8(polyMesh.verts[i]);
+      dest[1] = U8(polyMesh.verts[i] >> 8);
+   }
+
+   for(S32 i = 0; i < polyMesh.npolys * polyMesh.nvp; i++, dest += 2)
+   {
+      dest[0] = U8(polyMesh.polys[i]);
+      dest[1] = U8(polyMesh.polys[i] >> 8);
+   }
+
+   // Write it somewhere else first, so nobody ever reads half a file
+   string filename = getFileName(levelHash);
+   string tempFilename = filename + "." + mesh.inputHash + ".tmp";
+
+   FILE *f = fopen(tempFilename.c_str(), "wb");
+   if(!f)
+      return false;
+
+   bool written = fwrite(data.address(), 1, data.size(), f) == size_t(data.size());
+   written = (fclose(f) == 0) && written;
+
+   remove(filename.c_str());     // Windows won't rename over an existing file
+
+   if(!written || rename(tempFilename.c_str(), filename.c_str()) != 0)
+   {
+      remove(tempFilename.c_str());
+      return false;
+   }
+
+   prune(filename);
+
+   return true;
+}
+
+
+// Deletes the least recently written meshes until there are no more than mMaxFiles, never touching keepFilename.  Two
+// threads doing this at once may delete a few more than they need to, which costs no more than meshing them again.
+void BotZoneMeshCache::prune(const string &keepFilename) const
+{
+   const string extensions[] = { "zones" };
+   Vector<string> names;
+
+   if(!getFilesFromFolder(mDir, names, extensions, ARRAYSIZE(extensions)) || names.size() <= mMaxFiles)
+      return;
+
+   Vector<CacheFile> files;
+
+   for(S32 i = 0; i < names.size(); i++)
+   {
+      CacheFile file;
+      S64 size;
+      file.filename = joindir(mDir, names[i]);
+
+      if(file.filename != keepFilename && getFileStats(file.filename, file.modTime, size))
+         files.push_back(file);
+   }
+
+   std::sort(files.getStlVector().begin(), files.getStlVector().end());
+
+   // Leave room for the one we're keeping
+   for(S32 i = 0; i < files.size() - (mMaxFiles - 1); i++)
+      remove(files[i].filename.c_str());
+}
+
+
+}
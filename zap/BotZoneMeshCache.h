@@ -0,0 +1,46 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _BOT_ZONE_MESH_CACHE_H_
+#define _BOT_ZONE_MESH_CACHE_H_
+
+#include "BotNavMeshZone.h"
+
+#include <string>
+
+using namespace std;
+
+namespace Zap
+{
+
+// Keeps bot zone meshes on disk, so a level only ever needs to be meshed once.  Meshes are filed under the hash of
+// the level file, and remember the hash of the geometry they were built from; a mesh whose level has since been
+// edited is never found, and one from before a levelgen changed the level's shape is caught by the caller checking
+// BotZoneMesh::inputHash.  Files we can't make sense of (corrupt, or from an older version) are deleted, as are the
+// oldest files once there are more than maxFiles, so every version of every level ever played doesn't pile up forever.
+//
+// Holds no state beyond the folder, so can be used from any thread.
+class BotZoneMeshCache
+{
+private:
+   string mDir;               // Empty if we're not caching
+   S32 mMaxFiles;
+
+   string getFileName(const string &levelHash) const;
+   void prune(const string &keepFilename) const;
+
+public:
+   static const U32 Version = 1;       // Bump whenever the mesh we build for a given level might change
+   static const S32 DefaultMaxFiles = 200;
+
+   explicit BotZoneMeshCache(const string &dir, S32 maxFiles = DefaultMaxFiles);     // Constructor
+
+   bool load(const string &levelHash, BotZoneMesh &mesh) const;
+   bool save(const string &levelHash, const BotZoneMesh &mesh) const;
+};
+
+}
+
+#endif
@@ -920,6 +920,34 @@ void shuffleTeams(ClientGame *game, const Vector<string> &words)
 }
 
 
+// Server does the work; see GameType::processGhostProfileCommand()
+void ghostProfileHandler(ClientGame *game, const Vector<string> &words)
+{
+   if(game->hasAdmin("!!! Need admin permissions to profile the server"))
+   {
+      Vector<StringPtr> args;
+      for(S32 i = 1; i < words.size(); i++)
+         args.push_back(StringPtr(words[i]));
+
+      game->sendCommand("ghostprofile", args);
+   }
+}
+
+
+// Server does the work; see GameType::processScriptStatsCommand()
+void scriptStatsHandler(ClientGame *game, const Vector<string> &words)
+{
+   if(game->hasAdmin("!!! Need admin permissions to see script stats"))
+   {
+      Vector<StringPtr> args;
+      for(S32 i = 1; i < words.size(); i++)
+         args.push_back(StringPtr(words[i]));
+
+      game->sendCommand("scriptstats", args);
+   }
+}
+
+
 void banPlayerHandler(ClientGame *game, const Vector<string> &words)
 {
    if(game->hasAdmin("!!! Need admin permissions to ban players"))
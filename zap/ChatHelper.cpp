@@ -82,6 +82,8 @@ namespace Zap
    { "rename",             &ChatCommands::renamePlayerHandler,       { NAME, STR },  2, ADMIN_COMMANDS,  0,  1,  {"<from>","<to>"},       "Give a player a new name" },
    { "maxbots",            &ChatCommands::setMaxBotsHandler,         { xINT },       1, ADMIN_COMMANDS,  0,  1,  {"<count>"},             "Set the maximum bots allowed for this server" },
    { "shuffle",            &ChatCommands::shuffleTeams,              { },            0, ADMIN_COMMANDS,  0,  1,  { "" },                  "Randomly reshuffle teams" },
+   { "ghostprofile",       &ChatCommands::ghostProfileHandler,       { STR },        1, ADMIN_COMMANDS,  0,  1,  {"[on|off|reset|log]"},  "Show bandwidth and CPU used updating each object type" },
+   { "scriptstats",        &ChatCommands::scriptStatsHandler,        { STR },        1, ADMIN_COMMANDS,  0,  1,  {"[reset]"},             "Show CPU used by each bot and levelgen" },
 #ifdef TNL_DEBUG
    { "pause",              &ChatCommands::pauseHandler,              { },            0, ADMIN_COMMANDS,  0,  1,  { "" },                  "TODO: add 'PAUSED' display while paused" },
 #endif
@@ -14,6 +14,7 @@
 
 #include "barrier.h"
 #include "gameType.h"
+#include "projectile.h"
 #include "UIEditor.h"
 #include "UIManager.h"
 #include "EditorTeam.h"
@@ -268,6 +269,7 @@ void ClientGame::startLoadingLevel(bool engineerEnabled)
 void ClientGame::doneLoadingLevel()
 {
    computeWorldObjectExtents();              // Make sure our world extents reflect all the objects we've loaded
+   getGameObjDatabase()->chooseSpatialIndexType();
    Barrier::prepareRenderingGeometry(this);  // Get walls ready to render
 
    getUIManager()->doneLoadingLevel();
@@ -814,6 +816,9 @@ void ClientGame::idle(U32 timeDelta)
          mConnectionToServer->addPendingMove(theMove);
          theMove->time = timeDelta;
 
+         // Projectiles all move together, as that's much cheaper than each one moving itself when it's idled
+         Projectile::moveAll(mGameObjDatabase->findObjects_fast(BulletTypeNumber), timeDelta);
+
          const Vector<DatabaseObject *> *gameObjects = mGameObjDatabase->findObjects_fast();
 
          // Visit each game object, handling moves and running its idle method
@@ -0,0 +1,383 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "DynamicAABBTree.h"
+
+#include "MathUtils.h"
+
+namespace Zap
+{
+
+// Constructor
+DynamicAABBTree::DynamicAABBTree(F32 margin)
+{
+   mMargin = margin;
+   mRoot = NullNode;
+   mFreeList = NullNode;
+   mProxyCount = 0;
+}
+
+
+// Destructor
+DynamicAABBTree::~DynamicAABBTree()
+{
+   // Do nothing
+}
+
+
+// Forget everything in the tree, but keep the node storage around for reuse
+void DynamicAABBTree::clear()
+{
+   mNodes.clear();
+   mRoot = NullNode;
+   mFreeList = NullNode;
+   mProxyCount = 0;
+}
+
+
+S32 DynamicAABBTree::allocateNode()
+{
+   S32 nodeId;
+
+   if(mFreeList != NullNode)
+   {
+      nodeId = mFreeList;
+      mFreeList = mNodes[nodeId].parent;
+   }
+   else
+   {
+      nodeId = mNodes.size();
+      mNodes.resize(nodeId + 1);
+   }
+
+   Node &node = mNodes[nodeId];
+   node.userData = NULL;
+   node.parent = NullNode;
+   node.child1 = NullNode;
+   node.child2 = NullNode;
+   node.height = 0;
+
+   return nodeId;
+}
+
+
+void DynamicAABBTree::freeNode(S32 nodeId)
+{
+   TNLAssert(nodeId >= 0 && nodeId < mNodes.size(), "Invalid node!");
+
+   mNodes[nodeId].parent = mFreeList;
+   mNodes[nodeId].height = -1;
+   mFreeList = nodeId;
+}
+
+
+S32 DynamicAABBTree::createProxy(const Rect &extent, void *userData)
+{
+   S32 proxyId = allocateNode();
+
+   Rect fatExtent(extent);
+   fatExtent.expand(Point(mMargin, mMargin));
+
+   mNodes[proxyId].extent = fatExtent;
+   mNodes[proxyId].userData = userData;
+
+   insertLeaf(proxyId);
+   mProxyCount++;
+
+   return proxyId;
+}
+
+
+void DynamicAABBTree::destroyProxy(S32 proxyId)
+{
+   TNLAssert(proxyId >= 0 && proxyId < mNodes.size() && mNodes[proxyId].isLeaf(), "Invalid proxy!");
+
+   removeLeaf(proxyId);
+   freeNode(proxyId);
+   mProxyCount--;
+}
+
+
+// Only touches the tree if the new extent has escaped the fattened one we stored when the proxy was last inserted
+bool DynamicAABBTree::moveProxy(S32 proxyId, const Rect &extent)
+{
+   TNLAssert(proxyId >= 0 && proxyId < mNodes.size() && mNodes[proxyId].isLeaf(), "Invalid proxy!");
+
+   if(contains(mNodes[proxyId].extent, extent))
+      return false;
+
+   removeLeaf(proxyId);
+
+   Rect fatExtent(extent);
+   fatExtent.expand(Point(mMargin, mMargin));
+   mNodes[proxyId].extent = fatExtent;
+
+   insertLeaf(proxyId);
+
+   return true;
+}
+
+
+void *DynamicAABBTree::getUserData(S32 proxyId) const
+{
+   return mNodes[proxyId].userData;
+}
+
+
+const Rect &DynamicAABBTree::getFatExtent(S32 proxyId) const
+{
+   return mNodes[proxyId].extent;
+}
+
+
+S32 DynamicAABBTree::getProxyCount() const
+{
+   return mProxyCount;
+}
+
+
+S32 DynamicAABBTree::getHeight() const
+{
+   if(mRoot == NullNode)
+      return 0;
+
+   return mNodes[mRoot].height;
+}
+
+
+// Uses <= so that zero-area extents (points) are still found; callers apply the exact test
+bool DynamicAABBTree::overlaps(const Rect &a, const Rect &b)
+{
+   return a.min.x <= b.max.x && a.min.y <= b.max.y &&
+          a.max.x >= b.min.x && a.max.y >= b.min.y;
+}
+
+
+bool DynamicAABBTree::contains(const Rect &outer, const Rect &inner)
+{
+   return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+          outer.max.x >= inner.max.x && outer.max.y >= inner.max.y;
+}
+
+
+F32 DynamicAABBTree::perimeter(const Rect &rect)
+{
+   return 2 * ((rect.max.x - rect.min.x) + (rect.max.y - rect.min.y));
+}
+
+
+Rect DynamicAABBTree::combine(const Rect &a, const Rect &b)
+{
+   Rect rect(a);
+   rect.unionRect(b);
+   return rect;
+}
+
+
+// Find the best sibling for the new leaf using the surface area (well, perimeter, in 2D) heuristic,
+// then walk back up the tree fixing heights and extents
+void DynamicAABBTree::insertLeaf(S32 leaf)
+{
+   if(mRoot == NullNode)
+   {
+      mRoot = leaf;
+      mNodes[mRoot].parent = NullNode;
+      return;
+   }
+
+   const Rect leafExtent = mNodes[leaf].extent;
+   S32 index = mRoot;
+
+   while(!mNodes[index].isLeaf())
+   {
+      S32 child1 = mNodes[index].child1;
+      S32 child2 = mNodes[index].child2;
+
+      F32 area = perimeter(mNodes[index].extent);
+      F32 combinedArea = perimeter(combine(mNodes[index].extent, leafExtent));
+
+      // Cost of creating a new parent for this node and the new leaf
+      F32 cost = 2 * combinedArea;
+
+      // Minimum cost of pushing the leaf further down the tree
+      F32 inheritanceCost = 2 * (combinedArea - area);
+
+      F32 cost1 = perimeter(combine(leafExtent, mNodes[child1].extent)) + inheritanceCost;
+      if(!mNodes[child1].isLeaf())
+         cost1 -= perimeter(mNodes[child1].extent);
+
+      F32 cost2 = perimeter(combine(leafExtent, mNodes[child2].extent)) + inheritanceCost;
+      if(!mNodes[child2].isLeaf())
+         cost2 -= perimeter(mNodes[child2].extent);
+
+      if(cost < cost1 && cost < cost2)
+         break;
+
+      index = cost1 < cost2 ? child1 : child2;
+   }
+
+   S32 sibling = index;
+
+   // Create a new parent to hold the sibling and the leaf
+   S32 oldParent = mNodes[sibling].parent;
+   S32 newParent = allocateNode();      // Note: may reallocate mNodes, so don't hold references across this call
+
+   mNodes[newParent].parent = oldParent;
+   mNodes[newParent].extent = combine(leafExtent, mNodes[sibling].extent);
+   mNodes[newParent].height = mNodes[sibling].height + 1;
+   mNodes[newParent].child1 = sibling;
+   mNodes[newParent].child2 = leaf;
+   mNodes[sibling].parent = newParent;
+   mNodes[leaf].parent = newParent;
+
+   if(oldParent != NullNode)
+   {
+      if(mNodes[oldParent].child1 == sibling)
+         mNodes[oldParent].child1 = newParent;
+      else
+         mNodes[oldParent].child2 = newParent;
+   }
+   else
+      mRoot = newParent;
+
+   // Walk back up, rebalancing and refitting
+   index = mNodes[leaf].parent;
+   while(index != NullNode)
+   {
+      index = balance(index);
+
+      S32 child1 = mNodes[index].child1;
+      S32 child2 = mNodes[index].child2;
+
+      mNodes[index].height = 1 + MAX(mNodes[child1].height, mNodes[child2].height);
+      mNodes[index].extent = combine(mNodes[child1].extent, mNodes[child2].extent);
+
+      index = mNodes[index].parent;
+   }
+}
+
+
+void DynamicAABBTree::removeLeaf(S32 leaf)
+{
+   if(leaf == mRoot)
+   {
+      mRoot = NullNode;
+      return;
+   }
+
+   S32 parent = mNodes[leaf].parent;
+   S32 grandParent = mNodes[parent].parent;
+   S32 sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+   if(grandParent == NullNode)
+   {
+      mRoot = sibling;
+      mNodes[sibling].parent = NullNode;
+      freeNode(parent);
+      return;
+   }
+
+   // Replace parent with sibling
+   if(mNodes[grandParent].child1 == parent)
+      mNodes[grandParent].child1 = sibling;
+   else
+      mNodes[grandParent].child2 = sibling;
+
+   mNodes[sibling].parent = grandParent;
+   freeNode(parent);
+
+   S32 index = grandParent;
+   while(index != NullNode)
+   {
+      index = balance(index);
+
+      S32 child1 = mNodes[index].child1;
+      S32 child2 = mNodes[index].child2;
+
+      mNodes[index].extent = combine(mNodes[child1].extent, mNodes[child2].extent);
+      mNodes[index].height = 1 + MAX(mNodes[child1].height, mNodes[child2].height);
+
+      index = mNodes[index].parent;
+   }
+}
+
+
+// If node A is imbalanced, rotate the taller child up.  Returns the id of the node now sitting where A was.
+//
+//         A              C
+//        / \            / \
+//       B   C    ==>   A   F
+//          / \        / \
+//         F   G      B   G
+//
+S32 DynamicAABBTree::balance(S32 iA)
+{
+   Node *A = &mNodes[iA];
+
+   if(A->isLeaf() || A->height < 2)
+      return iA;
+
+   S32 iB = A->child1;
+   S32 iC = A->child2;
+
+   S32 heightDiff = mNodes[iC].height - mNodes[iB].height;
+
+   if(heightDiff > 1 || heightDiff < -1)
+   {
+      // Rotate whichever child is taller up into A's spot; the two cases are mirror images
+      bool rotateC = heightDiff > 1;
+
+      S32 iUp    = rotateC ? iC : iB;      // Child that moves up
+      S32 iOther = rotateC ? iB : iC;      // Child that stays with A
+
+      Node *up = &mNodes[iUp];
+
+      S32 iF = up->child1;
+      S32 iG = up->child2;
+
+      // Swap A and the rising child
+      up->child1 = iA;
+      up->parent = A->parent;
+      A->parent = iUp;
+
+      // A's old parent should point to the rising child
+      if(up->parent != NullNode)
+      {
+         if(mNodes[up->parent].child1 == iA)
+            mNodes[up->parent].child1 = iUp;
+         else
+            mNodes[up->parent].child2 = iUp;
+      }
+      else
+         mRoot = iUp;
+
+      // Keep the taller grandchild up top, and hand the shorter one to A
+      S32 iTall  = mNodes[iF].height > mNodes[iG].height ? iF : iG;
+      S32 iShort = iTall == iF ? iG : iF;
+
+      up->child2 = iTall;
+
+      if(rotateC)
+         A->child2 = iShort;
+      else
+         A->child1 = iShort;
+
+      mNodes[iShort].parent = iA;
+
+      A->extent  = combine(mNodes[iOther].extent, mNodes[iShort].extent);
+      up->extent = combine(A->extent, mNodes[iTall].extent);
+
+      A->height  = 1 + MAX(mNodes[iOther].height, mNodes[iShort].height);
+      up->height = 1 + MAX(A->height, mNodes[iTall].height);
+
+      return iUp;
+   }
+
+   return iA;
+}
+
+
+};
+
@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _DYNAMIC_AABB_TREE_H_
+#define _DYNAMIC_AABB_TREE_H_
+
+#include "Rect.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+#include "tnlAssert.h"
+
+using namespace TNL;
+
+namespace Zap
+{
+
+// A balanced bounding volume hierarchy of axis-aligned rectangles.  Every item is stored in exactly
+// one leaf, so unlike the bucket grid, a query never visits unrelated objects just because they
+// happen to hash to the same place, and cost grows with log(objectCount) regardless of map size.
+//
+// Leaves store a "fattened" copy of the item's extent, so objects that move a little bit each tick
+// can do so without touching the tree at all.
+class DynamicAABBTree
+{
+public:
+   static const S32 NullNode = -1;
+
+private:
+   struct Node
+   {
+      Rect extent;         // Fattened for leaves, union of children for internal nodes
+      void *userData;      // Only valid for leaves
+      S32 parent;          // Also used as "next" link while node is on the free list
+      S32 child1;
+      S32 child2;
+      S32 height;          // Leaf = 0, free node = -1
+
+      bool isLeaf() const { return child1 == NullNode; }
+   };
+
+   static const S32 MaxQueryDepth = 256;
+
+   Vector<Node> mNodes;
+   S32 mRoot;
+   S32 mFreeList;
+   S32 mProxyCount;
+   F32 mMargin;
+
+   S32 allocateNode();
+   void freeNode(S32 nodeId);
+
+   void insertLeaf(S32 leaf);
+   void removeLeaf(S32 leaf);
+   S32 balance(S32 nodeId);
+
+   static bool overlaps(const Rect &a, const Rect &b);
+   static bool contains(const Rect &outer, const Rect &inner);
+   static F32 perimeter(const Rect &rect);
+   static Rect combine(const Rect &a, const Rect &b);
+
+public:
+   explicit DynamicAABBTree(F32 margin = 32);   // Constructor
+   virtual ~DynamicAABBTree();                  // Destructor
+
+   S32 createProxy(const Rect &extent, void *userData);
+   void destroyProxy(S32 proxyId);
+   bool moveProxy(S32 proxyId, const Rect &extent);      // Returns true if the proxy had to be reinserted
+
+   void *getUserData(S32 proxyId) const;
+   const Rect &getFatExtent(S32 proxyId) const;
+
+   void clear();
+
+   S32 getProxyCount() const;
+   S32 getHeight() const;
+
+   // Calls callback(void *userData) for every leaf whose fattened extent touches rect.  Callers must do
+   // their own exact-extent test.  Templated so the per-leaf work can be inlined into the traversal.
+   template <class Callback>
+   void query(const Rect &rect, Callback &callback) const
+   {
+      if(mRoot == NullNode)
+         return;
+
+      S32 stack[MaxQueryDepth];
+      S32 count = 0;
+      stack[count++] = mRoot;
+
+      while(count > 0)
+      {
+         const Node &node = mNodes[stack[--count]];
+
+         if(!overlaps(node.extent, rect))
+            continue;
+
+         if(node.isLeaf())
+            callback(node.userData);
+         else
+         {
+            TNLAssert(count + 2 <= MaxQueryDepth, "AABB tree query stack overflow -- tree is badly unbalanced!");
+            stack[count++] = node.child1;
+            stack[count++] = node.child2;
+         }
+      }
+   }
+};
+
+
+};
+
+#endif
+
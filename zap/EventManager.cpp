@@ -6,6 +6,7 @@
 #include "EventManager.h"
 
 #include "CoreGame.h"
+#include "LuaScriptRunner.h"
 #include "playerInfo.h"          // For RobotPlayerInfo constructor
 #include "robot.h"
 #include "Zone.h"
@@ -25,21 +26,6 @@ namespace Zap
 {
 
 
-struct Subscription {
-   LuaScriptRunner *subscriber;
-   ScriptContext context;
-};
-
-
-// Statics:
-bool EventManager::anyPending = false; 
-static Vector<Subscription>      subscriptions         [EventManager::EventTypes];
-static Vector<Subscription>      pendingSubscriptions  [EventManager::EventTypes];
-static Vector<LuaScriptRunner *> pendingUnsubscriptions[EventManager::EventTypes];
-
-bool EventManager::mConstructed = false;  // Prevent duplicate instantiation
-
-
 struct EventDef {
    const char *name;
    const char *function;
@@ -54,17 +40,15 @@ static const EventDef eventDefs[] = {
 #undef EVENT
 };
 
-static EventManager *eventManager = NULL;   // Singleton event manager, one copy is used by all listeners
+static TNL_THREAD_LOCAL EventManager *eventManager = NULL;   // One per thread hosting a game, used by all its listeners
 
 
 // C++ constructor
 EventManager::EventManager()
 {
-   TNLAssert(!mConstructed, "There is only one EventManager to rule them all!");
-
    mIsPaused = false;
    mStepCount = -1;
-   mConstructed = true;
+   mAnyPending = false;
 }
 
 
@@ -91,7 +75,8 @@ void EventManager::shutdown()
 }
 
 
-// Provide access to the single EventManager instance; lazily initialized
+// Provide access to this thread's EventManager instance; lazily initialized.  Arenas hosted on threads of their own
+// each get one, so scripts only hear about what goes on in their own game.
 EventManager *EventManager::get()
 {
    if(!eventManager)
@@ -107,7 +92,7 @@ void EventManager::subscribe(LuaScriptRunner *subscriber, EventType eventType, S
    if(isSubscribed(subscriber, eventType) || isPendingSubscribed(subscriber, eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   lua_State *L = subscriber->getLuaState();
 
    // Make sure the script has the proper event listener
    bool ok = LuaScriptRunner::loadFunction(L, subscriber->getScriptId(), eventDefs[eventType].function);     // -- function
@@ -128,8 +113,8 @@ void EventManager::subscribe(LuaScriptRunner *subscriber, EventType eventType, S
    s.subscriber = subscriber;
    s.context = context;
 
-   pendingSubscriptions[eventType].push_back(s);
-   anyPending = true;
+   mPendingSubscriptions[eventType].push_back(s);
+   mAnyPending = true;
 
    lua_pop(L, -1);    // Remove function from stack                                  -- <<empty stack>>
 }
@@ -141,18 +126,18 @@ void EventManager::unsubscribe(LuaScriptRunner *subscriber, EventType eventType)
    {
       removeFromPendingSubscribeList(subscriber, eventType);
 
-      pendingUnsubscriptions[eventType].push_back(subscriber);
-      anyPending = true;
+      mPendingUnsubscriptions[eventType].push_back(subscriber);
+      mAnyPending = true;
    }
 }
 
 
 void EventManager::removeFromPendingSubscribeList(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < pendingSubscriptions[eventType].size(); i++)
-      if(pendingSubscriptions[eventType][i].subscriber == subscriber)
+   for(S32 i = 0; i < mPendingSubscriptions[eventType].size(); i++)
+      if(mPendingSubscriptions[eventType][i].subscriber == subscriber)
       {
-         pendingSubscriptions[eventType].erase_fast(i);
+         mPendingSubscriptions[eventType].erase_fast(i);
          return;
       }
 }
@@ -160,10 +145,10 @@ void EventManager::removeFromPendingSubscribeList(LuaScriptRunner *subscriber, E
 
 void EventManager::removeFromPendingUnsubscribeList(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < pendingUnsubscriptions[eventType].size(); i++)
-      if(pendingUnsubscriptions[eventType][i] == subscriber)
+   for(S32 i = 0; i < mPendingUnsubscriptions[eventType].size(); i++)
+      if(mPendingUnsubscriptions[eventType][i] == subscriber)
       {
-         pendingUnsubscriptions[eventType].erase_fast(i);
+         mPendingUnsubscriptions[eventType].erase_fast(i);
          return;
       }
 }
@@ -171,10 +156,10 @@ void EventManager::removeFromPendingUnsubscribeList(LuaScriptRunner *subscriber,
 
 void EventManager::removeFromSubscribedList(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
-      if(subscriptions[eventType][i].subscriber == subscriber)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
+      if(mSubscriptions[eventType][i].subscriber == subscriber)
       {
-         subscriptions[eventType].erase_fast(i);
+         mSubscriptions[eventType].erase_fast(i);
          return;
       }
 }
@@ -192,8 +177,8 @@ void EventManager::unsubscribeImmediate(LuaScriptRunner *subscriber, EventType e
 // Check if we're subscribed to an event
 bool EventManager::isSubscribed(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
-      if(subscriptions[eventType][i].subscriber == subscriber)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
+      if(mSubscriptions[eventType][i].subscriber == subscriber)
          return true;
 
    return false;
@@ -202,8 +187,8 @@ bool EventManager::isSubscribed(LuaScriptRunner *subscriber, EventType eventType
 
 bool EventManager::isPendingSubscribed(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < pendingSubscriptions[eventType].size(); i++)
-      if(pendingSubscriptions[eventType][i].subscriber == subscriber)
+   for(S32 i = 0; i < mPendingSubscriptions[eventType].size(); i++)
+      if(mPendingSubscriptions[eventType][i].subscriber == subscriber)
          return true;
 
    return false;
@@ -212,8 +197,8 @@ bool EventManager::isPendingSubscribed(LuaScriptRunner *subscriber, EventType ev
 
 bool EventManager::isPendingUnsubscribed(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < pendingUnsubscriptions[eventType].size(); i++)
-      if(pendingUnsubscriptions[eventType][i] == subscriber)
+   for(S32 i = 0; i < mPendingUnsubscriptions[eventType].size(); i++)
+      if(mPendingUnsubscriptions[eventType][i] == subscriber)
          return true;
 
    return false;
@@ -223,23 +208,23 @@ bool EventManager::isPendingUnsubscribed(LuaScriptRunner *subscriber, EventType
 // Process all pending subscriptions and unsubscriptions
 void EventManager::update()
 {
-   if(anyPending)
+   if(mAnyPending)
    {
       for(S32 i = 0; i < EventTypes; i++)
-         for(S32 j = 0; j < pendingUnsubscriptions[i].size(); j++)     // Unsubscribing first means less searching!
-            removeFromSubscribedList(pendingUnsubscriptions[i][j], (EventType) i);
+         for(S32 j = 0; j < mPendingUnsubscriptions[i].size(); j++)     // Unsubscribing first means less searching!
+            removeFromSubscribedList(mPendingUnsubscriptions[i][j], (EventType) i);
 
       for(S32 i = 0; i < EventTypes; i++)
-         for(S32 j = 0; j < pendingSubscriptions[i].size(); j++)     
-            subscriptions[i].push_back(pendingSubscriptions[i][j]);
+         for(S32 j = 0; j < mPendingSubscriptions[i].size(); j++)     
+            mSubscriptions[i].push_back(mPendingSubscriptions[i][j]);
 
       for(S32 i = 0; i < EventTypes; i++)
       {
-         pendingSubscriptions[i].clear();
-         pendingUnsubscriptions[i].clear();
+         mPendingSubscriptions[i].clear();
+         mPendingUnsubscriptions[i].clear();
       }
 
-      anyPending = false;
+      mAnyPending = false;
    }
 }
 
@@ -250,15 +235,14 @@ void EventManager::fireEvent(EventType eventType)
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 0, subscriptions[eventType][i].context);
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 0, mSubscriptions[eventType][i].context);
          
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -279,16 +263,65 @@ void EventManager::fireEvent(EventType eventType, U32 deltaT)
    if(eventType == TickEvent)
       mStepCount--;   
 
-   lua_State *L = LuaScriptRunner::getL();
+   // Scripts with a lua_State of their own can run side by side, if we have threads to run them on.  They go first, and
+   // the rest take their turns after.
+   bool parallel = LuaScriptRunner::getScriptThreadCount() > 0;
+
+   if(parallel)
+   {
+      Vector<LuaScriptRunner *> scripts;
+
+      for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
+      {
+         LuaScriptRunner *subscriber = mSubscriptions[eventType][i].subscriber;
+
+         if(!subscriber->isIsolated())
+            continue;
+
+         if(subscriber->isOverBudget())
+         {
+            subscriber->deferTickTime(deltaT);
+            continue;
+         }
+
+         lua_State *L = subscriber->getLuaState();
+         TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
+         setScriptContext(L, mSubscriptions[eventType][i].context);
+         lua_pushinteger(L, deltaT + subscriber->takeDeferredTickTime());   // -- deltaT
+         subscriber->startParallelCmd(eventDefs[eventType].function, 1);   // --
+
+         scripts.push_back(subscriber);
+      }
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+      LuaScriptRunner::runParallelCmds(scripts);
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+      // Scripts that fail are unsubscribed, but not deleted until later, so we can finish them all in any case
+      for(S32 i = 0; i < scripts.size(); i++)
+         scripts[i]->finishParallelCmd();
+   }
+
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
-      lua_pushinteger(L, deltaT);   // -- deltaT
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
+      LuaScriptRunner *subscriber = mSubscriptions[eventType][i].subscriber;
+
+      if(parallel && subscriber->isIsolated())     // Taken care of above
+         continue;
+
+      lua_State *L = subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
+      // Scripts that have used up their instruction budget get this tick's time added to their next one
+      if(subscriber->isOverBudget())
+      {
+         subscriber->deferTickTime(deltaT);
+         continue;
+      }
+
+      lua_pushinteger(L, deltaT + subscriber->takeDeferredTickTime());   // -- deltaT
+      bool error = fire(L, subscriber, eventDefs[eventType].function, 1, mSubscriptions[eventType][i].context);
          
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -306,16 +339,15 @@ void EventManager::fireEvent(EventType eventType, CoreItem *core)
    if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       core->push(L);                // -- core
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, mSubscriptions[eventType][i].context);
          
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -333,16 +365,15 @@ void EventManager::fireEvent(EventType eventType, Ship *ship)
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       ship->push(L);                // -- ship
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, mSubscriptions[eventType][i].context);
          
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -360,12 +391,11 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damaging
    if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       ship->push(L);                // -- ship
 
       if(damagingObject)
@@ -378,9 +408,9 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damaging
       else
          lua_pushnil(L);
 
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 3, subscriptions[eventType][i].context);
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 3, mSubscriptions[eventType][i].context);
          
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -400,15 +430,14 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
-      if(sender == subscriptions[eventType][i].subscriber)    // Don't alert sender about own message!
+      if(sender == mSubscriptions[eventType][i].subscriber)    // Don't alert sender about own message!
          continue;
 
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushstring(L, message);   // -- message
 
       if(playerInfo)
@@ -418,9 +447,9 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
 
       lua_pushboolean(L, global);   // -- message, player, isGlobal
 
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 3, subscriptions[eventType][i].context);
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 3, mSubscriptions[eventType][i].context);
          
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -428,43 +457,137 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
          clearStack(L);
          i--;
       }
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   }
+}
+
+
+// Copies the value at index on from's stack onto to's.  Tables are copied deeply, and tables that appear more than once
+// are copied once; copies is the index on to's stack of a table keeping track of them.  Game objects and points are
+// given as themselves; anything else we can't copy (functions, for example) becomes nil.
+static void copyValue(lua_State *from, S32 index, lua_State *to, S32 copies)
+{
+   if(index < 0)
+      index = lua_gettop(from) + index + 1;
+
+   switch(lua_type(from, index))
+   {
+      case LUA_TBOOLEAN:
+         lua_pushboolean(to, lua_toboolean(from, index));
+         return;
+
+      case LUA_TNUMBER:
+         lua_pushnumber(to, lua_tonumber(from, index));
+         return;
+
+      case LUA_TSTRING:
+      {
+         size_t length;
+         const char *str = lua_tolstring(from, index, &length);
+         lua_pushlstring(to, str, length);
+         return;
+      }
+
+      case LUA_TUSERDATA:
+      {
+         BfObject *object = luaW_to<BfObject>(from, index);
+
+         if(object)
+            object->push(to);
+         else
+            lua_pushnil(to);
+         return;
+      }
+
+      case LUA_TTABLE:
+         break;
+
+      default:
+         lua_pushnil(to);
+         return;
    }
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(luaIsPoint(from, index))
+   {
+      luaPushPoint(to, luaToPoint(from, index));
+      return;
+   }
+
+   lua_pushlightuserdata(to, (void *)lua_topointer(from, index));    // -- key
+   lua_rawget(to, copies);                                           // -- copy or nil
+
+   if(!lua_isnil(to, -1))
+      return;
+
+   lua_pop(to, 1);                                                   // --
+   lua_newtable(to);                                                 // -- copy
+   lua_pushlightuserdata(to, (void *)lua_topointer(from, index));    // -- copy, key
+   lua_pushvalue(to, -2);                                            // -- copy, key, copy
+   lua_rawset(to, copies);                                           // -- copy
+
+   lua_pushnil(from);
+   while(lua_next(from, index))                                      // from: -- key, value
+   {
+      copyValue(from, -2, to, copies);                               // -- copy, key
+      copyValue(from, -1, to, copies);                               // -- copy, key, value
+
+      if(lua_isnil(to, -2))
+         lua_pop(to, 2);                                             // -- copy
+      else
+         lua_rawset(to, -3);                                         // -- copy
+
+      lua_pop(from, 1);                                              // from: -- key
+   }
 }
 
 
 // onDataReceived
-void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType)
+// The data is on senderL's stack.  Scripts that share senderL get it as it is; those with a lua_State of their own get
+// a copy.
+void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, lua_State *senderL)
 {
-   lua_State *L = LuaScriptRunner::getL();
-
    if(suppressEvents(eventType))
    {
-      clearStack(L);
+      clearStack(senderL);
       return;
    }
 
-   S32 argCount = lua_gettop(L);
+   S32 argCount = lua_gettop(senderL);
 
    // Because we're going to call this function repeatedly, and because each call removes these items from the stack,
    // we need to make a copy of them first so we can add them back for subsequent calls.
 
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
-      if(sender == subscriptions[eventType][i].subscriber)    // Don't alert sender about own message!
+      if(sender == mSubscriptions[eventType][i].subscriber)    // Don't alert sender about own message!
          continue;
 
-      Subscription subscription = subscriptions[eventType][i];
+      Subscription subscription = mSubscriptions[eventType][i];
 
-      // Duplicate the first argCount items on the stack
-      for(S32 j = 1; j <= argCount; j++)
-         lua_pushvalue(L, j);
+      lua_State *L = subscription.subscriber->getLuaState();
+      S32 stackDepth = lua_gettop(L);
+
+      if(L == senderL)
+      {
+         // Duplicate the first argCount items on the stack
+         for(S32 j = 1; j <= argCount; j++)
+            lua_pushvalue(L, j);
+      }
+      else
+      {
+         lua_newtable(L);                                   // -- copies
+
+         for(S32 j = 1; j <= argCount; j++)
+            copyValue(senderL, j, L, stackDepth + 1);       // -- copies, <<args>>
+
+         lua_remove(L, stackDepth + 1);                     // -- <<args>>
+      }
 
       bool error = fire(L, subscription.subscriber, eventDefs[eventType].function, argCount, subscription.context);
 
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -473,14 +596,14 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType)
          // But we can't do both.
          // subscription.subscriber is getting deleted in the bowels of fire()
          //unsubscribeImmediate(subscription.subscriber, eventType);  /// <===== WHy does this break tests????
-         lua_settop(L, argCount);
+         lua_settop(L, stackDepth);
          i--;
       }
 
-      TNLAssert(lua_gettop(L) == argCount, "Expect args to still be on the stack!");
+      TNLAssert(lua_gettop(L) == stackDepth, "Expect args to still be on the stack!");
    }
 
-   clearStack(L);    // Get rid of final copy of args
+   clearStack(senderL);    // Get rid of final copy of args
 }
 
 
@@ -490,19 +613,18 @@ void EventManager::fireEvent(LuaScriptRunner *player, EventType eventType, LuaPl
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
-      if(player == subscriptions[eventType][i].subscriber)    // Don't trouble player with own joinage or leavage!
+      if(player == mSubscriptions[eventType][i].subscriber)    // Don't trouble player with own joinage or leavage!
          continue;
 
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       playerInfo->push(L);          // -- playerInfo
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, subscriptions[eventType][i].context);
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 1, mSubscriptions[eventType][i].context);
 
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -520,21 +642,20 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, Zone *zone)
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       // Passing ship, zone, zoneType, zoneId
       ship->push(L);                                     // -- ship
       zone->push(L);                                     // -- ship, zone   
       lua_pushinteger(L, zone->getObjectTypeNumber());   // -- ship, zone, zone->objTypeNumber
       lua_pushinteger(L, zone->getUserAssignedId());     // -- ship, zone, zone->objTypeNumber, zone->id
 
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 4, subscriptions[eventType][i].context);
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 4, mSubscriptions[eventType][i].context);
 
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -552,21 +673,20 @@ void EventManager::fireEvent(EventType eventType, MoveObject *object, Zone *zone
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       // Passing object, zone, zoneType, zoneId
       object->push(L);                                   // -- object
       zone->push(L);                                     // -- object, zone   
       lua_pushinteger(L, zone->getObjectTypeNumber());   // -- object, zone, zone->objTypeNumber
       lua_pushinteger(L, zone->getUserAssignedId());     // -- object, zone, zone->objTypeNumber, zone->id
 
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 4, subscriptions[eventType][i].context);
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 4, mSubscriptions[eventType][i].context);
 
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -584,12 +704,11 @@ void EventManager::fireEvent(EventType eventType, S32 score, S32 team, LuaPlayer
    if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
-
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushinteger(L, score);   // -- score
       lua_pushinteger(L, team);    // -- score, team
 
@@ -598,9 +717,9 @@ void EventManager::fireEvent(EventType eventType, S32 score, S32 team, LuaPlayer
       else
          lua_pushnil(L);
 
-      bool error = fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, 3, subscriptions[eventType][i].context);
+      bool error = fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, 3, mSubscriptions[eventType][i].context);
 
-      // If an error occurred, the subscriber is gone; subscriptions[eventType].size() is now smaller, and the
+      // If an error occurred, the subscriber is gone; mSubscriptions[eventType].size() is now smaller, and the
       // next one we need to handle is at index i.  i will increment at the end of this block, so we need to 
       // compensate for that by decrementing it here.
       if(error)
@@ -616,8 +735,16 @@ void EventManager::fireEvent(EventType eventType, S32 score, S32 team, LuaPlayer
 // Returns true if there was an error, false if everything ran ok
 bool EventManager::fire(lua_State *L, LuaScriptRunner *scriptRunner, const char *function, S32 argCount, ScriptContext context)
 {
+   // Scripts that have used up their instruction budget miss events until the next tick
+   if(scriptRunner->isOverBudget())
+   {
+      scriptRunner->skipEvent();
+      lua_pop(L, argCount);
+      return false;
+   }
+
    setScriptContext(L, context);
-   return scriptRunner->runCmd(function, argCount, 0);
+   return scriptRunner->runCmd(function, argCount, 0, true);
 }
 
 
@@ -641,7 +768,7 @@ bool EventManager::fire(lua_State *L, LuaScriptRunner *scriptRunner, const char
 // If true, events will not fire!
 bool EventManager::suppressEvents(EventType eventType)
 {
-   if(subscriptions[eventType].size() == 0)
+   if(mSubscriptions[eventType].size() == 0)
       return true;
 
    return mIsPaused && mStepCount <= 0;    // Paused bots should still respond to events as long as stepCount > 0
@@ -25,7 +25,10 @@ class Robot;
 class Ship;
 class Zone;
 
-struct Subscription; 
+struct Subscription {
+   LuaScriptRunner *subscriber;
+   ScriptContext context;
+};
 
 class EventManager
 {
@@ -84,9 +87,13 @@ private:
    //void handleEventFiringError(lua_State *L, const Subscription &subscriber, EventType eventType, const char *errorMsg);
    bool fire(lua_State *L, LuaScriptRunner *scriptRunner, const char *function, S32 argCount, ScriptContext context);
       
+   Vector<Subscription>      mSubscriptions         [EventTypes];
+   Vector<Subscription>      mPendingSubscriptions  [EventTypes];
+   Vector<LuaScriptRunner *> mPendingUnsubscriptions[EventTypes];
+
    bool mIsPaused;
    S32 mStepCount;           // If running for a certain number of steps, this will be > 0, while mIsPaused will be true
-   static bool mConstructed;
+   bool mAnyPending;
 
 public:
    EventManager();                       // C++ constructor
@@ -95,14 +102,9 @@ public:
 
    static void shutdown();
 
-   static EventManager *get();         // Provide access to the single EventManager instance
+   static EventManager *get();         // Provide access to this thread's EventManager instance
    bool suppressEvents(EventType eventType);
 
-   //static Vector<Subscription> subscriptions[EventTypes];
-   //static Vector<Subscription> pendingSubscriptions[EventTypes];
-   //static Vector<pendingUnsubscriptions *> pendingUnsubscriptions[EventTypes];
-   static bool anyPending;
-
    void subscribe  (LuaScriptRunner *subscriber, EventType eventType, ScriptContext context, bool failSilently = false);
    void unsubscribe(LuaScriptRunner *subscriber, EventType eventType);
 
@@ -117,7 +119,7 @@ public:
    void fireEvent(EventType eventType, Ship *ship);      // ShipSpawned
    void fireEvent(EventType eventType, Ship *ship, BfObject *damagingObject, BfObject *shooter);  // ShipKilled
    void fireEvent(LuaScriptRunner *sender, EventType eventType, const char *message, LuaPlayerInfo *playerInfo, bool global);  // MsgReceived
-   void fireEvent(LuaScriptRunner* sender, EventType eventType);  // DataReceivedEvent
+   void fireEvent(LuaScriptRunner* sender, EventType eventType, lua_State *senderL);  // DataReceivedEvent
    void fireEvent(LuaScriptRunner *player, EventType eventType, LuaPlayerInfo *playerInfo);  // PlayerJoined, PlayerLeft, PlayerTeamChanged
    void fireEvent(EventType eventType, Ship *ship, Zone *zone); // ShipEnteredZoneEvent, ShipLeftZoneEvent
    void fireEvent(EventType eventType, S32 score, S32 team, LuaPlayerInfo *playerInfo);
@@ -6,6 +6,7 @@
 #include "GameManager.h"
 
 #include "ServerGame.h"
+#include "ArenaThread.h"
 
 #ifndef ZAP_DEDICATED
 #  include "UIErrorMessage.h"
@@ -18,11 +19,13 @@ namespace Zap
 {
 
 // Declare statics
-ServerGame *GameManager::mServerGame = NULL;
+TNL_THREAD_LOCAL ServerGame *GameManager::mServerGame = NULL;
+thread_local Vector<ArenaThread *> GameManager::mArenas;
+atomic<S32> GameManager::mArenaThreadCount(0);
 #ifndef ZAP_DEDICATED
    Vector<ClientGame *> GameManager::mClientGames;
 #endif
-GameManager::HostingModePhase GameManager::mHostingModePhase = GameManager::NotHosting;
+TNL_THREAD_LOCAL GameManager::HostingModePhase GameManager::mHostingModePhase = GameManager::NotHosting;
 
 
 // Constructor
@@ -56,12 +59,43 @@ void GameManager::setServerGame(ServerGame *serverGame)
 
 void GameManager::deleteServerGame()
 {
+   // Any other arenas go first; each cleans up after itself on its own thread
+   for(S32 i = mArenas.size() - 1; i >= 0; i--)
+   {
+      delete mArenas[i];
+      mArenaThreadCount--;
+   }
+
+   mArenas.clear();
+
    // mServerGame might be NULL here; for example when quitting after losing a connection to the game server
    delete mServerGame;     // Kill the serverGame (leaving the clients running)
    mServerGame = NULL;
 }
 
 
+// A dedicated server can host more games alongside the first one, each running on its own thread.  We take ownership.
+void GameManager::addArena(ArenaThread *arena)
+{
+   TNLAssert(mServerGame && mServerGame->isDedicated(), "Only dedicated servers host more than one game!");
+
+   mArenas.push_back(arena);
+   mArenaThreadCount++;
+}
+
+
+const Vector<ArenaThread *> *GameManager::getArenas()
+{
+   return &mArenas;
+}
+
+
+S32 GameManager::getArenaThreadCount()
+{
+   return mArenaThreadCount.load();
+}
+
+
 void GameManager::idleServerGame(U32 timeDelta)
 {
    if(mServerGame)
@@ -7,13 +7,18 @@
 #define _GAME_MANAGER_H_
 
 #include "tnlVector.h"
+#include "tnlTypes.h"
+
+#include <atomic>
 
 using namespace TNL;
+using namespace std;
 
 namespace Zap
 {
 
 class ServerGame;
+class ArenaThread;
 #ifndef ZAP_DEDICATED
 class ClientGame;
 #endif
@@ -31,12 +36,15 @@ public:
    };
 
 private:
-   static ServerGame *mServerGame;
+   // Dedicated servers can host several arenas, each on a thread of its own, so these are per-thread
+   static TNL_THREAD_LOCAL ServerGame *mServerGame;
+   static thread_local Vector<ArenaThread *> mArenas;   // Arenas after the first, which this thread started
+   static atomic<S32> mArenaThreadCount;                // Size of the above, as seen from any thread
 #ifndef ZAP_DEDICATED
    static Vector<ClientGame *> mClientGames;
 #endif
 
-   static HostingModePhase mHostingModePhase;
+   static TNL_THREAD_LOCAL HostingModePhase mHostingModePhase;
 
 public:
    GameManager();
@@ -45,9 +53,13 @@ public:
    // ServerGame related
    static void setServerGame(ServerGame *serverGame);
    static ServerGame *getServerGame();
-   static void deleteServerGame();
+   static void deleteServerGame();              // Along with any other arenas
    static void idleServerGame(U32 timeDelta);
 
+   static void addArena(ArenaThread *arena);
+   static const Vector<ArenaThread *> *getArenas();
+   static S32 getArenaThreadCount();            // Safe to call from any arena's thread
+
    // ClientGame related
 #ifndef ZAP_DEDICATED
    static const Vector<ClientGame *> *getClientGames();
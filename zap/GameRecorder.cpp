@@ -19,99 +19,740 @@
 #include "version.h"
 
 #include <algorithm>
+#include <atomic>
+
+#ifndef BF_NO_ZLIB
+#  include <zlib.h>
+#endif
 
 namespace Zap
 {
 
+// A recording's index goes after the last block, uncompressed:
+//
+//    total time, keyframe count, {time, offset} for each keyframe, block count, {stream position, file offset}
+//    for each block, then the file offset of the index itself and IndexMagic
+//
+// all as little-endian U32s.  Uncompressed recordings have no blocks.
+static const U32 IndexMagic = 0x58444E49;    // "INDX"
+
+
+static void writeU32(U8 *dest, U32 value)
+{
+   for(S32 i = 0; i < 4; i++)
+      dest[i] = U8(value >> (i * 8));
+}
 
 
 // fwrite might have multiple 1-second freeze on VPS server or heavy disk access
 // Having fwrite in separate thread might fix the game from freezing/lagging
 // if run in VPS server or with heavy disk access
+//
+// The game thread and the writer thread share a ring buffer without locks: the game thread only ever moves
+// mWritePos and the writer thread only ever moves mReadPos.  Neither side waits for the other.  If the disk
+// falls so far behind that a packet won't fit, it goes into an overflow buffer until there's room, so a slow
+// disk costs memory rather than frame time.  Past MaxOverflow we give up, and the recording ends early.
 
 class WriteBufferThread : public Thread
 {
+public:
+   struct Stats
+   {
+      U64 bytesRecorded;         // Packet stream, before compression
+      U64 bytesWritten;          // What ended up in the file
+      U32 packetsRecorded;
+      U32 packetsDropped;        // Thrown away because the overflow buffer was full
+      U32 overflowCount;         // Packets that didn't fit in the ring buffer
+      U32 peakBufferUse;         // Most bytes ever waiting in the ring buffer
+      U32 peakOverflow;          // Most bytes ever waiting in the overflow buffer
+   };
+
 private:
+   static const U32 MaxOverflow = 16 * 1024 * 1024;
+   static const U32 BlockSize = 64 * 1024;      // Bytes of packet stream per compressed block
+
    FILE *f;
-   U32 lastPos;
-   U32 currPos;
-   U8 buffer[1024*128];
-   TNL::Semaphore sem1;
-   U32 threadPos;
-   bool exitNow;
-public:
+   bool mCompress;
+   bool mThreaded;            // False if there's no writer thread, and we write everything ourselves
+   bool mFinished;
+   bool mGaveUp;              // Overflow buffer filled up, we're dropping everything
+
+   U8 *mBuffer;
+   U32 mBufferMask;           // Buffer size is a power of two, so this turns a position into an index
+
+   atomic<U32> mWritePos;     // Both positions only ever increase (wrapping at 2^32); size is mWritePos - mReadPos
+   atomic<U32> mReadPos;
+   atomic<bool> mWriterIdle;  // Writer is waiting on mDataAvailable, or about to
+   atomic<bool> mExitNow;
+
+   TNL::Semaphore mDataAvailable;
+   TNL::Semaphore mWriterDone;
+
+   Vector<U8> mOverflow;      // Owned by the game thread until mExitNow is set, then by the writer
+   U32 mOverflowStart;        // Bytes before this have already gone into the ring buffer
+
+   Vector<U8> mBlock;         // Writer thread only: packet stream waiting to be compressed
+   Vector<U8> mCompressedBlock;
+
+   // For the index.  Keyframes and time belong to the game thread until mExitNow is set, blocks to the writer.
+   Vector<RecordingKeyframe> mKeyframes;
+   U32 mTotalTime;
+   Vector<U32> mBlockLocations;     // Stream position and file offset of each block
+   U32 mBlockStreamPos;             // Stream position of mBlock
+
+   Stats mStats;
 
-   WriteBufferThread(FILE *file)
+   // Game thread side
+   bool copyToBuffer(const U8 *data, U32 size)
    {
-      TNLAssert(file != 0, "Must have a file handle");
-      lastPos = 0;
-      currPos = 0;
-      threadPos = 0;
-      exitNow = false;
-      f = file;
-      if(!start())
+      U32 writePos = mWritePos.load(memory_order_relaxed);
+      U32 used = writePos - mReadPos.load(memory_order_acquire);
+
+      if(size > mBufferMask + 1 - used)
+         return false;
+
+      U32 index = writePos & mBufferMask;
+      U32 firstPart = min(size, mBufferMask + 1 - index);   // Up to the end of the buffer, then wrap around
+
+      memcpy(&mBuffer[index], data, firstPart);
+      memcpy(&mBuffer[0], data + firstPart, size - firstPart);
+
+      mWritePos.store(writePos + size, memory_order_release);
+      mStats.peakBufferUse = max(mStats.peakBufferUse, used + size);
+
+      return true;
+   }
+
+   // Moves as much of the overflow buffer into the ring buffer as will fit
+   void drainOverflow()
+   {
+      U32 waiting = mOverflow.size() - mOverflowStart;
+      U32 room = mBufferMask + 1 - (mWritePos.load(memory_order_relaxed) - mReadPos.load(memory_order_acquire));
+      U32 size = min(waiting, room);
+
+      if(size > 0 && copyToBuffer(&mOverflow[mOverflowStart], size))
+         mOverflowStart += size;
+
+      if(mOverflowStart == U32(mOverflow.size()))
       {
-         logprintf(LogConsumer::LogWarning, "Failed to create thread for recorder, games may not record");
-         fclose(f);
-			f = NULL;
+         mOverflow.clear();
+         mOverflowStart = 0;
       }
    }
+
+   void wakeWriter()
+   {
+      if(mWriterIdle.exchange(false))
+         mDataAvailable.increment();
+   }
+
+   // Writer thread side, or game thread if mThreaded is false
+   void output(const U8 *data, U32 size)
+   {
+      if(!mCompress)
+      {
+         fwrite(data, 1, size, f);
+         mStats.bytesWritten += size;
+         return;
+      }
+
+      while(size > 0)
+      {
+         U32 part = min(size, BlockSize - U32(mBlock.size()));
+         S32 oldSize = mBlock.size();
+         mBlock.resize(oldSize + part);
+         memcpy(&mBlock[oldSize], data, part);
+
+         data += part;
+         size -= part;
+
+         if(U32(mBlock.size()) == BlockSize)
+            writeBlock();
+      }
+   }
+
+   // Each block starts with its uncompressed and compressed sizes; if compressing didn't help, the sizes are
+   // the same and the block is stored as is
+   void writeBlock()
+   {
+      if(mBlock.size() == 0)
+         return;
+
+      U32 rawSize = mBlock.size();
+      const U8 *blockData = mBlock.address();
+      U32 blockSize = rawSize;
+
+#ifndef BF_NO_ZLIB
+      uLongf compressedSize = compressBound(rawSize);
+      mCompressedBlock.resize(compressedSize);
+
+      if(compress2(mCompressedBlock.address(), &compressedSize, blockData, rawSize, Z_DEFAULT_COMPRESSION) == Z_OK &&
+            compressedSize < rawSize)
+      {
+         blockData = mCompressedBlock.address();
+         blockSize = U32(compressedSize);
+      }
+#endif
+
+      mBlockLocations.push_back(mBlockStreamPos);
+      mBlockLocations.push_back(U32(mStats.bytesWritten));
+      mBlockStreamPos += rawSize;
+
+      U8 header[8];
+      writeU32(&header[0], rawSize);
+      writeU32(&header[4], blockSize);
+
+      fwrite(header, 1, sizeof(header), f);
+      fwrite(blockData, 1, blockSize, f);
+      mStats.bytesWritten += sizeof(header) + blockSize;
+
+      mBlock.clear();
+   }
+
+   // Ends the packet stream and adds the index, so playback knows how long the recording is and where it can jump to
+   void writeEnd()
+   {
+      U8 endMarker[3] = { RecordingEndMarker, 0, 0 };
+      output(endMarker, sizeof(endMarker));
+      writeBlock();
+
+      Vector<U8> index;
+      index.resize(4 * (5 + 2 * mKeyframes.size() + mBlockLocations.size()));
+      U8 *dest = index.address();
+
+      writeU32(dest, mTotalTime);
+      writeU32(dest + 4, mKeyframes.size());
+      dest += 8;
+
+      for(S32 i = 0; i < mKeyframes.size(); i++, dest += 8)
+      {
+         writeU32(dest, mKeyframes[i].time);
+         writeU32(dest + 4, mKeyframes[i].offset);
+      }
+
+      writeU32(dest, mBlockLocations.size() / 2);
+      dest += 4;
+
+      for(S32 i = 0; i < mBlockLocations.size(); i++, dest += 4)
+         writeU32(dest, mBlockLocations[i]);
+
+      writeU32(dest, U32(mStats.bytesWritten));
+      writeU32(dest + 4, IndexMagic);
+
+      fwrite(index.address(), 1, index.size(), f);
+      mStats.bytesWritten += index.size();
+   }
+
+public:
+   WriteBufferThread(FILE *file, U32 bufferSize, bool compress)
+   {
+      TNLAssert(file != 0, "Must have a file handle");
+
+      // Round up to a power of two
+      U32 size = 1;
+      while(size < bufferSize)
+         size <<= 1;
+
+      f = file;
+      mBuffer = new U8[size];
+      mBufferMask = size - 1;
+      mWritePos = 0;
+      mReadPos = 0;
+      mWriterIdle = false;
+      mExitNow = false;
+      mOverflowStart = 0;
+      mFinished = false;
+      mGaveUp = false;
+      mTotalTime = 0;
+      mBlockStreamPos = 0;
+      memset(&mStats, 0, sizeof(mStats));
+
+#ifdef BF_NO_ZLIB
+      mCompress = false;
+#else
+      mCompress = compress;
+#endif
+
+#ifdef TNL_NO_THREADS
+      mThreaded = false;      // Thread::start() would run our writer loop here, and never return
+#else
+      mThreaded = start();
+      if(!mThreaded)
+         logprintf(LogConsumer::LogWarning, "Failed to create thread for recorder, writing recording on the game thread");
+#endif
+   }
+
    ~WriteBufferThread()
    {
-      exitNow = true;
-      sem1.increment();
-      while(f != 0)         // Wait until the other thread is done
-         Platform::sleep(1);
+      finish();
+      delete[] mBuffer;
    }
 
+   bool isCompressed() const
+   {
+      return mCompress;
+   }
 
-   U8 *getBuffer(U32 size)
+   // Written straight to the file, and never compressed.  Call before anything else is written; the writer
+   // thread won't touch the file until there's something in the ring buffer for it.
+   void writeHeader(const U8 *data, U32 size)
    {
-      if(currPos + size > sizeof(buffer))
+      TNLAssert(mWritePos.load() == 0 && mStats.bytesRecorded == 0, "Header must come first");
+
+      fwrite(data, 1, size, f);
+      mStats.bytesRecorded += size;
+      mStats.bytesWritten += size;
+   }
+
+   // Hands a packet over to be written.  Never waits for the disk.  Returns false if the packet was dropped.
+   bool write(const U8 *data, U32 size)
+   {
+      if(mFinished)
+         return false;
+
+      if(mGaveUp)
       {
-         lastPos = currPos;
-         currPos = 0;
+         mStats.packetsDropped++;
+         return false;
       }
-      U32 t = threadPos;
-      while(t > currPos && t < currPos + size) // Buffer too full, waiting...
+
+      if(!mThreaded)
+         output(data, size);
+
+      else
       {
-         Platform::sleep(1);
-         t = threadPos;
+         // Anything still in the overflow buffer has to go first, to keep the file in order
+         if(mOverflow.size() > 0)
+            drainOverflow();
+
+         if(mOverflow.size() > 0 || !copyToBuffer(data, size))
+         {
+            if(mOverflow.size() - mOverflowStart + size > MaxOverflow)
+            {
+               logprintf(LogConsumer::LogWarning, "Recording can't keep up with the disk, stopping it early");
+               mGaveUp = true;
+               mStats.packetsDropped++;
+               return false;
+            }
+
+            S32 oldSize = mOverflow.size();
+            mOverflow.resize(oldSize + size);
+            memcpy(&mOverflow[oldSize], data, size);
+
+            mStats.overflowCount++;
+            mStats.peakOverflow = max(mStats.peakOverflow, U32(mOverflow.size()) - mOverflowStart);
+         }
+
+         wakeWriter();
       }
-      return &buffer[currPos];
+
+      mStats.bytesRecorded += size;
+      mStats.packetsRecorded++;
+      return true;
    }
-   void addBuffer(U32 size)
+
+   // Marks a point, time milliseconds into the recording, that playback can start from
+   bool writeKeyframe(U32 time)
    {
-      currPos += size;
-      sem1.increment();
+      RecordingKeyframe keyframe;
+      keyframe.time = time;
+      keyframe.offset = U32(mStats.bytesRecorded) - RecordingReader::HeaderSize;
+
+      U8 marker[3];
+      marker[0] = 0;
+      marker[1] = U8((RecordingKeyframeMarker >> 8) << 6);
+      marker[2] = U8(RecordingKeyframeMarker);
+
+      if(!write(marker, sizeof(marker)))
+         return false;
+
+      mKeyframes.push_back(keyframe);
+      return true;
+   }
+
+   // Writes out everything we've been given, along with the index, and closes the file.  Waits for the disk,
+   // so only call this when the recording is over.
+   void finish(U32 totalTime = 0)
+   {
+      if(mFinished)
+         return;
+
+      mFinished = true;
+      mTotalTime = totalTime;
+
+      if(mThreaded)
+      {
+         mExitNow.store(true);
+         mDataAvailable.increment();
+         mWriterDone.wait();
+      }
+      else
+      {
+         writeEnd();
+         fclose(f);
+      }
+
+      f = NULL;
+   }
+
+   const Stats &getStats() const
+   {
+      return mStats;
    }
 
    U32 run()
    {
-      U32 currPos1 = currPos; // currPos could change anytime by other thread
-      while(!exitNow || currPos1 != threadPos)
+      for(;;)
       {
-         if(currPos1 < threadPos)
+         bool exiting = mExitNow.load(memory_order_acquire);      // Check before mWritePos, so we can't miss a final write
+         U32 readPos = mReadPos.load(memory_order_relaxed);
+         U32 writePos = mWritePos.load(memory_order_acquire);
+
+         if(writePos != readPos)
          {
+            // Everything that's there, in at most two pieces
+            U32 index = readPos & mBufferMask;
+            U32 size = writePos - readPos;
+            U32 firstPart = min(size, mBufferMask + 1 - index);
 
-            fwrite(&buffer[threadPos], 1, lastPos - threadPos, f);
-            threadPos = 0;
+            output(&mBuffer[index], firstPart);
+            if(size > firstPart)
+               output(&mBuffer[0], size - firstPart);
+
+            mReadPos.store(writePos, memory_order_release);
+            continue;
          }
-         else if(currPos1 > threadPos)
+
+         if(exiting)
+            break;
+
+         // Tell the game thread to wake us, then make sure nothing arrived while we were saying so
+         mWriterIdle.store(true);
+         if(mWritePos.load() != readPos || mExitNow.load())
          {
-            fwrite(&buffer[threadPos], 1, currPos1 - threadPos, f);
-            threadPos = currPos1;
+            mWriterIdle.store(false);
+            continue;
          }
-         else
-            sem1.wait();  // Waits until sem1.increment
-         currPos1 = currPos;
+
+         mDataAvailable.wait();
       }
+
+      // The game thread is done with the overflow buffer now
+      if(mOverflow.size() > S32(mOverflowStart))
+         output(&mOverflow[mOverflowStart], mOverflow.size() - mOverflowStart);
+
+      writeEnd();
       fclose(f);
-      f = 0;
+
+      mWriterDone.increment();
       return 0;
    }
 };
 
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+RecordingReader::RecordingReader()
+{
+   mFile = NULL;
+   mCompressed = false;
+   mBlockStart = 0;
+   mBlockPos = 0;
+   mStreamPos = 0;
+}
+
+
+// Destructor
+RecordingReader::~RecordingReader()
+{
+   close();
+}
+
+
+bool RecordingReader::open(const char *filename, U8 *header)
+{
+   close();
+
+   mFile = fopen(filename, "rb");
+   if(!mFile)
+      return false;
+
+   if(fread(header, 1, HeaderSize, mFile) != HeaderSize)
+   {
+      close();
+      return false;
+   }
+
+   mCompressed = (header[3] & RecordingCompressed) != 0;
+
+#ifdef BF_NO_ZLIB
+   if(mCompressed)
+   {
+      logprintf(LogConsumer::LogWarning, "Can't play compressed recording %s, this build has no zlib", filename);
+      close();
+      return false;
+   }
+#endif
+
+   return true;
+}
+
+
+void RecordingReader::close()
+{
+   if(mFile)
+      fclose(mFile);
+
+   mFile = NULL;
+   mBlock.clear();
+   mBlocks.clear();
+   mBlockStart = 0;
+   mBlockPos = 0;
+   mStreamPos = 0;
+}
+
+
+bool RecordingReader::isOpen() const
+{
+   return mFile != NULL;
+}
+
+
+static U32 readU32(const U8 *src)
+{
+   return U32(src[0]) | (U32(src[1]) << 8) | (U32(src[2]) << 16) | (U32(src[3]) << 24);
+}
+
+
+// Loads and unpacks the next block of a compressed recording
+bool RecordingReader::readBlock()
+{
+   BlockLocation location;
+   location.streamPos = mBlockStart + mBlock.size();
+   location.fileOffset = U32(ftell(mFile));
+
+   mBlock.clear();
+   mBlockStart = location.streamPos;
+   mBlockPos = 0;
+
+   if(mBlocks.size() == 0 || mBlocks.last().streamPos < location.streamPos)
+      mBlocks.push_back(location);
+
+   U8 header[8];
+   if(fread(header, 1, sizeof(header), mFile) != sizeof(header))
+      return false;
+
+   U32 rawSize = readU32(&header[0]);
+   U32 blockSize = readU32(&header[4]);
+
+   if(rawSize == 0 || blockSize > rawSize)    // Not something we wrote
+      return false;
+
+   mBlock.resize(rawSize);
+
+   if(blockSize == rawSize)
+      return fread(mBlock.address(), 1, rawSize, mFile) == rawSize;
+
+#ifdef BF_NO_ZLIB
+   return false;
+#else
+   mCompressedBlock.resize(blockSize);
+   if(fread(mCompressedBlock.address(), 1, blockSize, mFile) != blockSize)
+      return false;
+
+   uLongf size = rawSize;
+   if(uncompress(mBlock.address(), &size, mCompressedBlock.address(), blockSize) != Z_OK || size != rawSize)
+   {
+      mBlock.clear();
+      return false;
+   }
+
+   return true;
+#endif
+}
+
+
+U32 RecordingReader::read(U8 *data, U32 size)
+{
+   if(!mFile)
+      return 0;
+
+   if(!mCompressed)
+   {
+      U32 done = U32(fread(data, 1, size, mFile));
+      mStreamPos += done;
+      return done;
+   }
+
+   U32 done = 0;
+   while(done < size)
+   {
+      if(mBlockPos == U32(mBlock.size()) && !readBlock())
+         break;
+
+      U32 part = min(size - done, mBlock.size() - mBlockPos);
+      memcpy(data + done, &mBlock[mBlockPos], part);
+
+      mBlockPos += part;
+      done += part;
+   }
+
+   mStreamPos += done;
+   return done;
+}
+
+
+bool RecordingReader::skip(U32 size)
+{
+   if(!mFile)
+      return false;
+
+   if(!mCompressed)
+   {
+      if(fseek(mFile, size, SEEK_CUR) != 0)
+         return false;
+
+      mStreamPos += size;
+      return true;
+   }
+
+   while(size > 0)
+   {
+      if(mBlockPos == U32(mBlock.size()) && !readBlock())
+         return false;
+
+      U32 part = min(size, mBlock.size() - mBlockPos);
+      mBlockPos += part;
+      mStreamPos += part;
+      size -= part;
+   }
+
+   return true;
+}
+
+
+void RecordingReader::rewind()
+{
+   if(!mFile)
+      return;
+
+   fseek(mFile, HeaderSize, SEEK_SET);
+   mBlock.clear();
+   mBlockStart = 0;
+   mBlockPos = 0;
+   mStreamPos = 0;
+}
+
+
+U32 RecordingReader::tell() const
+{
+   return mStreamPos;
+}
+
+
+// Compressed recordings have to be unpacked a block at a time, so we go to the start of the block holding
+// streamPos and skip forward from there
+bool RecordingReader::seek(U32 streamPos)
+{
+   if(!mFile)
+      return false;
+
+   if(!mCompressed)
+   {
+      if(fseek(mFile, HeaderSize + streamPos, SEEK_SET) != 0)
+         return false;
+
+      mStreamPos = streamPos;
+      return true;
+   }
+
+   // Last block starting at or before streamPos
+   S32 first = 0, last = mBlocks.size() - 1;
+   while(first < last)
+   {
+      S32 middle = (first + last + 1) / 2;
+      if(mBlocks[middle].streamPos <= streamPos)
+         first = middle;
+      else
+         last = middle - 1;
+   }
+
+   if(mBlocks.size() == 0 || mBlocks[first].streamPos > streamPos)
+      rewind();
+   else
+   {
+      fseek(mFile, mBlocks[first].fileOffset, SEEK_SET);
+      mBlock.clear();
+      mBlockStart = mBlocks[first].streamPos;
+      mBlockPos = 0;
+      mStreamPos = mBlockStart;
+   }
+
+   return skip(streamPos - mStreamPos);
+}
+
+
+bool RecordingReader::readIndex(U32 &totalTime, Vector<RecordingKeyframe> &keyframes)
+{
+   if(!mFile)
+      return false;
+
+   U8 trailer[8];
+   if(fseek(mFile, -S32(sizeof(trailer)), SEEK_END) != 0 || fread(trailer, 1, sizeof(trailer), mFile) != sizeof(trailer) ||
+         readU32(&trailer[4]) != IndexMagic)
+   {
+      rewind();
+      return false;
+   }
+
+   U32 indexEnd = U32(ftell(mFile)) - sizeof(trailer);
+   U32 indexStart = readU32(&trailer[0]);
+
+   Vector<U8> index;
+   if(indexStart < HeaderSize || indexStart > indexEnd)
+      indexStart = indexEnd;      // Something's wrong, and the checks below will say so
+
+   index.resize(indexEnd - indexStart);
+   fseek(mFile, indexStart, SEEK_SET);
+
+   bool valid = index.size() >= 12 && fread(index.address(), 1, index.size(), mFile) == U32(index.size());
+
+   U32 keyframeCount = valid ? readU32(&index[4]) : 0;
+   valid = valid && keyframeCount <= U32(index.size() - 12) / 8;
+
+   U32 blockCount = valid ? readU32(&index[8 + keyframeCount * 8]) : 0;
+   valid = valid && U32(index.size()) == 12 + keyframeCount * 8 + blockCount * 8;
+
+   if(valid)
+   {
+      totalTime = readU32(&index[0]);
+
+      keyframes.resize(keyframeCount);
+      for(U32 i = 0; i < keyframeCount; i++)
+      {
+         keyframes[i].time = readU32(&index[8 + i * 8]);
+         keyframes[i].offset = readU32(&index[12 + i * 8]);
+      }
+
+      const U8 *src = &index[12 + keyframeCount * 8];
+      mBlocks.resize(blockCount);
+      for(U32 i = 0; i < blockCount; i++)
+      {
+         mBlocks[i].streamPos = readU32(src + i * 8);
+         mBlocks[i].fileOffset = readU32(src + i * 8 + 4);
+      }
+   }
+
+   rewind();
+   return valid;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
 static void gameRecorderScoping(GameRecorderServer *conn, Game *game)
 {
    GameType *gt = game->getGameType();
@@ -162,23 +803,39 @@ static string newRecordingFileName(const string &dir, const string &levelName, c
    return filenum;
 }
 
+// Arenas on other threads record into the same folder; hold this from picking a name until the file exists
+static Mutex &getRecordingFileLock()
+{
+   static Mutex recordingFileLock;
+   return recordingFileLock;
+}
+
+
 // Constructor
 GameRecorderServer::GameRecorderServer(ServerGame *game)
 {
    mWriter = NULL;
    mGame = game;
    mMilliSeconds = 0;
+   mTotalTime = 0;
+   mLastKeyframeTime = 0;
+   mKeyframeInterval = game->getSettings()->getIniSettings()->gameRecordingKeyframeInterval * 1000;
    mWriteMaxBitSize = U32_MAX;
    mPackUnpackShipEnergyMeter = true;
 
    {
       const string &dir = game->getSettings()->getFolderManager()->recordDir;
+      getRecordingFileLock().lock();
       mFileName = newRecordingFileName(dir, game->getGameType()->getLevelName(), game->getSettings()->getHostName()) +
             "." + buildGameRecorderExtension();
       string filename = joindir(dir, mFileName);
       FILE *file = fopen(filename.c_str(), "wb");
+      getRecordingFileLock().unlock();
       if(file)
-         mWriter = new WriteBufferThread(file);
+      {
+         const IniSettings *iniSettings = game->getSettings()->getIniSettings();
+         mWriter = new WriteBufferThread(file, iniSettings->gameRecordingBufferSize * 1024, iniSettings->compressGameRecordings);
+      }
    }
 
    if(mWriter)
@@ -195,12 +852,12 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
       mConnectionParameters.mIsInitiator = false;
       mConnectionParameters.mDebugObjectSizes = false;
 
-      U8 *data = mWriter->getBuffer(4);
+      U8 data[RecordingReader::HeaderSize];
       data[0] = CS_PROTOCOL_VERSION;
       data[1] = U8(mGhostClassCount);
       data[2] = U8(mEventClassCount);
-      data[3] = U8(mEventClassCount >> 8) | 0x10;
-      mWriter->addBuffer(4);
+      data[3] = U8(mEventClassCount >> 8) | RecordingShipEnergyMeter | (mWriter->isCompressed() ? RecordingCompressed : 0);
+      mWriter->writeHeader(data, sizeof(data));
       gameRecorderScoping(this, game);
 
       s2cSetServerName(game->getSettings()->getHostName());
@@ -210,8 +867,18 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
 // Destructor
 GameRecorderServer::~GameRecorderServer()
 {
-   if(mWriter)
-      delete mWriter;
+   if(!mWriter)
+      return;
+
+   mWriter->finish(mTotalTime);
+
+   const WriteBufferThread::Stats &stats = mWriter->getStats();
+   logprintf(LogConsumer::ServerFilter, "Recorded %s: %u packets, %s KB written of %s KB recorded; write buffer peaked at %u KB, "
+             "overflowed %u times (peak %u KB), %u packets dropped", mFileName.c_str(), stats.packetsRecorded,
+             itos(stats.bytesWritten / 1024).c_str(), itos(stats.bytesRecorded / 1024).c_str(), stats.peakBufferUse / 1024,
+             stats.overflowCount, stats.peakOverflow / 1024, stats.packetsDropped);
+
+   delete mWriter;
 }
 
 
@@ -240,10 +907,20 @@ void GameRecorderServer::idle(U32 MilliSeconds)
       return;
    }
 
+   writeRecordedPacket(MilliSeconds + mMilliSeconds);
+   mMilliSeconds = 0;
+
+   if(mKeyframeInterval != 0 && mTotalTime - mLastKeyframeTime >= mKeyframeInterval)
+      writeKeyframe();
+}
+
+
+void GameRecorderServer::writeRecordedPacket(U32 milliSeconds)
+{
    GhostPacketNotify notify;
    mNotifyQueueTail = &notify;
 
-   U8 *data = mWriter->getBuffer(16383 + 3);
+   U8 data[16383 + 3];
    BitStream bstream(&data[3], 16383);
 
    prepareWritePacket();
@@ -254,12 +931,47 @@ void GameRecorderServer::idle(U32 MilliSeconds)
 
    bstream.zeroToByteBoundary();
    U32 size = bstream.getBytePosition();
-   U32 ms = MilliSeconds + mMilliSeconds;
-   mMilliSeconds = 0;
    data[0] = U8(size);
-   data[1] = U8((size >> 8) & 63) | U8((ms >> 8) << 6);
-   data[2] = U8(ms);
-   mWriter->addBuffer(bstream.getBytePosition() + 3);
+   data[1] = U8((size >> 8) & 63) | U8((milliSeconds >> 8) << 6);
+   data[2] = U8(milliSeconds);
+
+   if(mWriter->write(data, size + 3))
+      mTotalTime += milliSeconds & 0x3FF;
+}
+
+
+// Throws away everything the recording has told playback so far, and sends it all again from scratch, so
+// playback can start here without reading anything before
+void GameRecorderServer::writeKeyframe()
+{
+   static const S32 MaxKeyframePackets = 64;
+
+   // Anything already posted has to go out first; if there's too much for one packet, try again next time
+   if(!restartEventSequence())
+      return;
+
+   if(!mWriter->writeKeyframe(mTotalTime))
+      return;
+
+   mLastKeyframeTime = mTotalTime;
+
+   // Like resetGhosting() followed by activateGhosting(), but without telling playback, which already knows
+   // to start over when it sees the keyframe marker
+   mGhosting = false;
+   mScoping = false;
+   clearGhostInfo();
+   mGhostingSequence++;
+
+   if(mStringTable)
+      mStringTable->resetReceiveConfirmations();
+
+   mScoping = true;
+   rpcReadyForNormalGhosts_remote(mGhostingSequence);
+   gameRecorderScoping(this, mGame);
+
+   // Get the whole game out now, so playback never shows a partly built one
+   for(S32 i = 0; i < MaxKeyframePackets && GhostConnection::isDataToTransmit(); i++)
+      writeRecordedPacket(0);
 }
 
 
@@ -17,6 +17,75 @@ namespace Zap {
 class ServerGame;
 class WriteBufferThread;
 
+// Flags kept in the high bits of the fourth byte of a recording's header
+enum RecordingHeaderFlags {
+   RecordingShipEnergyMeter = 0x10,    // Ship updates include the energy meter
+   RecordingCompressed      = 0x20,    // Everything after the header is in compressed blocks
+};
+
+
+// Each packet in a recording has a three byte header: 14 bits of size and 10 bits of milliseconds since the
+// previous packet.  A header with a size of zero has no packet after it, and means one of these:
+enum RecordingMarkers {
+   RecordingEndMarker      = 0,        // End of the packet stream; the keyframe index may follow
+   RecordingKeyframeMarker = 0x3FF,    // Everything starts over here, so playback can begin here too
+};
+
+
+// Where playback can jump to
+struct RecordingKeyframe
+{
+   U32 time;         // Milliseconds from the start of the recording
+   U32 offset;       // Position of the keyframe marker in the packet stream
+};
+
+
+// Reads back the packet stream written by GameRecorderServer, unpacking compressed recordings as it goes,
+// so the caller only ever sees the bytes that were recorded
+class RecordingReader
+{
+private:
+   FILE *mFile;
+   bool mCompressed;
+
+   struct BlockLocation
+   {
+      U32 streamPos;                // Where the block starts in the packet stream
+      U32 fileOffset;               // ...and in the file
+   };
+
+   Vector<U8> mBlock;               // Current block, uncompressed
+   U32 mBlockStart;                 // Position of mBlock in the packet stream
+   U32 mBlockPos;                   // Next byte to read from mBlock
+   Vector<U8> mCompressedBlock;
+   Vector<BlockLocation> mBlocks;   // Every block we know the location of, in order
+
+   U32 mStreamPos;                  // Next byte of the packet stream
+
+   bool readBlock();
+
+public:
+   static const U32 HeaderSize = 4;
+
+   RecordingReader();      // Constructor
+   ~RecordingReader();     // Destructor
+
+   bool open(const char *filename, U8 *header);    // Fills header with HeaderSize bytes
+   void close();
+   bool isOpen() const;
+
+   U32 read(U8 *data, U32 size);    // Returns number of bytes read
+   bool skip(U32 size);
+   void rewind();                   // Back to the first packet
+
+   U32 tell() const;                // Position in the packet stream
+   bool seek(U32 streamPos);
+
+   // Reads the index at the end of the file, if the recording has one
+   bool readIndex(U32 &totalTime, Vector<RecordingKeyframe> &keyframes);
+};
+
+
 class GameRecorderServer : public GameConnection
 {
    typedef GhostConnection Parent;
@@ -27,6 +96,13 @@ private:
    TNL::NetObject mNetObj;
    U32 mMilliSeconds;
 
+   U32 mTotalTime;            // Milliseconds recorded so far
+   U32 mKeyframeInterval;     // Milliseconds between keyframes, 0 for none
+   U32 mLastKeyframeTime;
+
+   void writeRecordedPacket(U32 milliSeconds);
+   void writeKeyframe();
+
 public:
    string mFileName;
 
@@ -72,7 +72,6 @@ static void resetRenderState(ClientGame *game)
 
 GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filename) : GameConnection(game, false)
 {
-   mFile = NULL;
    mGame = game;
    mMilliSeconds = 0;
    mSizeToRead = 0;
@@ -80,27 +79,20 @@ GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filenam
    mTotalTime = 0;
    mIsButtonHeldDown = false;
 
-   if(!mFile)
-      mFile = fopen(filename, "rb");
+   U8 data[RecordingReader::HeaderSize];
 
-   if(mFile)
+   if(mReader.open(filename, data))
    {
-      U8 data[4];
-      data[0] = 0;
-      fread(data, 1, 4, mFile);
       mGhostClassCount = data[1];
-      mEventClassCount = U32(data[2]) | (U32(data[3]) << 8);
-      if(mEventClassCount & 0x1000)
-      {
+      mEventClassCount = U32(data[2]) | (U32(data[3] & 0x0F) << 8);    // High bits are RecordingHeaderFlags
+      if(data[3] & RecordingShipEnergyMeter)
          mPackUnpackShipEnergyMeter = true;
-         mEventClassCount &= ~0x1000;
-      }
+
       if(data[0] != CS_PROTOCOL_VERSION || 
          mEventClassCount > NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeEvent) || 
          mGhostClassCount > NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeObject))
       {
-         fclose(mFile); // Wrong version, warn about this problem?
-         mFile = NULL;
+         mReader.close(); // Wrong version, warn about this problem?
       }
 
       setGhostFrom(false);
@@ -113,34 +105,46 @@ GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filenam
    mConnectionParameters.mDebugObjectSizes = false;
 
 
-   if(mFile)
+   // Recordings without an index have to be read through to find out how long they are, and where the keyframes are
+   if(mReader.isOpen() && !mReader.readIndex(mTotalTime, mKeyframes))
    {
-      S32 filepos = ftell(mFile);
       while(true)
       {
+         U32 offset = mReader.tell();
+
          U8 data[3];
-         if(fread(data, 1, 3, mFile) != 3)
+         if(mReader.read(data, 3) != 3)
             break;
          U32 size = (U32(data[1] & 63) << 8) + data[0];
          U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
+
+         if(size == 0 && milli == RecordingKeyframeMarker)
+         {
+            RecordingKeyframe keyframe;
+            keyframe.time = mTotalTime;
+            keyframe.offset = offset;
+            mKeyframes.push_back(keyframe);
+            continue;
+         }
+
          if(size == 0)
             break;
          mTotalTime += milli;
-         fseek(mFile, size, SEEK_CUR);
+         if(!mReader.skip(size))
+            break;
       }
-      fseek(mFile, filepos, SEEK_SET);
+      mReader.rewind();
    }
 }
 
 
 GameRecorderPlayback::~GameRecorderPlayback()
 {
-   if(mFile)
-      fclose(mFile);
+   // Do nothing
 }
 
 
-bool GameRecorderPlayback::isValid()     { return mFile != NULL; }
+bool GameRecorderPlayback::isValid()     { return mReader.isOpen(); }
 bool GameRecorderPlayback::lostContact() { return false; }
 
 
@@ -203,7 +207,7 @@ void GameRecorderPlayback::updateSpectate()
 
 void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
 {
-   if(!mFile)
+   if(!mReader.isOpen())
    {
       //disconnect(ReasonShutdown, "");
       return;
@@ -228,7 +232,7 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
          mPacketRecvBytesTotal += mSizeToRead;
          mPacketRecvCount++;
 
-         if(fread(data, 1, mSizeToRead, mFile) == mSizeToRead)
+         if(mReader.read(data, mSizeToRead) == mSizeToRead)
          {
             BitStream bstream(data, mSizeToRead);
             GhostConnection::readPacket(&bstream);
@@ -236,11 +240,19 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
          mSizeToRead = 0;
       }
 
-      if(fread(data, 1, 3, mFile) != 3)
+      if(mReader.read(data, 3) != 3)
          break; // Could not read 3 bytes
 
       U32 size = (U32(data[1] & 63) << 8) + data[0];
       U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
+
+      // The recording starts over from here, with everything sent again
+      if(size == 0 && milli == RecordingKeyframeMarker)
+      {
+         clearGameState();
+         continue;
+      }
+
       mCurrentTime += milli;
       mMilliSeconds += milli;
 
@@ -260,17 +272,61 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
 }
 
 
-void GameRecorderPlayback::restart()
+// Moves ahead in steps, so objects move as they would during normal playback, but doesn't render anything
+// along the way
+void GameRecorderPlayback::fastForward(U32 MilliSeconds)
+{
+   static const U32 StepSize = 50;
+
+   while(MilliSeconds > 0 && mMilliSeconds != S32_MAX)
+   {
+      U32 step = min(MilliSeconds, StepSize);
+      processMoreData(step);
+      MilliSeconds -= step;
+   }
+}
+
+
+// Goes to time, starting from the nearest keyframe before it unless we're already closer
+void GameRecorderPlayback::seek(U32 time)
+{
+   S32 keyframe = -1;
+   for(S32 i = 0; i < mKeyframes.size() && mKeyframes[i].time < time; i++)
+      keyframe = i;
+
+   if(keyframe != -1 && (time < mCurrentTime || mKeyframes[keyframe].time > mCurrentTime))
+   {
+      clearGameState();
+      mMilliSeconds = 0;
+      mSizeToRead = 0;
+      mCurrentTime = mKeyframes[keyframe].time;
+
+      if(!mReader.seek(mKeyframes[keyframe].offset))
+         restart();
+   }
+   else if(time < mCurrentTime)
+      restart();
+
+   fastForward(time - mCurrentTime);
+}
+
+
+void GameRecorderPlayback::clearGameState()
 {
    deleteLocalGhosts();
+   clearRecvEvents();
+   mGame->clearClientList();
+}
+
+
+void GameRecorderPlayback::restart()
+{
+   clearGameState();
    mMilliSeconds = 0;
    mSizeToRead = 0;
    mCurrentTime = 0;
-   clearRecvEvents();
-   mGame->clearClientList();
 
-   if(mFile)
-      fseek(mFile, 4, SEEK_SET);
+   mReader.rewind();
 }
 
 // --------
@@ -521,7 +577,7 @@ bool PlaybackGameUserInterface::onKeyDown(InputCode inputCode)
          else if(x >= btn2_x && x <= btn2_x + btn_w)
             mSpeed = 2;
          else if(x >= btn3_x && x <= btn3_x + btn_w)
-            mSpeed = 3;
+            mSpeed = (mSpeed == 3) ? 4 : 3;     // Click again to go faster still
          return true;
       }
       else if(y >= playbackBar_y && y <= playbackBar_y + playbackBar_h)
@@ -534,11 +590,7 @@ bool PlaybackGameUserInterface::onKeyDown(InputCode inputCode)
 
          U32 time = U32(x2 * mPlaybackConnection->mTotalTime);
 
-         // TODO: maybe we need to seek more efficiency by avoiding having to start all over from the beginning
-         if(time < mPlaybackConnection->mCurrentTime)
-            mPlaybackConnection->restart();
-
-         mPlaybackConnection->processMoreData(time - mPlaybackConnection->mCurrentTime);
+         mPlaybackConnection->seek(time);
          resetRenderState(getGame());
 
          return true;
@@ -625,12 +677,18 @@ void PlaybackGameUserInterface::idle(U32 timeDelta)
       case 1: idleTime = (timeDelta + mSpeedRemainder) >> 2; mSpeedRemainder = (mSpeedRemainder + timeDelta) & 3; break;
       case 2: break;
       case 3: idleTime = timeDelta * 4; break;
+      case 4: idleTime = timeDelta * 16; break;
    }
 
    if(idleTime != 0)
    {
       mGameInterface->idleFxManager(idleTime);
-      mPlaybackConnection->processMoreData(idleTime);
+
+      // Too far to go in one step; only the frame we end up at gets rendered
+      if(mSpeed == 4)
+         mPlaybackConnection->fastForward(idleTime);
+      else
+         mPlaybackConnection->processMoreData(idleTime);
    }
 
    // Cheap way to avoid letting the client move objects, because of pause/slow motion/fast forward
@@ -10,6 +10,7 @@
 #include "tnlGhostConnection.h"
 #include "tnlNetObject.h"
 #include "gameConnection.h"
+#include "GameRecorder.h"
 
 #include "UIMenus.h"
 
@@ -23,11 +24,14 @@ class Timer;
 class GameRecorderPlayback : public GameConnection
 {
    typedef GameConnection Parent;
-   FILE *mFile;
+   RecordingReader mReader;
    ClientGame *mGame;
    S32 mMilliSeconds;
    U32 mSizeToRead;
    SafePtr<ClientInfo> mClientInfoSpectating;
+   Vector<RecordingKeyframe> mKeyframes;
+
+   void clearGameState();
 public:
    StringTableEntry mClientInfoSpectatingName;
    bool mIsButtonHeldDown;
@@ -45,6 +49,8 @@ public:
 
    void updateSpectate();
    void processMoreData(TNL::U32 MilliSeconds);
+   void fastForward(TNL::U32 MilliSeconds);
+   void seek(TNL::U32 time);
    void restart();
 };
 
@@ -14,6 +14,7 @@
 
 #include "tnlTypes.h"         // For TNL_OS_WIN32 def
 #include "tnlLog.h"           // For logprintf
+#include "tnlThread.h"
 
 #include "version.h"
 
@@ -103,6 +104,7 @@ ParamInfo paramDefs[] = {
 { "plugindir",             ONE_REQUIRED,   PLUGIN_DIR,            3, "<path>",                "Folder where editor plugins are stored",     "You must specify your plugins folder with the -plugindir option" },
 { "fontsdir",              ONE_REQUIRED,   FONTS_DIR,             3, "<path>",                "Folder where fonts are stored",              "You must specify your fonts folder with the -fontsdir option" },
 { "recorddir",             ONE_REQUIRED,   RECORD_DIR,            3, "<path>",                "Folder where recording gameplay are stored", "You must specify your recorded gameplay folder with the -recorddir option" },
+{ "cachedir",              ONE_REQUIRED,   CACHE_DIR,             3, "<path>",                "Folder where bot zones are cached",          "You must specify your cache folder with the -cachedir option" },
 
 // Developer-oriented options
 { "loss",                  ONE_REQUIRED,   SIMULATED_LOSS,        4, "<float>",   "Simulate the specified amount of packet loss, from 0 (no loss) to 1 (all packets lost) Note: Client only!", "You must specify a loss rate between 0 and 1 with the -loss option" },
@@ -168,6 +170,13 @@ CIniFile GameSettings::iniFile("dummy");                 // Our INI file.  Real
 CIniFile GameSettings::userPrefs("dummy");               // Our INI file.  Real filename will be supplied later.
 
 
+Mutex &GameSettings::getLock()
+{
+   static Mutex settingsLock;
+   return settingsLock;
+}
+
+
 // Constructor
 GameSettings::GameSettings()
 {
@@ -203,116 +212,178 @@ static const string *choose(const string &firstChoice, const string &secondChoic
 
 string GameSettings::getHostName()
 {
-   return mHostName;
+   getLock().lock();
+   string value = mHostName;
+   getLock().unlock();
+
+   return value;
 }
 
 
 void GameSettings::setHostName(const string &hostName, bool updateINI) 
 { 
+   getLock().lock();
+
    mHostName = hostName; 
 
    if(updateINI)
       mIniSettings.hostname = hostName; 
+
+   getLock().unlock();
 }
 
 
 string GameSettings::getHostDescr()
 {
-   return mHostDescr;
+   getLock().lock();
+   string value = mHostDescr;
+   getLock().unlock();
+
+   return value;
 }
 
 
 void GameSettings::setHostDescr(const string &hostDescr, bool updateINI) 
 { 
+   getLock().lock();
+
    mHostDescr = hostDescr;
    
    if(updateINI)
       mIniSettings.hostdescr = hostDescr; 
+
+   getLock().unlock();
 }
 
 
 string GameSettings::getWelcomeMessage() const
 {
-   return mWelcomeMessage;
+   getLock().lock();
+   string value = mWelcomeMessage;
+   getLock().unlock();
+
+   return value;
 }
 
 
 void GameSettings::setGlobalLevelgenScript(const string &globalLevelScript)
 { 
-      mIniSettings.globalLevelScript = globalLevelScript;
+   getLock().lock();
+   mIniSettings.globalLevelScript = globalLevelScript;
+   getLock().unlock();
 }
 string GameSettings::getGlobalLevelgenScript() const
 {
-   return mIniSettings.globalLevelScript;
+   getLock().lock();
+   string value = mIniSettings.globalLevelScript;
+   getLock().unlock();
+
+   return value;
 }
 
 
 void GameSettings::setWelcomeMessage(const string &welcomeMessage, bool updateINI)
  {
+   getLock().lock();
+
    mWelcomeMessage = welcomeMessage;
 
    if(updateINI)
       mIniSettings.welcomeMessage = welcomeMessage;
+
+   getLock().unlock();
 }
 
 
 string GameSettings::getServerPassword()
 {
-   return mServerPassword;
+   getLock().lock();
+   string value = mServerPassword;
+   getLock().unlock();
+
+   return value;
 }
 
 
 void GameSettings::setServerPassword(const string &serverPassword, bool updateINI) 
 { 
+   getLock().lock();
+
    mServerPassword = serverPassword; 
 
    if(updateINI)
       mIniSettings.serverPassword = serverPassword; 
+
+   getLock().unlock();
 }
 
 
 string GameSettings::getOwnerPassword()
 {
-   return mOwnerPassword;
+   getLock().lock();
+   string value = mOwnerPassword;
+   getLock().unlock();
+
+   return value;
 }
 
 
 void GameSettings::setOwnerPassword(const string &ownerPassword, bool updateINI)
 {
+   getLock().lock();
+
    mOwnerPassword = ownerPassword;
 
    if(updateINI)
       mIniSettings.ownerPassword = ownerPassword;
+
+   getLock().unlock();
 }
 
 
 string GameSettings::getAdminPassword()
 {
-   return mAdminPassword;
+   getLock().lock();
+   string value = mAdminPassword;
+   getLock().unlock();
+
+   return value;
 }
 
 
 void GameSettings::setAdminPassword(const string &adminPassword, bool updateINI) 
 { 
+   getLock().lock();
+
    mAdminPassword = adminPassword; 
 
    if(updateINI)
       mIniSettings.adminPassword = adminPassword; 
+
+   getLock().unlock();
 }
 
 
 string GameSettings::getLevelChangePassword()
 {
-   return mLevelChangePassword;
+   getLock().lock();
+   string value = mLevelChangePassword;
+   getLock().unlock();
+
+   return value;
 }
 
 
 void GameSettings::setLevelChangePassword(const string &levelChangePassword, bool updateINI) 
 { 
+   getLock().lock();
+
    mLevelChangePassword = levelChangePassword;     // Update our working copy
 
    if(updateINI)
       mIniSettings.levelChangePassword = levelChangePassword; 
+
+   getLock().unlock();
 }
 
 
@@ -364,7 +435,8 @@ FolderManager GameSettings::getCmdLineFolderManager()
                           getString(ROOT_DATA_DIR),
                           getString(PLUGIN_DIR),
                           getString(FONTS_DIR),
-                          getString(RECORD_DIR));
+                          getString(RECORD_DIR),
+                          getString(CACHE_DIR));
 }
 
 
@@ -421,7 +493,9 @@ void GameSettings::save()
    //saveWindowMode(&iniFile, &mIniSettings);
    //getIniSettings()->mSettings.setVal("WindowMode", cmdLineDisplayMode);
       //ini->SetValue("Settings",  "WindowMode", displayModeToString(iniSettings->displayMode));;
+   getLock().lock();
    saveSettingsToINI(&iniFile, this);        // Writes settings to iniFile, then writes it to disk
+   getLock().unlock();
 }
 
 
@@ -692,6 +766,8 @@ Vector<string> GameSettings::getLevelList(const string &levelDir, bool ignoreCmd
 
 
    // Now, remove any levels listed in the skip list from levelList.  Not foolproof!
+   getLock().lock();
+
    for(S32 i = 0; i < levelList.size(); i++)
    {
       // Make sure we have the right extension
@@ -709,6 +785,8 @@ Vector<string> GameSettings::getLevelList(const string &levelDir, bool ignoreCmd
          }
    }
 
+   getLock().unlock();
+
    return levelList;
 }
 
@@ -984,11 +1062,16 @@ Vector<string> *GameSettings::getMasterServerList()
 void GameSettings::saveMasterAddressListInIniUnlessItCameFromCmdLine()
 {
    // If we got the master from the cmd line, or we only have one address, we have nothing to do
-   if(mMasterServerSpecifiedOnCmdLine || mMasterServerList.size() < 2)
+   if(mMasterServerSpecifiedOnCmdLine)
       return;
 
+   getLock().lock();
+
    // Otherwise write the master list to the INI file in their new order; the most recently successful address will now be first
-   mIniSettings.masterAddress = listToString(mMasterServerList, ",");
+   if(mMasterServerList.size() >= 2)
+      mIniSettings.masterAddress = listToString(mMasterServerList, ",");
+
+   getLock().unlock();
 }
 
 
@@ -1279,23 +1362,30 @@ void GameSettings::deleteServerPassword(const string &serverName)
 
 bool GameSettings::isLevelOnSkipList(const string &filename) const
 {
-   for(S32 i = 0; i < mLevelSkipList.size(); i++)
-      if(mLevelSkipList[i] == filename)    // Already on our list!
-         return true;
+   bool found = false;
+
+   getLock().lock();
+   for(S32 i = 0; i < mLevelSkipList.size() && !found; i++)
+      found = (mLevelSkipList[i] == filename);    // Already on our list!
+   getLock().unlock();
 
-   return false;
+   return found;
 }
 
 
 void GameSettings::addLevelToSkipList(const string &filename)
 {
+   getLock().lock();
    mLevelSkipList.push_back(filename);
    saveSkipList();
+   getLock().unlock();
 }
 
 
 void GameSettings::removeLevelFromSkipList(const string &filename)
 {
+   getLock().lock();
+
    for(S32 i = 0; i < mLevelSkipList.size(); i++)
       if(mLevelSkipList[i] == filename)
       {
@@ -1303,14 +1393,18 @@ void GameSettings::removeLevelFromSkipList(const string &filename)
          saveSkipList();
          break;
       }
+
+   getLock().unlock();
 }
 
 
 // Do we still need to do this at this point?  This will get done when INI is saved through regular channels...
 void GameSettings::saveSkipList() const
 {
+   getLock().lock();
    writeSkipList(&iniFile, &mLevelSkipList);  // Write skipped levels to INI
    iniFile.WriteFile();                       // Save new INI settings to disk
+   getLock().unlock();
 }
 
 
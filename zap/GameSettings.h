@@ -17,6 +17,8 @@
 #include <string>
 #include <map>
 
+namespace TNL { class Mutex; }
+
 using namespace std;
 using namespace TNL;
 
@@ -65,6 +67,7 @@ enum ParamId {
    MUSIC_DIR,
    FONTS_DIR,
    RECORD_DIR,
+   CACHE_DIR,
 
    SIMULATED_LOSS,
    SIMULATED_LAG,
@@ -160,6 +163,10 @@ public:
    static CIniFile iniFile;
    static CIniFile userPrefs;
 
+   // Arenas hosted on their own threads share one GameSettings.  Hold this while using iniFile or the skip list; the
+   // strings admins can change from within a game take it themselves.
+   static Mutex &getLock();
+
    static const S32 LoadoutPresetCount = 6;     // How many presets do we save?
 
    static const U16 DEFAULT_GAME_PORT = 28000;
@@ -268,6 +268,47 @@ bool circleCircleIntersect(const Point &center1, F32 radius1, const Point &cente
 // Check if circle at inCenter with radius^2 = inRadiusSq intersects with a polygon.
 // Function returns true when it does and the intersection point is in outPoint
 // Works only for convex hulls.. maybe no longer true... may work for all polys now
+// One edge's worth of polygonCircleIntersect(): does the circle touch v1, or the edge from v1 to v1 + v1_v2, any closer
+// than sqrt(inRadiusSq)?  If so, shrinks inRadiusSq to the new distance.
+bool circleIntersectsEdge(const Point &v1, const Point &v1_v2, F32 v1_v2_len_sq, const Point &inCenter, F32 &inRadiusSq,
+                          Point &outPoint, const Point *ignoreVelocityEpsilon)
+{
+   // Get fraction where the closest point to this edge occurs
+   Point v1_center = inCenter - v1;
+   F32 fraction = v1_center.dot(v1_v2);
+   if (fraction < 0.0f)
+   {
+      // Closest point is v1
+      F32 dist_sq = v1_center.lenSquared();
+      if (dist_sq <= inRadiusSq)
+         if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot(v1 - inCenter) > 0)
+         {
+            outPoint = v1;
+            inRadiusSq = dist_sq;
+            return true;
+         }
+   }
+   else
+   {
+      if (fraction <= v1_v2_len_sq)
+      {
+         // Closest point is on line segment
+         Point point = v1 + v1_v2 * (fraction / v1_v2_len_sq);
+         F32 dist_sq = (point - inCenter).lenSquared();
+         if (dist_sq <= inRadiusSq)
+            if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot(point - inCenter) > 0)
+            {
+               outPoint = point;
+               inRadiusSq = dist_sq;
+               return true;
+            }
+      }
+   }
+
+   return false;
+}
+
+
 bool polygonCircleIntersect(const Point *inVertices, int inNumVertices, const Point &inCenter, F32 inRadiusSq, Point &outPoint, Point *ignoreVelocityEpsilon)
 {
    // Check if the center is inside the polygon  ==> now works for all polys
@@ -281,39 +322,10 @@ bool polygonCircleIntersect(const Point *inVertices, int inNumVertices, const Po
    bool collision = false;
    for (const Point *v1 = inVertices, *v2 = inVertices + inNumVertices - 1; v1 < inVertices + inNumVertices; v2 = v1, ++v1)
    {
-      // Get fraction where the closest point to this edge occurs
       Point v1_v2 = *v2 - *v1;
-      Point v1_center = inCenter - *v1;
-      F32 fraction = v1_center.dot(v1_v2);
-      if (fraction < 0.0f)
-      {
-         // Closest point is v1
-         F32 dist_sq = v1_center.lenSquared();
-         if (dist_sq <= inRadiusSq)
-            if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot((*v1) - inCenter) > 0)
-            {
-               collision = true;
-               outPoint = *v1;
-               inRadiusSq = dist_sq;
-            }
-      }
-      else
-      {
-         F32 v1_v2_len_sq = v1_v2.lenSquared();
-         if (fraction <= v1_v2_len_sq)
-         {
-            // Closest point is on line segment
-            Point point = *v1 + v1_v2 * (fraction / v1_v2_len_sq);
-            F32 dist_sq = (point - inCenter).lenSquared();
-            if (dist_sq <= inRadiusSq)
-               if(!ignoreVelocityEpsilon || ignoreVelocityEpsilon->dot(point - inCenter) > 0)
-               {
-                  collision = true;
-                  outPoint = point;
-                  inRadiusSq = dist_sq;
-               }
-         }
-      }
+
+      if(circleIntersectsEdge(*v1, v1_v2, v1_v2.lenSquared(), inCenter, inRadiusSq, outPoint, ignoreVelocityEpsilon))
+         collision = true;
    }
 
    return collision;
@@ -464,7 +476,7 @@ bool segmentsColinear(const Point &p1, const Point &p2, const Point &p3, const P
 
 bool pointOnSegment(const Point &c, const Point &a, const Point &b, F32 closeEnough)
 {
-   static Point closest;
+   static thread_local Point closest;
 
    return c.distSquared(a) < closeEnough || c.distSquared(b) < closeEnough || 
          (findNormalPoint(c, a, b, closest) && c.distSquared(closest) < closeEnough);
@@ -660,6 +672,55 @@ bool zonesTouch(const Vector<Point> *zone1, const Vector<Point> *zone2, F32 scal
 }
 
 
+// One edge's worth of SweptCircleEdgeVertexIntersect(): does the circle hit v1, or the edge from v1 to v1 + v1v2, before
+// inUpperBound?  If so, lowers inUpperBound to when it does.
+bool sweptCircleIntersectsEdge(const Point &v1, const Point &v1v2, F32 v1v2_len_sq, const Point &inBegin, const Point &inDelta,
+                               F32 inA, F32 inB, F32 inC, F32 &inUpperBound, Point &outPoint)
+{
+   bool collision = false;
+   F32 t;
+
+   // Check if circle hits the vertex
+   Point bv1 = v1 - inBegin;
+   F32 a1 = inA - inDelta.lenSquared();
+   F32 b1 = inB + 2.0f * inDelta.dot(bv1);
+   F32 c1 = inC - bv1.lenSquared();
+   if (findLowestRootInInterval(a1, b1, c1, inUpperBound, t))
+      if(inDelta.dot(v1 - inBegin) > 0)
+      {
+         // We have a collision
+         collision = true;
+         inUpperBound = t;
+         outPoint = v1;
+      }
+
+   // Check if circle hits the edge
+   F32 v1v2_dot_delta = v1v2.dot(inDelta);
+   F32 v1v2_dot_bv1 = v1v2.dot(bv1);
+   F32 a2 = v1v2_len_sq * a1 + v1v2_dot_delta * v1v2_dot_delta;
+   F32 b2 = v1v2_len_sq * b1 - 2.0f * v1v2_dot_bv1 * v1v2_dot_delta;
+   F32 c2 = v1v2_len_sq * c1 + v1v2_dot_bv1 * v1v2_dot_bv1;
+   if (findLowestRootInInterval(a2, b2, c2, inUpperBound, t))
+   {
+      // Check if the intersection point is on the edge
+      F32 f = t * v1v2_dot_delta - v1v2_dot_bv1;
+      if (f >= 0.0f && f <= v1v2_len_sq)
+      {
+         Point p(v1 + v1v2 * (f / v1v2_len_sq));
+         if(inDelta.dot(p - inBegin) > 0)
+         {
+            // We have a collision
+            collision = true;
+            inUpperBound = t;
+            outPoint = p;
+         }
+      }
+   }
+
+   return collision;
+}
+
+
 // Checks intersection between a polygon an moving circle at inBegin + t * inDelta with radius^2 = inA * t^2 + inB * t + inC, t in [0, 1]
 // Returns true when it does and returns the intersection position in outPoint and the intersection fraction (value for t) in outFraction
 bool SweptCircleEdgeVertexIntersect(const Point *inVertices, int inNumVertices, const Point &inBegin, const Point &inDelta, F32 inA, F32 inB, F32 inC, Point &outPoint, F32 &outFraction)
@@ -669,46 +730,10 @@ bool SweptCircleEdgeVertexIntersect(const Point *inVertices, int inNumVertices,
    bool collision = false;
    for (const Point *v1 = inVertices, *v2 = inVertices + inNumVertices - 1; v1 < inVertices + inNumVertices; v2 = v1, ++v1)
    {
-      F32 t;
-
-      // Check if circle hits the vertex
-      Point bv1 = *v1 - inBegin;
-      F32 a1 = inA - inDelta.lenSquared();
-      F32 b1 = inB + 2.0f * inDelta.dot(bv1);
-      F32 c1 = inC - bv1.lenSquared();
-      if (findLowestRootInInterval(a1, b1, c1, upper_bound, t))
-         if(inDelta.dot((*v1) - inBegin) > 0)
-         {
-            // We have a collision
-            collision = true;
-            upper_bound = t;
-            outPoint = *v1;
-         }
-
-      // Check if circle hits the edge
       Point v1v2 = *v2 - *v1;
-      F32 v1v2_dot_delta = v1v2.dot(inDelta);
-      F32 v1v2_dot_bv1 = v1v2.dot(bv1);
-      F32 v1v2_len_sq = v1v2.lenSquared();
-      F32 a2 = v1v2_len_sq * a1 + v1v2_dot_delta * v1v2_dot_delta;
-      F32 b2 = v1v2_len_sq * b1 - 2.0f * v1v2_dot_bv1 * v1v2_dot_delta;
-      F32 c2 = v1v2_len_sq * c1 + v1v2_dot_bv1 * v1v2_dot_bv1;
-      if (findLowestRootInInterval(a2, b2, c2, upper_bound, t))
-      {
-         // Check if the intersection point is on the edge
-         F32 f = t * v1v2_dot_delta - v1v2_dot_bv1;
-         if (f >= 0.0f && f <= v1v2_len_sq)
-         {
-            Point p(*v1 + v1v2 * (f / v1v2_len_sq));
-            if(inDelta.dot(p - inBegin) > 0)
-            {
-               // We have a collision
-               collision = true;
-               upper_bound = t;
-               outPoint = p;
-            }
-         }
-      }
+
+      if(sweptCircleIntersectsEdge(*v1, v1v2, v1v2.lenSquared(), inBegin, inDelta, inA, inB, inC, upper_bound, outPoint))
+         collision = true;
    }
 
    // Check if we had a collision
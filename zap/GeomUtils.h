@@ -83,6 +83,12 @@ bool segsOverlap(const Point &p1, const Point &p2, const Point &p3, const Point
 bool zonesTouch(const Vector<Point> *zone1, const Vector<Point> *zone2, F32 scaleFact, Point &overlapStart, Point &overlapEnd);
 bool pointOnSegment(const Point &c, const Point &a, const Point &b, F32 closeEnough);
 bool polygonCircleIntersect(const Point *inVertices, int inNumVertices, const Point &inCenter, F32 inRadiusSq, Point &outPoint, Point *ignoreVelocityEpsilon = NULL);
+
+// Single edges of the two polygon tests above, for those that keep edges of their own
+bool circleIntersectsEdge(const Point &v1, const Point &v1_v2, F32 v1_v2_len_sq, const Point &inCenter, F32 &inRadiusSq,
+                          Point &outPoint, const Point *ignoreVelocityEpsilon);
+bool sweptCircleIntersectsEdge(const Point &v1, const Point &v1v2, F32 v1v2_len_sq, const Point &inBegin, const Point &inDelta,
+                               F32 inA, F32 inB, F32 inC, F32 &inUpperBound, Point &outPoint);
 bool circleCircleIntersect(const Point &center1, F32 radius1, const Point &center2, F32 radius2);
 
 bool polygonsIntersect(const Vector<Point> &p1, const Vector<Point> &p2);
@@ -0,0 +1,491 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "HeadlessRenderer.h"
+#include "MathUtils.h"
+
+#include <string.h>
+
+namespace Zap
+{
+
+// Bytes a draw uploads for one attribute, the same way GL2Renderer works it out
+static U32 getAttributeBytes(U32 bytesPerVertex, U32 vertCount, U32 stride)
+{
+   if(stride > bytesPerVertex)
+      bytesPerVertex = stride;
+
+   return bytesPerVertex * vertCount;
+}
+
+
+static U32 getPixelBytes(TextureFormat format, DataType dataType, U32 width, U32 height)
+{
+   U32 channels = 4;
+   switch(format)
+   {
+      case TextureFormat::RGB:   channels = 3; break;
+      case TextureFormat::RGBA:  channels = 4; break;
+      case TextureFormat::Alpha: channels = 1; break;
+   }
+
+   U32 channelSize = 4;
+   switch(dataType)
+   {
+      case DataType::UnsignedByte:
+      case DataType::Byte:          channelSize = 1; break;
+      case DataType::UnsignedShort:
+      case DataType::Short:         channelSize = 2; break;
+      case DataType::UnsignedInt:
+      case DataType::Int:
+      case DataType::Float:         channelSize = 4; break;
+   }
+
+   return width * height * channels * channelSize;
+}
+
+
+HeadlessRenderer::HeadlessRenderer()
+   : mRecordCommands(true)
+   , mMatrixMode(MatrixType::ModelView)
+   , mLineWidth(1.0f)
+   , mPointSize(1.0f)
+   , mAntialiasing(false)
+   , mBlending(false)
+   , mBlendFunction(BlendFunction::Default)
+   , mDepthTest(false)
+   , mStencil(false)
+   , mStencilTest(StencilTest::None)
+   , mStencilDraw(false)
+   , mScissor(false)
+   , mBoundTexture(0)
+   , mNextTexture(1)
+{
+   for(S32 i = 0; i < 4; i++)
+   {
+      mClearColor[i] = 0;
+      mColor[i] = 1;
+      mViewport[i] = 0;
+      mScissorRect[i] = 0;
+   }
+
+   // Give each stack an identity matrix
+   mModelViewMatrixStack.push(Matrix4());
+   mProjectionMatrixStack.push(Matrix4());
+   initRenderer();
+
+   // Start counting from a clean slate, not with the setup initRenderer() did
+   reset();
+}
+
+HeadlessRenderer::~HeadlessRenderer()
+{
+   // Do nothing
+}
+
+// Static
+void HeadlessRenderer::create()
+{
+   setInstance(std::unique_ptr<Renderer>(new HeadlessRenderer));
+}
+
+const Vector<RenderCommand> &HeadlessRenderer::getCommands() const
+{
+   return mCommands;
+}
+
+const RenderStats &HeadlessRenderer::getStats() const
+{
+   return mStats;
+}
+
+void HeadlessRenderer::setRecordCommands(bool record)
+{
+   mRecordCommands = record;
+}
+
+void HeadlessRenderer::reset()
+{
+   mCommands.clear();
+   memset(&mStats, 0, sizeof(mStats));
+}
+
+HeadlessRenderer::MatrixStack &HeadlessRenderer::getStack(MatrixType type)
+{
+   return (type == MatrixType::ModelView) ? mModelViewMatrixStack : mProjectionMatrixStack;
+}
+
+void HeadlessRenderer::addCommand(RenderCommandType type, RenderState state, bool redundant)
+{
+   if(!mRecordCommands)
+      return;
+
+   RenderCommand command;
+   command.type = type;
+   command.state = state;
+   command.primitive = RenderType::Points;
+   command.vertexCount = 0;
+   command.bytes = 0;
+   command.texture = mBoundTexture;
+   command.redundant = redundant;
+
+   mCommands.push_back(command);
+}
+
+void HeadlessRenderer::changeState(RenderState state, bool changed)
+{
+   mStats.stateChanges++;
+   if(!changed)
+      mStats.redundantStateChanges++;
+
+   addCommand(RenderCommandType::StateChange, state, !changed);
+}
+
+template<typename T>
+void HeadlessRenderer::setState(RenderState state, T &current, T value)
+{
+   changeState(state, current != value);
+   current = value;
+}
+
+void HeadlessRenderer::draw(RenderType type, U32 vertCount, U32 bytes)
+{
+   mStats.drawCalls++;
+   mStats.vertices += vertCount;
+   mStats.bytesUploaded += bytes;
+
+   addCommand(RenderCommandType::Draw);
+
+   if(mRecordCommands)
+   {
+      mCommands.last().primitive = type;
+      mCommands.last().vertexCount = vertCount;
+      mCommands.last().bytes = bytes;
+   }
+}
+
+void HeadlessRenderer::clear()
+{
+   addCommand(RenderCommandType::Clear);
+}
+
+void HeadlessRenderer::clearStencil()
+{
+   addCommand(RenderCommandType::Clear, RenderState::Stencil);
+}
+
+void HeadlessRenderer::clearDepth()
+{
+   addCommand(RenderCommandType::Clear, RenderState::DepthTest);
+}
+
+void HeadlessRenderer::setClearColor(F32 r, F32 g, F32 b, F32 alpha)
+{
+   F32 color[4] = { r, g, b, alpha };
+   changeState(RenderState::ClearColor, memcmp(color, mClearColor, sizeof(color)) != 0);
+   memcpy(mClearColor, color, sizeof(color));
+}
+
+void HeadlessRenderer::setColor(F32 r, F32 g, F32 b, F32 alpha)
+{
+   F32 color[4] = { r, g, b, alpha };
+   changeState(RenderState::Color, memcmp(color, mColor, sizeof(color)) != 0);
+   memcpy(mColor, color, sizeof(color));
+}
+
+void HeadlessRenderer::setLineWidth(F32 width)
+{
+   setState(RenderState::LineWidth, mLineWidth, width);
+}
+
+void HeadlessRenderer::setPointSize(F32 size)
+{
+   setState(RenderState::PointSize, mPointSize, size);
+}
+
+void HeadlessRenderer::enableAntialiasing()
+{
+   setState(RenderState::Antialiasing, mAntialiasing, true);
+}
+
+void HeadlessRenderer::disableAntialiasing()
+{
+   setState(RenderState::Antialiasing, mAntialiasing, false);
+}
+
+void HeadlessRenderer::enableBlending()
+{
+   setState(RenderState::Blending, mBlending, true);
+}
+
+void HeadlessRenderer::disableBlending()
+{
+   setState(RenderState::Blending, mBlending, false);
+}
+
+void HeadlessRenderer::useTransparentBlackBlending()
+{
+   setState(RenderState::BlendFunction, mBlendFunction, BlendFunction::TransparentBlack);
+}
+
+void HeadlessRenderer::useSpyBugBlending()
+{
+   setState(RenderState::BlendFunction, mBlendFunction, BlendFunction::SpyBug);
+}
+
+void HeadlessRenderer::useDefaultBlending()
+{
+   setState(RenderState::BlendFunction, mBlendFunction, BlendFunction::Default);
+}
+
+void HeadlessRenderer::enableDepthTest()
+{
+   setState(RenderState::DepthTest, mDepthTest, true);
+}
+
+void HeadlessRenderer::disableDepthTest()
+{
+   setState(RenderState::DepthTest, mDepthTest, false);
+}
+
+void HeadlessRenderer::enableStencil()
+{
+   setState(RenderState::Stencil, mStencil, true);
+}
+
+void HeadlessRenderer::disableStencil()
+{
+   setState(RenderState::Stencil, mStencil, false);
+}
+
+void HeadlessRenderer::useAndStencilTest()
+{
+   setState(RenderState::StencilTest, mStencilTest, StencilTest::And);
+}
+
+void HeadlessRenderer::useNotStencilTest()
+{
+   setState(RenderState::StencilTest, mStencilTest, StencilTest::Not);
+}
+
+void HeadlessRenderer::enableStencilDrawOnly()
+{
+   setState(RenderState::StencilDraw, mStencilDraw, true);
+}
+
+void HeadlessRenderer::disableStencilDraw()
+{
+   setState(RenderState::StencilDraw, mStencilDraw, false);
+}
+
+void HeadlessRenderer::setViewport(S32 x, S32 y, S32 width, S32 height)
+{
+   S32 viewport[4] = { x, y, width, height };
+   changeState(RenderState::Viewport, memcmp(viewport, mViewport, sizeof(viewport)) != 0);
+   memcpy(mViewport, viewport, sizeof(viewport));
+}
+
+Point HeadlessRenderer::getViewportPos()
+{
+   return Point(mViewport[0], mViewport[1]);
+}
+
+Point HeadlessRenderer::getViewportSize()
+{
+   return Point(mViewport[2], mViewport[3]);
+}
+
+void HeadlessRenderer::enableScissor()
+{
+   setState(RenderState::Scissor, mScissor, true);
+}
+
+void HeadlessRenderer::disableScissor()
+{
+   setState(RenderState::Scissor, mScissor, false);
+}
+
+bool HeadlessRenderer::isScissorEnabled()
+{
+   return mScissor;
+}
+
+void HeadlessRenderer::setScissor(S32 x, S32 y, S32 width, S32 height)
+{
+   S32 rect[4] = { x, y, width, height };
+   changeState(RenderState::ScissorRect, memcmp(rect, mScissorRect, sizeof(rect)) != 0);
+   memcpy(mScissorRect, rect, sizeof(rect));
+}
+
+Point HeadlessRenderer::getScissorPos()
+{
+   return Point(mScissorRect[0], mScissorRect[1]);
+}
+
+Point HeadlessRenderer::getScissorSize()
+{
+   return Point(mScissorRect[2], mScissorRect[3]);
+}
+
+void HeadlessRenderer::scale(F32 x, F32 y, F32 z)
+{
+   MatrixStack &stack = getStack(mMatrixMode);
+   stack.top() = stack.top().scale(x, y, z);
+   mStats.matrixOperations++;
+}
+
+void HeadlessRenderer::translate(F32 x, F32 y, F32 z)
+{
+   MatrixStack &stack = getStack(mMatrixMode);
+   stack.top() = stack.top().translate(x, y, z);
+   mStats.matrixOperations++;
+}
+
+void HeadlessRenderer::rotate(F32 degAngle, F32 x, F32 y, F32 z)
+{
+   MatrixStack &stack = getStack(mMatrixMode);
+   stack.top() = stack.top().rotate(degreesToRadians(degAngle), x, y, z);
+   mStats.matrixOperations++;
+}
+
+void HeadlessRenderer::setMatrixMode(MatrixType type)
+{
+   mMatrixMode = type;
+}
+
+void HeadlessRenderer::getMatrix(MatrixType type, F32 *matrix)
+{
+   memcpy(matrix, getStack(type).top().getData(), 16 * sizeof(F32));
+}
+
+void HeadlessRenderer::pushMatrix()
+{
+   MatrixStack &stack = getStack(mMatrixMode);
+   stack.push(stack.top());
+   mStats.matrixOperations++;
+}
+
+void HeadlessRenderer::popMatrix()
+{
+   getStack(mMatrixMode).pop();
+   mStats.matrixOperations++;
+}
+
+void HeadlessRenderer::loadMatrix(const F32 *m)
+{
+   getStack(mMatrixMode).top() = Matrix4(m);
+   mStats.matrixOperations++;
+}
+
+void HeadlessRenderer::loadMatrix(const F64 *m)
+{
+   getStack(mMatrixMode).top() = Matrix4(m);
+   mStats.matrixOperations++;
+}
+
+void HeadlessRenderer::loadIdentity()
+{
+   getStack(mMatrixMode).top() = Matrix4();
+   mStats.matrixOperations++;
+}
+
+void HeadlessRenderer::projectOrtho(F32 left, F32 right, F32 bottom, F32 top, F32 nearZ, F32 farZ)
+{
+   MatrixStack &stack = getStack(mMatrixMode);
+   stack.top() = Matrix4::getOrthoProjection(left, right, bottom, top, nearZ, farZ) * stack.top();
+   mStats.matrixOperations++;
+}
+
+U32 HeadlessRenderer::generateTexture(bool useLinearFiltering)
+{
+   mTextures.push_back(mNextTexture);
+   return mNextTexture++;
+}
+
+void HeadlessRenderer::bindTexture(U32 textureHandle)
+{
+   setState(RenderState::Texture, mBoundTexture, textureHandle);
+}
+
+bool HeadlessRenderer::isTexture(U32 textureHandle)
+{
+   return mTextures.contains(textureHandle);
+}
+
+void HeadlessRenderer::deleteTexture(U32 textureHandle)
+{
+   S32 index = mTextures.getIndex(textureHandle);
+   if(index != -1)
+      mTextures.erase_fast(index);
+
+   if(mBoundTexture == textureHandle)
+      mBoundTexture = 0;
+}
+
+void HeadlessRenderer::setTextureData(TextureFormat format, DataType dataType, U32 width, U32 height, const void *data)
+{
+   setSubTextureData(format, dataType, 0, 0, width, height, data);
+}
+
+void HeadlessRenderer::setSubTextureData(TextureFormat format, DataType dataType, S32 xOffset, S32 yOffset,
+   U32 width, U32 height, const void *data)
+{
+   U32 bytes = getPixelBytes(format, dataType, width, height);
+
+   mStats.textureUploads++;
+   mStats.bytesUploaded += bytes;
+
+   addCommand(RenderCommandType::TextureUpload);
+   if(mRecordCommands)
+      mCommands.last().bytes = bytes;
+}
+
+// There's nothing to read, so everything comes back black
+void HeadlessRenderer::readFramebufferPixels(TextureFormat format, DataType dataType, S32 x, S32 y, S32 width, S32 height, void *data)
+{
+   memset(data, 0, getPixelBytes(format, dataType, width, height));
+   addCommand(RenderCommandType::FramebufferRead);
+}
+
+void HeadlessRenderer::renderVertexArray(const S8 verts[], U32 vertCount, RenderType type,
+   U32 start, U32 stride, U32 vertDimension)
+{
+   draw(type, vertCount, getAttributeBytes(sizeof(S8) * vertDimension, vertCount, stride));
+}
+
+void HeadlessRenderer::renderVertexArray(const S16 verts[], U32 vertCount, RenderType type,
+   U32 start, U32 stride, U32 vertDimension)
+{
+   draw(type, vertCount, getAttributeBytes(sizeof(S16) * vertDimension, vertCount, stride));
+}
+
+void HeadlessRenderer::renderVertexArray(const F32 verts[], U32 vertCount, RenderType type,
+   U32 start, U32 stride, U32 vertDimension)
+{
+   draw(type, vertCount, getAttributeBytes(sizeof(F32) * vertDimension, vertCount, stride));
+}
+
+void HeadlessRenderer::renderColored(const F32 verts[], const F32 colors[], U32 vertCount,
+   RenderType type, U32 start, U32 stride, U32 vertDimension)
+{
+   draw(type, vertCount, getAttributeBytes(sizeof(F32) * vertDimension, vertCount, stride) +
+                         getAttributeBytes(sizeof(F32) * 4, vertCount, stride));
+}
+
+void HeadlessRenderer::renderTextured(const F32 verts[], const F32 UVs[], U32 vertCount,
+   RenderType type, U32 start, U32 stride, U32 vertDimension)
+{
+   draw(type, vertCount, getAttributeBytes(sizeof(F32) * vertDimension, vertCount, stride) +
+                         getAttributeBytes(sizeof(F32) * 2, vertCount, stride));
+}
+
+void HeadlessRenderer::renderColoredTexture(const F32 verts[], const F32 UVs[], U32 vertCount, RenderType type,
+   U32 start, U32 stride, U32 vertDimension, bool isAlphaTexture)
+{
+   draw(type, vertCount, getAttributeBytes(sizeof(F32) * vertDimension, vertCount, stride) +
+                         getAttributeBytes(sizeof(F32) * 2, vertCount, stride));
+}
+
+}
@@ -0,0 +1,218 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _HEADLESSRENDERER_H_
+#define _HEADLESSRENDERER_H_
+
+#include "Renderer.h"
+#include "Matrix4.h"
+#include "Stack.h"
+#include "Point.h"
+#include "tnlVector.h"
+
+namespace Zap
+{
+
+enum class RenderCommandType
+{
+   Clear,
+   StateChange,
+   Draw,
+   TextureUpload,
+   FramebufferRead
+};
+
+// Which bit of state a StateChange command touched
+enum class RenderState
+{
+   None,
+   ClearColor,
+   Color,
+   LineWidth,
+   PointSize,
+   Antialiasing,
+   Blending,
+   BlendFunction,
+   DepthTest,
+   Stencil,
+   StencilTest,
+   StencilDraw,
+   Viewport,
+   Scissor,
+   ScissorRect,
+   Texture
+};
+
+
+struct RenderCommand
+{
+   RenderCommandType type;
+   RenderState state;         // StateChange only
+   RenderType primitive;      // Draw only
+   U32 vertexCount;           // Draw only
+   U32 bytes;                 // Vertex data for a draw (positions, colors and UVs), pixel data for a texture
+   U32 texture;               // Texture bound when the command was issued, 0 for none
+   bool redundant;            // StateChange that set things to the way they already were
+};
+
+
+struct RenderStats
+{
+   U32 drawCalls;
+   U32 vertices;
+   U32 stateChanges;
+   U32 redundantStateChanges;
+   U32 matrixOperations;      // Pushes, pops, loads and transforms
+   U32 textureUploads;
+   U64 bytesUploaded;         // Vertex data plus texture data
+};
+
+
+// Renderer that draws nothing and needs no GPU.  It keeps track of enough state to answer the queries the
+// rest of the game makes (matrices, viewport, scissor), and records every draw call, state change and upload
+// in a command list, so render code can be benchmarked and tested on machines without a display.
+class HeadlessRenderer: public Renderer
+{
+private:
+   using MatrixStack = Stack<Matrix4, 100>;
+
+   enum class BlendFunction
+   {
+      Default,
+      TransparentBlack,
+      SpyBug
+   };
+
+   enum class StencilTest
+   {
+      None,
+      And,
+      Not
+   };
+
+   Vector<RenderCommand> mCommands;
+   RenderStats mStats;
+   bool mRecordCommands;
+
+   MatrixStack mModelViewMatrixStack;
+   MatrixStack mProjectionMatrixStack;
+   MatrixType mMatrixMode;
+
+   F32 mClearColor[4];
+   F32 mColor[4];
+   F32 mLineWidth;
+   F32 mPointSize;
+   bool mAntialiasing;
+   bool mBlending;
+   BlendFunction mBlendFunction;
+   bool mDepthTest;
+   bool mStencil;
+   StencilTest mStencilTest;
+   bool mStencilDraw;
+   bool mScissor;
+   S32 mViewport[4];
+   S32 mScissorRect[4];
+   U32 mBoundTexture;
+   U32 mNextTexture;
+   Vector<U32> mTextures;
+
+   HeadlessRenderer();
+
+   MatrixStack &getStack(MatrixType type);
+   void addCommand(RenderCommandType type, RenderState state = RenderState::None, bool redundant = false);
+   void changeState(RenderState state, bool changed);
+   void draw(RenderType type, U32 vertCount, U32 bytes);
+
+   template<typename T>
+   void setState(RenderState state, T &current, T value);
+
+public:
+   ~HeadlessRenderer() override;
+   static void create();
+
+   const Vector<RenderCommand> &getCommands() const;
+   const RenderStats &getStats() const;
+   void setRecordCommands(bool record);   // Just keep the stats when false, which is quicker
+   void reset();                          // Forget the commands and stats so far, but keep the current state
+
+   void clear() override;
+   void clearStencil() override;
+   void clearDepth() override;
+   void setClearColor(F32 r, F32 g, F32 b, F32 alpha = 1.0f) override;
+   void setColor(F32 r, F32 g, F32 b, F32 alpha = 1.0f) override;
+
+   void setLineWidth(F32 width) override;
+   void setPointSize(F32 size) override;
+   void enableAntialiasing() override;
+   void disableAntialiasing() override;
+   void enableBlending() override;
+   void disableBlending() override;
+   void useTransparentBlackBlending() override;
+   void useSpyBugBlending() override;
+   void useDefaultBlending() override;
+   void enableDepthTest() override;
+   void disableDepthTest() override;
+
+   void enableStencil() override;
+   void disableStencil() override;
+   void useAndStencilTest() override;
+   void useNotStencilTest() override;
+   void enableStencilDrawOnly() override;
+   void disableStencilDraw() override;
+
+   void setViewport(S32 x, S32 y, S32 width, S32 height) override;
+   Point getViewportPos() override;
+   Point getViewportSize() override;
+
+   void enableScissor() override;
+   void disableScissor() override;
+   bool isScissorEnabled() override;
+   void setScissor(S32 x, S32 y, S32 width, S32 height) override;
+   Point getScissorPos() override;
+   Point getScissorSize() override;
+
+   void scale(F32 x, F32 y, F32 z = 1.0f) override;
+   void translate(F32 x, F32 y, F32 z = 0.0f) override;
+   void rotate(F32 degAngle, F32 x, F32 y, F32 z) override;
+
+   void setMatrixMode(MatrixType type) override;
+   void getMatrix(MatrixType type, F32 *matrix) override;
+   void pushMatrix() override;
+   void popMatrix() override;
+   void loadMatrix(const F32 *m) override;
+   void loadMatrix(const F64 *m) override;
+   void loadIdentity() override;
+   void projectOrtho(F32 left, F32 right, F32 bottom, F32 top, F32 nearZ, F32 farZ) override;
+
+   U32 generateTexture(bool useLinearFiltering = true) override;
+   void bindTexture(U32 textureHandle) override;
+   bool isTexture(U32 textureHandle) override;
+   void deleteTexture(U32 textureHandle) override;
+   void setTextureData(TextureFormat format, DataType dataType, U32 width, U32 height, const void *data) override;
+   void setSubTextureData(TextureFormat format, DataType dataType, S32 xOffset, S32 yOffset,
+      U32 width, U32 height, const void *data) override;
+
+   void readFramebufferPixels(TextureFormat format, DataType dataType, S32 x, S32 y, S32 width, S32 height, void *data) override;
+
+   void renderVertexArray(const S8 verts[], U32 vertCount, RenderType type,
+      U32 start = 0, U32 stride = 0, U32 vertDimension = 2) override;
+   void renderVertexArray(const S16 verts[], U32 vertCount, RenderType type,
+      U32 start = 0, U32 stride = 0, U32 vertDimension = 2) override;
+   void renderVertexArray(const F32 verts[], U32 vertCount, RenderType type,
+      U32 start = 0, U32 stride = 0, U32 vertDimension = 2) override;
+
+   void renderColored(const F32 verts[], const F32 colors[], U32 vertCount,
+      RenderType type, U32 start = 0, U32 stride = 0, U32 vertDimension = 2) override;
+
+   void renderTextured(const F32 verts[], const F32 UVs[], U32 vertCount,
+      RenderType type, U32 start = 0, U32 stride = 0, U32 vertDimension = 2) override;
+
+   void renderColoredTexture(const F32 verts[], const F32 UVs[], U32 vertCount, RenderType type,
+      U32 start = 0, U32 stride = 0, U32 vertDimension = 2, bool isAlphaTexture = false) override;
+};
+
+}
+
+#endif // _HEADLESSRENDERER_H_
@@ -0,0 +1,242 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelPreloader.h"
+
+#include "md5wrapper.h"
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+
+#include <fstream>
+
+namespace Zap
+{
+
+// Constructor
+PreloadedLevel::PreloadedLevel()
+{
+   index = -1;
+   fileModTime = 0;
+   fileSize = 0;
+   mesh = NULL;
+}
+
+
+// Destructor
+PreloadedLevel::~PreloadedLevel()
+{
+   delete mesh;
+}
+
+
+void PreloadedLevel::clear()
+{
+   index = -1;
+   filename.clear();
+   contents.clear();
+   hash.clear();
+   fileModTime = 0;
+   fileSize = 0;
+
+   delete mesh;
+   mesh = NULL;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelPreloader::LevelPreloader(const BotZoneMeshCache *cache)
+{
+   mCache = cache;
+   mJobOutstanding = false;
+   mHaveMeshInput = false;
+   mExitNow = false;
+
+#ifdef TNL_NO_THREADS
+   mThreaded = false;      // Thread::start() would run our worker loop here, and never return
+#else
+   mThreaded = start();
+   if(!mThreaded)
+      logprintf(LogConsumer::LogWarning, "Failed to create thread for level preloading; levels will be loaded when they're needed");
+#endif
+}
+
+
+// Destructor
+LevelPreloader::~LevelPreloader()
+{
+   if(!mThreaded)
+      return;
+
+   finishJob();
+
+   mExitNow.store(true);
+   mJobReady.increment();
+   mWorkerDone.wait();
+}
+
+
+// Remember what the level in filename looked like the last time it was loaded, so we can mesh it ahead of time next time
+void LevelPreloader::rememberMeshInput(const string &filename, const string &hash, const BotZoneMeshInput &input)
+{
+   if(filename == "" || hash == "")
+      return;
+
+   MeshInputRecord &record = mMeshInputs[filename];
+   record.hash = hash;
+   record.input = input;
+}
+
+
+void LevelPreloader::finishJob()
+{
+   if(!mJobOutstanding)
+      return;
+
+   mJobDone.wait();
+   mJobOutstanding = false;
+}
+
+
+// Start reading the level at index, which lives in filename, in the background.  Forgets about anything preloaded earlier.
+void LevelPreloader::preload(S32 index, const string &filename)
+{
+   if(!mThreaded || filename == "")
+      return;
+
+   // Already on it?
+   if(mJobOutstanding && mJob.index == index && mJob.filename == filename)
+      return;
+
+   finishJob();
+   mJob.clear();
+
+   mJob.index = index;
+   mJob.filename = filename;
+
+   map<string, MeshInputRecord>::iterator it = mMeshInputs.find(filename);
+   mHaveMeshInput = (it != mMeshInputs.end());
+
+   if(mHaveMeshInput)
+   {
+      mMeshInput = it->second.input;
+      mMeshInputHash = it->second.hash;
+   }
+
+   mJobOutstanding = true;
+   mJobReady.increment();
+}
+
+
+// If the level at index was preloaded from filename, hands it over and returns true.  If the worker is still busy with
+// it, waits for it to finish, which will be no slower than loading the level ourselves.  Levels are preloaded a whole
+// game ahead, so if the file has been replaced since (by an upload, say), we return false and let it be loaded afresh.
+bool LevelPreloader::takeLevel(S32 index, const string &filename, PreloadedLevel &level)
+{
+   level.clear();
+
+   if(!mJobOutstanding || mJob.index != index || mJob.filename != filename || filename == "")
+      return false;
+
+   finishJob();
+
+   S64 modTime, size;
+
+   if(!getFileStats(filename, modTime, size) || modTime != mJob.fileModTime || size != mJob.fileSize)
+   {
+      mJob.clear();
+      return false;
+   }
+
+   level.index = mJob.index;
+   level.filename.swap(mJob.filename);
+   level.contents.swap(mJob.contents);
+   level.hash.swap(mJob.hash);
+   level.fileModTime = mJob.fileModTime;
+   level.fileSize = mJob.fileSize;
+   level.mesh = mJob.mesh;
+
+   mJob.mesh = NULL;
+   mJob.clear();
+
+   return level.hash != "";
+}
+
+
+// Worker thread
+void LevelPreloader::doJob()
+{
+   // Before reading, so anything written while we're reading counts as a change
+   if(!getFileStats(mJob.filename, mJob.fileModTime, mJob.fileSize))
+      return;
+
+   ifstream file(mJob.filename.c_str(), ios_base::in | ios_base::binary);
+
+   if(!file.is_open())
+      return;
+
+   file.seekg(0, ios::end);
+   mJob.contents.resize((string::size_type)file.tellg());
+   file.seekg(0, ios::beg);
+
+   file.read(&mJob.contents[0], mJob.contents.size());
+   file.close();
+
+   if(mJob.contents == "")
+      return;
+
+   // Hash the file as it is on disk, then clean it up the way readFile() would
+   md5wrapper md5;
+   mJob.hash = md5.getHashFromString(mJob.contents);
+   trim_left_in_place(mJob.contents, "\357\273\277");    // UTF-8 BOM
+
+   // We know what the level looks like if we saw it earlier, and the file hasn't changed since
+   bool knowInput = mHaveMeshInput && mMeshInputHash == mJob.hash;
+   string inputHash = knowInput ? mMeshInput.getHash() : "";
+
+   mJob.mesh = new BotZoneMesh;
+
+   // Any cached mesh will do if we don't know what the level looks like; the game will check it
+   if(mCache && mCache->load(mJob.hash, *mJob.mesh) && (!knowInput || mJob.mesh->inputHash == inputHash))
+      return;
+
+   string error;
+
+   if(knowInput && BotNavMeshZone::buildMesh(mMeshInput, *mJob.mesh, error))
+   {
+      if(mCache)
+         mCache->save(mJob.hash, *mJob.mesh);
+
+      return;
+   }
+
+   // If meshing failed, the game will have another go itself, and report the problem
+   delete mJob.mesh;
+   mJob.mesh = NULL;
+}
+
+
+U32 LevelPreloader::run()
+{
+   for(;;)
+   {
+      mJobReady.wait();
+
+      if(mExitNow.load())
+         break;
+
+      doJob();
+      mJobDone.increment();
+   }
+
+   mWorkerDone.increment();
+   return 0;
+}
+
+
+}
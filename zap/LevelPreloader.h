@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LEVEL_PRELOADER_H_
+#define _LEVEL_PRELOADER_H_
+
+#include "BotNavMeshZone.h"
+#include "BotZoneMeshCache.h"
+
+#include "tnlThread.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+
+using namespace std;
+using namespace TNL;
+
+namespace Zap
+{
+
+// What the preloader knows about a level before the game gets to it
+struct PreloadedLevel
+{
+   S32 index;
+   string filename;              // Full path
+   string contents;              // Level code, ready for Game::loadLevelFromString()
+   string hash;                  // Of the file, as LevelSource::loadLevel() would report it; empty if it couldn't be read
+   S64 fileModTime;              // When the file was read, so we can tell if it has been replaced since
+   S64 fileSize;
+   BotZoneMesh *mesh;            // NULL unless we found it in the cache, or knew the level's geometry and meshed it
+
+   PreloadedLevel();             // Constructor
+   ~PreloadedLevel();            // Destructor
+
+   PreloadedLevel(const PreloadedLevel &) = delete;               // We own mesh
+   PreloadedLevel &operator=(const PreloadedLevel &) = delete;
+
+   void clear();
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Reads, hashes and meshes the next level on a worker thread while the current one is being played, so that
+// switching levels doesn't have to wait for the disk or for Clipper and Recast.
+//
+// A level's geometry isn't known until the game has loaded it (levelgens and all), so meshing can only be done
+// ahead of time for levels that have been played before.  The game tells us what each level it loads looks like
+// with rememberMeshInput(); failing that, we take whatever mesh the cache has for the level.  Either way, the game
+// checks the mesh's inputHash against what it actually loaded before using it.
+class LevelPreloader : public Thread
+{
+private:
+   struct MeshInputRecord
+   {
+      string hash;               // File the geometry came from; meshing is only worth doing if the file hasn't changed
+      BotZoneMeshInput input;
+   };
+
+   map<string, MeshInputRecord> mMeshInputs;    // By filename; game thread only
+   const BotZoneMeshCache *mCache;              // Can be NULL
+
+   bool mThreaded;               // False if we couldn't start a thread, and aren't preloading anything
+   bool mJobOutstanding;         // A job was started whose mJobDone hasn't been consumed yet; game thread only
+   atomic<bool> mExitNow;
+
+   TNL::Semaphore mJobReady;
+   TNL::Semaphore mJobDone;
+   TNL::Semaphore mWorkerDone;
+
+   // The job.  Belongs to the game thread until mJobReady is signalled, then to the worker until mJobDone is.
+   PreloadedLevel mJob;
+   bool mHaveMeshInput;
+   string mMeshInputHash;        // Hash of the file mMeshInput came from
+   BotZoneMeshInput mMeshInput;
+
+   void finishJob();             // Waits for any job in progress
+   void doJob();
+
+   friend class LevelPreloaderTest;
+
+public:
+   explicit LevelPreloader(const BotZoneMeshCache *cache);     // Constructor
+   virtual ~LevelPreloader();    // Destructor
+
+   void rememberMeshInput(const string &filename, const string &hash, const BotZoneMeshInput &input);
+
+   void preload(S32 index, const string &filename);
+   bool takeLevel(S32 index, const string &filename, PreloadedLevel &level);
+
+   U32 run();
+};
+
+}
+
+#endif
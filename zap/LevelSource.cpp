@@ -225,6 +225,15 @@ string LevelSource::getLevelFileName(S32 index)
    else
       return mLevelInfos[index].filename;
 }
+
+
+// Level code that doesn't come from a file has no path to offer
+string LevelSource::findLevelFile(S32 index) const
+{
+   return "";
+}
+
+
 void LevelSource::setLevelFileName(S32 index, const string &filename)
 {
    mLevelInfos[index].filename = filename;
@@ -317,13 +326,11 @@ string MultiLevelSource::loadLevel(S32 index, Game *game, GridDatabase *gameObje
 {
    TNLAssert(index >= 0 && index < mLevelInfos.size(), "Index out of bounds!");
 
-   LevelInfo *levelInfo = &mLevelInfos[index];
-
-   string filename = FolderManager::findLevelFile(levelInfo->folder, levelInfo->filename);
+   string filename = findLevelFile(index);
 
    if(filename == "")
    {
-      logprintf("Unable to find level file \"%s\".  Skipping...", levelInfo->filename.c_str());
+      logprintf("Unable to find level file \"%s\".  Skipping...", mLevelInfos[index].filename.c_str());
       return "";
    }
 
@@ -331,12 +338,18 @@ string MultiLevelSource::loadLevel(S32 index, Game *game, GridDatabase *gameObje
       return Game::md5.getHashFromFile(filename);    // TODO: Combine this with the reading of the file we're doing anyway in initLevelFromFile()
    else
    {
-      logprintf("Unable to process level file \"%s\".  Skipping...", levelInfo->filename.c_str());
+      logprintf("Unable to process level file \"%s\".  Skipping...", mLevelInfos[index].filename.c_str());
       return "";
    }
 }
 
 
+string MultiLevelSource::findLevelFile(S32 index) const
+{
+   return FolderManager::findLevelFile(mLevelInfos[index].folder, mLevelInfos[index].filename);
+}
+
+
 // Returns a textual level descriptor good for logging and error messages and such
 string MultiLevelSource::getLevelFileDescriptor(S32 index) const
 {
@@ -395,6 +408,12 @@ FolderLevelSource::~FolderLevelSource()
 }
 
 
+LevelSource *FolderLevelSource::clone() const
+{
+   return new FolderLevelSource(*this);
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -413,28 +432,16 @@ FileListLevelSource::~FileListLevelSource()
 }
 
 
-// Load specified level, put results in gameObjectDatabase.  Return md5 hash of level.
-string FileListLevelSource::loadLevel(S32 index, Game *game, GridDatabase *gameObjectDatabase)
+LevelSource *FileListLevelSource::clone() const
 {
-   TNLAssert(index >= 0 && index < mLevelInfos.size(), "Index out of bounds!");
-
-   LevelInfo *levelInfo = &mLevelInfos[index];
+   return new FileListLevelSource(*this);
+}
 
-   string filename = FolderManager::findLevelFile(GameSettings::getFolderManager()->levelDir, levelInfo->filename);
 
-   if(filename == "")
-   {
-      logprintf("Unable to find level file \"%s\".  Skipping...", levelInfo->filename.c_str());
-      return "";
-   }
-
-   if(game->loadLevelFromFile(filename, gameObjectDatabase))
-      return Game::md5.getHashFromFile(filename);   
-   else
-   {
-      logprintf("Unable to process level file \"%s\".  Skipping...", levelInfo->filename.c_str());
-      return "";
-   }
+// Load specified level, put results in gameObjectDatabase.  Return md5 hash of level.
+string FileListLevelSource::findLevelFile(S32 index) const
+{
+   return FolderManager::findLevelFile(GameSettings::getFolderManager()->levelDir, mLevelInfos[index].filename);
 }
 
 
@@ -516,4 +523,10 @@ bool StringLevelSource::isEmptyLevelDirOk() const
 }
 
 
+LevelSource *StringLevelSource::clone() const
+{
+   return new StringLevelSource(*this);
+}
+
+
 }
@@ -86,9 +86,11 @@ public:
 
    virtual bool populateLevelInfoFromSource(const string &fullFilename, LevelInfo &levelInfo) = 0;
    virtual string loadLevel(S32 index, Game *game, GridDatabase *gameObjDatabase) = 0;
+   virtual string findLevelFile(S32 index) const;      // Full path to the level's file, or "" if it doesn't come from one
    virtual bool loadLevels(FolderManager *folderManager);
    virtual string getLevelFileDescriptor(S32 index) const = 0;
    virtual bool isEmptyLevelDirOk() const = 0;
+   virtual LevelSource *clone() const = 0;      // Copies the level list as it stands, so it can be changed separately
 
    bool populateLevelInfoFromSource(const string &sourceName, S32 levelInfoIndex);
 
@@ -111,6 +113,7 @@ public:
 
    bool loadLevels(FolderManager *folderManager);
    string loadLevel(S32 index, Game *game, GridDatabase *gameObjDatabase);
+   string findLevelFile(S32 index) const;
    string getLevelFileDescriptor(S32 index) const;
    bool isEmptyLevelDirOk() const;
 
@@ -129,6 +132,8 @@ class FolderLevelSource : public MultiLevelSource
 public:
    FolderLevelSource(const Vector<string> &levelList, const string &folder);  // Constructor
    virtual ~FolderLevelSource();                                              // Destructor
+
+   LevelSource *clone() const;
 };
 
 
@@ -148,7 +153,8 @@ public:
    FileListLevelSource(const Vector<string> &levelList, const string &folder);     // Constructor
    virtual ~FileListLevelSource();                                                                                                                // Destructor
 
-   string loadLevel(S32 index, Game *game, GridDatabase *gameObjDatabase);
+   string findLevelFile(S32 index) const;
+   LevelSource *clone() const;
 
    static Vector<string> findAllFilesInPlaylist(const string &fileName, const string &levelDir);
 };
@@ -173,6 +179,7 @@ public:
    string loadLevel(S32 index, Game *game, GridDatabase *gameObjDatabase);
    string getLevelFileDescriptor(S32 index) const;
    bool isEmptyLevelDirOk() const;
+   LevelSource *clone() const;
 
    bool populateLevelInfoFromSource(const string &fullFilename, LevelInfo &levelInfo);
 };
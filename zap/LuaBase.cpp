@@ -712,6 +712,20 @@ S32 luaTableCopy(lua_State *L)
 }
 
 
+/**
+ * [ -0, +0 ]
+ * Clears out the array part of the table at index after its first length items.
+ */
+void luaTableTruncate(lua_State *L, S32 index, S32 length)
+{
+   for(S32 i = (S32)lua_objlen(L, index); i > length; i--)
+   {
+      lua_pushnil(L);
+      lua_rawseti(L, index, i);
+   }
+}
+
+
 void luaPushPoint(lua_State *L, F32 x, F32 y)
 {
    // The luavec.lua script should already be loaded and have the 'point'
@@ -995,11 +1009,14 @@ string prettyPrintParamList(const LuaFunctionArgList &functionArgList)
 }
 
 
-#define SCRIPT_CONTEXT_KEY "running_script_context"
+// Kept in the registry under this variable's address, which is quicker to look up than a string; every object pushed
+// onto the stack needs it
+static char scriptContextKey;
 
 ScriptContext getScriptContext(lua_State *L)
 {
-   lua_getfield(L, LUA_REGISTRYINDEX, SCRIPT_CONTEXT_KEY);
+   lua_pushlightuserdata(L, &scriptContextKey);
+   lua_rawget(L, LUA_REGISTRYINDEX);
    S32 context = S32(lua_tointeger(L, -1));
    lua_pop(L, 1);    // Remove the value we just added from the stack
 
@@ -1013,8 +1030,9 @@ ScriptContext getScriptContext(lua_State *L)
 
 void setScriptContext(lua_State *L, ScriptContext context)
 {
+   lua_pushlightuserdata(L, &scriptContextKey);
    lua_pushinteger(L, context);
-   lua_setfield(L, LUA_REGISTRYINDEX, SCRIPT_CONTEXT_KEY);     // Pops the int we just pushed from the stack
+   lua_rawset(L, LUA_REGISTRYINDEX);     // Pops the key and int we just pushed from the stack
 }
 
 };
@@ -188,6 +188,7 @@ const char *getCheckedString(lua_State *L, S32 index, const char *methodName);
 const char *getString(lua_State *L, S32 index, const char *defaultVal);
 
 S32 luaTableCopy(lua_State *L);
+void luaTableTruncate(lua_State *L, S32 index, S32 length);
 
 void luaPushPoint(lua_State *L, F32 x, F32 y);
 void luaPushPoint(lua_State *L, const Point &pt);
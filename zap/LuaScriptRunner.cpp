@@ -24,10 +24,15 @@
 
 #include <clipper.hpp>
 
+extern "C" {
+#include <luajit.h>            // For luaJIT_setmode
+}
+
 #include "tnlLog.h"            // For logprintf
 #include "tnlRandom.h"
 
 #include <iostream>            // For enum code
+#include <map>
 #include <sstream>             // For enum code
 #include <string>
 
@@ -39,10 +44,20 @@ namespace Zap
 ////////////////////////////////////////
 
 // Declare and Initialize statics:
-lua_State *LuaScriptRunner::L = NULL;
-string LuaScriptRunner::mScriptingDir;
+TNL_THREAD_LOCAL lua_State *LuaScriptRunner::L = NULL;
+thread_local string LuaScriptRunner::mScriptingDir;
+
+thread_local deque<string> LuaScriptRunner::mCachedScripts;
 
-deque<string> LuaScriptRunner::mCachedScripts;
+TNL_THREAD_LOCAL U32 LuaScriptRunner::mInstructionBudget = 0;
+TNL_THREAD_LOCAL LuaScriptRunner *LuaScriptRunner::mRunningScript = NULL;
+TNL_THREAD_LOCAL bool LuaScriptRunner::mEnforcingBudget = false;
+
+thread_local Vector<LuaScriptRunner *> LuaScriptRunner::mIsolatedScripts;
+TNL_THREAD_LOCAL WorkerPool *LuaScriptRunner::mScriptThreadPool = NULL;
+TNL_THREAD_LOCAL LuaScriptRunner *LuaScriptRunner::mParallelScript = NULL;
+
+static const S32 HookInterval = 1000;     // Instructions between calls to the count hook, while there's a budget
 
 void LuaScriptRunner::clearScriptCache()
 {
@@ -54,6 +69,35 @@ void LuaScriptRunner::clearScriptCache()
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+ScriptStats::ScriptStats()
+{
+   clear();
+}
+
+
+void ScriptStats::clear()
+{
+   calls = 0;
+   time = 0;
+   instructions = 0;
+   overruns = 0;
+   skippedEvents = 0;
+}
+
+
+F64 ScriptStats::getMilliseconds() const
+{
+   return Platform::getHighPrecisionMilliseconds(time);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
 // Constructor
 LuaScriptRunner::LuaScriptRunner()
 {
@@ -61,7 +105,7 @@ LuaScriptRunner::LuaScriptRunner()
    mLuaGame = NULL;
    mLuaGridDatabase = NULL;
 
-   static U32 mNextScriptId = 0;
+   static TNL_THREAD_LOCAL U32 mNextScriptId = 0;
 
    // Initialize all subscriptions to unsubscribed -- bits will automatically subscribe to onTick later
    for(S32 i = 0; i < EventManager::EventTypes; i++)
@@ -70,6 +114,22 @@ LuaScriptRunner::LuaScriptRunner()
    mScriptId = "script" + itos(mNextScriptId++);
    mScriptType = ScriptTypeInvalid;
 
+   mBudgetTick = 0;
+   mTickInstructions = 0;
+   mPreempted = false;
+   mDeferredTickTime = 0;
+   mDeferredTimerTime = 0;
+
+   mIsolatedL = NULL;
+   mParallelThread = NULL;
+   mParallelThreadRef = LUA_NOREF;
+   mParallelFunction = NULL;
+   mParallelCmdPending = false;
+   mParallelStatus = 0;
+   mParallelResumeArgs = 0;
+   mMainThreadCall = NULL;
+   mSelfUserdata = NULL;
+
    LUAW_CONSTRUCTOR_INITIALIZATIONS;
 }
 
@@ -86,8 +146,14 @@ LuaScriptRunner::~LuaScriptRunner()
    // Clean-up any game objects that were added in Lua with '.new()' but not added
    // with bf:addItem()
 
-   // And delete the script's environment table from the Lua instance
-   deleteScript(getScriptId());
+   // And delete the script's environment table from the Lua instance; an isolated script takes its instance with it
+   if(mIsolatedL)
+   {
+      mIsolatedScripts.erase(mIsolatedScripts.getIndex(this));
+      lua_close(mIsolatedL);
+   }
+   else
+      deleteScript(getScriptId());
 
    LUAW_DESTRUCTOR_CLEANUP;
 }
@@ -105,6 +171,8 @@ lua_State *LuaScriptRunner::getL()
 
 void LuaScriptRunner::shutdown()
 {
+   setScriptThreadCount(0);
+
    if(L)
    {
       lua_close(L);
@@ -113,6 +181,45 @@ void LuaScriptRunner::shutdown()
 }
 
 
+lua_State *LuaScriptRunner::getLuaState()
+{
+   return mIsolatedL ? mIsolatedL : L;
+}
+
+
+bool LuaScriptRunner::isIsolated()
+{
+   return mIsolatedL != NULL;
+}
+
+
+// Isolated scripts get an interpreter of their own, configured just like L.  Returns false if one couldn't be made, in
+// which case the script will share L, as usual.
+bool LuaScriptRunner::createIsolatedState()
+{
+   TNLAssert(!mIsolatedL, "Already isolated!");
+
+   lua_State *state = lua_open();
+
+   if(!state)
+      return false;
+
+   if(!configureNewLuaInstance(state))
+   {
+      lua_close(state);
+      return false;
+   }
+
+   if(mInstructionBudget > 0)
+      applyInstructionBudget(state);
+
+   mIsolatedL = state;
+   mIsolatedScripts.push_back(this);
+
+   return true;
+}
+
+
 const char *LuaScriptRunner::getScriptId()
 {
    return mScriptId.c_str();
@@ -130,7 +237,9 @@ bool LuaScriptRunner::runScript(bool cacheScript)
 // Sets the environment for the function on the top of the stack to that associated with name
 // Starts with a function on the stack
 void LuaScriptRunner::setEnvironment()
-{                                    
+{
+   lua_State *L = getLuaState();
+                                    
    // Grab the script's environment table from the registry, place it on the stack
    lua_getfield(L, LUA_REGISTRYINDEX, getScriptId());    // Push REGISTRY[scriptId] onto stack           -- function, table
    lua_setfenv(L, -2);                                   // Set that table to be the env for function    -- function
@@ -187,6 +296,8 @@ bool LuaScriptRunner::loadAndRunGlobalFunction(lua_State *L, const char *key, Sc
 // This function can safely throw errors.
 void LuaScriptRunner::pushStackTracer()
 {
+   lua_State *L = getLuaState();
+
    // _stackTracer is a function included in lua_helper_functions that manages the stack trace; it should ALWAYS be present.
    if(!loadFunction(L, getScriptId(), "_stackTracer"))
    {
@@ -200,8 +311,10 @@ void LuaScriptRunner::pushStackTracer()
 // Use this method to load an external script directly into the currently running script's
 // environment.  This loaded script will be cleared when the parent script terminates
 bool LuaScriptRunner::loadCompileRunEnvironmentScript(const string &scriptName) {
+   lua_State *L = getLuaState();
+
    // The timer is loaded in each script
-   loadCompileScript(joindir(mScriptingDir, scriptName).c_str());
+   loadCompileScript(L, joindir(mScriptingDir, scriptName).c_str());
    setEnvironment();
 
    S32 err = lua_pcall(L, 0, 0, 0);
@@ -226,6 +339,8 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
    if(mScriptName == "")
       return true;
 
+   lua_State *L = getLuaState();
+
    static const S32 MAX_CACHE_SIZE = 16;
 
    // On a dedicated server, we'll always cache our scripts; on a regular server, we'll cache script except when the user is testing
@@ -238,8 +353,8 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
    {
       pushStackTracer();            // -- _stackTracer
 
-      if(!cacheScript)
-         loadCompileScript(mScriptName.c_str());
+      if(!cacheScript || mIsolatedL)       // Isolated scripts have nobody to share the cache with
+         loadCompileScript(L, mScriptName.c_str());
       else  
       {
          bool found = false;
@@ -264,7 +379,7 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
             }
 
             // Load new script into cache using full name as registry key
-            loadCompileSaveScript(mScriptName.c_str(), mScriptName.c_str());
+            loadCompileSaveScript(L, mScriptName.c_str(), mScriptName.c_str());
             mCachedScripts.push_back(mScriptName);
          }
 
@@ -306,6 +421,8 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
 // Returns true if string ran successfully
 bool LuaScriptRunner::runString(const string &code)
 {
+   lua_State *L = getLuaState();
+
    luaL_loadstring(L, code.c_str());
    setEnvironment();
    return !lua_pcall(L, 0, 0, 0);      // lua_pcall returns 0 in case of success
@@ -324,6 +441,8 @@ bool LuaScriptRunner::runMain()
 // Returns false if there was an error
 bool LuaScriptRunner::runMain(const Vector<string> &args)
 {
+   lua_State *L = getLuaState();
+
    if(mScriptName == "")
       return true;
 
@@ -370,19 +489,33 @@ void improveErrorMessages_global(string &msg, const string &startStr)
    string var = msg.substr(start, end - start);    // var is the problematic variable (abc in the sample above)
 
    size_t insertPos = msg.find("Stack Traceback", end);
-   if(end == string::npos)          // Not found
-      return;
+   if(insertPos == string::npos)    // No traceback (yet), so the note goes at the end
+      insertPos = msg.length();
 
    msg.insert(insertPos, ">>> This error could mean that '" + var + 
                          "' has a value of nil or that it has not been defined.\r\n");
 }
 
 
-// Returns true if there was an error, false if everything ran ok
-bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValueCount)
+// Returns true if there was an error, false if everything ran ok.
+// Budgeted calls are stopped if the script runs through its instruction budget for the tick; that isn't an error, and
+// the script carries on next tick, just as if the function had returned.
+bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValueCount, bool budgeted)
 {
+   lua_State *L = getLuaState();
    S32 stackDepth = lua_gettop(L);
 
+   // We may have been called by another script (via sendData(), for example); it gets billed again when we're done
+   LuaScriptRunner *caller = mRunningScript;
+   bool callerBudgeted = mEnforcingBudget;
+
+   startBudgetTick();
+   mRunningScript = this;
+   mEnforcingBudget = budgeted && mLuaGame != NULL;   // Budgets are per game tick, so scripts outside a game don't have one
+   mPreempted = false;
+
+   S64 startTime = Platform::getHighPrecisionTimerValue();
+
    // argCount args are already on the stack... we'll refer to these as collectively as <<args>>
    pushStackTracer();                                       // -- <<whatever>>, <<args>>, _stackTracer
 
@@ -395,7 +528,7 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
       if(argCount > 0)
       {
          // top should be 1 in all cases except for sendData() where we duplicate stack args, 
-         // in which it should be argCount + 1
+         // in which it should be argCount + 1 (or 1 again, if the data was copied from another lua_State)
          // top = # items on stack - 2 [_stackTracer and function we want to run] - argCount + 1 [top of stack is 1 not 0]
          S32 top = lua_gettop(L) - 2 - argCount + 1;
 
@@ -407,7 +540,7 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
          // we never copy them into C++ land; we just duplicate them from the stack as needed.  For other
          // functions, we have the arguments in C++, so we can just push them onto the stack multiple times
          // for firing an event for multiple listeners.
-         TNLAssert((!strcmp(function, "onDataReceived") && top == (argCount + 1)) || (strcmp(function, "onDataReceived") && top == 1), \
+         TNLAssert((!strcmp(function, "onDataReceived") && (top == (argCount + 1) || top == 1)) || (strcmp(function, "onDataReceived") && top == 1), \
             "Unexpected number of items on stack!");
          lua_insert(L, top);                                // -- <<whatever>>, function, <<args>>, _stackTracer
          lua_insert(L, top);                                // -- <<whatever>>, _stackTracer, function, <<args>>
@@ -426,6 +559,34 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
    else
       error = -1;
 
+   mScriptStats.calls++;
+   mScriptStats.time += Platform::getHighPrecisionTimerValue() - startTime;
+
+   mRunningScript = caller;
+   mEnforcingBudget = callerBudgeted;
+
+   if(mPreempted)
+   {
+      lua_sethook(L, countHook, LUA_MASKCOUNT, HookInterval);     // countHook() checked every instruction after stopping us
+
+      mScriptStats.overruns++;
+      if(mScriptStats.overruns == 1)
+         logprintf(LogConsumer::LogWarning, "%s\nScript %s used up its budget of %d instructions in %s(); "
+                   "it will be stopped whenever it does that", getErrorMessagePrefix(), mScriptName.c_str(),
+                   mInstructionBudget, function);
+
+      // Scripts can catch the error with pcall(), so they may finish normally; if not, make it look like they did
+      if(error)
+      {
+         lua_settop(L, stackDepth - argCount);     // Remove <<args>> and other cruft     -- <<whatever>>
+
+         for(S32 i = 0; i < returnValueCount; i++)
+            lua_pushnil(L);                        //                                     -- <<whatever>>, nil...
+
+         return false;
+      }
+   }
+
    if(!error)
    {
       lua_remove(L, -1 - returnValueCount);    // Remove _stackTracer           // -- <<whatever>>, <<return values>>
@@ -473,6 +634,562 @@ bool LuaScriptRunner::runCmd(const char* function, S32 argCount, S32 returnValue
 }
 
 
+// Bills the running script for the instructions it's run, and stops it if it's used up its budget
+void LuaScriptRunner::countHook(lua_State *L, lua_Debug *ar)
+{
+   LuaScriptRunner *script = mRunningScript;
+
+   if(!script)
+      return;
+
+   S32 instructions = lua_gethookcount(L);
+   script->mTickInstructions += instructions;
+   script->mScriptStats.instructions += instructions;
+
+   if(mEnforcingBudget && script->mTickInstructions >= mInstructionBudget)
+   {
+      script->mPreempted = true;
+
+      // If the script catches this with pcall(), we'll be back at its next instruction to raise it again
+      lua_sethook(L, countHook, LUA_MASKCOUNT, 1);
+      luaL_error(L, "Script used up its budget of %d instructions for this tick", mInstructionBudget);
+   }
+}
+
+
+// Budgets are per game tick; the first call in a new tick starts the script's count over
+void LuaScriptRunner::startBudgetTick()
+{
+   if(!mLuaGame)
+      return;
+
+   U32 tick = mLuaGame->getCurrentTime();
+
+   if(tick != mBudgetTick)
+   {
+      mBudgetTick = tick;
+      mTickInstructions = 0;
+   }
+}
+
+
+void LuaScriptRunner::setInstructionBudget(U32 budget)
+{
+   if(budget == mInstructionBudget)
+      return;
+
+   mInstructionBudget = budget;
+   applyInstructionBudget(L);
+
+   for(S32 i = 0; i < mIsolatedScripts.size(); i++)
+      applyInstructionBudget(mIsolatedScripts[i]->mIsolatedL);
+}
+
+
+U32 LuaScriptRunner::getInstructionBudget()
+{
+   return mInstructionBudget;
+}
+
+
+// LuaJIT doesn't call hooks from compiled code, so counting instructions means running everything in the interpreter
+void LuaScriptRunner::applyInstructionBudget(lua_State *L)
+{
+   if(!L)
+      return;        // startLua() will get here when the time comes
+
+   if(mInstructionBudget > 0)
+   {
+      luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_FLUSH);
+      luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+      lua_sethook(L, countHook, LUA_MASKCOUNT, HookInterval);
+   }
+   else
+   {
+      lua_sethook(L, NULL, 0, 0);
+      luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
+   }
+}
+
+
+bool LuaScriptRunner::isOverBudget()
+{
+   if(mInstructionBudget == 0 || !mLuaGame)
+      return false;
+
+   startBudgetTick();
+   return mTickInstructions >= mInstructionBudget;
+}
+
+
+void LuaScriptRunner::skipEvent()
+{
+   mScriptStats.skippedEvents++;
+}
+
+
+void LuaScriptRunner::deferTickTime(U32 deltaT)
+{
+   mDeferredTickTime += deltaT;
+   skipEvent();
+}
+
+
+U32 LuaScriptRunner::takeDeferredTickTime()
+{
+   U32 deltaT = mDeferredTickTime;
+   mDeferredTickTime = 0;
+   return deltaT;
+}
+
+
+const ScriptStats &LuaScriptRunner::getScriptStats() const
+{
+   return mScriptStats;
+}
+
+
+void LuaScriptRunner::resetScriptStats()
+{
+   mScriptStats.clear();
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+// Running isolated scripts in parallel
+//
+// Isolated scripts each have a lua_State of their own, so several can run at once on the worker threads, as long as
+// they only read the world, which nothing changes while they run.  Anything else is passed back to the main thread:
+// the script yields, and the main thread runs the call between rounds of parallel running, then resumes the script with
+// the results.  Changes to the script's own object (see Robot::queueActions()) are held back until the end of the
+// round, and applied in the same order every time, so they can run in parallel too.
+
+// How a function may be used by a script running in parallel
+enum ParallelSafety
+{
+   ParallelReadOnly,    // Only reads the world
+   ParallelOwnObject,   // Changes nothing but the object it's called on, and queues that; only safe on the script's own object
+};
+
+struct ParallelSafeFunctions
+{
+   const char *className;     // Or module, for loose functions
+   const char *functions;     // Space separated
+   ParallelSafety safety;
+};
+
+// Anything not listed here runs on the main thread.  Careful: some innocent looking getters create things on demand.
+static const ParallelSafeFunctions parallelSafeMethods[] = {
+   { "BfObject",        "getObjType getId getPos getTeamIndex getGeom",                                       ParallelReadOnly  },
+   { "CoreItem",        "getCurrentHealth getFullHealth getRotationSpeed",                                    ParallelReadOnly  },
+   { "EngineeredItem",  "isActive getMountAngle getHealth getDisabledThreshold getHealRate getEngineered "
+                        "getAimAngle",                                                                        ParallelReadOnly  },
+   { "LuaScriptRunner", "pointCanSeePoint findObjectById findAllObjects findAllObjectsInArea",                ParallelReadOnly  },
+   { "GameInfo",        "getGameType getGameTypeName getFlagCount getWinningScore getGameTimeTotal "
+                        "getGameTimeRemaining getLeadingScore getLeadingTeam getTeamCount getLevelName "
+                        "isTeamGame getEventScore isNexusOpen getNexusTimeLeft getTeam",                      ParallelReadOnly  },
+   { "PlayerInfo",      "getName getTeamIndex getRating getScore isRobot getScriptName",                      ParallelReadOnly  },
+   { "Team",            "getIndex getName getScore getColor",                                                 ParallelReadOnly  },
+   { "Item",            "getRad getShip isInCaptureZone getCaptureZone",                                      ParallelReadOnly  },
+   { "MoveObject",      "getVel getAngle getShip isOnShip getSizeIndex getSizeCount",                         ParallelReadOnly  },
+   { "Projectile",      "getRad getWeapon getVel",                                                            ParallelReadOnly  },
+   { "Ship",            "isAlive isModActive getEnergy getHealth hasFlag getFlagCount getAngle "
+                        "getActiveWeapon getMountedItems getLoadout",                                         ParallelReadOnly  },
+   { "Robot",           "getAnglePt canSeePoint hasWeapon hasModule findVisibleObjects findClosestEnemy "
+                        "getFiringSolution getInterceptCourse",                                               ParallelReadOnly  },
+   { "Robot",           "setAngle setThrust setThrustToPt fireWeapon fireModule globalMsg teamMsg privateMsg", ParallelOwnObject },
+   { "Zone",            "containsPoint",                                                                      ParallelReadOnly  },
+   { "GoalZone",        "hasFlag",                                                                            ParallelReadOnly  },
+   { "FlagItem",        "isInInitLoc getFlagCount",                                                           ParallelReadOnly  },
+   { "NexusZone",       "isOpen",                                                                             ParallelReadOnly  },
+   { "SlipZone",        "getSlipFactor",                                                                      ParallelReadOnly  },
+   { "SpeedZone",       "getDir getSpeed getSnapping",                                                        ParallelReadOnly  },
+   { "TextItem",        "getText",                                                                            ParallelReadOnly  },
+   { "Teleporter",      "getDest getDestCount getEngineered getDelay",                                        ParallelReadOnly  },
+   { "PickupItem",      "isVis getRegenTime",                                                                 ParallelReadOnly  },
+   { "Spawn",           "getSpawnTime",                                                                       ParallelReadOnly  },
+   { "WallItem",        "getWidth",                                                                           ParallelReadOnly  },
+   { "LineItem",        "getGlobal",                                                                          ParallelReadOnly  },
+};
+
+static const ParallelSafeFunctions parallelSafeLooseFunctions[] = {
+   { "global",          "getRandomNumber getMachineTime getVersion",                                          ParallelReadOnly  },
+   { "Geom",            "segmentsIntersect",                                                                  ParallelReadOnly  },
+};
+
+static map<lua_CFunction, ParallelSafety> parallelSafety;     // Filled in by findParallelSafeFunctions()
+static Mutex parallelSafetyLock;                               // Every thread hosting a game may want it filled in
+static Mutex proxyListLock;
+
+
+static lua_CFunction findLooseFunction(const char *module, const char *name)
+{
+   ProfileMap &profiles = LuaModuleRegistrarBase::getModuleProfiles();
+   ProfileMap::iterator it = profiles.find(module);
+
+   if(it != profiles.end())
+      for(U32 i = 0; i < it->second.size(); i++)
+         if(!strcmp(it->second[i].functionName, name))
+            return it->second[i].function;
+
+   return NULL;
+}
+
+
+static void addParallelSafeFunctions(const ParallelSafeFunctions &functions, bool loose)
+{
+   Vector<string> names;
+   parseString(functions.functions, names, ' ');
+
+   for(S32 i = 0; i < names.size(); i++)
+   {
+      lua_CFunction function = loose ? findLooseFunction(functions.className, names[i].c_str()) :
+                                       LuaW_Registrar::findMethod(functions.className, names[i].c_str());
+
+      TNLAssert(function, "No such function!");
+      if(function)
+         parallelSafety[function] = functions.safety;
+   }
+}
+
+
+static void findParallelSafeFunctions()
+{
+   for(U32 i = 0; i < ARRAYSIZE(parallelSafeMethods); i++)
+      addParallelSafeFunctions(parallelSafeMethods[i], false);
+
+   for(U32 i = 0; i < ARRAYSIZE(parallelSafeLooseFunctions); i++)
+      addParallelSafeFunctions(parallelSafeLooseFunctions[i], true);
+}
+
+
+// Isolated scripts run their Tick handlers on this many worker threads, with the main thread lending a hand.  Scripts
+// are isolated when they start, so this only affects those that start after it's set.
+void LuaScriptRunner::setScriptThreadCount(U32 threads)
+{
+   if(threads == getScriptThreadCount())
+      return;
+
+   delete mScriptThreadPool;
+   mScriptThreadPool = threads ? new WorkerPool(threads) : NULL;
+
+   parallelSafetyLock.lock();
+
+   if(threads && parallelSafety.size() == 0)
+      findParallelSafeFunctions();
+
+   parallelSafetyLock.unlock();
+}
+
+
+U32 LuaScriptRunner::getScriptThreadCount()
+{
+   return mScriptThreadPool ? mScriptThreadPool->getThreadCount() : 0;
+}
+
+
+// Moves function, and the argCount args on top of our stack, onto the thread we'll run them on.  Follow with
+// runParallelCmds(), then finishParallelCmd().
+void LuaScriptRunner::startParallelCmd(const char *function, S32 argCount)
+{
+   TNLAssert(mIsolatedL, "Only isolated scripts can run in parallel!");
+   TNLAssert(!mParallelCmdPending, "Already running a command!");
+
+   lua_State *L = mIsolatedL;
+
+   startBudgetTick();
+   mPreempted = false;
+   mParallelFunction = function;
+   mParallelCmdPending = true;
+   mParallelError = "";
+
+   if(!loadFunction(L, getScriptId(), function))           // -- <<args>>
+   {
+      lua_pop(L, argCount);
+      mParallelStatus = -1;
+      return;
+   }
+
+   if(!mParallelThread)
+   {
+      mParallelThread = lua_newthread(L);                   // -- <<args>>, function, thread
+      mParallelThreadRef = luaL_ref(L, LUA_REGISTRYINDEX);  // -- <<args>>, function
+   }
+
+   lua_insert(L, -1 - argCount);                            // -- function, <<args>>
+   lua_xmove(L, mParallelThread, argCount + 1);             // --
+
+   mParallelStatus = 0;
+   mParallelResumeArgs = argCount;
+}
+
+
+// Runs commands a round at a time, until they have all finished.  Between rounds, the main thread applies what the
+// scripts have queued up, and runs any calls they are waiting for, in the order the scripts are given.
+void LuaScriptRunner::runParallelCmds(const Vector<LuaScriptRunner *> &scripts)
+{
+   TNLAssert(mScriptThreadPool, "No threads to run scripts on!");
+
+   Vector<LuaScriptRunner *> running;
+
+   for(S32 i = 0; i < scripts.size(); i++)
+      if(scripts[i]->mParallelCmdPending && scripts[i]->mParallelStatus == 0)
+         running.push_back(scripts[i]);
+
+   while(running.size() > 0)
+   {
+      for(S32 i = 0; i < running.size(); i++)
+         running[i]->queueActions();
+
+      ParallelJobs jobs = { &running, mInstructionBudget };
+      mScriptThreadPool->run(runParallelJob, &jobs, running.size());
+
+      S32 stillRunning = 0;
+
+      for(S32 i = 0; i < running.size(); i++)
+      {
+         LuaScriptRunner *script = running[i];
+         script->applyQueuedActions();
+
+         if(script->mMainThreadCall && script->runMainThreadCall())
+            running[stillRunning++] = script;
+      }
+
+      running.resize(stillRunning);
+   }
+}
+
+
+void LuaScriptRunner::runParallelJob(void *context, U32 index)
+{
+   const ParallelJobs *jobs = static_cast<ParallelJobs *>(context);
+   LuaScriptRunner *script = (*jobs->scripts)[index];
+
+   mInstructionBudget = jobs->instructionBudget;      // Workers don't see the budget of the thread that handed them the job
+   mParallelScript = script;
+   script->resumeParallelCmd();
+   mParallelScript = NULL;
+}
+
+
+// Runs on a worker thread
+void LuaScriptRunner::resumeParallelCmd()
+{
+   mRunningScript = this;
+   mEnforcingBudget = mLuaGame != NULL;
+   mMainThreadCall = NULL;
+
+   S64 startTime = Platform::getHighPrecisionTimerValue();
+
+   mParallelStatus = lua_resume(mParallelThread, mParallelResumeArgs);
+
+   mScriptStats.time += Platform::getHighPrecisionTimerValue() - startTime;
+
+   mRunningScript = NULL;
+   mEnforcingBudget = false;
+}
+
+
+// Runs the call the script yielded for, and leaves the results on its thread to resume it with.  Returns false if the
+// call raised an error, which ends the script's command as if it had been raised in the script.
+bool LuaScriptRunner::runMainThreadCall()
+{
+   lua_State *L = mIsolatedL;
+   lua_CFunction function = mMainThreadCall;
+   mMainThreadCall = NULL;
+
+   S32 argCount = lua_gettop(mParallelThread);      // Everything the script yielded
+   S32 stackDepth = lua_gettop(L);
+
+   lua_pushcfunction(L, function);                  // -- function
+   lua_xmove(mParallelThread, L, argCount);         // -- function, <<args>>
+
+   // Whatever the call does in Lua is billed to us, but we can't stop it partway through
+   LuaScriptRunner *caller = mRunningScript;
+   bool callerBudgeted = mEnforcingBudget;
+   mRunningScript = this;
+   mEnforcingBudget = false;
+
+   S32 error = lua_pcall(L, argCount, LUA_MULTRET, 0);
+
+   mRunningScript = caller;
+   mEnforcingBudget = callerBudgeted;
+
+   if(error)
+   {
+      mParallelError = lua_tostring(L, -1) ? lua_tostring(L, -1) : "Unknown error";
+      mParallelStatus = error;
+      lua_settop(L, stackDepth);
+      return false;
+   }
+
+   mParallelResumeArgs = lua_gettop(L) - stackDepth;
+   lua_xmove(L, mParallelThread, mParallelResumeArgs);
+
+   return true;
+}
+
+
+// Deals with the outcome of our command, the way runCmd() does.  Returns true if there was an error, in which case the
+// script has been killed.
+bool LuaScriptRunner::finishParallelCmd()
+{
+   TNLAssert(mParallelCmdPending, "No command to finish!");
+   mParallelCmdPending = false;
+
+   lua_State *L = mIsolatedL;
+   S32 status = mParallelStatus;
+
+   if(status != -1)
+      mScriptStats.calls++;
+
+   if(mPreempted)
+   {
+      lua_sethook(L, countHook, LUA_MASKCOUNT, HookInterval);     // countHook() checked every instruction after stopping us
+
+      mScriptStats.overruns++;
+      if(mScriptStats.overruns == 1)
+         logprintf(LogConsumer::LogWarning, "%s\nScript %s used up its budget of %d instructions in %s(); "
+                   "it will be stopped whenever it does that", getErrorMessagePrefix(), mScriptName.c_str(),
+                   mInstructionBudget, mParallelFunction);
+
+      if(status != 0)      // Like runCmd(), make it look like the script finished
+      {
+         releaseParallelThread();
+         return false;
+      }
+   }
+
+   if(status == 0)
+   {
+      lua_settop(mParallelThread, 0);     // Return values; the thread is ready for next time
+      return false;
+   }
+
+   if(status == -1)
+   {
+      string text = "Cannot find Lua function " + string(mParallelFunction) + "()!\n";
+      logprintf(LogConsumer::LogError, "%s\n%s", getErrorMessagePrefix(), text.c_str());
+   }
+   else if(status == LUA_YIELD && mParallelError == "")
+      logprintf(LogConsumer::LogError, "%s\nIn method %s():\nScripts can't yield from event handlers while running in "
+                "parallel", getErrorMessagePrefix(), mParallelFunction);
+   else
+   {
+      const char *error = lua_tostring(mParallelThread, -1);
+      string msg = mParallelError != "" ? mParallelError : error ? error : "Unknown error";
+      improveErrorMessages(msg);    // Modifies msg
+
+      luaL_traceback(L, mParallelThread, msg.c_str(), 0);
+      string text = "In method " + string(mParallelFunction) + "():\n" + lua_tostring(L, -1);
+      lua_pop(L, 1);
+
+      logprintf(LogConsumer::LogError, "%s\n%s", getErrorMessagePrefix(), text.c_str());
+   }
+
+   logprintf(LogConsumer::LogError, "Terminating script");
+
+   releaseParallelThread();
+   killScript();
+
+   return true;
+}
+
+
+// Threads that stopped partway through, or with an error, can't be used again
+void LuaScriptRunner::releaseParallelThread()
+{
+   luaL_unref(mIsolatedL, LUA_REGISTRYINDEX, mParallelThreadRef);
+   mParallelThread = NULL;
+   mParallelThreadRef = LUA_NOREF;
+}
+
+
+bool LuaScriptRunner::isRunningInParallel()
+{
+   return mParallelScript != NULL;
+}
+
+
+bool LuaScriptRunner::mustRunOnMainThread(lua_State *L, lua_CFunction method)
+{
+   map<lua_CFunction, ParallelSafety>::const_iterator it = parallelSafety.find(method);
+
+   if(it == parallelSafety.end())
+      return true;
+
+   // Method's object is the first arg
+   return it->second == ParallelOwnObject && lua_touserdata(L, 1) != mParallelScript->mSelfUserdata;
+}
+
+
+// Suspends the script until the main thread has run method with the args on L's stack
+S32 LuaScriptRunner::runOnMainThread(lua_State *L, lua_CFunction method)
+{
+   LuaScriptRunner *script = mParallelScript;
+
+   // A coroutine of the script's own would yield to the script, not to us
+   if(L != script->mParallelThread)
+      return luaL_error(L, "This can't be done from a coroutine while scripts are running in parallel");
+
+   script->mMainThreadCall = method;
+   return lua_yield(L, lua_gettop(L));
+}
+
+
+}  // namespace Zap
+
+
+// LuaWrapper.h's hooks into the above
+bool luaW_isRunningInParallel()
+{
+   return Zap::LuaScriptRunner::isRunningInParallel();
+}
+
+
+bool luaW_mustRunOnMainThread(lua_State *L, lua_CFunction method)
+{
+   return Zap::LuaScriptRunner::mustRunOnMainThread(L, method);
+}
+
+
+int luaW_runOnMainThread(lua_State *L, lua_CFunction method)
+{
+   return Zap::LuaScriptRunner::runOnMainThread(L, method);
+}
+
+
+void luaW_lockProxyLists()
+{
+   Zap::proxyListLock.lock();
+}
+
+
+void luaW_unlockProxyLists()
+{
+   Zap::proxyListLock.unlock();
+}
+
+
+namespace Zap
+{
+
+
+// Queues nothing by default
+void LuaScriptRunner::queueActions()
+{
+   // Do nothing
+}
+
+
+void LuaScriptRunner::applyQueuedActions()
+{
+   // Do nothing
+}
+
+
+
 // Start Lua and get everything configured
 bool LuaScriptRunner::startLua(const string &scriptingDir)
 {
@@ -503,6 +1220,9 @@ bool LuaScriptRunner::startLua(const string &scriptingDir)
       return false;
    }
 
+   if(mInstructionBudget > 0)
+      applyInstructionBudget(L);
+
    return true;
 }
 
@@ -521,10 +1241,10 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
       luaL_openlibs(L);    // Load the standard libraries
 
       // This allows the safe use of 'require' in our scripts
-      setModulePath();
+      setModulePath(L);
 
       // Register all our classes in the global namespace... they will be copied below when we copy the environment
-      registerClasses();            // Perform class and global function registration once per lua_State
+      registerClasses(L);           // Perform class and global function registration once per lua_State
       registerLooseFunctions(L);    // Register some functions not associated with a particular class
 
       // Set scads of global vars in the Lua instance that mimic the use of the enums we use everywhere.
@@ -533,19 +1253,19 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
       setGlobalObjectArrays(L);
 
       // Immediately execute the lua helper functions (these are global and need to be loaded before sandboxing)
-      loadCompileRunHelper("lua_helper_functions.lua");
+      loadCompileRunHelper(L, "lua_helper_functions.lua");
 
       // Load our vector library
-      loadCompileRunHelper("luavec.lua");
+      loadCompileRunHelper(L, "luavec.lua");
 
       // Load our helper functions and store copies of the compiled code in the registry where we can use them for starting new scripts
-      loadCompileSaveHelper("robot_helper_functions.lua",    ROBOT_HELPER_FUNCTIONS_KEY);
-      loadCompileSaveHelper("levelgen_helper_functions.lua", LEVELGEN_HELPER_FUNCTIONS_KEY);
-      loadCompileSaveHelper("timer.lua",                     SCRIPT_TIMER_KEY);
+      loadCompileSaveHelper(L, "robot_helper_functions.lua",    ROBOT_HELPER_FUNCTIONS_KEY);
+      loadCompileSaveHelper(L, "levelgen_helper_functions.lua", LEVELGEN_HELPER_FUNCTIONS_KEY);
+      loadCompileSaveHelper(L, "timer.lua",                     SCRIPT_TIMER_KEY);
 
       // Perform sandboxing now
       // Only code executed before this point can access dangerous functions
-      loadCompileRunHelper("sandbox.lua");
+      loadCompileRunHelper(L, "sandbox.lua");
 
       return true;
    }
@@ -557,17 +1277,17 @@ bool LuaScriptRunner::configureNewLuaInstance(lua_State *L)
 }
 
 
-void LuaScriptRunner::loadCompileSaveHelper(const string &scriptName, const char *registryKey)
+void LuaScriptRunner::loadCompileSaveHelper(lua_State *L, const string &scriptName, const char *registryKey)
 {
-   loadCompileSaveScript(joindir(mScriptingDir, scriptName).c_str(), registryKey);
+   loadCompileSaveScript(L, joindir(mScriptingDir, scriptName).c_str(), registryKey);
 }
 
 
 // Load a script from the scripting directory by basename (e.g. "my_script.lua").
 // Throws LuaException when there's an error compiling or running the script.
-void LuaScriptRunner::loadCompileRunHelper(const string &scriptName)
+void LuaScriptRunner::loadCompileRunHelper(lua_State *L, const string &scriptName)
 {
-   loadCompileScript(joindir(mScriptingDir, scriptName).c_str());
+   loadCompileScript(L, joindir(mScriptingDir, scriptName).c_str());
    if(lua_pcall(L, 0, 0, 0))
       throw LuaException("Error running " + scriptName + ": " + string(lua_tostring(L, -1)));
 }
@@ -575,16 +1295,16 @@ void LuaScriptRunner::loadCompileRunHelper(const string &scriptName)
 
 // Load script from specified file, compile it, and store it in the registry.
 // All callers of this script have catch blocks, so we can throw errors if something goes wrong.
-void LuaScriptRunner::loadCompileSaveScript(const char *filename, const char *registryKey)
+void LuaScriptRunner::loadCompileSaveScript(lua_State *L, const char *filename, const char *registryKey)
 {
-   loadCompileScript(filename);                       // Throws if there is an error
+   loadCompileScript(L, filename);                       // Throws if there is an error
    lua_setfield(L, LUA_REGISTRYINDEX, registryKey);   // Save compiled code in registry
 }
 
 
 // Load script and place on top of the stack.
 // All callers of this script have catch blocks, so we can throw errors if something goes wrong.
-void LuaScriptRunner::loadCompileScript(const char *filename)
+void LuaScriptRunner::loadCompileScript(lua_State *L, const char *filename)
 {
    // luaL_loadfile: Loads a file as a Lua chunk. This function uses lua_load to load the chunk in the file named filename. 
    // If filename is NULL, then it loads from the standard input. The first line in the file is ignored if it starts with a #.
@@ -613,6 +1333,8 @@ void LuaScriptRunner::deleteScript(const char *name)
 
 bool LuaScriptRunner::prepareEnvironment()              
 {
+   lua_State *L = getLuaState();
+
    if(!L)
    {
       logprintf(LogConsumer::LogError, "%s %s.", getErrorMessagePrefix(), 
@@ -679,9 +1401,13 @@ static string getStackTraceLine(lua_State *L, S32 level)
 */
 
 // Register classes needed by all script runners
-void LuaScriptRunner::registerClasses()
+void LuaScriptRunner::registerClasses(lua_State *L)
 {
+   static Mutex registrationLock;      // Registering fills in LuaWrapper's statics, which every thread's Lua shares
+
+   registrationLock.lock();
    LuaW_Registrar::registerClasses(L);    // Register all objects that use our automatic registration scheme
+   registrationLock.unlock();
 }
 
 
@@ -705,6 +1431,8 @@ void LuaScriptRunner::registerClasses()
 // By Lua convention, we'll put the name of the script into the 0th element.
 void LuaScriptRunner::setLuaArgs(const Vector<string> &args)
 {
+   lua_State *L = getLuaState();
+
    S32 stackDepth = lua_gettop(L);
 
    lua_getfield(L, LUA_REGISTRYINDEX, getScriptId()); // Put script's env table onto the stack  -- ..., env_table
@@ -728,7 +1456,7 @@ void LuaScriptRunner::setLuaArgs(const Vector<string> &args)
 
 
 // Set up paths so that we can use require to load code in our scripts 
-void LuaScriptRunner::setModulePath()   
+void LuaScriptRunner::setModulePath(lua_State *L)   
 {
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
@@ -1099,6 +1827,25 @@ void LuaScriptRunner::setGlobalObjectArrays(lua_State *L)
 GENERATE_LUA_FUNARGS_TABLE(LuaScriptRunner, LUA_METHODS);
 GENERATE_LUA_METHODS_TABLE(LuaScriptRunner, LUA_METHODS);
 
+// Loose functions are wrapped in this, so they can pass themselves to the main thread, as methods do in luaW_doMethod()
+static S32 callLooseFunction(lua_State *L)
+{
+   lua_CFunction function = (lua_CFunction)lua_touserdata(L, lua_upvalueindex(1));
+
+   if(luaW_isRunningInParallel() && luaW_mustRunOnMainThread(L, function))
+      return luaW_runOnMainThread(L, function);
+
+   return function(L);
+}
+
+
+static void pushLooseFunction(lua_State *L, lua_CFunction function)
+{
+   lua_pushlightuserdata(L, (void *)function);
+   lua_pushcclosure(L, callLooseFunction, 1);
+}
+
+
 void LuaScriptRunner::registerLooseFunctions(lua_State *L)
 {
    ProfileMap moduleProfiles = LuaModuleRegistrarBase::getModuleProfiles();
@@ -1112,7 +1859,7 @@ void LuaScriptRunner::registerLooseFunctions(lua_State *L)
          for(U32 i = 0; i < profiles.size(); i++)
          {
             LuaStaticFunctionProfile &profile = profiles[i];
-            lua_pushcfunction(L, profile.function);                 // -- fn
+            pushLooseFunction(L, profile.function);                 // -- fn
             lua_setglobal(L, profile.functionName);                 // --
          }
       }
@@ -1124,7 +1871,7 @@ void LuaScriptRunner::registerLooseFunctions(lua_State *L)
          for(U32 i = 0; i < profiles.size(); i++)
          {
             LuaStaticFunctionProfile &profile = profiles[i];
-            lua_pushcfunction(L, profile.function);                 // -- table, fn
+            pushLooseFunction(L, profile.function);                 // -- table, fn
             lua_setfield(L, -2, profile.functionName);              // -- table
          }
          lua_setglobal(L, (*it).first.c_str());                     // --
@@ -1208,6 +1955,11 @@ S32 LuaScriptRunner::lua_findObjectById(lua_State *L)
  * If no object types are provided, this function will return every object on
  * the level (warning, may be slow).
  *
+ * Scripts that search every tick can pass in a table of their own to be filled
+ * with the results, rather than have a new one made each time.  Whatever was in
+ * it before is replaced.
+ *
+ * @param results (optional) A table to put the found objects in.
  * @param objType \link ObjType ObjTypes\endlink specifying what types of objects to find.
  *
  * @return A table with any found objects.
@@ -1226,7 +1978,12 @@ S32 LuaScriptRunner::lua_findObjectById(lua_State *L)
  *    end
  * end
  * 
+ * local items = {}                            -- Reused from tick to tick
  * 
+ * function onTick()
+ *    bf:findAllObjects(items, ObjType.ResourceItem)
+ *    print(#items)
+ * end
  * @endcode
  */
 S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
@@ -1235,63 +1992,62 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
 
    TNLAssert(mLuaGridDatabase != NULL, "Grid Database must not be NULL!");
 
-   fillVector.clear();
-   static Vector<U8> types;
+   DatabaseQuery &query = mLuaQuery;
+   Vector<U8> &types = mLuaQueryTypes;
 
-   types.clear();    // Needed because types is a reusable static vector, and we need to clear out any residuals
+   query.clear();    // Both are reused from call to call, so we need to clear out any residuals
+   types.clear();
 
    // We expect the stack to look like this: -- objType1, objType2, ...
-   // or this, if using the deprecated fill table option -- [fillTable], objType1, objType2, ...
+   // or this, if the script wants the results in a table of its own -- [results], objType1, objType2, ...
    // We'll work our way down from the top of the stack (element -1) until we find something that is not a number.
-   // We expect that when we find something that is not a number, the stack will only contain a fillTable.  If the stack
-   // is empty at that point, we'll add a table later.
+   // We expect that when we find something that is not a number, the stack will only contain the results table.  If
+   // the stack is empty at that point, we'll add a table later.
    // Note that even if stack is empty, lua_isnumber will return a value... which makes no sense!
    while(lua_gettop(L) > 0 && lua_isnumber(L, -1))
    {
       U8 typenum = (U8)lua_tointeger(L, -1);
 
       // Requests for botzones have to be handled separately; not a problem, we'll just do the search here, and add them to
-      // fillVector, where they'll be merged with the rest of our search results.
+      // query, where they'll be merged with the rest of our search results.
       if(typenum != BotNavMeshZoneTypeNumber)
          types.push_back(typenum);
       else
-         mLuaGame->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, fillVector);
+         mLuaGame->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, query);
 
       lua_pop(L, 1);
    }
 
-   const Vector<DatabaseObject *> * results;
+   const Vector<DatabaseObject *> *allObjects = NULL;
 
    if(types.size() == 0)
-      results = mLuaGridDatabase->findObjects_fast();
+      allObjects = mLuaGridDatabase->findObjects_fast();
    else
-   {
-      mLuaGridDatabase->findObjects(types, fillVector);
-      results = &fillVector;
-   }
+      mLuaGridDatabase->findObjects(types, query);
+
+   S32 resultCount = allObjects ? allObjects->size() : query.size();
 
    // This will guarantee a table at the top of the stack to return our found objects
    if(!lua_istable(L, -1))
    {
       TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
 
-      lua_createtable(L, results->size(), 0);    // Create a table, with enough slots pre-allocated for our data
+      lua_createtable(L, resultCount, 0);    // Create a table, with enough slots pre-allocated for our data
    }
-   else
-      logprintf(LogConsumer::LuaScriptMessage, "Usage of a fill table with findAllObjects() "
-            "is deprecated and will be removed in the future.  Instead, don't use one");
 
    TNLAssert((lua_gettop(L) == 1 && lua_istable(L, -1)) || dumpStack(L), "Should only have table!");
 
    S32 pushed = 0;      // Count of items we put into our table
 
-   for(S32 i = 0; i < results->size(); i++)
+   for(S32 i = 0; i < resultCount; i++)
    {
-      static_cast<BfObject *>(results->get(i))->push(L);
+      static_cast<BfObject *>(allObjects ? allObjects->get(i) : query.get(i))->push(L);
       pushed++;      // Increment pushed before using it because Lua uses 1-based arrays
       lua_rawseti(L, 1, pushed);
    }
 
+   luaTableTruncate(L, 1, pushed);     // Anything left over from the last time the table was used
+
    TNLAssert(lua_gettop(L) == 1 || dumpStack(L), "Stack has unexpected items on it!");
 
    return 1;
@@ -1307,8 +2063,9 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
  * constructed from the two points given, with each point positioned at opposite
  * corners.
  *
- * @note See findAllObjects() for a code example
+ * @note See findAllObjects() for a code example, and for reusing a results table
  *
+ * @param results (optional) A table to put the found objects in.
  * @param point1 One corner of a search rectangle.
  * @param point2 Another corner of a search rectangle diagonally opposite to the
  * first.
@@ -1322,15 +2079,16 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
 
    TNLAssert(mLuaGridDatabase != NULL, "Grid Database must not be NULL!");
 
-   static Vector<U8> types;
+   DatabaseQuery &query = mLuaQuery;
+   Vector<U8> &types = mLuaQueryTypes;
 
+   query.clear();
    types.clear();
-   fillVector.clear();
 
    bool hasBotZoneType = false;
 
    // We expect the stack to look like this: -- point1, point2, objType1, objType2, ...
-   // or this, if using the deprecated fill table option -- [fillTable], point1, point2, objType1, objType2, ...
+   // or this, if the script wants the results in a table of its own -- [results], point1, point2, objType1, objType2, ...
    // We'll work our way down from the top of the stack (element -1) until we find something that is not a number.
    while(lua_gettop(L) > 0 && lua_isnumber(L, -1))
    {
@@ -1353,30 +2111,29 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
    Rect searchArea = Rect(p1, p2);
 
    if(hasBotZoneType)
-      mLuaGame->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, fillVector, searchArea);
+      mLuaGame->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, query, searchArea);
 
-   mLuaGridDatabase->findObjects(types, fillVector, searchArea);
+   mLuaGridDatabase->findObjects(types, query, searchArea);
 
    // This will guarantee a table at the top of the stack to return our found objects
    if(!lua_istable(L, -1))
    {
       TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
 
-      lua_createtable(L, fillVector.size(), 0);    // Create a table, with enough slots pre-allocated for our data
+      lua_createtable(L, query.size(), 0);    // Create a table, with enough slots pre-allocated for our data
    }
-   else
-      logprintf(LogConsumer::LuaScriptMessage, "Usage of a fill table with findAllObjectsInArea() "
-            "is deprecated and will be removed in the future.  Instead, don't use one");
 
    S32 pushed = 0;      // Count of items we put into our table
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < query.size(); i++)
    {
-      static_cast<BfObject *>(fillVector[i])->push(L);
+      static_cast<BfObject *>(query[i])->push(L);
       pushed++;      // Increment pushed before using it because Lua uses 1-based arrays
       lua_rawseti(L, 1, pushed);
    }
 
+   luaTableTruncate(L, 1, pushed);     // Anything left over from the last time the table was used
+
    TNLAssert(lua_gettop(L) == 1 || dumpStack(L), "Stack has unexpected items on it!");
 
    return 1;
@@ -1635,6 +2392,10 @@ S32 LuaScriptRunner::lua_unsubscribe(lua_State *L)
  * subscribed to the \link DataReceived Event\endlink event, 
  * but it will not be sent back to the sender, even if they are subscribed.
  *
+ * When the server runs bots on several threads (the BotThreads setting), each bot has a Lua instance of its
+ * own, and gets a copy of the data rather than the data itself.  Tables sent that way are no longer shared, 
+ * and functions arrive as nil.
+ *
  * @param data Data to be sent (can be zero or more numeric, string, table, or other Lua values)
  */
 S32 LuaScriptRunner::lua_sendData(lua_State* L)
@@ -1642,7 +2403,7 @@ S32 LuaScriptRunner::lua_sendData(lua_State* L)
    // No need to check the args because... anything goes!!
 
    // Fire our event handler
-   EventManager::get()->fireEvent(this, EventManager::DataReceivedEvent);
+   EventManager::get()->fireEvent(this, EventManager::DataReceivedEvent, L);
 
    TNLAssert(lua_gettop(L) == 0, "Stack is dirty!");
 
@@ -9,8 +9,10 @@
 #include "LuaBase.h"          // Parent class
 #include "EventManager.h"
 #include "LuaWrapper.h"
+#include "gridDB.h"          // For DatabaseQuery
 
 #include "tnl.h"
+#include "tnlThread.h"
 #include "tnlVector.h"
 
 #include <deque>
@@ -43,24 +45,87 @@ class MenuItem;
 #define LEVELGEN_HELPER_FUNCTIONS_KEY "levelgen_helper_functions"
 #define SCRIPT_TIMER_KEY "script_timer"
 
+// CPU a script has used since its stats were last reset
+struct ScriptStats
+{
+   U32 calls;              // Times we've run one of its functions
+   S64 time;               // Time spent running them, in high precision timer ticks, including any scripts they set off
+   U64 instructions;       // Lua instructions run; only counted while there's an instruction budget
+   U32 overruns;           // Times it was stopped for running through its budget
+   U32 skippedEvents;      // Events it missed while waiting for its budget to be renewed
+
+   ScriptStats();
+   void clear();
+
+   F64 getMilliseconds() const;
+};
+
+
 class LuaScriptRunner
 {
 
 private:
-   static deque<string> mCachedScripts;
+   // Each thread hosting a game has a Lua of its own, so these statics are all per-thread
+   static thread_local deque<string> mCachedScripts;
 
-   static string mScriptingDir;
+   static thread_local string mScriptingDir;
 
    void setLuaArgs(const Vector<string> &args);
-   static void setModulePath();
+   static void setModulePath(lua_State *L);
 
-   static void loadCompileSaveHelper(const string &scriptName, const char *registryKey);
-   static void loadCompileRunHelper(const string &scriptName);
-   static void loadCompileSaveScript(const char *filename, const char *registryKey);
-   static void loadCompileScript(const char *filename);
+   static void loadCompileSaveHelper(lua_State *L, const string &scriptName, const char *registryKey);
+   static void loadCompileRunHelper(lua_State *L, const string &scriptName);
+   static void loadCompileSaveScript(lua_State *L, const char *filename, const char *registryKey);
+   static void loadCompileScript(lua_State *L, const char *filename);
 
    void pushStackTracer();      // Put error handler function onto the stack
 
+   // Instruction budgets: while a budget is set, a count hook bills every script for the instructions it runs, and
+   // stops scripts that run through their budget for the current game tick.  See runCmd().
+   static TNL_THREAD_LOCAL U32 mInstructionBudget;           // Instructions each script may run per tick, 0 for no limit
+   static TNL_THREAD_LOCAL LuaScriptRunner *mRunningScript;   // Whose instructions the hook is counting
+   static TNL_THREAD_LOCAL bool mEnforcingBudget;             // Whether the hook should stop mRunningScript if it goes over budget
+
+   static void applyInstructionBudget(lua_State *L);
+   static void countHook(lua_State *L, lua_Debug *ar);
+
+   // Isolated scripts have a lua_State of their own, rather than sharing L, so their onTick can run on a worker thread
+   // while others run theirs.  See runParallelCmds().
+   lua_State *mIsolatedL;
+   static thread_local Vector<LuaScriptRunner *> mIsolatedScripts;
+   static TNL_THREAD_LOCAL WorkerPool *mScriptThreadPool;      // NULL unless scripts run in parallel
+   static TNL_THREAD_LOCAL LuaScriptRunner *mParallelScript;   // Script this thread is running in parallel, if any
+
+   lua_State *mParallelThread;      // Coroutine our parallel commands run on, reused from one to the next
+   S32 mParallelThreadRef;          // Keeps it in mIsolatedL's registry
+   const char *mParallelFunction;   // Function it's running
+   bool mParallelCmdPending;        // Set from startParallelCmd() until finishParallelCmd()
+   S32 mParallelStatus;             // What lua_resume() last returned, or -1 if there was no function to run
+   S32 mParallelResumeArgs;         // Values on mParallelThread to resume it with
+   string mParallelError;           // Error raised by a call the main thread ran for us
+   lua_CFunction mMainThreadCall;   // Function the script is waiting for the main thread to run, if any
+   const void *mSelfUserdata;       // Userdata of the object this script belongs to; see setSelf()
+
+   struct ParallelJobs
+   {
+      Vector<LuaScriptRunner *> *scripts;
+      U32 instructionBudget;
+   };
+
+   static void runParallelJob(void *context, U32 index);
+   void resumeParallelCmd();
+   bool runMainThreadCall();
+   void releaseParallelThread();
+
+   U32 mBudgetTick;                 // Game time of the tick mTickInstructions is for
+   U32 mTickInstructions;           // Instructions run during that tick
+   bool mPreempted;                 // The hook stopped the current call
+   U32 mDeferredTickTime;           // onTick time missed while over budget, added to the next onTick
+   U32 mDeferredTimerTime;          // Likewise for script timers
+   ScriptStats mScriptStats;
+
+   void startBudgetTick();
+
    static void setEnums(lua_State *L);                       // Set a whole slew of enum values that we want the scripts to have access to
    static void setGlobalObjectArrays(lua_State *L);          // And some objects
    static void logErrorHandler(const char *msg, const char *prefix);
@@ -79,7 +144,7 @@ protected:
                                     // ClientGame depending on where the script is called from
    GridDatabase *mLuaGridDatabase;  // Pointer to our current grid database with objects to manipulate
 
-   static lua_State *L;          // Main Lua state variable
+   static TNL_THREAD_LOCAL lua_State *L;     // Main Lua state variable, shared by every script that isn't isolated
    string mScriptName;           // Fully qualified script name, with path and everything
    Vector<string> mScriptArgs;   // List of arguments passed to the script
 
@@ -88,11 +153,15 @@ protected:
 
    bool mSubscriptions[EventManager::EventTypes];  // Keep track of which events we're subscribed to for rapid unsubscription upon death or destruction
 
+   // Per-script scratch space for the find*Objects() family, so scripts don't share global query state
+   DatabaseQuery mLuaQuery;
+   Vector<U8> mLuaQueryTypes;
+
    // Sub-classes that override this should still call this with Parent::prepareEnvironment()
    virtual bool prepareEnvironment();
 
    static int luaPanicked(lua_State *L);  // Handle a total freakout by Lua
-   static void registerClasses();
+   static void registerClasses(lua_State *L);
    void setEnvironment();                 // Sets the environment for the function on the top of the stack to that associated with name
 
    bool loadCompileRunEnvironmentScript(const string &scriptName);
@@ -103,6 +172,13 @@ protected:
 
    static S32 findObjectById(lua_State *L, const Vector<DatabaseObject *> *objects);
 
+   bool createIsolatedState();   // Give this script a lua_State of its own; call before prepareEnvironment()
+
+   // Isolated scripts' calls to things that aren't safe to do in parallel are run on the main thread between rounds
+   // of parallel calls.  Sub-classes can also hold actions back until then, so scripts all see the same world.
+   virtual void queueActions();
+   virtual void applyQueuedActions();
+
 
    // Sets a var in the script's environment to give access to the caller's "this" obj, with the var name "name".
    // Basically sets the "bot", "levelgen", and "plugin" vars.
@@ -113,6 +189,7 @@ void setSelf(lua_State *L, T *self, const char *name)
 
       lua_pushstring(L, name);                                 //                                        -- env_table, "plugin"
       luaW_push(L, self);                                      //                                        -- env_table, "plugin", *this
+      mSelfUserdata = lua_touserdata(L, -1);
       lua_rawset(L, -3);                                       // env_table["plugin"] = *this            -- env_table
 
       lua_pop(L, -1);                                          // Cleanup                                -- <<empty stack>>
@@ -137,6 +214,9 @@ public:
    static bool startLua(const string &scriptingDir);  // Create L
    static void shutdown();                            // Delete L
 
+   lua_State *getLuaState();                          // Our own lua_State if we're isolated, L if not
+   bool isIsolated();
+
    static bool configureNewLuaInstance(lua_State *L); // Prepare a new Lua environment for use
 
    bool runString(const string &code);
@@ -146,7 +226,30 @@ public:
    bool loadScript(bool cacheScript);  // Loads script from file into a Lua chunk, then runs it
    bool runScript(bool cacheScript);   // Load the script, execute the chunk to get it in memory, then run its main() function
 
-   bool runCmd(const char *function, S32 argCount, S32 returnValueCount);
+   bool runCmd(const char *function, S32 argCount, S32 returnValueCount, bool budgeted = false);
+
+   static void setInstructionBudget(U32 budget);     // Instructions per script per tick, or 0 for no limit
+   static U32 getInstructionBudget();
+
+   static void setScriptThreadCount(U32 threads);     // Worker threads for isolated scripts, or 0 to run them all serially
+   static U32 getScriptThreadCount();
+
+   // Running an event handler for many isolated scripts at once
+   void startParallelCmd(const char *function, S32 argCount);     // Takes argCount args from the top of our stack
+   static void runParallelCmds(const Vector<LuaScriptRunner *> &scripts);
+   bool finishParallelCmd();                                      // Returns true if there was an error, like runCmd()
+
+   static bool isRunningInParallel();
+   static bool mustRunOnMainThread(lua_State *L, lua_CFunction method);
+   static S32 runOnMainThread(lua_State *L, lua_CFunction method);
+
+   bool isOverBudget();                               // True if script has used up its budget for this tick
+   void skipEvent();                                  // Note an event the script missed for being over budget
+   void deferTickTime(U32 deltaT);                    // Skip an onTick, saving its time for the next one
+   U32 takeDeferredTickTime();                        // Returns, and forgets, onTick time saved while over budget
+
+   const ScriptStats &getScriptStats() const;
+   void resetScriptStats();
 
    const char *getScriptId();
    static bool loadFunction(lua_State *L, const char *scriptId, const char *functionName);
@@ -162,9 +265,21 @@ public:
    template <class T>
    void tickTimer(U32 deltaT)
    {
+      lua_State *L = getLuaState();
+
       TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
       clearStack(L);
 
+      // Timers can wait until the script has some budget again; they'll catch up then
+      if(isOverBudget())
+      {
+         mDeferredTimerTime += deltaT;
+         return;
+      }
+
+      deltaT += mDeferredTimerTime;
+      mDeferredTimerTime = 0;
+
       luaW_push<T>(L, static_cast<T *>(this));           // -- this
       lua_pushnumber(L, deltaT);                         // -- this, deltaT
 
@@ -174,18 +289,19 @@ public:
 
       // Note that we don't care if this generates an error... if it does the error handler will
       // print a nice message, then call killScript().
-      runCmd("_tickTimer", 2, 0);
+      runCmd("_tickTimer", 2, 0, true);
    }
 
 
    template<typename T>
    T getLuaGlobalVar(const char* varName)
    {
+      lua_State *L = getLuaState();
       S32 stackDepth = lua_gettop(L);
 
       lua_getfield(L, LUA_REGISTRYINDEX, getScriptId());   // Push REGISTRY[scriptId] onto stack            -- registry table
       lua_getfield(L, -1, varName);                        // Get value of variable from environment table  -- registry table, value of var 
-      T var = getVal<T>(-1);
+      T var = getVal<T>(L, -1);
       lua_pop(L, 1);
       lua_pop(L, 1);
 
@@ -196,7 +312,7 @@ public:
 
 
    template<typename T>
-   T getVal(S32 index) { return getVal<T>(index); }
+   T getVal(lua_State *L, S32 index);
 
 
    //// Lua interface
@@ -225,15 +341,15 @@ public:
 };
 
 
-template<> inline S32 LuaScriptRunner::getVal(S32 index) { return S32(lua_tointeger(L, index)); }
-template<> inline U32 LuaScriptRunner::getVal(S32 index) { return U32(lua_tointeger(L, index)); }
-template<> inline S16 LuaScriptRunner::getVal(S32 index) { return S16(lua_tointeger(L, index)); }
-template<> inline U16 LuaScriptRunner::getVal(S32 index) { return U16(lua_tointeger(L, index)); }
-template<> inline S8  LuaScriptRunner::getVal(S32 index) { return S8(lua_tointeger(L, index)); }
-template<> inline U8  LuaScriptRunner::getVal(S32 index) { return U8(lua_tointeger(L, index)); }
-template<> inline F32 LuaScriptRunner::getVal(S32 index) { return F32(lua_tonumber(L, index)); }
-template<> inline bool LuaScriptRunner::getVal(S32 index) { return lua_toboolean(L, index); }
-template<> inline string LuaScriptRunner::getVal(S32 index) {
+template<> inline S32 LuaScriptRunner::getVal(lua_State *L, S32 index) { return S32(lua_tointeger(L, index)); }
+template<> inline U32 LuaScriptRunner::getVal(lua_State *L, S32 index) { return U32(lua_tointeger(L, index)); }
+template<> inline S16 LuaScriptRunner::getVal(lua_State *L, S32 index) { return S16(lua_tointeger(L, index)); }
+template<> inline U16 LuaScriptRunner::getVal(lua_State *L, S32 index) { return U16(lua_tointeger(L, index)); }
+template<> inline S8  LuaScriptRunner::getVal(lua_State *L, S32 index) { return S8(lua_tointeger(L, index)); }
+template<> inline U8  LuaScriptRunner::getVal(lua_State *L, S32 index) { return U8(lua_tointeger(L, index)); }
+template<> inline F32 LuaScriptRunner::getVal(lua_State *L, S32 index) { return F32(lua_tonumber(L, index)); }
+template<> inline bool LuaScriptRunner::getVal(lua_State *L, S32 index) { return lua_toboolean(L, index); }
+template<> inline string LuaScriptRunner::getVal(lua_State *L, S32 index) {
    size_t len;
    const char* cstr = lua_tolstring(L, -1, &len);
    return string(cstr, len);
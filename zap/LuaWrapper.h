@@ -94,6 +94,34 @@ inline bool luaW_shouldCreateProxy(lua_State* L)
 }
 
 
+// Robots can have a lua_State of their own, and have their onTick run on worker threads at the same time as others.
+// These hooks are defined in LuaScriptRunner.cpp; see LuaScriptRunner::runParallelCmds().
+bool luaW_isRunningInParallel();                                       // True while this thread is running a script in parallel
+bool luaW_mustRunOnMainThread(lua_State *L, lua_CFunction method);     // True if method can't be run with these args in parallel
+int  luaW_runOnMainThread(lua_State *L, lua_CFunction method);         // Suspends the script until the main thread has run method
+void luaW_lockProxyLists();
+void luaW_unlockProxyLists();
+
+
+// Objects keep a list of proxies, one for each lua_State they have been pushed into.  Scripts running in parallel may
+// add to or remove from any object's list, so they lock it first.  Nothing else touches the lists while they run.
+class luaW_ProxyListLock
+{
+   bool mLocked;
+
+public:
+   luaW_ProxyListLock()  { mLocked = luaW_isRunningInParallel(); if(mLocked) luaW_lockProxyLists(); }
+   ~luaW_ProxyListLock() { if(mLocked) luaW_unlockProxyLists(); }
+};
+
+
+// Identifies the lua_State L belongs to; coroutines share the registry of the state that created them
+inline const void *luaW_stateId(lua_State *L)
+{
+   return lua_topointer(L, LUA_REGISTRYINDEX);
+}
+
+
 // These are the default allocator and deallocator. If you would prefer an
 // alternative option, you may select a different function when registering
 // your class.
@@ -168,6 +196,15 @@ void luaW_identify(lua_State* L, T* obj)
     LuaWrapper<U>::identifier(L, static_cast<U*>(obj));
 }
 
+// Puts T's cache table on top of the stack.  It's LuaWrapper.cache[classname], but registration also puts it in the
+// registry under a key of T's own, which is quicker to get to; objects get pushed a lot.
+template <typename T>
+inline void luaW_cachetable(lua_State* L)
+{
+    lua_pushlightuserdata(L, (void *)&LuaWrapper<T>::classname); // ... key
+    lua_rawget(L, LUA_REGISTRYINDEX); // ... cache
+}
+
 // Get a field from the LuaWrapper table, put it on top of the stack
 template <typename T>
 inline void luaW_wrapperfield(lua_State* L, const char* field)
@@ -233,6 +270,21 @@ inline bool luaW_isUsingProxy(lua_State* L, void *objptr)
 }
 
 
+// Find obj's proxy in L's state, if it has one
+template <typename T>
+LuaProxy<T> *luaW_findProxy(lua_State* L, T* obj)
+{
+   const void *state = luaW_stateId(L);
+   luaW_ProxyListLock lock;
+
+   for(LuaProxy<T> *proxy = obj->getLuaProxy(); proxy; proxy = proxy->getNext())
+      if(proxy->getState() == state)
+         return proxy;
+
+   return NULL;
+}
+
+
 // Set whether or not our object uses a proxy
 template <typename T>
 void luaW_setUsingProxy(lua_State* L, T* obj, bool usingProxy)
@@ -244,7 +296,7 @@ void luaW_setUsingProxy(lua_State* L, T* obj, bool usingProxy)
    // will contain the proxy for proxied object otherwise it contains the object itself
    if(usingProxy)
    {
-      LuaProxy<T> *proxy = obj->getLuaProxy();
+      LuaProxy<T> *proxy = luaW_findProxy(L, obj);
       lua_pushlightuserdata(L, proxy);                // -- ... usingproxy_table, &proxy
    }
    else
@@ -387,17 +439,17 @@ void luaW_push(lua_State* L, T* obj)
    if(luaW_shouldCreateProxy(L))
    {
       // Get the object's proxy, or create one if it doesn't yet exist
-      LuaProxy<T> *proxy = obj->getLuaProxy();
+      LuaProxy<T> *proxy = luaW_findProxy(L, obj);
 
       if(proxy)         // Retrieve the userdata for this proxy from our cache table
       {
-         luaW_wrapperfield<T>(L, LUAW_CACHE_KEY);        // -- cache_table
+         luaW_cachetable<T>(L);                          // -- cache_table
          LuaWrapper<T>::identifier(L, obj);              // -- cache_table, id
 
-         // lua_gettable pushes onto the stack the value t[k], where t is the value at the given valid
-         // index and k is the value at the top of the stack.  Pops k, triggers metamethods.
+         // lua_rawget pushes onto the stack the value t[k], where t is the value at the given valid
+         // index and k is the value at the top of the stack.  Pops k; the cache's metatable only makes it weak.
          // Here: retrieves and pushes cache_table[id]
-         lua_gettable(L, -2);                            // -- cache_table, userdata
+         lua_rawget(L, -2);                              // -- cache_table, userdata
 
          TNLAssert(lua_isuserdata(L, -1) ||
                dumpStack(L, "Expect table, userdata") || dumpTable(L, -2, "Cached Userdatas"),
@@ -410,13 +462,13 @@ void luaW_push(lua_State* L, T* obj)
       else
       {
          // Create a new proxy
-         proxy = new LuaProxy<T>(obj);
+         proxy = new LuaProxy<T>(obj, luaW_stateId(L));
 
          // Add a new entry to our cache table (a weak table; more about those here: http://lua-users.org/wiki/WeakTablesTutorial).
          // Note that from here on down, we'll fall back on the normal LuaW push code, except for the bit at the end where
          // we add it to the table.
          LuaWrapper<T>::identifier(L, obj);                 // -- id
-         luaW_wrapperfield<T>(L, LUAW_CACHE_KEY);           // -- id, cache_table
+         luaW_cachetable<T>(L);                             // -- id, cache_table
 
          lua_pushvalue(L, -2);                              // -- id, cache_table, id
 
@@ -447,7 +499,7 @@ void luaW_push(lua_State* L, T* obj)
    else
    {
       LuaWrapper<T>::identifier(L, obj); // ... id
-      luaW_wrapperfield<T>(L, LUAW_CACHE_KEY); // ... id cache
+      luaW_cachetable<T>(L); // ... id cache
       lua_pushvalue(L, -2); // ... id cache id
       lua_gettable(L, -2); // ... id cache obj
       if (lua_isnil(L, -1))
@@ -577,6 +629,9 @@ inline int luaW_new(lua_State* L, int args)
 template <typename T>
 int luaW_new(lua_State* L)
 {
+    if(luaW_isRunningInParallel())     // Constructors always run on the main thread
+        return luaW_runOnMainThread(L, &luaW_new<T>);
+
     return luaW_new<T>(L, lua_gettop(L));
 }
 
@@ -808,10 +863,15 @@ void luaW_setfuncs(lua_State* L, const char* classname, const luaL_Reg* table,
 {
     luaW_initialize(L);
 
-    LuaWrapper<T>::classname   = classname;
-    LuaWrapper<T>::identifier  = identifier;
-    LuaWrapper<T>::allocator   = allocator;
-    LuaWrapper<T>::deallocator = deallocator;
+    // Every lua_State we register T with shares these, and scripts on other threads may be using them, so
+    // only fill them in the first time around
+    if(!LuaWrapper<T>::classname)
+    {
+        LuaWrapper<T>::classname   = classname;
+        LuaWrapper<T>::identifier  = identifier;
+        LuaWrapper<T>::allocator   = allocator;
+        LuaWrapper<T>::deallocator = deallocator;
+    }
 
     const luaL_Reg defaulttable[] =
     {
@@ -843,6 +903,9 @@ void luaW_setfuncs(lua_State* L, const char* classname, const luaL_Reg* table,
     lua_newtable(L); // ... LuaWrapper LuaWrapper.cache {}
     luaW_wrapperfield<T>(L, LUAW_CACHE_METATABLE_KEY); // ... LuaWrapper LuaWrapper.cache {} cmt
     lua_setmetatable(L, -2); // ... LuaWrapper LuaWrapper.cache {}
+    lua_pushlightuserdata(L, (void *)&LuaWrapper<T>::classname); // ... LuaWrapper LuaWrapper.cache {} key
+    lua_pushvalue(L, -2); // ... LuaWrapper LuaWrapper.cache {} key {}
+    lua_rawset(L, LUA_REGISTRYINDEX); // ... LuaWrapper LuaWrapper.cache {}
     lua_setfield(L, -2, LuaWrapper<T>::classname); // ... LuaWrapper LuaWrapper.cache
     lua_pop(L, 1); // ... LuaWrapper
 
@@ -888,8 +951,11 @@ void luaW_extend(lua_State* L)
     if(!LuaWrapper<U>::classname)
         luaL_error(L, "attempting to extend %s by a type that has not been registered", LuaWrapper<T>::classname);
 
-    LuaWrapper<T>::cast = luaW_cast<T, U>;
-    LuaWrapper<T>::identifier = luaW_identify<T, U>;
+    if(!LuaWrapper<T>::cast)      // As in luaW_setfuncs, only the first time around
+    {
+        LuaWrapper<T>::cast = luaW_cast<T, U>;
+        LuaWrapper<T>::identifier = luaW_identify<T, U>;
+    }
 
     luaL_getmetatable(L, LuaWrapper<T>::classname); // mt
     luaL_getmetatable(L, LuaWrapper<U>::classname); // mt emt
@@ -915,6 +981,9 @@ void luaW_extend(lua_State* L)
 
     lua_getfield(L, -1, LUAW_CACHE_KEY); // ... LuaWrapper LuaWrapper.cache
     lua_getfield(L, -1, LuaWrapper<U>::classname); // ... LuaWrapper LuaWrapper.cache U
+    lua_pushlightuserdata(L, (void *)&LuaWrapper<T>::classname); // ... LuaWrapper LuaWrapper.cache U key
+    lua_pushvalue(L, -2); // ... LuaWrapper LuaWrapper.cache U key U
+    lua_rawset(L, LUA_REGISTRYINDEX); // ... LuaWrapper LuaWrapper.cache U
     lua_setfield(L, -2, LuaWrapper<T>::classname); // ... LuaWrapper LuaWrapper.cache
     lua_pop(L, 1); // ... LuaWrapper
 
@@ -973,6 +1042,8 @@ private:
 
    typedef std::pair<ClassName, const LuaFunctionProfile *> NameArgumentListPair;
 
+   typedef std::map <ClassName, const luaL_Reg *> MethodTableMap;  // Map of class name and its luaMethods
+
 
    // List of registration functions
    static FunctionMap &getRegistrationFunctions()
@@ -990,6 +1061,14 @@ private:
    }
 
 
+   // Methods each class defines itself (not including those it inherits)
+   static MethodTableMap &getMethodTables()
+   {
+      static MethodTableMap methodTables;
+      return methodTables;
+   }
+
+
    // Mapping of function name to arguments to various defined functions
    static ArgMap &getArgMap()
    {
@@ -1071,6 +1150,7 @@ private:
    {
       NameFunctionPair regPair(T::luaClassName, &registerClass<T>);
       getRegistrationFunctions().insert(regPair);
+      getMethodTables().insert(std::pair<ClassName, const luaL_Reg *>(T::luaClassName, T::luaMethods));
 
       // The following are only used when dumping the lua documentation with -luadoc
       NameArgumentListPair argPair(T::luaClassName, T::functionArgs);
@@ -1107,6 +1187,23 @@ protected:
    }
 
 public:
+   // Returns the function Lua calls for className's methodName, or NULL if className doesn't define one
+   static lua_CFunction findMethod(const char *className, const char *methodName)
+   {
+      for(MethodTableMap::iterator it = getMethodTables().begin(); it != getMethodTables().end(); it++)
+      {
+         if(strcmp(it->first, className) != 0)
+            continue;
+
+         for(const luaL_Reg *method = it->second; method->name; method++)
+            if(strcmp(method->name, methodName) == 0)
+               return method->func;
+      }
+
+      return NULL;
+   }
+
+
    static void registerClasses(lua_State *L)
    {
       sortClassList();
@@ -1161,31 +1258,52 @@ class LuaProxy
 private:
     bool mDefunct;
     T *mProxiedObject;
+    const void *mState;       // The lua_State this proxy lives in; see luaW_stateId()
+    LuaProxy<T> *mNext;       // Proxy for the same object in another lua_State
 
 public:
     // Default constructor
     LuaProxy() { TNLAssert(false, "Not used"); }
 
     // Typical constructor
-    explicit LuaProxy(T *obj)
+    LuaProxy(T *obj, const void *state)
     {
       mProxiedObject = obj;
-      obj->setLuaProxy(this);
+      mState = state;
       mDefunct = false;
+
+      luaW_ProxyListLock lock;
+      mNext = obj->getLuaProxy();
+      obj->setLuaProxy(this);
     }
 
    // Destructor
    ~LuaProxy()
    {
-      if(!mDefunct)
-         mProxiedObject->mLuaProxy = NULL;
+      if(mDefunct)
+         return;
+
+      luaW_ProxyListLock lock;
+      LuaProxy<T> **link = &mProxiedObject->mLuaProxy;
+
+      while(*link != this)
+         link = &(*link)->mNext;
+
+      *link = mNext;
    }
 
 
    T   *getProxiedObject() { return mProxiedObject; }
    bool isDefunct()        { return mDefunct;       }
+   const void *getState()  { return mState;         }
+   LuaProxy<T> *getNext()  { return mNext;          }
 
-   void setDefunct(bool isDefunct) { mDefunct = isDefunct; }
+   // Goes for every proxy further down the list, too
+   void setDefunct(bool isDefunct)
+   {
+      for(LuaProxy<T> *proxy = this; proxy; proxy = proxy->mNext)
+         proxy->mDefunct = isDefunct;
+   }
 };
 
 
@@ -1241,6 +1359,9 @@ public:
 template <typename T, int (T::*methodName)(lua_State * )>
 int luaW_doMethod(lua_State *L)
 {
+   if(luaW_isRunningInParallel() && luaW_mustRunOnMainThread(L, &luaW_doMethod<T, methodName>))
+      return luaW_runOnMainThread(L, &luaW_doMethod<T, methodName>);
+
    T *w = luaW_check<T>(L, 1);
    if(w) 
    {
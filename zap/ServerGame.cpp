@@ -14,6 +14,7 @@
 #include "luaLevelGenerator.h"
 #include "robot.h"
 #include "Teleporter.h"
+#include "projectile.h"          // For moving projectiles
 #include "BanList.h"             // For banList kick duration
 #include "BotNavMeshZone.h"      // For zone clearing code
 #include "LevelSource.h"
@@ -27,6 +28,8 @@
 
 #include "IniFile.h"
 
+#include <atomic>
+
 
 using namespace TNL;
 
@@ -34,7 +37,7 @@ namespace Zap
 {
 
 
-static bool instantiated;           // Just a little something to keep us from creating multiple ServerGames...
+static atomic<S32> instances(0);    // Just a little something to keep us from creating more ServerGames than we meant to...
 
 
 // Constructor -- be sure to see Game constructor too!  Lots going on there!
@@ -42,10 +45,11 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
       Game(address, settings),
       mRobotManager(this, settings)
 {
-   TNLAssert(!instantiated, "Only one ServerGame at a time, please!  If this trips while testing, "
+   TNLAssert(instances == 0 || (dedicated && instances < settings->getIniSettings()->arenas),
+      "Only one ServerGame at a time, please (unless hosting arenas)!  If this trips while testing, "
       "it is probably because a test failed before another instance could be deleted.  Try disabling "
       "this assert, see what test fails, and fix it.  Then re-enable it, please!");
-   instantiated = true;
+   instances++;
 
    mLevelSource = levelSource;
 
@@ -96,7 +100,24 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
    mTestMode = testMode;
 
    mNetInterface->setAllowsConnections(true);
+   mNetInterface->setPacketWriterThreadCount(settings->getIniSettings()->packetWriterThreads);
+   mNetInterface->setBatchedIO(settings->getIniSettings()->batchedNetworkIO);
    mMasterUpdateTimer.reset(UpdateServerStatusTime);
+   mStatusOnMaster.levelType = NoGameType;
+   mStatusOnMaster.robotCount = 0;
+   mStatusOnMaster.playerCount = 0;
+
+   LuaScriptRunner::setInstructionBudget(settings->getIniSettings()->luaInstructionBudget);
+   LuaScriptRunner::setScriptThreadCount(settings->getIniSettings()->botThreads);
+
+   // Profile ghost updates from the start if the host wants them logged
+   mGhostProfileStartTime = Platform::getRealMilliseconds();
+   U32 ghostProfileLogInterval = settings->getIniSettings()->ghostProfileLogInterval;
+   if(ghostProfileLogInterval > 0)
+   {
+      setGhostProfilingEnabled(true);
+      mGhostProfileLogTimer.reset(ghostProfileLogInterval * 1000);
+   }
 
    mSuspendor = NULL;
 
@@ -122,6 +143,9 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
    GameManager::setHostingModePhase(GameManager::NotHosting);
 
    mGameRecorderServer = NULL;
+
+   mBotZoneMeshCache = new BotZoneMeshCache(settings->getFolderManager()->cacheDir);
+   mLevelPreloader = hostOnServer ? NULL : new LevelPreloader(mBotZoneMeshCache);
 }
 
 
@@ -135,7 +159,7 @@ ServerGame::~ServerGame()
 
    clearAddTarget();
 
-   instantiated = false;
+   instances--;
 
    delete mGameInfo;
    delete mBotZoneDatabase;
@@ -144,6 +168,11 @@ ServerGame::~ServerGame()
 
    if(mGameRecorderServer)
       delete mGameRecorderServer;
+
+   delete mLevelPreloader;    // Waits for anything it's working on
+   delete mBotZoneMeshCache;
+
+   GhostConnection::setProfilingEnabled(false);    // Profiling is global; don't leave it running for the next server
 }
 
 
@@ -313,6 +342,12 @@ void ServerGame::resetLevelLoadIndex()
 }
 
 
+const LevelSource *ServerGame::getLevelSource() const
+{
+   return mLevelSource.get();
+}
+
+
 // Return true if the only client connected is the one we passed; don't consider bots
 bool ServerGame::onlyClientIs(GameConnection *client)
 {
@@ -641,6 +676,7 @@ void ServerGame::cycleLevel(S32 nextLevel)
    }
 
    computeWorldObjectExtents();                       // Compute world Extents nice and early
+   getGameObjDatabase()->chooseSpatialIndexType();   // Big levels do better with a tree than with our fixed-size grid
 
    if(!mGameRecorderServer && !mShuttingDown && getSettings()->getIniSettings()->enableGameRecording)
       mGameRecorderServer = new GameRecorderServer(this);
@@ -657,8 +693,21 @@ void ServerGame::cycleLevel(S32 nextLevel)
    triangulate = !isDedicated();
 #endif
 
-   mGameType->mBotZoneCreationFailed = !BotNavMeshZone::buildBotMeshZones(mBotZoneDatabase, getGameObjDatabase(), &mAllZones,
-                                                                          getWorldExtents(), triangulate);
+   BotZoneMeshInput meshInput;
+   BotNavMeshZone::gatherMeshInput(getGameObjDatabase(), getWorldExtents(), meshInput);
+
+   BotZoneMesh newMesh;
+   BotZoneMesh *mesh = findBotZoneMesh(meshInput, newMesh);
+
+   if(mesh)
+      BotNavMeshZone::buildZonesFromMesh(mBotZoneDatabase, getGameObjDatabase(), &mAllZones, *mesh, meshInput, triangulate);
+   else
+      mAllZones.deleteAndClear();      // Also clears mBotZoneDatabase
+
+   mGameType->mBotZoneCreationFailed = (mesh == NULL);
+   mBotZoneDatabase->chooseSpatialIndexType();
+   mZoneRouteCache.buildClusters(&mAllZones);     // Routes through the old level's zones are no use to us now
+
    if(mGameType->mBotZoneCreationFailed)
    {
       for(int i = 0; i < getClientCount(); i++)
@@ -705,6 +754,50 @@ void ServerGame::cycleLevel(S32 nextLevel)
    sendLevelStatsToMaster();     // Give the master some information about this level for its database
 
    suspendIfNoActivePlayers();   // Does nothing if we're already suspended
+
+   // So next time we see this level, we can mesh it before we get to it
+   if(mLevelPreloader)
+      mLevelPreloader->rememberMeshInput(mLevelSource->findLevelFile(mCurrentLevelIndex), mLevelFileHash, meshInput);
+
+   mPreloadedLevel.clear();
+   preloadLevel(getSettings()->getIniSettings()->randomLevels ? +RANDOM_LEVEL : +NEXT_LEVEL);
+}
+
+
+// Start reading, and if we can, meshing, the level that nextLevel will lead to, while the current one is played
+void ServerGame::preloadLevel(S32 nextLevel)
+{
+   // Random picks can't be made ahead of time without changing what gets picked
+   if(!mLevelPreloader || nextLevel == RANDOM_LEVEL || mShuttingDown || mLevelSource->getLevelCount() == 0)
+      return;
+
+   S32 index = getAbsoluteLevelIndex(nextLevel);
+   mLevelPreloader->preload(index, mLevelSource->findLevelFile(index));
+}
+
+
+// Find a mesh for the level we're loading, whose geometry is in input: the preloader's, if it has one, then the one in the
+// cache, and if all else fails, a new one built into newMesh.  Returns NULL if the level can't be meshed.
+BotZoneMesh *ServerGame::findBotZoneMesh(const BotZoneMeshInput &input, BotZoneMesh &newMesh)
+{
+   // Meshes made from anything other than what the level looks like now (because a levelgen changed it, say) are no good
+   string inputHash = input.getHash();
+
+   if(mPreloadedLevel.mesh && mPreloadedLevel.mesh->inputHash == inputHash)
+      return mPreloadedLevel.mesh;
+
+   if(mBotZoneMeshCache->load(mLevelFileHash, newMesh) && newMesh.inputHash == inputHash)
+      return &newMesh;
+
+   string error;
+   if(!BotNavMeshZone::buildMesh(input, newMesh, error))
+   {
+      logprintf(LogConsumer::LogLevelError, "%s", error.c_str());
+      return NULL;
+   }
+
+   mBotZoneMeshCache->save(mLevelFileHash, newMesh);
+   return &newMesh;
 }
 
 
@@ -1043,7 +1136,16 @@ bool ServerGame::loadLevel()
    mObjectsLoaded = 0;
    setLevelDatabaseId(LevelDatabase::NOT_IN_DATABASE);
 
-   mLevelFileHash = mLevelSource->loadLevel(mCurrentLevelIndex, this, getGameObjDatabase());
+   // Use the preloaded copy of the level if there is one; it's the same as what's on disk, but we don't have to wait for it
+   string filename = mLevelSource->findLevelFile(mCurrentLevelIndex);
+
+   if(mLevelPreloader && mLevelPreloader->takeLevel(mCurrentLevelIndex, filename, mPreloadedLevel))
+   {
+      loadLevelFromString(mPreloadedLevel.contents, getGameObjDatabase(), filename);
+      mLevelFileHash = mPreloadedLevel.hash;
+   }
+   else
+      mLevelFileHash = mLevelSource->loadLevel(mCurrentLevelIndex, this, getGameObjDatabase());
 
    // Empty hash means file was not loaded.  Danger Will Robinson!
    if(mLevelFileHash == "")
@@ -1404,12 +1506,23 @@ void ServerGame::idle(U32 timeDelta)
    mNetInterface->checkIncomingPackets();
    checkConnectionToMaster(timeDelta);                   // Connect to master server if not connected
 
-   mSettings->getBanList()->updateKickList(timeDelta);   // Unban players who's bans have expired
+   mSettings->getBanList()->updateKickList();            // Unban players who's bans have expired
 
    // Periodically update our status on the master, so they know what we're doing...
    if(mMasterUpdateTimer.update(timeDelta))
       updateStatusOnMaster();
 
+   // Periodically dump the ghost update profile to the log, and start a fresh one
+   if(mGhostProfileLogTimer.update(timeDelta))
+   {
+      if(GhostConnection::isProfilingEnabled())
+      {
+         logGhostProfile();
+         resetGhostProfile();
+      }
+      mGhostProfileLogTimer.reset();
+   }
+
    // If we have a data transfer going on, process it
    if(!dataSender.isDone())
       dataSender.sendNextLine();
@@ -1473,6 +1586,9 @@ void ServerGame::idle(U32 timeDelta)
       botControlTickTimer.reset();
    }
    
+   // Projectiles all move together, as that's much cheaper than each one moving itself when it's idled
+   Projectile::moveAll(mGameObjDatabase->findObjects_fast(BulletTypeNumber), timeDelta);
+
    const Vector<DatabaseObject *> *gameObjects = mGameObjDatabase->findObjects_fast();
 
    // Visit each game object, handling moves and running its idle method
@@ -1668,6 +1784,7 @@ void ServerGame::processVoting(U32 timeDelta)
             {
                case VoteLevelChange:
                   mNextLevel = mVoteNumber;
+                  preloadLevel(mNextLevel);
                   if(mGameType)
                      mGameType->gameOverManGameOver();
                   break;
@@ -1761,33 +1878,188 @@ void ServerGame::processVoting(U32 timeDelta)
 }
 
 
+// Turning profiling on starts a fresh profile
+void ServerGame::setGhostProfilingEnabled(bool enabled)
+{
+   if(enabled && !GhostConnection::isProfilingEnabled())
+      resetGhostProfile();
+
+   GhostConnection::setProfilingEnabled(enabled);
+}
+
+
+void ServerGame::resetGhostProfile()
+{
+   NetClassRep::resetGhostProfiles();
+
+   for(S32 i = 0; i < getClientCount(); i++)
+   {
+      GameConnection *conn = getClientInfo(i)->getConnection();
+      if(conn)
+         conn->resetGhostProfile();
+   }
+
+   mGhostProfileStartTime = Platform::getRealMilliseconds();
+}
+
+
+static string formatGhostProfile(const string &name, const GhostUpdateProfile &profile, F32 seconds)
+{
+   F32 kbits = profile.bitsUsed / 1000.0f;
+
+   string line = name + ": " + itos(profile.updateCount) + " updates, " + ftos(kbits, 1) + " kbit";
+   if(seconds > 0)
+      line += " (" + ftos(kbits / seconds, 2) + " kbit/s)";
+   line += ", " + ftos(F32(profile.getPackMilliseconds()), 2) + " ms";
+
+   return line;
+}
+
+
+struct ClassGhostProfile
+{
+   const NetClassRep *classRep;
+   GhostUpdateProfile profile;
+};
+
+
+// Biggest bandwidth users first
+static bool ghostProfileBitsSort(const ClassGhostProfile &a, const ClassGhostProfile &b)
+{
+   return a.profile.bitsUsed > b.profile.bitsUsed;
+}
+
+
+// Object classes, heaviest first, then each client.  includeMaskBits breaks each class down
+// by update mask bit, which is too much for a message box but handy in the log.
+void ServerGame::getGhostProfileReport(Vector<string> &lines, bool includeMaskBits) const
+{
+   F32 seconds = (Platform::getRealMilliseconds() - mGhostProfileStartTime) / 1000.0f;
+
+   Vector<ClassGhostProfile> classProfiles;
+   for(U32 i = 0; i < NetClassRep::getNetClassCount(NetClassGroupGame, NetClassTypeObject); i++)
+   {
+      ClassGhostProfile classProfile;
+      classProfile.classRep = NetClassRep::getClass(NetClassGroupGame, NetClassTypeObject, i);
+      classProfile.profile = classProfile.classRep->getGhostProfile();
+
+      if(classProfile.profile.updateCount > 0)
+         classProfiles.push_back(classProfile);
+   }
+
+   classProfiles.sort(ghostProfileBitsSort);
+
+   GhostUpdateProfile total;
+   for(S32 i = 0; i < classProfiles.size(); i++)
+      total.add(classProfiles[i].profile);
+
+   lines.push_back("Ghost updates over the last " + ftos(seconds, 1) + " seconds");
+   lines.push_back(formatGhostProfile("All objects", total, seconds));
+
+   for(S32 i = 0; i < classProfiles.size(); i++)
+   {
+      const GhostUpdateProfile &profile = classProfiles[i].profile;
+      lines.push_back(formatGhostProfile(classProfiles[i].classRep->getClassName(), profile, seconds));
+
+      if(!includeMaskBits)
+         continue;
+
+      for(U32 j = 0; j < GhostUpdateProfile::MaskBitCount; j++)
+         if(profile.maskBitUpdateCount[j] > 0)
+            lines.push_back("   mask bit " + itos(j) + ": " + itos(profile.maskBitUpdateCount[j]) + " updates, " + 
+                            ftos(profile.maskBitBitsUsed[j] / 1000.0f, 1) + " kbit");
+   }
+
+   for(S32 i = 0; i < getClientCount(); i++)
+   {
+      ClientInfo *clientInfo = getClientInfo(i);
+      GameConnection *conn = clientInfo->getConnection();
+
+      if(conn && !clientInfo->isRobot())
+         lines.push_back(formatGhostProfile(string("Client ") + clientInfo->getName().getString(), conn->getGhostProfile(), seconds));
+   }
+}
+
+
+void ServerGame::logGhostProfile() const
+{
+   Vector<string> lines;
+   getGhostProfileReport(lines, true);
+
+   for(S32 i = 0; i < lines.size(); i++)
+      logprintf(LogConsumer::ServerFilter, "%s", lines[i].c_str());
+}
+
+
+void ServerGame::resetScriptStats()
+{
+   for(S32 i = 0; i < getBotCount(); i++)
+      getBot(i)->resetScriptStats();
+
+   for(S32 i = 0; i < mLevelGens.size(); i++)
+      mLevelGens[i]->resetScriptStats();
+}
+
+
+static string formatScriptStats(const string &name, const ScriptStats &stats)
+{
+   string line = name + ": " + itos(stats.calls) + " calls, " + ftos(F32(stats.getMilliseconds()), 2) + " ms";
+
+   if(LuaScriptRunner::getInstructionBudget() > 0)
+      line += ", " + itos(S32(stats.instructions / 1000)) + "k instructions, " + itos(stats.overruns) + " overruns, " +
+              itos(stats.skippedEvents) + " events skipped";
+
+   return line;
+}
+
+
+void ServerGame::getScriptStatsReport(Vector<string> &lines)
+{
+   U32 budget = LuaScriptRunner::getInstructionBudget();
+
+   if(budget > 0)
+      lines.push_back("Budget is " + itos(budget) + " instructions per script per tick");
+   else
+      lines.push_back("No instruction budget; only counting time");
+
+   for(S32 i = 0; i < mLevelGens.size(); i++)
+      lines.push_back(formatScriptStats("Levelgen " + extractFilename(mLevelGens[i]->getScriptName()),
+                                        mLevelGens[i]->getScriptStats()));
+
+   for(S32 i = 0; i < getBotCount(); i++)
+   {
+      Robot *bot = getBot(i);
+      ClientInfo *clientInfo = bot->getClientInfo();
+      string name = clientInfo ? clientInfo->getName().getString() : "?";
+
+      lines.push_back(formatScriptStats("Bot " + name + " (" + extractFilename(bot->getScriptName()) + ")",
+                                        bot->getScriptStats()));
+   }
+}
+
+
 // Inform master of how things are hanging on this game server
 void ServerGame::updateStatusOnMaster()
 {
    MasterServerConnection *masterConn = getConnectionToMaster();
 
-   static string prevCurrentLevelName;      // Using static, so it holds the value when it comes back here
-   static GameTypeId prevCurrentLevelType;
-   static S32 prevRobotCount;
-   static S32 prevPlayerCount;
-
    if(masterConn && masterConn->isEstablished())
    {
       // Only update if something is different
-      if(prevCurrentLevelName != getGameType()->getLevelName() ||
-         prevCurrentLevelType != getGameType()->getGameTypeId() ||
-         prevRobotCount       != getRobotCount() ||
-         prevPlayerCount      != getPlayerCount())
+      if(mStatusOnMaster.levelName   != getGameType()->getLevelName() ||
+         mStatusOnMaster.levelType   != getGameType()->getGameTypeId() ||
+         mStatusOnMaster.robotCount  != getRobotCount() ||
+         mStatusOnMaster.playerCount != getPlayerCount())
       {
-         prevCurrentLevelName = getGameType()->getLevelName();
-         prevCurrentLevelType = getGameType()->getGameTypeId();
-         prevRobotCount       = getRobotCount();
-         prevPlayerCount      = getPlayerCount();
-
-         masterConn->updateServerStatus(StringTableEntry(prevCurrentLevelName.c_str()), 
-                                        GameType::getGameTypeName(prevCurrentLevelType), 
-                                        prevRobotCount, 
-                                        prevPlayerCount, 
+         mStatusOnMaster.levelName   = getGameType()->getLevelName();
+         mStatusOnMaster.levelType   = getGameType()->getGameTypeId();
+         mStatusOnMaster.robotCount  = getRobotCount();
+         mStatusOnMaster.playerCount = getPlayerCount();
+
+         masterConn->updateServerStatus(StringTableEntry(mStatusOnMaster.levelName.c_str()), 
+                                        GameType::getGameTypeName(mStatusOnMaster.levelType), 
+                                        mStatusOnMaster.robotCount, 
+                                        mStatusOnMaster.playerCount, 
                                         mSettings->getMaxPlayers(), 
                                         mInfoFlags);
 
@@ -1798,7 +2070,7 @@ void ServerGame::updateStatusOnMaster()
    }
    else
    {
-      prevPlayerCount = -1;   // Not sure if needed, but if we're disconnected, we need to update to master when we reconnect
+      mStatusOnMaster.playerCount = -1;   // Not sure if needed, but if we're disconnected, we need to update to master when we reconnect
       mMasterUpdateTimer.reset(CheckServerStatusTime);
    }
 }
@@ -1949,6 +2221,14 @@ const Vector<BotNavMeshZone *> *ServerGame::getBotZones() const
 }
 
 
+// Route from startZone towards targetZone, remembered for the next bot to ask.  On big levels this may only
+// get part of the way; see ZoneRoute.
+const ZoneRoute &ServerGame::findZoneRoute(U16 startZone, U16 targetZone)
+{
+   return mZoneRouteCache.findRoute(&mAllZones, startZone, targetZone);
+}
+
+
 // Returns ID of zone containing specified point
 U16 ServerGame::findZoneContaining(const Point &p) const
 {
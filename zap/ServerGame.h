@@ -10,6 +10,7 @@
 
 #include "BotNavMeshZone.h"
 #include "dataConnection.h"
+#include "LevelPreloader.h"
 #include "LevelSource.h"         // For LevelSourcePtr def
 #include "LevelSpecifierEnum.h"
 #include "RobotManager.h"
@@ -56,6 +57,16 @@ private:
    Timer mLevelSwitchTimer;               // Track how long after game has ended before we actually switch levels
    Timer mMasterUpdateTimer;              // Periodically let the master know how we're doing
 
+   struct {                               // What we last told the master
+      string levelName;
+      GameTypeId levelType;
+      S32 robotCount;
+      S32 playerCount;
+   } mStatusOnMaster;
+
+   Timer mGhostProfileLogTimer;           // Periodically write the ghost update profile to the log, if configured
+   U32 mGhostProfileStartTime;            // Real time when the ghost update profile was last reset
+
    bool mShuttingDown;
    string mShutdownReason;                // Message to local user about why we're shutting down, optional
 
@@ -70,6 +81,10 @@ private:
 
    GameRecorderServer *mGameRecorderServer;
 
+   BotZoneMeshCache *mBotZoneMeshCache;
+   LevelPreloader *mLevelPreloader;       // NULL when hosting levels that come from the hoster
+   PreloadedLevel mPreloadedLevel;        // Level being loaded, if the preloader got to it first
+
    string mOriginalName;
    string mOriginalDescr;
    string mOriginalServerPassword;
@@ -106,6 +121,8 @@ private:
 
    void cleanUp();
    bool loadLevel();                                  // Load the level pointed to by mCurrentLevelIndex
+   void preloadLevel(S32 nextLevel);                  // Get a head start on the level we expect to play next
+   BotZoneMesh *findBotZoneMesh(const BotZoneMeshInput &input, BotZoneMesh &newMesh);
    void runLevelGenScript(const string &scriptName);  // Run any levelgens specified by the level or in the INI
 
    AbstractTeam *getNewTeam();
@@ -119,6 +136,7 @@ private:
 
    GridDatabase *mBotZoneDatabase;
    Vector<BotNavMeshZone *> mAllZones;
+   ZoneRouteCache mZoneRouteCache;        // Recently used routes between zones, shared by all bots
    
 public:
    ServerGame(const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource, bool testMode, bool dedicated, bool hostOnServer = false);    // Constructor
@@ -167,6 +185,7 @@ public:
 
    void resetLevelLoadIndex();
    string loadNextLevelInfo();
+   const LevelSource *getLevelSource() const;
    bool populateLevelInfoFromSource(const string &fullFilename, LevelInfo &levelInfo);
 
    void deleteLevelGen(LuaLevelGenerator *levelgen);     // Add misbehaved levelgen to the kill list
@@ -184,6 +203,18 @@ public:
 
    void onConnectedToMaster();
 
+   /////
+   // Ghost update profiling -- how much bandwidth and CPU each object class and client uses
+   void setGhostProfilingEnabled(bool enabled);
+   void resetGhostProfile();
+   void getGhostProfileReport(Vector<string> &lines, bool includeMaskBits) const;
+   void logGhostProfile() const;
+
+   /////
+   // Script CPU use -- see LuaScriptRunner::runCmd()
+   void resetScriptStats();
+   void getScriptStatsReport(Vector<string> &lines);
+
    /////
    // Bot related
    void startAllBots();                            // Loop through all our bots and run thier main() functions
@@ -264,6 +295,7 @@ public:
    // BotNavMeshZone management
    GridDatabase *getBotZoneDatabase() const;
    const Vector<BotNavMeshZone *> *getBotZones() const;
+   const ZoneRoute &findZoneRoute(U16 startZone, U16 targetZone);
    U16 findZoneContaining(const Point &p) const;
 
    void setGameType(GameType *gameType);
@@ -9,6 +9,7 @@
 #include "GameSettings.h"
 #include "ServerGame.h"
 #include "LevelSource.h"
+#include "ArenaThread.h"
 
 #ifndef ZAP_DEDICATED
 #  include "ClientGame.h"
@@ -37,13 +38,21 @@ namespace Zap
 {
 
 
+static Address getHostAddress(GameSettingsPtr settings)
+{
+   Address address(IPProtocol, Address::Any, GameSettings::DEFAULT_GAME_PORT);   // Equivalent to ("IP:Any:28000")
+   address.set(settings->getHostAddress());                          // May overwrite parts of address, depending on what getHostAddress contains
+
+   return address;
+}
+
+
 // Host a game (and maybe even play a bit, too!)
 void initHosting(GameSettingsPtr settings, LevelSourcePtr levelSource, bool testMode, bool dedicatedServer, bool hostOnServer)
 {
    TNLAssert(!GameManager::getServerGame(), "Already have a ServerGame!");
 
-   Address address(IPProtocol, Address::Any, GameSettings::DEFAULT_GAME_PORT);   // Equivalent to ("IP:Any:28000")
-   address.set(settings->getHostAddress());                          // May overwrite parts of address, depending on what getHostAddress contains
+   Address address = getHostAddress(settings);
 
    GameManager::setServerGame(new ServerGame(address, settings, levelSource, testMode, dedicatedServer, hostOnServer));
 
@@ -84,6 +93,38 @@ void initHosting(GameSettingsPtr settings, LevelSourcePtr levelSource, bool test
 }
 
 
+// Once the first arena has loaded its levels and started hosting, a dedicated server can start up the rest of the Arenas
+// the INI asks for, each on a thread of its own (see ArenaThread).  They go on the ports after the first one's, and each
+// gets its own copy of the level list, since admins can change it from within a game.  Each connects to the master and
+// is listed there on its own.
+void hostArenas(ServerGame *firstArena)
+{
+   GameSettingsPtr settings = firstArena->getSettingsPtr();
+   S32 arenas = settings->getIniSettings()->arenas;
+
+   if(!firstArena->isDedicated() || arenas <= 1 || GameManager::getArenas()->size() > 0)
+      return;
+
+   Address address = getHostAddress(settings);
+
+   for(S32 i = 1; i < arenas; i++)
+   {
+      Address arenaAddress = address;
+      arenaAddress.port = U16(address.port + i);
+
+      LevelSourcePtr levelSource = LevelSourcePtr(firstArena->getLevelSource()->clone());
+
+      ArenaThread *arena = new ArenaThread(i, arenaAddress, settings, levelSource);
+      GameManager::addArena(arena);
+
+      logprintf(LogConsumer::ServerFilter, "Hosting arena %d on port %d", i + 1, arenaAddress.port);
+
+      if(!arena->startHosting())
+         logprintf(LogConsumer::LogError, "Arena %d couldn't start hosting", i + 1);
+   }
+}
+
+
 void shutdownBitfighter();    // Forward declaration
 
 // If we can't load any levels, here's the plan...
@@ -139,7 +139,7 @@ const Vector<Point> *Teleporter::getDestList() const
 
 TNL_IMPLEMENT_NETOBJECT(Teleporter);
 
-static Vector<DatabaseObject *> foundObjects;      // Reusable container
+static thread_local Vector<DatabaseObject *> foundObjects;      // Reusable container
 
 const F32 Teleporter::DamageReductionFactor = 0.5f;
 
@@ -295,8 +295,7 @@ void QueryServersUserInterface::contactEveryone()
          masterConn->c2mJoinGlobalChat();    // Announce our presence in the chat room
          mAnnounced = true;
       }
-      masterConn->startServerQuery(mHostOnServer);
-      mWaitingForResponseFromMaster = true;
+      mWaitingForResponseFromMaster = masterConn->startServerQuery(mHostOnServer);
    }
    else     // Don't have a valid connection object
    {
@@ -306,6 +305,16 @@ void QueryServersUserInterface::contactEveryone()
 }
 
 
+// Tell the master we're done with the server list
+void QueryServersUserInterface::stopServerQuery()
+{
+   MasterServerConnection *masterConn = getGame()->getConnectionToMaster();
+
+   if(masterConn)
+      masterConn->stopServerQuery();
+}
+
+
 // Returns index of found server, -1 if it found none
 static S32 findServerByAddress(const Vector<ServerAddr> &serverList, const Address &address)
 {
@@ -1198,6 +1207,7 @@ bool QueryServersUserInterface::onKeyDown(InputCode inputCode)
             if(servers.size() > currentIndex)      // Index is valid
             {
                leaveGlobalChat();
+               stopServerQuery();
 
                // Join the selected game...   (what if we select a local server from the list...  wouldn't 2nd param be true?)
                // Second param, false when we can ping that server, allows faster connect. If we can ping, we can connect without master help.
@@ -1217,6 +1227,7 @@ bool QueryServersUserInterface::onKeyDown(InputCode inputCode)
    {
       playBoop();
       leaveGlobalChat();
+      stopServerQuery();
       getUIManager()->reactivatePrevUI();      // MainMenuUserInterface
    }
    else if(inputCode == KEY_LEFT)
@@ -80,6 +80,7 @@ private:
    void sortSelected();
 
    void contactEveryone();    // Try contacting master server, and local broadcast servers
+   void stopServerQuery();    // Stop the master keeping us up to date with the server list
    bool mWaitingForResponseFromMaster;
    bool mItemSelectedWithMouse;
    bool mSortAscending;
@@ -0,0 +1,404 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "WallCollisionTree.h"
+
+#include "gridDB.h"
+#include "GeomUtils.h"
+
+#include "tnlAssert.h"
+
+#include <algorithm>
+
+namespace Zap
+{
+
+static bool overlaps(const Rect &a, const Rect &b)
+{
+   return a.min.x <= b.max.x && a.min.y <= b.max.y &&
+          a.max.x >= b.min.x && a.max.y >= b.min.y;
+}
+
+
+// For putting walls in address order
+static bool objectLessThan(const DatabaseObject *a, const DatabaseObject *b)
+{
+   return a < b;
+}
+
+
+// For splitting a node's edges in half along one axis
+struct EdgeCenterLessThan
+{
+   const Vector<Point> *centers;
+   bool xAxis;
+
+   bool operator()(S32 a, S32 b) const
+   {
+      return xAxis ? centers->get(a).x < centers->get(b).x : centers->get(a).y < centers->get(b).y;
+   }
+};
+
+
+// Constructor
+WallCollisionTree::WallCollisionTree()
+{
+   // Do nothing
+}
+
+
+// Destructor
+WallCollisionTree::~WallCollisionTree()
+{
+   // Do nothing
+}
+
+
+void WallCollisionTree::clear()
+{
+   mVertices.clear();
+   mEdges.clear();
+   mWalls.clear();
+   mNodes.clear();
+   mEdgeOrder.clear();
+}
+
+
+// Walls are anything with a collision polygon; anything without one is ignored
+void WallCollisionTree::build(const Vector<DatabaseObject *> &walls)
+{
+   clear();
+
+   Vector<DatabaseObject *> sortedWalls(walls);
+   std::sort(sortedWalls.address(), sortedWalls.address() + sortedWalls.size(), objectLessThan);
+
+   for(S32 i = 0; i < sortedWalls.size(); i++)
+   {
+      const Vector<Point> *poly = sortedWalls[i]->getCollisionPoly();
+
+      if(!poly || poly->size() == 0)
+         continue;
+
+      Wall wall;
+      wall.object = sortedWalls[i];
+      wall.firstEdge = mEdges.size();
+      wall.edgeCount = poly->size();
+
+      for(S32 j = 0; j < poly->size(); j++)
+      {
+         Edge edge;
+         edge.v1 = poly->get(j);
+         edge.v2 = poly->get(j == 0 ? poly->size() - 1 : j - 1);
+         edge.v1v2 = edge.v2 - edge.v1;
+         edge.lenSquared = edge.v1v2.lenSquared();
+         edge.wall = mWalls.size();
+
+         // As polygonIntersectsSegmentDetailed() works it out, going the other way along the edge
+         Point dv = edge.v1 - edge.v2;
+         edge.normal.set(dv.y, -dv.x);
+         edge.normal.normalize();
+
+         mVertices.push_back(edge.v1);
+         mEdges.push_back(edge);
+      }
+
+      mWalls.push_back(wall);
+   }
+
+   if(mEdges.size() == 0)
+      return;
+
+   Vector<Rect> edgeExtents(mEdges.size());
+   Vector<Point> edgeCenters(mEdges.size());
+
+   mEdgeOrder.resize(mEdges.size());
+
+   for(S32 i = 0; i < mEdges.size(); i++)
+   {
+      edgeExtents.push_back(Rect(mEdges[i].v1, mEdges[i].v2));
+      edgeCenters.push_back((mEdges[i].v1 + mEdges[i].v2) * 0.5f);
+      mEdgeOrder[i] = i;
+   }
+
+   buildNode(0, mEdges.size(), edgeExtents, edgeCenters);
+}
+
+
+// Splits edges in half, along whichever axis their centers are most spread out on, until there are few enough to make
+// a leaf.  Returns the index of the new node.
+S32 WallCollisionTree::buildNode(S32 first, S32 count, const Vector<Rect> &edgeExtents, const Vector<Point> &edgeCenters)
+{
+   S32 nodeIndex = mNodes.size();
+   mNodes.push_back(Node());
+
+   Rect extent(edgeExtents[mEdgeOrder[first]]);
+   Rect centerExtent(edgeCenters[mEdgeOrder[first]], edgeCenters[mEdgeOrder[first]]);
+
+   for(S32 i = first + 1; i < first + count; i++)
+   {
+      extent.unionRect(edgeExtents[mEdgeOrder[i]]);
+      centerExtent.unionPoint(edgeCenters[mEdgeOrder[i]]);
+   }
+
+   mNodes[nodeIndex].extent = extent;
+
+   if(count <= MaxEdgesPerLeaf)
+   {
+      mNodes[nodeIndex].first = first;
+      mNodes[nodeIndex].edgeCount = count;
+      return nodeIndex;
+   }
+
+   S32 half = count / 2;
+
+   EdgeCenterLessThan lessThan;
+   lessThan.centers = &edgeCenters;
+   lessThan.xAxis = centerExtent.getWidth() >= centerExtent.getHeight();
+
+   S32 *order = mEdgeOrder.address();
+   std::nth_element(order + first, order + first + half, order + first + count, lessThan);
+
+   buildNode(first, half, edgeExtents, edgeCenters);
+   S32 secondChild = buildNode(first + half, count - half, edgeExtents, edgeCenters);
+
+   mNodes[nodeIndex].first = secondChild;
+   mNodes[nodeIndex].edgeCount = 0;
+
+   return nodeIndex;
+}
+
+
+// Calls callback(edgeIndex) for every edge whose bounding box touches rect
+template <class Callback>
+void WallCollisionTree::query(const Rect &rect, Callback &callback) const
+{
+   if(mNodes.size() == 0)
+      return;
+
+   S32 stack[MaxDepth];
+   S32 count = 0;
+   stack[count++] = 0;
+
+   while(count > 0)
+   {
+      S32 nodeIndex = stack[--count];
+      const Node &node = mNodes[nodeIndex];
+
+      if(!overlaps(node.extent, rect))
+         continue;
+
+      if(node.edgeCount > 0)
+      {
+         for(S32 i = node.first; i < node.first + node.edgeCount; i++)
+         {
+            const Edge &edge = mEdges[mEdgeOrder[i]];
+
+            // Strictly inside, as Rect::intersects() has it, so we find what the database's queries would find
+            if(getMin(edge.v1.x, edge.v2.x) < rect.max.x && getMax(edge.v1.x, edge.v2.x) > rect.min.x &&
+               getMin(edge.v1.y, edge.v2.y) < rect.max.y && getMax(edge.v1.y, edge.v2.y) > rect.min.y)
+               callback(mEdgeOrder[i]);
+         }
+      }
+      else
+      {
+         TNLAssert(count + 2 <= MaxDepth, "Wall collision tree is too deep!");
+         stack[count++] = node.first;
+         stack[count++] = nodeIndex + 1;
+      }
+   }
+}
+
+
+bool WallCollisionTree::contains(const DatabaseObject *wall) const
+{
+   S32 low = 0;
+   S32 high = mWalls.size() - 1;
+
+   while(low <= high)
+   {
+      S32 mid = (low + high) / 2;
+
+      if(mWalls[mid].object == wall)
+         return true;
+
+      if(mWalls[mid].object < wall)
+         low = mid + 1;
+      else
+         high = mid - 1;
+   }
+
+   return false;
+}
+
+
+S32 WallCollisionTree::getWallCount() const
+{
+   return mWalls.size();
+}
+
+
+S32 WallCollisionTree::getEdgeCount() const
+{
+   return mEdges.size();
+}
+
+
+struct EdgeCollector
+{
+   Vector<S32> *edges;
+
+   void operator()(S32 edge) { edges->push_back(edge); }
+};
+
+
+// Each wall nearby gets the same treatment PolygonSweptCircleIntersect() would give it, but only the edges close enough
+// to matter are looked at
+DatabaseObject *WallCollisionTree::findFirstSweptCircleHit(const Point &begin, const Point &delta, F32 radius,
+                                                           F32 &fraction, Point &point)
+{
+   Rect queryRect(begin, begin + delta);
+   queryRect.expand(Point(radius, radius));
+
+   mCandidates.clear();
+
+   EdgeCollector collector;
+   collector.edges = &mCandidates;
+   query(queryRect, collector);
+
+   if(mCandidates.size() == 0)
+      return NULL;
+
+   // Each wall's edges are numbered consecutively, so this puts them together
+   std::sort(mCandidates.address(), mCandidates.address() + mCandidates.size());
+
+   F32 radiusSq = radius * radius;
+   DatabaseObject *hitWall = NULL;
+
+   for(S32 i = 0; i < mCandidates.size(); )
+   {
+      const Wall &wall = mWalls[mEdges[mCandidates[i]].wall];
+
+      S32 end = i + 1;
+      while(end < mCandidates.size() && mEdges[mCandidates[end]].wall == mEdges[mCandidates[i]].wall)
+         end++;
+
+      S32 first = i;
+      i = end;
+
+      if(!wall.object->isCollisionEnabled())
+         continue;
+
+      // Already touching, and moving further in?
+      F32 closestSq = radiusSq;
+      bool touching = false;
+      Point hitPoint;
+
+      for(S32 j = first; j < end; j++)
+      {
+         const Edge &edge = mEdges[mCandidates[j]];
+
+         if(circleIntersectsEdge(edge.v1, edge.v1v2, edge.lenSquared, begin, closestSq, hitPoint, &delta))
+            touching = true;
+      }
+
+      F32 hitFraction = 0;
+
+      if(touching)
+      {
+         if(hitPoint == begin)
+            continue;
+      }
+      else
+      {
+         F32 upperBound = 1;
+         bool hit = false;
+
+         for(S32 j = first; j < end; j++)
+         {
+            const Edge &edge = mEdges[mCandidates[j]];
+
+            if(sweptCircleIntersectsEdge(edge.v1, edge.v1v2, edge.lenSquared, begin, delta, 0, 0, radiusSq, upperBound, hitPoint))
+               hit = true;
+         }
+
+         if(!hit)
+            continue;
+
+         hitFraction = upperBound;
+      }
+
+      // Starting inside a wall means we can't hit it; otherwise we'd never be able to get out.  This looks at every
+      // edge of the wall, so we leave it until we know there's a hit.
+      if(polygonContainsPoint(&mVertices[wall.firstEdge], wall.edgeCount, begin))
+         continue;
+
+      if(!hitWall || hitFraction < fraction)
+      {
+         hitWall = wall.object;
+         fraction = hitFraction;
+         point = hitPoint;
+
+         if(fraction == 0)
+            break;
+      }
+   }
+
+   return hitWall;
+}
+
+
+// Same sums as polygonIntersectsSegmentDetailed(), which has its edges going from v2 to v1
+struct WallCollisionTree::RayHitFinder
+{
+   const WallCollisionTree *tree;
+   Point start;
+   Point dp;
+
+   F32 collisionTime;
+   S32 hitEdge;
+
+   void operator()(S32 edgeIndex)
+   {
+      const Edge &edge = tree->mEdges[edgeIndex];
+
+      Point dv = edge.v1 - edge.v2;
+
+      F32 denom = dp.y * dv.x - dp.x * dv.y;
+      if(denom == 0)    // Parallel
+         return;
+
+      F32 s = ( (start.x - edge.v2.x) * dv.y + (edge.v2.y - start.y) * dv.x ) / denom;
+      F32 t = ( (start.x - edge.v2.x) * dp.y + (edge.v2.y - start.y) * dp.x ) / denom;
+
+      if(s >= 0 && s <= 1 && t >= 0 && t <= 1 && s < collisionTime && tree->mWalls[edge.wall].object->isCollisionEnabled())
+      {
+         collisionTime = s;
+         hitEdge = edgeIndex;
+      }
+   }
+};
+
+
+DatabaseObject *WallCollisionTree::findFirstRayHit(const Point &start, const Point &end, F32 &collisionTime, Point &normal) const
+{
+   RayHitFinder finder;
+   finder.tree = this;
+   finder.start = start;
+   finder.dp = end - start;
+   finder.collisionTime = 1;
+   finder.hitEdge = -1;
+
+   query(Rect(start, end), finder);
+
+   if(finder.hitEdge == -1)
+      return NULL;
+
+   collisionTime = finder.collisionTime;
+   normal = mEdges[finder.hitEdge].normal;
+   return mWalls[mEdges[finder.hitEdge].wall].object;
+}
+
+
+};
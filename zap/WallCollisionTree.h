@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _WALL_COLLISION_TREE_H_
+#define _WALL_COLLISION_TREE_H_
+
+#include "Rect.h"
+#include "Point.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+using namespace TNL;
+
+namespace Zap
+{
+
+class DatabaseObject;
+
+// Walls never move, so rather than have everything that moves dig them out of the database and test its path against
+// every edge of every wall nearby, we put all their edges into a bounding volume hierarchy once, when the level is
+// loaded, and let queries find just the edges they're close to.  Built by GridDatabase; see getWallCollisionTree().
+//
+// Queries give exactly the answers the usual polygon tests would give against each wall in turn.
+class WallCollisionTree
+{
+private:
+   // Each edge runs from a vertex, v1, back to the one before it, v2, which is how the polygon tests in GeomUtils walk
+   // them.  The vertex at either end of an edge is an obstacle too, so v1 goes with the edge.
+   struct Edge
+   {
+      Point v1;
+      Point v2;
+      Point v1v2;
+      F32 lenSquared;
+      Point normal;        // Unit length; points outward, as walls are counterclockwise
+      S32 wall;
+   };
+
+   struct Wall
+   {
+      DatabaseObject *object;
+      S32 firstEdge;       // Edges and vertices of a wall are kept together, in order
+      S32 edgeCount;
+   };
+
+   // Leaves have edgeCount > 0, and cover mEdgeOrder[first] to mEdgeOrder[first + edgeCount - 1].  Otherwise we're a
+   // branch; our first child is the next node along, and the other is at index first.
+   struct Node
+   {
+      Rect extent;
+      S32 first;
+      S32 edgeCount;
+   };
+
+   static const S32 MaxEdgesPerLeaf = 4;
+   static const S32 MaxDepth = 64;
+
+   Vector<Point> mVertices;
+   Vector<Edge> mEdges;
+   Vector<Wall> mWalls;          // Sorted by object, so contains() can find them quickly
+   Vector<Node> mNodes;
+   Vector<S32> mEdgeOrder;       // Edge indices, shuffled so each leaf's are together
+
+   Vector<S32> mCandidates;      // Scratch space for findFirstSweptCircleHit()
+
+   struct RayHitFinder;
+
+   S32 buildNode(S32 first, S32 count, const Vector<Rect> &edgeExtents, const Vector<Point> &edgeCenters);
+
+   template <class Callback>
+   void query(const Rect &rect, Callback &callback) const;
+
+public:
+   WallCollisionTree();             // Constructor
+   virtual ~WallCollisionTree();    // Destructor
+
+   void build(const Vector<DatabaseObject *> &walls);
+   void clear();
+
+   bool contains(const DatabaseObject *wall) const;
+   S32 getWallCount() const;
+   S32 getEdgeCount() const;
+
+   // Works like MoveObject::findFirstCollision(), for walls only: a circle moving from begin to begin + delta first
+   // hits returned wall at begin + delta * fraction, touching it at point.  A circle that starts out inside a wall
+   // doesn't hit that wall at all, so it can get out again.  Not thread safe.
+   DatabaseObject *findFirstSweptCircleHit(const Point &begin, const Point &delta, F32 radius, F32 &fraction, Point &point);
+
+   // Works like GridDatabase::findObjectLOS(), for walls only.  Safe to call from any number of threads at once.
+   DatabaseObject *findFirstRayHit(const Point &start, const Point &end, F32 &collisionTime, Point &normal) const;
+};
+
+
+};
+
+#endif
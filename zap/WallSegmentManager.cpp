@@ -16,7 +16,7 @@ namespace Zap
 {
 
 // Statics
-bool WallSegmentManager::mBatchUpdatingGeom = false;
+TNL_THREAD_LOCAL bool WallSegmentManager::mBatchUpdatingGeom = false;
 
 
 // Constructor
@@ -28,7 +28,7 @@ private:
    GridDatabase *mWallSegmentDatabase;
    GridDatabase *mWallEdgeDatabase;
 
-   static bool mBatchUpdatingGeom;     
+   static TNL_THREAD_LOCAL bool mBatchUpdatingGeom;     
 
    void rebuildEdges();
    void buildWallSegmentEdgesAndPoints(GridDatabase *gameDatabase, DatabaseObject *object, const Vector<DatabaseObject *> &engrObjects);
@@ -5,10 +5,17 @@ option(BITFIGHTER_COVERAGE "Add coverage information to the test executable and
 
 set(TEST_SOURCES
 	${CMAKE_SOURCE_DIR}/bitfighter_test/LevelFilesForTesting.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestBitStream.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestBotNavMeshZone.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestBotZoneMeshCache.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestDatabaseAccessThread.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestEditor.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGameType.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGameUserInterface.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGeomUtils.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGlobalChat.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGridDatabase.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestHeadlessRenderer.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestHelpItemManager.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestHttpRequest.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestINISettings.cpp
@@ -16,6 +23,7 @@ set(TEST_SOURCES
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestIntegration.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLevelLoader.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLevelMenuSelectUserInterface.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLevelPreloader.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLoadoutIndicator.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLoadoutTracker.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLuaEnvironment.cpp
@@ -23,16 +31,20 @@ set(TEST_SOURCES
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestMove.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestObjects.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestPolylineGeometry.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestProjectile.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestRenderUtils.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestRobot.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestRobotManager.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestServerGame.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSettings.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestShip.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSocket.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSpawnDelay.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestStringUtils.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSymbolStrings.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSymmetricCipher.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestUtils.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestWallCollisionTree.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/main_test.cpp
 )
 
@@ -91,6 +91,12 @@ IniSettings::IniSettings()
 
    maxDedicatedFPS = 100;             // Max FPS on dedicated server
    maxFPS = 100;                      // Max FPS on client/non-dedicated server
+   packetWriterThreads = 0;           // Write packets on the main thread unless asked otherwise
+   batchedNetworkIO = true;
+   ghostProfileLogInterval = 0;       // Don't profile ghost updates unless asked
+   luaInstructionBudget = 0;          // Scripts can run as long as they like
+   botThreads = 0;                    // Bots share the main thread, and a Lua instance, with the levelgens
+   arenas = 1;
 
    masterAddress = MASTER_SERVER_LIST_ADDRESS;   // Default address of our master server
    name = "";                         // Player name (none by default)
@@ -130,6 +136,9 @@ IniSettings::IniSettings()
    allowLevelgenUpload = true;
 
    enableGameRecording = false;
+   gameRecordingBufferSize = 256;
+   compressGameRecordings = false;     // Older versions can't play compressed recordings back, so admins have to ask for it
+   gameRecordingKeyframeInterval = 30;
 
    voteEnable = false;     // Voting disabled by default
    voteLength = 12;
@@ -644,6 +653,22 @@ static void loadHostConfiguration(CIniFile *ini, IniSettings *iniSettings)
       iniSettings->maxDedicatedFPS = fps; 
    // TODO: else warn?
 
+   S32 packetWriterThreads = ini->GetValueI(section, "PacketWriterThreads", iniSettings->packetWriterThreads);
+   iniSettings->packetWriterThreads = U32(max(packetWriterThreads, 0));
+
+   iniSettings->batchedNetworkIO = ini->GetValueYN(section, "BatchedNetworkIO", iniSettings->batchedNetworkIO);
+
+   S32 ghostProfileLogInterval = ini->GetValueI(section, "GhostProfileLogInterval", iniSettings->ghostProfileLogInterval);
+   iniSettings->ghostProfileLogInterval = U32(max(ghostProfileLogInterval, 0));
+
+   S32 luaInstructionBudget = ini->GetValueI(section, "LuaInstructionBudget", iniSettings->luaInstructionBudget);
+   iniSettings->luaInstructionBudget = U32(max(luaInstructionBudget, 0));
+
+   S32 botThreads = ini->GetValueI(section, "BotThreads", iniSettings->botThreads);
+   iniSettings->botThreads = U32(max(botThreads, 0));
+
+   iniSettings->arenas = max(ini->GetValueI(section, "Arenas", iniSettings->arenas), 1);
+
    iniSettings->logStats = ini->GetValueYN(section, "LogStats", iniSettings->logStats);
 
    //iniSettings->SendStatsToMaster = (lcase(ini->GetValue(section, "SendStatsToMaster", "yes")) != "no");
@@ -684,6 +709,14 @@ static void loadHostConfiguration(CIniFile *ini, IniSettings *iniSettings)
    iniSettings->globalLevelScript  = ini->GetValue(section, "GlobalLevelScript", iniSettings->globalLevelScript);
 
    iniSettings->enableGameRecording = ini->GetValueYN(section, "GameRecording", iniSettings->enableGameRecording);
+
+   S32 gameRecordingBufferSize = ini->GetValueI(section, "GameRecordingBufferSize", iniSettings->gameRecordingBufferSize);
+   iniSettings->gameRecordingBufferSize = U32(max(min(gameRecordingBufferSize, 65536), 32));   // Room for at least one packet
+
+   iniSettings->compressGameRecordings = ini->GetValueYN(section, "CompressGameRecordings", iniSettings->compressGameRecordings);
+
+   S32 keyframeInterval = ini->GetValueI(section, "GameRecordingKeyframeInterval", iniSettings->gameRecordingKeyframeInterval);
+   iniSettings->gameRecordingKeyframeInterval = keyframeInterval <= 0 ? 0 : U32(max(min(keyframeInterval, 3600), 5));
 }
 
 
@@ -1771,6 +1804,19 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
       addComment(" KickIdlePlayers - If true, the server will kick players that are considered idle.");
       addComment(" AlertsVolume - Volume of audio alerts when players join or leave game from 0 (mute) to 10 (full bore).");
       addComment(" MaxFPS - Maximum FPS the dedicaetd server will run at.  Higher values use more CPU, lower may increase lag (default = 100).");
+      addComment(" PacketWriterThreads - Number of extra threads used to work out what each player can see and write their network packets.");
+      addComment("                       Can help busy servers on multi-core machines.  0 does everything on the main thread (default = 0).");
+      addComment(" BatchedNetworkIO - Send and receive many packets with each call to the operating system, rather than one.  Cuts CPU use on");
+      addComment("                    busy servers.  Only has an effect on Linux (default = Yes).");
+      addComment(" GhostProfileLogInterval - Seconds between writing a breakdown of the bandwidth and CPU time used to update each type of");
+      addComment("                           object and each player to the server log.  0 turns this off (default = 0).");
+      addComment(" LuaInstructionBudget - Most Lua instructions each bot or levelgen may run per tick.  Scripts that run out are stopped, and");
+      addComment("                        pick up again next tick.  Setting a budget makes all scripts run somewhat slower.  0 for no limit (default = 0).");
+      addComment(" BotThreads - Number of extra threads used to run bots' onTick.  Each bot added while this is on gets a Lua instance of its own,");
+      addComment("              so bots can no longer share tables with each other or the levelgen.  0 runs all scripts on the main thread (default = 0).");
+      addComment(" Arenas - Number of separate games a dedicated server hosts, on consecutive ports starting with the one in ServerAddress.");
+      addComment("          Each runs on a thread of its own and is listed on the master on its own; they share this server's levels and");
+      addComment("          settings, so /loadini is turned off when there is more than one (default = 1).");
       addComment(" RandomLevels - When current level ends, this can enable randomly switching to any available levels.");
       addComment(" SkipUploads - When current level ends, enables skipping all uploaded levels.");
       addComment(" AllowGetMap - When getmap is allowed, anyone can download the current level using the /getmap command.");
@@ -1779,6 +1825,10 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
       addComment(" LogStats - Save game stats locally to built-in sqlite database (saves the same stats as are sent to the master)");
       addComment(" DefaultRobotScript - If user adds a robot, this script is used if none is specified");
       addComment(" GlobalLevelScript - Specify a levelgen that will get run on every level");
+      addComment(" GameRecording - Record games on this server, so they can be played back later.");
+      addComment(" GameRecordingBufferSize - KB of memory used to hold recorded games until they can be written to disk (default = 256).");
+      addComment(" CompressGameRecordings - Compress recorded games as they are written.  Older versions can't play them back (default = No).");
+      addComment(" GameRecordingKeyframeInterval - Seconds between points in a recorded game that playback can jump straight to, 0 for none (default = 30).");
       addComment(" MySqlStatsDatabaseCredentials - If MySql integration has been compiled in (which it probably hasn't been), you can specify the");
       addComment("                                 database server, database name, login, and password as a comma delimeted list");
       addComment(" VoteLength - number of seconds the voting will last, zero will disable voting.");
@@ -1807,6 +1857,12 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
    ini->setValueYN(section, "AllowGetMap", iniSettings->allowGetMap);
    ini->setValueYN(section, "AllowDataConnections", iniSettings->allowDataConnections);
    ini->SetValueI (section, "MaxFPS", iniSettings->maxDedicatedFPS);
+   ini->SetValueI (section, "PacketWriterThreads", S32(iniSettings->packetWriterThreads));
+   ini->setValueYN(section, "BatchedNetworkIO", iniSettings->batchedNetworkIO);
+   ini->SetValueI (section, "GhostProfileLogInterval", S32(iniSettings->ghostProfileLogInterval));
+   ini->SetValueI (section, "LuaInstructionBudget", S32(iniSettings->luaInstructionBudget));
+   ini->SetValueI (section, "BotThreads", S32(iniSettings->botThreads));
+   ini->SetValueI (section, "Arenas", iniSettings->arenas);
    ini->setValueYN(section, "LogStats", iniSettings->logStats);
 
    ini->setValueYN(section, "RandomLevels", S32(iniSettings->randomLevels) );
@@ -1829,6 +1885,9 @@ static void writeHost(CIniFile *ini, IniSettings *iniSettings)
    ini->SetValue  (section, "GlobalLevelScript", iniSettings->globalLevelScript);
 
    ini->setValueYN(section, "GameRecording", iniSettings->enableGameRecording);
+   ini->SetValueI (section, "GameRecordingBufferSize", S32(iniSettings->gameRecordingBufferSize));
+   ini->setValueYN(section, "CompressGameRecordings", iniSettings->compressGameRecordings);
+   ini->SetValueI (section, "GameRecordingKeyframeInterval", S32(iniSettings->gameRecordingKeyframeInterval));
 #ifdef BF_WRITE_TO_MYSQL
    if(iniSettings->mySqlStatsDatabaseServer == "" && iniSettings->mySqlStatsDatabaseName == "" && iniSettings->mySqlStatsDatabaseUser == "" && iniSettings->mySqlStatsDatabasePassword == "")
       ini->SetValue  (section, "MySqlStatsDatabaseCredentials", "server, dbname, login, password");
@@ -2024,7 +2083,7 @@ FolderManager::FolderManager()
 FolderManager::FolderManager(const string &levelDir, const string &robotDir,    const string &shaderDir, const string &sfxDir,
                              const string &musicDir, const string &iniDir,      const string &logDir,    const string &screenshotDir,
                              const string &luaDir,   const string &rootDataDir, const string &pluginDir, const string &fontsDir,
-                             const string &recordDir) :
+                             const string &recordDir, const string &cacheDir) :
                levelDir      (levelDir),
                robotDir      (robotDir),
                shaderDir     (shaderDir),
@@ -2037,7 +2096,8 @@ FolderManager::FolderManager(const string &levelDir, const string &robotDir,
                rootDataDir   (rootDataDir),
                pluginDir     (pluginDir),
                fontsDir      (fontsDir),
-               recordDir     (recordDir)
+               recordDir     (recordDir),
+               cacheDir      (cacheDir)
 {
    // Do nothing (more)
 }
@@ -2086,6 +2146,7 @@ void FolderManager::resolveDirs(GameSettings *settings)
    folderManager->screenshotDir = resolutionHelper(cmdLineDirs.screenshotDir, rootDataDir, "screenshots");
    folderManager->musicDir      = resolutionHelper(cmdLineDirs.musicDir,      rootDataDir, "music");
    folderManager->recordDir     = resolutionHelper(cmdLineDirs.recordDir,     rootDataDir, "record");
+   folderManager->cacheDir      = resolutionHelper(cmdLineDirs.cacheDir,      rootDataDir, "cache");
 
    // rootDataDir not used for these folders
    folderManager->sfxDir        = resolutionHelper(cmdLineDirs.sfxDir,        "", "sfx");
@@ -2109,6 +2170,7 @@ void FolderManager::resolveDirs(const string &root)
    screenshotDir = joindir(root, "screenshots");
    musicDir      = joindir(root, "music");
    recordDir     = joindir(root, "record");
+   cacheDir      = joindir(root, "cache");
 
    // root not used for these folders
    sfxDir        = joindir("", "sfx");
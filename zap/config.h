@@ -48,7 +48,7 @@ struct FolderManager
    FolderManager(const string &levelDir, const string &robotDir,    const string &shaderDir, const string &sfxDir,
                  const string &musicDir, const string &iniDir,      const string &logDir,    const string &screenshotDir,
                  const string &luaDir,   const string &rootDataDir, const string &pluginDir, const string &fontsDir,
-                 const string &recordDir);
+                 const string &recordDir, const string &cacheDir);
 
    string levelDir;
    string robotDir;
@@ -63,6 +63,7 @@ struct FolderManager
    string pluginDir;
    string fontsDir;
    string recordDir;
+   string cacheDir;
 
    void resolveDirs(GameSettings *settings);                                  
    void resolveDirs(const string &root);
@@ -202,6 +203,12 @@ public:
 
    U32 maxDedicatedFPS;
    U32 maxFPS;
+   U32 packetWriterThreads;         // Worker threads for writing packets to clients; 0 writes them on the main thread
+   bool batchedNetworkIO;           // Send and receive many packets per system call, where the OS allows
+   U32 ghostProfileLogInterval;     // Seconds between ghost update profile dumps to the server log; 0 disables them
+   U32 luaInstructionBudget;        // Lua instructions each bot or levelgen may run per tick; 0 for no limit
+   U32 botThreads;                  // Worker threads for running bots' onTick; 0 runs all scripts on the main thread
+   S32 arenas;                      // Games a dedicated server hosts at once, on consecutive ports
 
 
    string masterAddress;            // Default address of our master server
@@ -227,6 +234,9 @@ public:
    bool enableServerVoiceChat;      // No voice chat allowed in server if disabled
    bool allowTeamChanging;
    bool enableGameRecording;
+   U32 gameRecordingBufferSize;     // KB of memory for recorded packets waiting to be written to disk
+   bool compressGameRecordings;
+   U32 gameRecordingKeyframeInterval;  // Seconds between keyframes playback can seek to, 0 for none
    bool kickIdlePlayers;
 
    S32 connectionSpeed;
@@ -212,7 +212,7 @@ S32 EngineerHelper::getAnimationTime() const
 // Basically draws a red box where the ship is pointing
 void EngineerHelper::renderDeploymentMarker(const Ship *ship)
 {
-   static Point deployPosition, deployNormal;      // Reusable containers
+   static thread_local Point deployPosition, deployNormal;      // Reusable containers
 
    U32 item = engineerItemInfo[mSelectedIndex].itemIndex;
 
@@ -49,7 +49,7 @@ U32 NameToAddressThread::run()
 {
    // This can take a lot of time converting name (such as "bitfighter.org:25955") into IP address.
    mAddress.set(mAddress_string);
-   mDone = true;
+   mDone.store(true);      // Publishes mAddress to the game's thread
    return 0;
 }
 
@@ -57,14 +57,14 @@ U32 NameToAddressThread::run()
 ////////////////////////////////////////
 ////////////////////////////////////////
 
-static Vector<DatabaseObject *> fillVector2;
+static thread_local Vector<DatabaseObject *> fillVector2;
 md5wrapper Game::md5;
 
 ////////////////////////////////////
 ////////////////////////////////////
 
 // Statics
-static Game *mObjectAddTarget = NULL;
+static TNL_THREAD_LOCAL Game *mObjectAddTarget = NULL;
 
 const U32 Game::CurrentLevelFormat = 2;
 
@@ -1025,13 +1025,19 @@ void Game::checkConnectionToMaster(U32 timeDelta)
    {
       Vector<string> *masterServerList = mSettings->getMasterServerList();
 
-      if(masterServerList->size() == 0)
+      GameSettings::getLock().lock();     // Arenas on other threads share the list
+      bool haveMasters = masterServerList->size() > 0;
+      GameSettings::getLock().unlock();
+
+      if(!haveMasters)
          return;
 
       if(mNextMasterTryTime < timeDelta && mReadyToConnectToMaster)
       {
          if(!mNameToAddressThread)
          {
+            GameSettings::getLock().lock();
+
             if(mHaveTriedToConnectToMaster && masterServerList->size() >= 2)
             {  
                // Rotate the list so as to try each one until we find one that works...
@@ -1039,17 +1045,19 @@ void Game::checkConnectionToMaster(U32 timeDelta)
                masterServerList->erase(0);
             }
 
-            const char *addr = masterServerList->get(0).c_str();
+            string addr = masterServerList->get(0);
+
+            GameSettings::getLock().unlock();
 
             mHaveTriedToConnectToMaster = true;
-            logprintf(LogConsumer::LogConnection, "%s connecting to master [%s]", isServer() ? "Server" : "Client", addr);
+            logprintf(LogConsumer::LogConnection, "%s connecting to master [%s]", isServer() ? "Server" : "Client", addr.c_str());
 
-            mNameToAddressThread = new NameToAddressThread(addr);
+            mNameToAddressThread = new NameToAddressThread(addr.c_str());
             mNameToAddressThread->start();
          }
          else
          {
-            if(mNameToAddressThread->mDone)
+            if(mNameToAddressThread->mDone.load())
             {
                if(mNameToAddressThread->mAddress.isValid())
                {
@@ -1090,18 +1098,20 @@ void Game::processAnonymousMasterConnection()
    {
       Vector<string> *masterServerList = mSettings->getMasterServerList();
 
+      GameSettings::getLock().lock();
+      string addr = masterServerList->size() > 0 ? masterServerList->get(0) : "";
+      GameSettings::getLock().unlock();
+
       // No master server addresses?
-      if(masterServerList->size() == 0)
+      if(addr == "")
          return;
 
-      const char *addr = masterServerList->get(0).c_str();
-
-      mNameToAddressThread = new NameToAddressThread(addr);
+      mNameToAddressThread = new NameToAddressThread(addr.c_str());
       mNameToAddressThread->start();
    }
    else
    {
-      if(mNameToAddressThread->mDone)
+      if(mNameToAddressThread->mDone.load())
       {
          if(mNameToAddressThread->mAddress.isValid())
             mAnonymousMasterServerConnection->connect(mNetInterface, mNameToAddressThread->mAddress);
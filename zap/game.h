@@ -25,6 +25,7 @@
 #include "tnlThread.h"
 #include "tnlNonce.h"
 
+#include <atomic>
 #include <string>
 #include <memory>
 
@@ -142,7 +143,7 @@ private:
    string mAddress_string;
 public:
    Address mAddress;
-   bool mDone;
+   atomic<bool> mDone;
 
    explicit NameToAddressThread(const char *address_string);  // Constructor
    virtual ~NameToAddressThread();                            // Destructor
@@ -27,6 +27,8 @@
 #include "Colors.h"
 #include "stringUtils.h"         // For strictjoindir()
 
+#include "tnlThread.h"
+
 
 namespace Zap
 {
@@ -765,8 +767,10 @@ TNL_IMPLEMENT_RPC(GameConnection, c2sSetParam,
       if(paramName != NULL)
       {
          // Update the INI file
+         GameSettings::getLock().lock();
          GameSettings::iniFile.SetValue("Host", paramName, param.getString(), true);
          GameSettings::iniFile.WriteFile();    // Save new INI settings to disk
+         GameSettings::getLock().unlock();
       }
    }
 
@@ -893,15 +897,20 @@ void GameConnection::markCurrentLevelAsDeleted()
 
 string GameConnection::undeleteMostRecentlyDeletedLevel()
 {
+   GameSettings::getLock().lock();
+
    Vector<string> *skipList = mSettings->getLevelSkipList();
+   string name;
 
-   if(skipList->size() == 0)     // No deleted items to undelete
-      return "";
+   if(skipList->size() > 0)      // Otherwise there are no deleted items to undelete
+   {
+      name = skipList->last();
+      skipList->erase(skipList->size() - 1);
 
-   string name = skipList->last();
-   skipList->erase(skipList->size() - 1);
+      mSettings->saveSkipList();
+   }
 
-   mSettings->saveSkipList();
+   GameSettings::getLock().unlock();
 
    return name;
 }
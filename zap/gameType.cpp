@@ -13,6 +13,7 @@
 #include "GameRecorder.h"     // Needed, despite resharper
 #include "GeomUtils.h"
 #include "IniFile.h"          // For CIniFile
+#include "GameManager.h"      // For getArenaThreadCount()
 #include "ServerGame.h"
 #include "robot.h"
 #include "Spawn.h"
@@ -1009,7 +1010,7 @@ void GameType::achievementAchieved(U8 achievement, const StringTableEntry &playe
 }
 
 
-static Vector<StringTableEntry> messageVals;     // Reusable container
+static thread_local Vector<StringTableEntry> messageVals;     // Reusable container
 
 
 // Handle the end-of-game...  handles all games... not in any subclasses
@@ -1362,8 +1363,8 @@ void GameType::performScopeQuery(GhostConnection *connection)
       conn->objectInScope(co);            // Put controlObject in scope ==> This is where the update mask gets set to 0xFFFFFFFF
    }
 
-   // What does the spy bug see?
-   bool sameQuery = false;  // helps speed up by not repeatedly finding same objects
+   // What does the spy bug see?  Results accumulate in query, so we don't repeatedly find the same objects.
+   DatabaseQuery query;
 
    const Vector<DatabaseObject *> *spyBugs = mGame->getGameObjDatabase()->findObjects_fast(SpyBugTypeNumber);
    const Point scopeRange(SpyBug::SPY_BUG_RADIUS, SpyBug::SPY_BUG_RADIUS * FloatSqrt3Half);  // Bounding box of hexagon
@@ -1380,22 +1381,21 @@ void GameType::performScopeQuery(GhostConnection *connection)
 
          queryRect.expand(scopeRange);
 
-         fillVector.clear();
-         mGame->getGameObjDatabase()->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect, sameQuery);
-         sameQuery = true;
+         S32 firstNew = query.size();
+         mGame->getGameObjDatabase()->findObjects((TestFunc)isAnyObjectType, query, queryRect);
 
-         for(S32 j = 0; j < fillVector.size(); j++)
+         for(S32 j = firstNew; j < query.size(); j++)
          {
             // Some objects don't have geometry (ForceFields).  Is this a bug?
-            if(!fillVector[j]->hasGeometry())
+            if(!query[j]->hasGeometry())
                continue;
 
-            if(!pointInHexagon(fillVector[j]->getPos(), pos, SpyBug::SPY_BUG_RADIUS))
+            if(!pointInHexagon(query[j]->getPos(), pos, SpyBug::SPY_BUG_RADIUS))
                continue;
 
-            connection->objectInScope(static_cast<BfObject *>(fillVector[j]));
-            if(isShipType(fillVector[j]->getObjectTypeNumber()))
-               markAllMountedItemsAsBeingInScope(static_cast<Ship *>(fillVector[j]), conn);
+            connection->objectInScope(static_cast<BfObject *>(query[j]));
+            if(isShipType(query[j]->getObjectTypeNumber()))
+               markAllMountedItemsAsBeingInScope(static_cast<Ship *>(query[j]), conn);
          }
       }
    }
@@ -1430,11 +1430,11 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
    GameConnection *connection = clientInfo->getConnection();
    TNLAssert(connection, "NULL gameConnection!");
 
+   DatabaseQuery query;    // Results accumulate here, so we don't repeatedly find the same objects
+
    if(isTeamGame() && connection->isInCommanderMap())
    {
       S32 teamId = clientInfo->getTeamIndex();
-      fillVector.clear();
-      bool sameQuery = false;  // helps speed up by not repeatedly finding same objects
 
       for(S32 i = 0; i < mGame->getClientCount(); i++)
       {
@@ -1459,8 +1459,7 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
             else     // No sensor
                testFunc = &isVisibleOnCmdrsMapType;
 
-         mGame->getGameObjDatabase()->findObjects(testFunc, fillVector, queryRect, sameQuery);
-         sameQuery = true;
+         mGame->getGameObjDatabase()->findObjects(testFunc, query, queryRect);
       }
    }
    else     // Not a team game OR not in commander's map -- Do a simple query of the objects within scope range of the ship
@@ -1473,16 +1472,15 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
       Rect queryRect(pos, pos);
       queryRect.expand( mGame->getScopeRange(co->hasModule(ModuleSensor)) );
 
-      fillVector.clear();
-      mGame->getGameObjDatabase()->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect);
+      mGame->getGameObjDatabase()->findObjects((TestFunc)isAnyObjectType, query, queryRect);
    }
 
    // Set object-in-scope for all objects found above
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < query.size(); i++)
    {
-      connection->objectInScope(static_cast<BfObject *>(fillVector[i]));
-      if(isShipType(fillVector[i]->getObjectTypeNumber()))
-         markAllMountedItemsAsBeingInScope(static_cast<Ship *>(fillVector[i]), connection);
+      connection->objectInScope(static_cast<BfObject *>(query[i]));
+      if(isShipType(query[i]->getObjectTypeNumber()))
+         markAllMountedItemsAsBeingInScope(static_cast<Ship *>(query[i]), connection);
    }
 
    // Make bots visible if showAllBots has been activated
@@ -2692,10 +2690,18 @@ void GameType::processServerCommand(ClientInfo *clientInfo, const char *cmd, Vec
       serverGame->voteClient(clientInfo, false);
    else if(stricmp(cmd, "loadini") == 0 || stricmp(cmd, "loadsetting") == 0)
    {
-      if(clientInfo->isAdmin())
+      // Every arena reads the one set of settings, unlocked, and has its own Lua and bot threads to reconfigure
+      if(clientInfo->isAdmin() && GameManager::getArenaThreadCount() > 0)
+         clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Can't reload settings while hosting more than one arena; restart the server instead");
+      else if(clientInfo->isAdmin())
       {
          bool prev_enableServerVoiceChat = serverGame->getSettings()->getIniSettings()->enableServerVoiceChat;
+         GameSettings::getLock().lock();
          loadSettingsFromINI(&GameSettings::iniFile, serverGame->getSettings());    // Why??
+         GameSettings::getLock().unlock();
+
+         LuaScriptRunner::setInstructionBudget(serverGame->getSettings()->getIniSettings()->luaInstructionBudget);
+         LuaScriptRunner::setScriptThreadCount(serverGame->getSettings()->getIniSettings()->botThreads);
 
          if(prev_enableServerVoiceChat != serverGame->getSettings()->getIniSettings()->enableServerVoiceChat)
             for(S32 i = 0; i < mGame->getClientCount(); i++)
@@ -2709,11 +2715,102 @@ void GameType::processServerCommand(ClientInfo *clientInfo, const char *cmd, Vec
       else
          clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Need admin");
    }
+   else if(stricmp(cmd, "ghostprofile") == 0)
+      processGhostProfileCommand(clientInfo, args);
+   else if(stricmp(cmd, "scriptstats") == 0)
+      processScriptStatsCommand(clientInfo, args);
    else
       clientInfo->getConnection()->s2cDisplayErrorMessage("!!! Invalid Command");
 }
 
 
+// /ghostprofile [on | off | reset | log] -- with no args, shows the current profile
+void GameType::processGhostProfileCommand(ClientInfo *clientInfo, const Vector<StringPtr> &args)
+{
+   ServerGame *serverGame = static_cast<ServerGame *>(mGame);
+   GameConnection *conn = clientInfo->getConnection();
+
+   if(!clientInfo->isAdmin())
+   {
+      conn->s2cDisplayErrorMessage("!!! Need admin");
+      return;
+   }
+
+   const char *option = args.size() > 0 ? args[0].getString() : "";
+
+   if(stricmp(option, "on") == 0)
+   {
+      serverGame->setGhostProfilingEnabled(true);
+      conn->s2cDisplayMessage(GameConnection::ColorInfo, SFXNone, "Ghost profiling on");
+   }
+   else if(stricmp(option, "off") == 0)
+   {
+      serverGame->setGhostProfilingEnabled(false);
+      conn->s2cDisplayMessage(GameConnection::ColorInfo, SFXNone, "Ghost profiling off");
+   }
+   else if(stricmp(option, "reset") == 0)
+   {
+      serverGame->resetGhostProfile();
+      conn->s2cDisplayMessage(GameConnection::ColorInfo, SFXNone, "Ghost profile reset");
+   }
+   else if(stricmp(option, "log") == 0)
+   {
+      serverGame->logGhostProfile();
+      conn->s2cDisplayMessage(GameConnection::ColorInfo, SFXNone, "Ghost profile written to server log");
+   }
+   else if(option[0])
+      conn->s2cDisplayErrorMessage("!!! Usage: /ghostprofile [on | off | reset | log]");
+   else if(!GhostConnection::isProfilingEnabled())
+      conn->s2cDisplayErrorMessage("!!! Ghost profiling is off -- turn it on with /ghostprofile on");
+   else
+   {
+      Vector<string> lines;
+      serverGame->getGhostProfileReport(lines, false);
+
+      Vector<StringTableEntry> message;
+      for(S32 i = 0; i < lines.size(); i++)
+         message.push_back(StringTableEntry(lines[i].c_str(), false));
+
+      conn->s2cDisplayMessageBox("Ghost Profile", "Press [[Esc]] to continue", message);
+   }
+}
+
+
+// /scriptstats [reset] -- with no args, shows how much CPU each bot and levelgen has used
+void GameType::processScriptStatsCommand(ClientInfo *clientInfo, const Vector<StringPtr> &args)
+{
+   ServerGame *serverGame = static_cast<ServerGame *>(mGame);
+   GameConnection *conn = clientInfo->getConnection();
+
+   if(!clientInfo->isAdmin())
+   {
+      conn->s2cDisplayErrorMessage("!!! Need admin");
+      return;
+   }
+
+   const char *option = args.size() > 0 ? args[0].getString() : "";
+
+   if(stricmp(option, "reset") == 0)
+   {
+      serverGame->resetScriptStats();
+      conn->s2cDisplayMessage(GameConnection::ColorInfo, SFXNone, "Script stats reset");
+   }
+   else if(option[0])
+      conn->s2cDisplayErrorMessage("!!! Usage: /scriptstats [reset]");
+   else
+   {
+      Vector<string> lines;
+      serverGame->getScriptStatsReport(lines);
+
+      Vector<StringTableEntry> message;
+      for(S32 i = 0; i < lines.size(); i++)
+         message.push_back(StringTableEntry(lines[i].c_str(), false));
+
+      conn->s2cDisplayMessageBox("Script Stats", "Press [[Esc]] to continue", message);
+   }
+}
+
+
 bool GameType::canClientAddBots(GameConnection *conn, bool checkDefaultBot)
 {
    ClientInfo *clientInfo = conn->getClientInfo();
@@ -3051,12 +3148,16 @@ GAMETYPE_RPC_C2S(GameType, c2sBanPlayer, (StringTableEntry playerName, U32 durat
    settings->getBanList()->addToBanList(ipAddress, banDuration, !bannedClientInfo->isAuthenticated());  // non-authenticated only if player is not authenticated
    logprintf(LogConsumer::ServerFilter, "%s was banned for %d minutes", ipAddress.toString(), banDuration);
 
+   GameSettings::getLock().lock();
+
    // Save BanList in memory
    writeServerBanList(&GameSettings::iniFile, settings->getBanList());
 
    // Save new INI settings to disk
    GameSettings::iniFile.WriteFile();
 
+   GameSettings::getLock().unlock();
+
    GameConnection *conn = clientInfo->getConnection();
 
    // Disconnect player
@@ -3105,12 +3206,16 @@ GAMETYPE_RPC_C2S(GameType, c2sBanIp, (StringTableEntry ipAddressString, U32 dura
    settings->getBanList()->addToBanList(ipAddress, banDuration, true);  // most problem comes from non-authenticated users
    logprintf(LogConsumer::ServerFilter, "%s - banned for %d minutes", ipAddress.toString(), banDuration);
 
+   GameSettings::getLock().lock();
+
    // Save BanList in memory
    writeServerBanList(&GameSettings::iniFile, settings->getBanList());
 
    // Save new INI settings to disk
    GameSettings::iniFile.WriteFile();
 
+   GameSettings::getLock().unlock();
+
 
    if(!playerDisconnected)
       conn->s2cDisplayMessage(GameConnection::ColorRed, SFXNone, "Client has been banned but is no longer connected");
@@ -3585,10 +3690,10 @@ GAMETYPE_RPC_C2S(GameType, c2sSelectWeapon, (RangedU32<0, ShipWeaponCount> indx)
 }
 
 
-Vector<RangedU32<0, GameType::MaxPing> > GameType::mPingTimes; ///< Static vector used for constructing update RPCs
+thread_local Vector<RangedU32<0, GameType::MaxPing> > GameType::mPingTimes; ///< Static vector used for constructing update RPCs
 
-Vector<Int<10> > GameType::mKills;
-Vector<Int<10> > GameType::mDeaths;
+thread_local Vector<Int<10> > GameType::mKills;
+thread_local Vector<Int<10> > GameType::mDeaths;
 
 void GameType::updateClientScoreboard(GameConnection *gc)
 {
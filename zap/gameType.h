@@ -260,10 +260,10 @@ public:
    virtual S32 getEventScore(ScoringGroup scoreGroup, ScoringEvent scoreEvent, S32 data);
    static string getScoringEventDescr(ScoringEvent event);
 
-   // Static vectors used for constructing update RPCs
-   static Vector<RangedU32<0, MaxPing> > mPingTimes;
-   static Vector<Int<10> > mKills;
-   static Vector<Int<10> > mDeaths;
+   // Static vectors used for constructing update RPCs; one set per thread hosting a game
+   static thread_local Vector<RangedU32<0, MaxPing> > mPingTimes;
+   static thread_local Vector<Int<10> > mKills;
+   static thread_local Vector<Int<10> > mDeaths;
 
    explicit GameType(S32 winningScore = DefaultWinningScore);    // Constructor
    virtual ~GameType();                                 // Destructor
@@ -508,12 +508,12 @@ public:
    virtual void majorScoringEventOcurred(S32 team);    // Gets called when touchdown is scored...  currently only used by zone control & retrieve
 
    void processServerCommand(ClientInfo *clientInfo, const char *cmd, Vector<StringPtr> args);
+   void processGhostProfileCommand(ClientInfo *clientInfo, const Vector<StringPtr> &args);
+   void processScriptStatsCommand(ClientInfo *clientInfo, const Vector<StringPtr> &args);
    bool canClientAddBots(GameConnection *source, bool checkDefaultBot = true);
    bool addBotFromClient(Vector<StringTableEntry> args);
 
    void displayAnnouncement(const string &message) const;
-
-   map <pair<U16,U16>, Vector<Point> > cachedBotFlightPlans;  // cache of zone-to-zone flight plans, shared for all bots
 };
 
 #define GAMETYPE_RPC_S2C(className, methodName, args, argNames) \
@@ -6,6 +6,7 @@
 #include "gridDB.h"
 #include "moveObject.h"    // For def of ActualState
 #include "WallSegmentManager.h"
+#include "WallCollisionTree.h"
 #include "GeomUtils.h"
 
 #include "tnlLog.h"
@@ -13,13 +14,12 @@
 namespace Zap
 {
 
-U32 GridDatabase::mQueryId = 0;
-ClassChunker<DatabaseBucketEntry> *GridDatabase::mChunker = NULL;
-U32 GridDatabase::mCountGridDatabase = 0;
+TNL_THREAD_LOCAL ClassChunker<DatabaseBucketEntry> *GridDatabase::mChunker = NULL;
+TNL_THREAD_LOCAL U32 GridDatabase::mCountGridDatabase = 0;
 
 static U32 getNextId() 
 {
-   static U32 nextId = 0;
+   static TNL_THREAD_LOCAL U32 nextId = 0;
    return nextId++;
 }
 
@@ -27,7 +27,7 @@ static U32 getNextId()
 GridDatabase::GridDatabase(bool createWallSegmentManager)
 {
    if(mChunker == NULL)
-      mChunker = new ClassChunker<DatabaseBucketEntry>();        // Static shared by all databases, reference counted and deleted in destructor
+      mChunker = new ClassChunker<DatabaseBucketEntry>();        // Shared by all of this thread's databases, reference counted and deleted in destructor
 
    mCountGridDatabase++;
 
@@ -40,6 +40,13 @@ GridDatabase::GridDatabase(bool createWallSegmentManager)
    else
       mWallSegmentManager = NULL;
 
+   mSpatialIndexType = BucketGridIndex;
+   mTree = NULL;
+
+   mWallTree = NULL;
+   mWallTreeDirty = true;
+   mWallTreeHasAllWalls = false;
+
    mDatabaseId = getNextId();
 }
 
@@ -64,6 +71,9 @@ GridDatabase::~GridDatabase()
    if(mWallSegmentManager)
       delete mWallSegmentManager;
 
+   delete mTree;
+   delete mWallTree;
+
    mCountGridDatabase--;
 
    if(mCountGridDatabase == 0)
@@ -105,6 +115,7 @@ void GridDatabase::copyObjects(const GridDatabase *source)
    mGoalZones .reserve(source->mGoalZones.size());
    mFlags     .reserve(source->mFlags.size());
    mSpyBugs   .reserve(source->mSpyBugs.size());
+   mBullets   .reserve(source->mBullets.size());
 
 
    for(S32 i = 0; i < source->mAllObjects.size(); i++)
@@ -127,23 +138,7 @@ void GridDatabase::addToDatabase(DatabaseObject *theObject)
 
    theObject->mDatabase = this;
 
-   static IntRect bins;
-   fillBins(theObject->getExtent(), bins);
-
-   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
-      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
-      {
-         DatabaseBucketEntry *be = mChunker->alloc();
-         DatabaseBucketEntryBase *base = &mBuckets[x & BucketMask][y & BucketMask];
-         be->theObject = theObject;
-         if(base->nextInBucket)
-            base->nextInBucket->prevInBucket = be;
-         be->nextInBucket = base->nextInBucket;
-         be->prevInBucket = base;
-         base->nextInBucket = be;
-         be->nextInBucketForThisObject = theObject->mBucketList;
-         theObject->mBucketList = be;
-      }
+   addToIndex(theObject);
 
    // Add the object to our non-spatial "database" as well
    mAllObjects.push_back(theObject);
@@ -155,6 +150,11 @@ void GridDatabase::addToDatabase(DatabaseObject *theObject)
       mFlags.push_back(theObject);
    else if(type == SpyBugTypeNumber)
       mSpyBugs.push_back(theObject);
+   else if(type == BulletTypeNumber)
+      mBullets.push_back(theObject);
+
+   if(isWallType(type))
+      mWallTreeDirty = true;
    
    //sortObjects(mAllObjects);  // problem: Barriers in-game don't have mGeometry (it is NULL)
 }
@@ -186,12 +186,26 @@ void GridDatabase::removeEverythingFromDatabase()
       }
    }
 
+   // The tree doesn't let us walk its contents like the buckets above, but everything in it is also in mAllObjects
+   if(mTree)
+   {
+      for(S32 i = 0; i < mAllObjects.size(); i++)
+      {
+         mAllObjects[i]->mDatabase = NULL;
+         mAllObjects[i]->mTreeProxy = DynamicAABBTree::NullNode;
+      }
+
+      mTree->clear();
+   }
+
    // Clear out our specialty lists -- since objects are also in mAllObjects, they'll be deleted below
    mGoalZones.clear();
    mFlags.clear();
    mSpyBugs.clear();
+   mBullets.clear();
 
    mAllObjects.deleteAndClear();
+   mWallTreeDirty = true;
    
    if(mWallSegmentManager)
       mWallSegmentManager->clear();
@@ -216,24 +230,9 @@ void GridDatabase::removeFromDatabase(DatabaseObject *object, bool deleteObject)
    if(object->mDatabase != this)
       return;
 
-   const Rect &extents = object->mExtent;
+   removeFromIndex(object);
    object->mDatabase = NULL;
 
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   while(object->mBucketList)
-   {
-      DatabaseBucketEntry *b = object->mBucketList;
-      TNLAssert(b->theObject == object, "Object mismatch");
-      TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
-      if(b->nextInBucket)
-         b->nextInBucket->prevInBucket = b->prevInBucket;
-      b->prevInBucket->nextInBucket = b->nextInBucket;
-      object->mBucketList = b->nextInBucketForThisObject;
-      mChunker->free(b);
-   }
-
    // Find and delete object from our non-spatial databases
    for(S32 i = 0; i < mAllObjects.size(); i++)
       if(mAllObjects[i] == object)
@@ -244,13 +243,19 @@ void GridDatabase::removeFromDatabase(DatabaseObject *object, bool deleteObject)
 
 
    U8 type = object->getObjectTypeNumber();
+   bool deleted = (type == DeletedTypeNumber);     // Deleted objects could have been anything, so check every list
 
-   if(type == GoalZoneTypeNumber)
+   if(type == GoalZoneTypeNumber || deleted)
       eraseObject_fast(&mGoalZones, object);
-   else if(type == FlagTypeNumber)
+   if(type == FlagTypeNumber || deleted)
       eraseObject_fast(&mFlags, object);
-   else if(type == SpyBugTypeNumber)
+   if(type == SpyBugTypeNumber || deleted)
       eraseObject_fast(&mSpyBugs, object);
+   if(type == BulletTypeNumber || deleted)
+      eraseObject_fast(&mBullets, object);
+
+   if(isWallType(type) || (deleted && mWallTree && mWallTree->contains(object)))
+      mWallTreeDirty = true;
 
    if(deleteObject)
       delete object;      
@@ -285,40 +290,139 @@ const Vector<DatabaseObject *> *GridDatabase::findObjects_fast(U8 typeNumber) co
    if(typeNumber == SpyBugTypeNumber)
       return &mSpyBugs;
 
+   if(typeNumber == BulletTypeNumber)
+      return &mBullets;
+
    TNLAssert(false, "This type not currently supported!  Sorry dude!");
    return NULL;  // this line gets rid of compile warning "Not all control paths return a value"
 }
 
 
-void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const
+// Type tests for findObjectsInExtents()
+struct SingleTypeTest
 {
-   static Vector<U8> types;
-   types.resize(1);
+   U8 typeNumber;
+   explicit SingleTypeTest(U8 typeNumber) : typeNumber(typeNumber) { }
+   bool operator()(U8 objectType) const { return objectType == typeNumber; }
+};
 
-   types[0] = typeNumber;
 
-   findObjects(types, fillVector, extents, bins);
-}
+struct TypeListTest
+{
+   const Vector<U8> &types;
+   explicit TypeListTest(const Vector<U8> &types) : types(types) { }
+   bool operator()(U8 objectType) const
+   {
+      for(S32 i = 0; i < types.size(); i++)
+         if(types[i] == objectType)
+            return true;
+
+      return false;
+   }
+};
 
 
-void GridDatabase::findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const
+// Gathers up objects found by either index
+template <class TypeTest>
+struct GridDatabase::QueryCollector
 {
-   mQueryId++;    // Used to prevent the same item from being found in multiple buckets
+   const TypeTest &typeTest;
+   DatabaseQuery &query;
+   Rect extents;
+   bool checkDuplicates;
+
+   QueryCollector(const TypeTest &typeTest, DatabaseQuery &query, const Rect &extents, bool checkDuplicates) :
+         typeTest(typeTest), query(query), extents(extents), checkDuplicates(checkDuplicates) { }
+
+   void operator()(void *userData)
+   {
+      DatabaseObject *theObject = static_cast<DatabaseObject *>(userData);
+
+      if(typeTest(theObject->getObjectTypeNumber()) &&              // Object is of the right type; and
+         theObject->mExtent.intersects(extents) &&                  // overlaps our extents; and
+         (!checkDuplicates || query.markSeen(theObject)))           // hasn't already been found
+         query.add(theObject);
+   }
+};
+
+
+// Every extent query ends up here, regardless of which index this database is using
+template <class TypeTest>
+void GridDatabase::findObjectsInExtents(const TypeTest &typeTest, DatabaseQuery &query, const Rect &extents) const
+{
+   // Objects can span several buckets, so the grid always needs to weed out duplicates.  Every object lives in exactly
+   // one tree leaf, so the tree only needs to if the query already has results from an earlier search.
+   bool checkDuplicates = !mTree || !query.isEmpty();
+
+   if(checkDuplicates)
+      query.prepareForDuplicates();
+
+   QueryCollector<TypeTest> collector(typeTest, query, extents, checkDuplicates);
+
+   if(mTree)
+   {
+      mTree->query(extents, collector);
+      return;
+   }
+
+   IntRect bins;
+   fillBins(extents, bins);
 
-   for(S32 x = bins->minx; bins->maxx - x >= 0; x++)
-      for(S32 y = bins->miny; bins->maxy - y >= 0; y++)
+   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
+      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
          for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
-         {
-            DatabaseObject *theObject = walk->theObject;
+            collector(walk->theObject);
+}
 
-            if(theObject->mLastQueryId != mQueryId &&                         // Object hasn't been queried; and
-               testTypes(typeNumbers, theObject->getObjectTypeNumber()) &&    // is of the right type; and
-               (!extents || theObject->mExtent.intersects(*extents)) )        // overlaps our extents (if passed)
-            {
-               walk->theObject->mLastQueryId = mQueryId;    // Flag the object so we know we've already visited it
-               fillVector.push_back(walk->theObject);       // And save it as a found item
-            }
-         }
+
+// Non-spatial version of the above; mAllObjects has no duplicates, so we only need to check for them when adding to earlier results
+template <class TypeTest>
+void GridDatabase::findAllObjects(const TypeTest &typeTest, DatabaseQuery &query) const
+{
+   bool checkDuplicates = !query.isEmpty();
+
+   if(checkDuplicates)
+      query.prepareForDuplicates();
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      if(typeTest(mAllObjects[i]->getObjectTypeNumber()) && (!checkDuplicates || query.markSeen(mAllObjects[i])))
+         query.add(mAllObjects[i]);
+}
+
+
+void GridDatabase::findObjects(U8 typeNumber, DatabaseQuery &query) const
+{
+   findAllObjects(SingleTypeTest(typeNumber), query);
+}
+
+
+void GridDatabase::findObjects(U8 typeNumber, DatabaseQuery &query, const Rect &extents) const
+{
+   findObjectsInExtents(SingleTypeTest(typeNumber), query, extents);
+}
+
+
+void GridDatabase::findObjects(TestFunc testFunc, DatabaseQuery &query) const
+{
+   findAllObjects(testFunc, query);
+}
+
+
+void GridDatabase::findObjects(TestFunc testFunc, DatabaseQuery &query, const Rect &extents) const
+{
+   findObjectsInExtents(testFunc, query, extents);
+}
+
+
+void GridDatabase::findObjects(const Vector<U8> &types, DatabaseQuery &query) const
+{
+   findAllObjects(TypeListTest(types), query);
+}
+
+
+void GridDatabase::findObjects(const Vector<U8> &types, DatabaseQuery &query, const Rect &extents) const
+{
+   findObjectsInExtents(TypeListTest(types), query, extents);
 }
 
 
@@ -375,33 +479,9 @@ void GridDatabase::fillBins(const Rect &extents, IntRect &bins) const
 // Find all objects in &extents that are of type typeNumber
 void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   findObjects(typeNumber, fillVector, &extents, &bins);
-}
-
-
-void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins, bool sameQuery) const
-{
-   TNLAssert(this, "findObjects 'this' is NULL");
-   if(!sameQuery)
-      mQueryId++;    // Used to prevent the same item from being found in multiple buckets
-
-   for(S32 x = bins->minx; bins->maxx - x >= 0; x++)
-      for(S32 y = bins->miny; bins->maxy - y >= 0; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
-         {
-            DatabaseObject *theObject = walk->theObject;
-
-            if(theObject->mLastQueryId != mQueryId &&                      // Object hasn't been queried; and
-               (testFunc(theObject->getObjectTypeNumber())) &&             // is of the right type; and
-               (!extents || theObject->mExtent.intersects(*extents)) )     // overlaps our extents (if passed)
-            {
-               walk->theObject->mLastQueryId = mQueryId;    // Flag the object so we know we've already visited it
-               fillVector.push_back(walk->theObject);       // And save it as a found item
-            }
-         }
+   DatabaseQuery query;
+   findObjectsInExtents(SingleTypeTest(typeNumber), query, extents);
+   query.toVector(fillVector);
 }
 
 
@@ -417,10 +497,9 @@ void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fill
 // Find all objects in database using derived type test function
 void GridDatabase::findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   findObjects(types, fillVector, &extents, &bins);
+   DatabaseQuery query;
+   findObjectsInExtents(TypeListTest(types), query, extents);
+   query.toVector(fillVector);
 }
 
 
@@ -459,17 +538,27 @@ bool GridDatabase::testTypes(const Vector<U8> &types, U8 objectType) const
 
 
 // Find all objects in &extents derived type test function
-void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, bool sameQuery) const
+void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   findObjects(testFunc, fillVector, &extents, &bins, sameQuery);
+   DatabaseQuery query;
+   findObjectsInExtents(testFunc, query, extents);
+   query.toVector(fillVector);
 }
 
 
 void GridDatabase::dumpObjects()
 {
+   if(mTree)
+   {
+      for(S32 i = 0; i < mAllObjects.size(); i++)
+      {
+         DatabaseObject *theObject = mAllObjects[i];
+         logprintf("Found object in tree leaf %d with extents %s", theObject->mTreeProxy, theObject->getExtent().toString().c_str());
+         logprintf("Obj coords: %s", static_cast<BfObject *>(theObject)->getPos().toString().c_str());
+      }
+      return;
+   }
+
    for(S32 x = 0; x < BucketRowCount; x++)
       for(S32 y = 0; y < BucketRowCount; y++)
          for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
@@ -533,6 +622,328 @@ WallSegmentManager *GridDatabase::getWallSegmentManager() const
 }
 
 
+GridDatabase::SpatialIndexType GridDatabase::getSpatialIndexType() const
+{
+   return mSpatialIndexType;
+}
+
+
+// Switch indices, moving any objects already in the database over to the new one
+void GridDatabase::setSpatialIndexType(SpatialIndexType indexType)
+{
+   if(indexType == mSpatialIndexType)
+      return;
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      removeFromIndex(mAllObjects[i]);
+
+   mSpatialIndexType = indexType;
+
+   if(mSpatialIndexType == AABBTreeIndex)
+   {
+      if(!mTree)
+         mTree = new DynamicAABBTree(AABBTreeMargin);    // Deleted in destructor
+   }
+   else
+   {
+      delete mTree;
+      mTree = NULL;
+   }
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      addToIndex(mAllObjects[i]);
+}
+
+
+// The bucket grid wraps around every (BucketRowCount << BucketWidthBitShift) pixels, so on levels larger than that,
+// objects that are far apart share buckets and every query wades through them.  Lots of objects clog the buckets
+// too.  Use the tree in either of those cases, and stick with the cheaper grid otherwise.
+void GridDatabase::chooseSpatialIndexType()
+{
+   const F32 gridSpan = F32(BucketRowCount << BucketWidthBitShift);
+
+   Rect extents = getExtents();
+
+   bool useTree = extents.getWidth()  > gridSpan ||
+                  extents.getHeight() > gridSpan ||
+                  mAllObjects.size()  > AABBTreeObjectThreshold;
+
+   setSpatialIndexType(useTree ? AABBTreeIndex : BucketGridIndex);
+}
+
+
+void GridDatabase::addToIndex(DatabaseObject *theObject)
+{
+   if(mTree)
+   {
+      theObject->mTreeProxy = mTree->createProxy(theObject->mExtent, theObject);
+      return;
+   }
+
+   IntRect bins;
+   fillBins(theObject->mExtent, bins);
+
+   // Don't use x <= maxx, it will endless loop if maxx = S32_MAX and x overflows
+   // Instead, use maxx - x >= 0, it will better handle overflows and avoid endless loop (MIN_S32 - MAX_S32 = +1)
+   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
+      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
+      {
+         DatabaseBucketEntry *be = mChunker->alloc();
+         DatabaseBucketEntryBase *base = &mBuckets[x & BucketMask][y & BucketMask];
+         be->theObject = theObject;
+         if(base->nextInBucket)
+            base->nextInBucket->prevInBucket = be;
+         be->nextInBucket = base->nextInBucket;
+         be->prevInBucket = base;
+         base->nextInBucket = be;
+         be->nextInBucketForThisObject = theObject->mBucketList;
+         theObject->mBucketList = be;
+      }
+}
+
+
+void GridDatabase::removeFromIndex(DatabaseObject *theObject)
+{
+   if(mTree)
+   {
+      if(theObject->mTreeProxy != DynamicAABBTree::NullNode)
+         mTree->destroyProxy(theObject->mTreeProxy);
+
+      theObject->mTreeProxy = DynamicAABBTree::NullNode;
+      return;
+   }
+
+   while(theObject->mBucketList)
+   {
+      DatabaseBucketEntry *b = theObject->mBucketList;
+      TNLAssert(b->theObject == theObject, "Object mismatch");
+      TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
+      if(b->nextInBucket)
+         b->nextInBucket->prevInBucket = b->prevInBucket;
+      b->prevInBucket->nextInBucket = b->nextInBucket;
+      theObject->mBucketList = b->nextInBucketForThisObject;
+      mChunker->free(b);
+   }
+}
+
+
+// Object's extent has changed from oldExtents to whatever it is now
+void GridDatabase::updateIndex(DatabaseObject *theObject, const Rect &oldExtents)
+{
+   if(isWallType(theObject->getObjectTypeNumber()))
+      mWallTreeDirty = true;
+
+   if(mTree)
+   {
+      mTree->moveProxy(theObject->mTreeProxy, theObject->mExtent);
+      return;
+   }
+
+   IntRect oldBins, newBins;
+   fillBins(oldExtents, oldBins);
+   fillBins(theObject->mExtent, newBins);
+
+   // Don't do anything if the buckets haven't changed...
+   if((oldBins.minx - newBins.minx) | (oldBins.miny - newBins.miny) | (oldBins.maxx - newBins.maxx) | (oldBins.maxy - newBins.maxy))
+   {
+      // They are different... remove and readd to index, but don't touch mAllObjects
+      removeFromIndex(theObject);
+      addToIndex(theObject);
+   }
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+DatabaseQuery::DatabaseQuery()
+{
+   mResults = mInlineResults;
+   mCapacity = InlineCapacity;
+   mCount = 0;
+
+   mSeen = mInlineSeen;
+   mSeenMask = InlineSeenCapacity - 1;
+   mSeenCount = 0;
+
+   for(S32 i = 0; i < InlineSeenCapacity; i++)
+      mSeen[i] = NULL;
+}
+
+
+// Copy constructor -- our storage pointers can't be shared, so we copy the results into storage of our own
+DatabaseQuery::DatabaseQuery(const DatabaseQuery &other)
+{
+   mResults = mInlineResults;
+   mCapacity = InlineCapacity;
+   mCount = 0;
+
+   mSeen = mInlineSeen;
+   mSeenMask = InlineSeenCapacity - 1;
+   mSeenCount = 0;
+
+   for(S32 i = 0; i < InlineSeenCapacity; i++)
+      mSeen[i] = NULL;
+
+   *this = other;
+}
+
+
+DatabaseQuery &DatabaseQuery::operator=(const DatabaseQuery &other)
+{
+   if(this == &other)
+      return *this;
+
+   clear();
+
+   for(S32 i = 0; i < other.mCount; i++)
+      add(other.mResults[i]);
+
+   if(other.mSeenCount > 0)
+      prepareForDuplicates();
+
+   return *this;
+}
+
+
+// Destructor
+DatabaseQuery::~DatabaseQuery()
+{
+   // Do nothing
+}
+
+
+// Forget our results, but hang on to any storage we've grown into so reusing this query won't allocate
+void DatabaseQuery::clear()
+{
+   if(mSeenCount > 0)
+      for(U32 i = 0; i <= mSeenMask; i++)
+         mSeen[i] = NULL;
+
+   mCount = 0;
+   mSeenCount = 0;
+}
+
+
+S32 DatabaseQuery::size() const
+{
+   return mCount;
+}
+
+
+bool DatabaseQuery::isEmpty() const
+{
+   return mCount == 0;
+}
+
+
+DatabaseObject *DatabaseQuery::get(S32 index) const
+{
+   TNLAssert(index >= 0 && index < mCount, "Index out of range!");
+   return mResults[index];
+}
+
+
+DatabaseObject *DatabaseQuery::operator[](S32 index) const
+{
+   return get(index);
+}
+
+
+void DatabaseQuery::toVector(Vector<DatabaseObject *> &fillVector) const
+{
+   S32 start = fillVector.size();
+   fillVector.resize(start + mCount);
+
+   for(S32 i = 0; i < mCount; i++)
+      fillVector[start + i] = mResults[i];
+}
+
+
+void DatabaseQuery::add(DatabaseObject *object)
+{
+   if(mCount == mCapacity)
+   {
+      mCapacity *= 2;
+      mOverflowResults.resize(mCapacity);
+
+      if(mResults == mInlineResults)
+         for(S32 i = 0; i < mCount; i++)
+            mOverflowResults[i] = mInlineResults[i];
+
+      mResults = mOverflowResults.address();
+   }
+
+   mResults[mCount++] = object;
+}
+
+
+// Pointer hash -- objects are at least 8-byte aligned, so toss the low bits, and mix in some high ones
+static inline U32 hashPointer(const DatabaseObject *object)
+{
+   U32 h = U32(size_t(object) >> 3);
+   return h ^ (h >> 15);
+}
+
+
+bool DatabaseQuery::markSeen(DatabaseObject *object)
+{
+   if(U32(mSeenCount + 1) * 2 > mSeenMask + 1)     // Keep the table at most half full
+      growSeen();
+
+   for(U32 i = hashPointer(object) & mSeenMask; ; i = (i + 1) & mSeenMask)
+   {
+      if(mSeen[i] == object)
+         return false;
+
+      if(mSeen[i] == NULL)
+      {
+         mSeen[i] = object;
+         mSeenCount++;
+         return true;
+      }
+   }
+}
+
+
+void DatabaseQuery::growSeen()
+{
+   U32 newSize = 2 * (mSeenMask + 1);
+
+   // Stash the old contents at the end of the new table while we rehash
+   Vector<DatabaseObject *> old(mSeenMask + 1);
+   for(U32 i = 0; i <= mSeenMask; i++)
+      if(mSeen[i])
+         old.push_back(mSeen[i]);
+
+   mOverflowSeen.resize(newSize);
+   mSeen = mOverflowSeen.address();
+   mSeenMask = newSize - 1;
+   mSeenCount = 0;
+
+   for(U32 i = 0; i < newSize; i++)
+      mSeen[i] = NULL;
+
+   for(S32 i = 0; i < old.size(); i++)
+      markSeen(old[i]);
+}
+
+
+// Results that were added without duplicate checking (i.e. from a tree query) aren't in mSeen yet; put them there so
+// that the next search doesn't add them again
+void DatabaseQuery::prepareForDuplicates()
+{
+   if(mSeenCount == mCount)
+      return;
+
+   TNLAssert(mSeenCount == 0, "Only expected to be missing results from a single unchecked search!");
+
+   for(S32 i = 0; i < mCount; i++)
+      markSeen(mResults[i]);
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -564,11 +975,11 @@ DatabaseObject::~DatabaseObject()
 // Code that needs to run for both constructor and copy constructor
 void DatabaseObject::initialize() 
 {
-   mLastQueryId = 0; 
    mExtent = Rect(); 
    mExtentSet = false;
    mDatabase = NULL;
    mBucketList = NULL;
+   mTreeProxy = DynamicAABBTree::NullNode;
 }
 
 
@@ -590,8 +1001,7 @@ DatabaseObject *GridDatabase::findObjectLOS(U8 typeNumber, U32 stateIndex, bool
 {
    Rect queryRect(rayStart, rayEnd);
 
-   static Vector<DatabaseObject *> fillVector;  // Use local here, Most of code expects a global FillVector left unchanged
-   fillVector.clear();
+   DatabaseQuery fillVector;     // Local, so we don't disturb our caller's results
 
    findObjects(typeNumber, fillVector, queryRect);
 
@@ -652,8 +1062,7 @@ DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex, b
 {
    Rect queryRect(rayStart, rayEnd);
 
-   static Vector<DatabaseObject *> fillVector;  // Use local here, most callers expect our global fillVector to be left unchanged
-   fillVector.clear();
+   DatabaseQuery fillVector;     // Local, so we don't disturb our caller's results
 
    findObjects(testFunc, fillVector, queryRect);
 
@@ -726,10 +1135,43 @@ bool GridDatabase::pointCanSeePoint(const Point &point1, const Point &point2)
    F32 time;
    Point coll;
 
+   // Never rebuilt here, as scripts can call this from several threads at once
+   if(mWallTree && !mWallTreeDirty && mWallTreeHasAllWalls)
+      return mWallTree->findFirstRayHit(point1, point2, time, coll) == NULL;
+
    return( findObjectLOS((TestFunc)isWallType, ActualState, true, point1, point2, time, coll) == NULL );
 }
 
 
+// Walls don't move, so this only needs doing when a level is loaded, or a script adds or removes one
+WallCollisionTree *GridDatabase::getWallCollisionTree()
+{
+   if(!mWallTreeDirty)
+      return mWallTree;
+
+   if(!mWallTree)
+      mWallTree = new WallCollisionTree();      // Deleted in destructor
+
+   Vector<DatabaseObject *> barriers;
+   mWallTreeHasAllWalls = true;
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+   {
+      U8 type = mAllObjects[i]->getObjectTypeNumber();
+
+      if(type == BarrierTypeNumber)
+         barriers.push_back(mAllObjects[i]);
+      else if(isWallType(type))
+         mWallTreeHasAllWalls = false;
+   }
+
+   mWallTree->build(barriers);
+   mWallTreeDirty = false;
+
+   return mWallTree;
+}
+
+
 void GridDatabase::computeSelectionMinMax(Point &min, Point &max)
 {
    min.set( F32_MAX,  F32_MAX);
@@ -773,6 +1215,9 @@ S32 GridDatabase::getObjectCount(U8 typeNumber) const
    if(typeNumber == SpyBugTypeNumber)
       return mSpyBugs.size();
 
+   if(typeNumber == BulletTypeNumber)
+      return mBullets.size();
+
    TNLAssert(false, "Unsupported type!");
    return 0;
 }
@@ -789,6 +1234,9 @@ bool GridDatabase::hasObjectOfType(U8 typeNumber) const
    if(typeNumber == SpyBugTypeNumber)
       return mSpyBugs.size() > 0;
 
+   if(typeNumber == BulletTypeNumber)
+      return mBullets.size() > 0;
+
    for(S32 i = 0; i < mAllObjects.size(); i++)
       if(mAllObjects[i]->getObjectTypeNumber() == typeNumber)
          return true;
@@ -898,75 +1346,16 @@ void DatabaseObject::setExtent(const Rect &extents)
    //if(lastx == last) { logprintf("SAME======================="); }
    //last = lastx;
 
-   GridDatabase *gridDB = getDatabase();
-
-   if(gridDB)
-   {
-      // Remove from the extents database for current extents...
-      //gridDB->removeFromDatabase(this, mExtent);    // old extent
-      // ...and re-add for the new extent
-      //gridDB->addToDatabase(this, extents);
-
-
-      S32 minxold, minyold, maxxold, maxyold;
-      S32 minx, miny, maxx, maxy;
-
-      minxold = S32(mExtent.min.x) >> GridDatabase::BucketWidthBitShift;
-      minyold = S32(mExtent.min.y) >> GridDatabase::BucketWidthBitShift;
-      maxxold = S32(mExtent.max.x) >> GridDatabase::BucketWidthBitShift;
-      maxyold = S32(mExtent.max.y) >> GridDatabase::BucketWidthBitShift;
-
-      minx    = S32(extents.min.x) >> GridDatabase::BucketWidthBitShift;
-      miny    = S32(extents.min.y) >> GridDatabase::BucketWidthBitShift;
-      maxx    = S32(extents.max.x) >> GridDatabase::BucketWidthBitShift;
-      maxy    = S32(extents.max.y) >> GridDatabase::BucketWidthBitShift;
-
-      // Don't do anything if the buckets haven't changed...
-      if((minxold - minx) | (minyold - miny) | (maxxold - maxx) | (maxyold - maxy))
-      {
-         // They are different... remove and readd to database, but don't touch gridDB->mAllObjects
-         if(U32(maxx - minx) >= gridDB->BucketRowCount)        maxx    = minx    + gridDB->BucketRowCount - 1;
-         if(U32(maxy - miny) >= gridDB->BucketRowCount)        maxy    = miny    + gridDB->BucketRowCount - 1;
-         if(U32(maxxold >= minxold) + gridDB->BucketRowCount)  maxxold = minxold + gridDB->BucketRowCount - 1;
-         if(U32(maxyold >= minyold) + gridDB->BucketRowCount)  maxyold = minyold + gridDB->BucketRowCount - 1;
-
-
-         // Don't use x <= maxx, it will endless loop if maxx = S32_MAX and x overflows
-         // Instead, use maxx - x >= 0, it will better handle overflows and avoid endless loop (MIN_S32 - MAX_S32 = +1)
-
-         // Remove from the extents database for current extents...
-         while(mBucketList)
-         {
-            DatabaseBucketEntry *b = mBucketList;
-            TNLAssert(b->theObject == this, "Object mismatch");
-            TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
-            if(b->nextInBucket)
-               b->nextInBucket->prevInBucket = b->prevInBucket;
-            b->prevInBucket->nextInBucket = b->nextInBucket;
-            mBucketList = b->nextInBucketForThisObject;
-            gridDB->mChunker->free(b);
-         }
-
-         // ...and re-add for the new extent
-         for(S32 x = minx; maxx - x >= 0; x++)
-            for(S32 y = miny; maxy - y >= 0; y++)
-            {
-               DatabaseBucketEntry *be = gridDB->mChunker->alloc();
-               DatabaseBucketEntryBase *base = &gridDB->mBuckets[x & gridDB->BucketMask][y & gridDB->BucketMask];
-               be->theObject = this;
-               if(base->nextInBucket)
-                  base->nextInBucket->prevInBucket = be;
-               be->nextInBucket = base->nextInBucket;
-               be->prevInBucket = base;
-               base->nextInBucket = be;
-               be->nextInBucketForThisObject = mBucketList;
-               mBucketList = be;
-            }
-      }
-   }
+   Rect oldExtents = mExtent;
 
    mExtent.set(extents);
    mExtentSet = true;
+
+   // Update object's position in the spatial index; the database won't bother if it doesn't need to
+   GridDatabase *gridDB = getDatabase();
+
+   if(gridDB)
+      gridDB->updateIndex(this, oldExtents);
 }
 
 
@@ -7,6 +7,7 @@
 #define _GRIDDB_H_
 
 #include "GeomObject.h"    // Base class
+#include "DynamicAABBTree.h"
 
 #include "tnlTypes.h"
 #include "tnlDataChunker.h"
@@ -50,11 +51,11 @@ class DatabaseObject : public GeomObject
 
 
 private:
-   U32 mLastQueryId;
    Rect mExtent;
    bool mExtentSet;     // A flag to mark whether extent has been set on this object
    GridDatabase *mDatabase;
    DatabaseBucketEntry *mBucketList;
+   S32 mTreeProxy;      // Our leaf in the database's AABB tree, when it is using one
 
 protected:
    U8 mObjectTypeNumber;
@@ -94,19 +95,83 @@ public:
 };
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Caller-owned container for spatial query results.  Small result sets live in inline storage, so a query object
+// kept on the stack or reused from one tick to the next never touches the heap.  Results accumulate across
+// findObjects() calls until clear() is called, and an object is never added twice.  Since duplicate suppression is
+// tracked here rather than on the objects, any number of queries can run at once, from any thread, as long as
+// nobody is modifying the database at the same time.
+class DatabaseQuery
+{
+   friend class GridDatabase;
+
+public:
+   static const S32 InlineCapacity = 64;
+
+private:
+   static const S32 InlineSeenCapacity = 2 * InlineCapacity;     // Must be power of 2
+
+   DatabaseObject *mInlineResults[InlineCapacity];
+   Vector<DatabaseObject *> mOverflowResults;      // Only used once we outgrow mInlineResults
+   DatabaseObject **mResults;
+   S32 mCount;
+   S32 mCapacity;
+
+   // Open-addressed hash set of everything in mResults, used to weed out duplicates
+   DatabaseObject *mInlineSeen[InlineSeenCapacity];
+   Vector<DatabaseObject *> mOverflowSeen;
+   DatabaseObject **mSeen;
+   U32 mSeenMask;
+   S32 mSeenCount;      // Number of results that have made it into mSeen; see prepareForDuplicates()
+
+   void add(DatabaseObject *object);
+   bool markSeen(DatabaseObject *object);       // Returns false if object was already seen
+   void prepareForDuplicates();                 // Makes sure everything found so far is in mSeen
+   void growSeen();
+
+public:
+   DatabaseQuery();                             // Constructor
+   DatabaseQuery(const DatabaseQuery &other);   // Copy constructor
+   virtual ~DatabaseQuery();                    // Destructor
+
+   DatabaseQuery &operator=(const DatabaseQuery &other);
+
+   void clear();
+
+   S32 size() const;
+   bool isEmpty() const;
+
+   DatabaseObject *get(S32 index) const;
+   DatabaseObject *operator[](S32 index) const;
+
+   void toVector(Vector<DatabaseObject *> &fillVector) const;     // Appends our results to fillVector
+};
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
 class WallSegmentManager;
+class WallCollisionTree;
 class GoalZone;
 class BfObject;
 
 class GridDatabase
 {
+   friend class DatabaseObject;
+
+public:
+   // Spatial index used to answer extent queries; picked per database
+   enum SpatialIndexType {
+      BucketGridIndex,     // Fixed-size hashed grid; cheap and fine for small levels
+      AABBTreeIndex,       // Dynamic AABB tree; scales with map size and object count
+   };
+
 private:
    U32 mDatabaseId;
-   static U32 mQueryId;
-   static U32 mCountGridDatabase;      // Reference counter for destruction of mChunker
+   static TNL_THREAD_LOCAL U32 mCountGridDatabase;     // Reference counter for destruction of mChunker
 
    WallSegmentManager *mWallSegmentManager;
 
@@ -114,20 +179,39 @@ private:
    Vector<DatabaseObject *> mGoalZones;
    Vector<DatabaseObject *> mFlags;
    Vector<DatabaseObject *> mSpyBugs;
+   Vector<DatabaseObject *> mBullets;
+
+   static const S32 AABBTreeMargin = 32;              // Objects can move this many pixels before their tree leaf needs updating
+   static const S32 AABBTreeObjectThreshold = 2048;   // Above this many objects, buckets get too crowded; see chooseSpatialIndexType()
+
+   SpatialIndexType mSpatialIndexType;
+   DynamicAABBTree *mTree;             // NULL unless mSpatialIndexType is AABBTreeIndex
 
-   void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
-   void findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
-   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins, bool sameQuery = false) const;
+   WallCollisionTree *mWallTree;       // Edges of every Barrier, for moving things to bump into; NULL until first needed
+   bool mWallTreeDirty;                // Walls have changed since mWallTree was built
+   bool mWallTreeHasAllWalls;          // No walls other than Barriers, so mWallTree can answer line of sight questions
+
+   template <class TypeTest>
+   struct QueryCollector;
+
+   template <class TypeTest>
+   void findObjectsInExtents(const TypeTest &typeTest, DatabaseQuery &query, const Rect &extents) const;
+   template <class TypeTest>
+   void findAllObjects(const TypeTest &typeTest, DatabaseQuery &query) const;
 
    void fillBins(const Rect &extents, IntRect &bins) const;    // Helper function -- translates extents into bins to search
 
+   void addToIndex(DatabaseObject *theObject);
+   void removeFromIndex(DatabaseObject *theObject);
+   void updateIndex(DatabaseObject *theObject, const Rect &oldExtents);
+
 public:
    enum {
       BucketRowCount = 16,    // Number of buckets per grid row, and number of rows; should be power of 2
       BucketMask = BucketRowCount - 1,
    };
 
-   static ClassChunker<DatabaseBucketEntry> *mChunker;
+   static TNL_THREAD_LOCAL ClassChunker<DatabaseBucketEntry> *mChunker;    // One per thread hosting a game
 
    DatabaseBucketEntryBase mBuckets[BucketRowCount][BucketRowCount];
 
@@ -138,6 +222,10 @@ public:
 
    static const S32 BucketWidthBitShift = 8;    // Width/height of each bucket in pixels, in a form of 2 ^ n, 8 is 256 pixels
 
+   SpatialIndexType getSpatialIndexType() const;
+   void setSpatialIndexType(SpatialIndexType indexType);    // Reindexes any objects already in the database
+   void chooseSpatialIndexType();                           // Picks the best index for what's in the database right now
+
    DatabaseObject *findObjectLOS(U8 typeNumber, U32 stateIndex, bool format, const Point &rayStart, const Point &rayEnd,
                                  float &collisionTime, Point &surfaceNormal) const;
    DatabaseObject *findObjectLOS(U8 typeNumber, U32 stateIndex, const Point &rayStart, const Point &rayEnd,
@@ -148,21 +236,33 @@ public:
                                  float &collisionTime, Point &surfaceNormal) const;
 
    bool pointCanSeePoint(const Point &point1, const Point &point2);
+
+   WallCollisionTree *getWallCollisionTree();      // Rebuilds it first if walls have changed, so main thread only
    void computeSelectionMinMax(Point &min, Point &max);
 
    void findObjects(Vector<DatabaseObject *> &fillVector) const;     // Returns all objects in the database
    const Vector<DatabaseObject *> *findObjects_fast() const;         // Faster than above, but results can't be modified
-   const Vector<DatabaseObject *> *findObjects_fast(U8 typeNumber) const;   // Currently only works with goalZones, may be expanded in the future
+   const Vector<DatabaseObject *> *findObjects_fast(U8 typeNumber) const;   // Only works with goalZones, flags, spybugs, and bullets
 
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector) const;
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
 
    void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector) const;
-   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, bool sameQuery = false) const;
+   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
 
    void findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector) const;
    void findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
 
+   // Re-entrant versions of the above; results are added to query
+   void findObjects(U8 typeNumber, DatabaseQuery &query) const;
+   void findObjects(U8 typeNumber, DatabaseQuery &query, const Rect &extents) const;
+
+   void findObjects(TestFunc testFunc, DatabaseQuery &query) const;
+   void findObjects(TestFunc testFunc, DatabaseQuery &query, const Rect &extents) const;
+
+   void findObjects(const Vector<U8> &types, DatabaseQuery &query) const;
+   void findObjects(const Vector<U8> &types, DatabaseQuery &query, const Rect &extents) const;
+
    BfObject *findObjectById(S32 id) const;
 
    void copyObjects(const GridDatabase *source);
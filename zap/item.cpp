@@ -22,7 +22,7 @@ Item::Item(F32 radius) : Parent(radius)
    mRadius = radius;
    setPos(Point(0,0));
 
-   static U16 itemId = 1;
+   static TNL_THREAD_LOCAL U16 itemId = 1;
    mItemId = itemId++;
 
    LUAW_CONSTRUCTOR_INITIALIZATIONS;
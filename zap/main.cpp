@@ -83,6 +83,7 @@ include (replaces require)
 #include "zapjournal.h"
 
 #include "GameManager.h"
+#include "ArenaThread.h"
 
 using namespace TNL;
 
@@ -113,6 +114,7 @@ using namespace TNL;
 #include "stringUtils.h"
 #include "BanList.h"
 #include "game.h"
+#include "gameNetInterface.h"
 #include "SoundSystem.h"
 #include "InputCode.h"     // initializeKeyNames()
 #include "ClientInfo.h"
@@ -205,6 +207,8 @@ void hostGame(ServerGame *serverGame)
       return;
    }
 
+   hostArenas(serverGame);    // Dedicated servers may host more than one game
+
 #ifndef ZAP_DEDICATED
    const Vector<ClientGame *> *clientGames = GameManager::getClientGames();
 
@@ -278,7 +282,15 @@ void checkIfServerGameIsShuttingDown(U32 timeDelta)
    ServerGame *serverGame = GameManager::getServerGame();
 
    string shutdownReason;
-   if(serverGame && serverGame->isReadyToShutdown(timeDelta, shutdownReason))
+   bool readyToShutdown = serverGame && serverGame->isReadyToShutdown(timeDelta, shutdownReason);
+
+   // Shutting down any arena shuts down the whole server
+   const Vector<ArenaThread *> *arenas = GameManager::getArenas();
+
+   for(S32 i = 0; i < arenas->size() && !readyToShutdown; i++)
+      readyToShutdown = arenas->get(i)->isReadyToShutdown(shutdownReason);
+
+   if(readyToShutdown)
    {
 #ifndef ZAP_DEDICATED
       // Disconnect any local clients, passing whatever reason string we have
@@ -405,10 +417,44 @@ void idle()
 }  // end idle()
 
 
+// A dedicated server has no screen to draw and no SDL events to poll, so rather than sleeping a millisecond at a time
+// and checking the clock, it blocks on the game's socket until the next tick is due.  Packets that turn up in between
+// are handled right away, so pings and connection requests don't sit around waiting for a tick.  See TickGrid for how
+// the ticks are timed.  Any other arenas we're hosting run the same way on threads of their own; see ArenaThread.
 void dedicatedServerLoop()
 {
+   TickGrid tickGrid;
+
    for(;;)        // Loop forever!
-      idle();     // Idly!
+   {
+      // Clients have drawing and SDL to attend to
+      if(!GameManager::getServerGame() || !GameManager::getServerGame()->isDedicated())
+      {
+         idle();
+         continue;
+      }
+
+      loadAnotherLevelOrStartHosting();
+
+      ServerGame *serverGame = GameManager::getServerGame();
+      U32 deltaT, timeout;
+
+      if(!tickGrid.tick(serverGame, deltaT, timeout))
+      {
+         // Levels get loaded one per pass, and we don't want to dawdle over that
+         if(GameManager::getHostingModePhase() == GameManager::LoadingLevels ||
+            GameManager::getHostingModePhase() == GameManager::DoneLoadingLevels)
+            continue;
+
+         if(serverGame->getNetInterface()->getSocket().waitForPacket(timeout))
+            serverGame->getNetInterface()->checkIncomingPackets();
+
+         continue;
+      }
+
+      checkIfServerGameIsShuttingDown(deltaT);
+      GameManager::idle(deltaT);
+   }
 }
 
 ////////////////////////////////////////
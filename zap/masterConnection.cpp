@@ -36,6 +36,10 @@ MasterServerConnection::MasterServerConnection(Game *game)
 
    mCurrentQueryId = 0;
 
+   mSubscribed = false;
+   mSubscribedHostOnly = false;
+   mSubscribedListReceived = false;
+
    // Determine connection type based on Game that is running
    // An anonymous connection can be set with setConnectionType()
    if(mGame->isServer())
@@ -70,17 +74,60 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cHostOnServerAvailable, (bo
    mHostOnServerAvailable = yes;
 }
 
-void MasterServerConnection::startServerQuery(bool hostOnServer)
+// Returns true if the list is on its way from the master, false if we've already passed it along
+bool MasterServerConnection::startServerQuery(bool hostOnServer)
 {
+   // Once we're subscribed, the master keeps our copy of the list up to date, so there's nothing to ask for
+   if(mSubscribed && mSubscribedHostOnly == hostOnServer)
+   {
+      if(!mSubscribedListReceived)
+         return true;
+
+#ifndef ZAP_DEDICATED
+      static_cast<ClientGame *>(mGame)->gotServerListFromMaster(mSubscribedList);
+#endif
+      return false;
+   }
+
    // Invalidate old queries
    mCurrentQueryId++;
 
+   if(supports024Rpcs())
+   {
+      mSubscribed = true;
+      mSubscribedHostOnly = hostOnServer;
+      mSubscribedListReceived = false;
+      mSubscribedList.clear();
+
+      c2mSubscribeServerList(mCurrentQueryId, hostOnServer);     // Replaces any subscription we already had
+      return true;
+   }
+
    // And automatically do a server query as well - you may not want to do things
    // in this order in your own clients.
    if(hostOnServer)
       c2mQueryHostServers(mCurrentQueryId);
    else
       c2mQueryServers(mCurrentQueryId);
+
+   return true;
+}
+
+
+// Call when we no longer care about the server list, so the master can stop telling us about it
+void MasterServerConnection::stopServerQuery()
+{
+   // Ignore anything still on its way
+   mCurrentQueryId++;
+
+   if(!mSubscribed)
+      return;
+
+   c2mUnsubscribeServerList();
+
+   mSubscribed = false;
+   mSubscribedListReceived = false;
+   mSubscribedList.clear();
 }
 
 
@@ -179,11 +226,67 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cQueryServersResponse_023,
 	}
 	else  // Empty list received, transmission complete, send whole list on to the UI
 	{
+		// If we're subscribed, this is the list future changes will be applied to
+		if(mSubscribed)
+		{
+			mSubscribedList = mServerList;
+			mSubscribedListReceived = true;
+		}
+
 		static_cast<ClientGame *>(mGame)->gotServerListFromMaster(mServerList);
 
 		mServerList.clear();
 	}
 }
+
+
+// Returns index of server in serverList, -1 if it's not there
+static S32 findServerById(const Vector<ServerAddr> &serverList, S32 id)
+{
+   for(S32 i = 0; i < serverList.size(); i++)
+      if(serverList[i].id == id)
+         return i;
+
+   return -1;
+}
+
+
+// Master is telling us what has changed on the list we subscribed to
+TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cServerListChanged, 
+                           (U32 queryId, Vector<IPAddress> ipList, Vector<S32> serverIdList, 
+                            Vector<StringTableEntry> serverNames, Vector<S32> removedServerIds))
+{
+   if(mGame->isServer())
+      return;
+
+   if(queryId != mCurrentQueryId || !mSubscribed || !mSubscribedListReceived)
+      return;
+
+   TNLAssert(ipList.size() == serverIdList.size(), "Expect the same number of elements!");
+   TNLAssert(ipList.size() == serverNames.size(),  "Expect the same number of elements!");
+   if(ipList.size() != serverIdList.size() || ipList.size() != serverNames.size())
+      return;
+
+   for(S32 i = 0; i < removedServerIds.size(); i++)
+   {
+      S32 index = findServerById(mSubscribedList, removedServerIds[i]);
+      if(index != -1)
+         mSubscribedList.erase_fast(index);
+   }
+
+   // Servers we already know about may have changed name
+   for(S32 i = 0; i < ipList.size(); i++)
+   {
+      S32 index = findServerById(mSubscribedList, serverIdList[i]);
+
+      if(index == -1)
+         mSubscribedList.push_back(ServerAddr(ipList[i], serverIdList[i], serverNames[i]));
+      else
+         mSubscribedList[index] = ServerAddr(ipList[i], serverIdList[i], serverNames[i]);
+   }
+
+   static_cast<ClientGame *>(mGame)->gotServerListFromMaster(mSubscribedList);
+}
 #endif
 
 
@@ -468,6 +571,40 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cPlayerLeftGlobalChat, (Str
 }
 
 
+// Handle a batch of players joining or leaving chat session
+// Runs on client only (but initiated by master)
+TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cGlobalChatChanged, 
+                           (Vector<StringTableEntry> leftNicks, Vector<StringTableEntry> joinedNicks))
+{
+   if(mGame->isServer())
+      return;
+
+   ClientGame *clientGame = static_cast<ClientGame *>(mGame);
+
+   for(S32 i = 0; i < leftNicks.size(); i++)
+      clientGame->playerLeftGlobalChat(leftNicks[i]);
+
+   for(S32 i = 0; i < joinedNicks.size(); i++)
+      clientGame->playerJoinedGlobalChat(joinedNicks[i]);
+}
+
+
+// Handle a batch of incoming chat messages
+// Runs on client only (but initiated by master)
+TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cSendChats, (Vector<StringTableEntry> playerNicks, Vector<string> messages))
+{
+   if(mGame->isServer())
+      return;
+
+   TNLAssert(playerNicks.size() == messages.size(), "Expect the same number of elements!");
+   if(playerNicks.size() != messages.size())
+      return;
+
+   for(S32 i = 0; i < messages.size(); i++)
+      static_cast<ClientGame *>(mGame)->gotGlobalChatMessage(playerNicks[i].getString(), messages[i].c_str(), false);
+}
+
+
 TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, m2cSendHighScores, (Vector<StringTableEntry> groupNames, 
                            Vector<string> names, Vector<string> scores))
 {
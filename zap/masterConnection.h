@@ -27,6 +27,12 @@ class MasterServerConnection : public MasterServerInterface
 private:
    U32 mCurrentQueryId;    // ID of our current query
 
+   // With a master that supports it, we subscribe to the server list rather than asking for all of it every time
+   bool mSubscribed;
+   bool mSubscribedHostOnly;
+   bool mSubscribedListReceived;
+   Vector<ServerAddr> mSubscribedList;       // Kept up to date by m2cServerListChanged
+
    Game *mGame;
    string mMasterName;
 
@@ -51,7 +57,8 @@ public:
    void setMasterName(string name);
    string getMasterName();
 
-   void startServerQuery(bool hostOnServer);
+   bool startServerQuery(bool hostOnServer);
+   void stopServerQuery();
 
    Vector<ServerAddr> mServerList;
 
@@ -69,6 +76,8 @@ public:
    TNL_DECLARE_RPC_OVERRIDE(m2cQueryServersResponse, (U32 queryId, Vector<IPAddress> ipList));
    TNL_DECLARE_RPC_OVERRIDE(m2cQueryServersResponse_019a, (U32 queryId, Vector<IPAddress> ipList, Vector<S32> clientIdList));
    TNL_DECLARE_RPC_OVERRIDE(m2cQueryServersResponse_023, (U32 queryId, Vector<IPAddress> ipList, Vector<S32> clientIdList, Vector<StringTableEntry> serverNames));
+   TNL_DECLARE_RPC_OVERRIDE(m2cServerListChanged, (U32 queryId, Vector<IPAddress> ipList, Vector<S32> serverIdList, 
+                                                   Vector<StringTableEntry> serverNames, Vector<S32> removedServerIds));
 #endif
 
    TNL_DECLARE_RPC_OVERRIDE(m2sClientRequestedArrangedConnection, (U32 requestId, Vector<IPAddress> possibleAddresses,
@@ -92,6 +101,8 @@ public:
    TNL_DECLARE_RPC_OVERRIDE(m2cPlayerJoinedGlobalChat, (StringTableEntry playerNick));
    TNL_DECLARE_RPC_OVERRIDE(m2cPlayerLeftGlobalChat, (StringTableEntry playerNick));
    TNL_DECLARE_RPC_OVERRIDE(m2cPlayersInGlobalChat, (Vector<StringTableEntry> playerNicks));
+   TNL_DECLARE_RPC_OVERRIDE(m2cGlobalChatChanged, (Vector<StringTableEntry> leftNicks, Vector<StringTableEntry> joinedNicks));
+   TNL_DECLARE_RPC_OVERRIDE(m2cSendChats, (Vector<StringTableEntry> playerNicks, Vector<string> messages));
    TNL_DECLARE_RPC_OVERRIDE(m2cSendHighScores, (Vector<StringTableEntry> groupNames, Vector<string> names, Vector<string> scores));
    TNL_DECLARE_RPC_OVERRIDE(m2cSendPlayerLevelRating,  (U32 databaseId, RangedU32<0, 2> rating));
    TNL_DECLARE_RPC_OVERRIDE(m2cSendTotalLevelRating, (U32 databaseId, S16 rating));
@@ -16,6 +16,7 @@
 
 #include "Colors.h"
 #include "GeomUtils.h"
+#include "WallCollisionTree.h"
 #include "stringUtils.h"
 #include "MathUtils.h"     // For findLowestRootIninterval()
 
@@ -338,7 +339,7 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
    Vector<SafePtr<BfObject> > disabledList;
    F32 moveTimeStart = moveTime;
 
-   static Point origPos;   // Reusable container
+   static thread_local Point origPos;   // Reusable container
    origPos = getPos(stateIndex);
 
    while(moveTime > moveTimeEpsilon && tryCount < TRY_COUNT_MAX)     // moveTimeEpsilon is a very short, but non-zero, bit of time
@@ -350,7 +351,7 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
          break;
 
       F32 collisionTime = moveTime;
-      static Point collisionPoint, newPos;     // Reusable containers
+      static thread_local Point collisionPoint, newPos;     // Reusable containers
 
       BfObject *objectHit = findFirstCollision(stateIndex, collisionTime, collisionPoint);
       if(!objectHit)    // No collision (or if isBeingDisplaced is true, we haven't been pushed into another object)
@@ -376,7 +377,7 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
          TNLAssert(dynamic_cast<MoveObject *>(objectHit), "Not a MoveObject");
          MoveObject *moveObjectThatWasHit = static_cast<MoveObject *>(objectHit);
 
-         static Point velDelta, posDelta;    // Reusable containers
+         static thread_local Point velDelta, posDelta;    // Reusable containers
          velDelta = moveObjectThatWasHit->getVel(stateIndex) - getVel(stateIndex);
          posDelta = moveObjectThatWasHit->getPos(stateIndex) - getPos(stateIndex);
 
@@ -456,9 +457,42 @@ static S32 QSORT_CALLBACK sortBarriersFirst(DatabaseObject **a, DatabaseObject *
 
 BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Point &collisionPoint)
 {
-   // Check for collisions against other objects
    Point delta = getVel(stateIndex) * collisionTime;
 
+   F32 collisionFraction;
+
+   BfObject *collisionObject = NULL;
+
+   // Do Barriers first, to prevent picking up flag (FlagItem::Collide) through Barriers, especially when client does
+   // /maxfps 10.  They never move, so the database keeps their edges in a tree of their own, which lets us look at just
+   // the few edges we're near rather than every edge of every Barrier in the area.
+   GridDatabase *database = getDatabase();
+   WallCollisionTree *wallTree = (database && collideTypes()(BarrierTypeNumber)) ? database->getWallCollisionTree() : NULL;
+
+   if(wallTree)
+   {
+      Point cp;
+      BfObject *wall = static_cast<BfObject *>(wallTree->findFirstSweptCircleHit(getPos(stateIndex), delta, mRadius,
+                                                                                   collisionFraction, cp));
+      if(wall)
+      {
+         bool collide1 = collide(wall);
+         bool collide2 = wall->collide(this);
+
+         if(collide1 && collide2)
+         {
+            collisionPoint = cp;
+            delta *= collisionFraction;
+            collisionTime *= collisionFraction;
+            collisionObject = wall;
+
+            if(!collisionTime)
+               return collisionObject;
+         }
+      }
+   }
+
+   // Check for collisions against other objects -- nothing past where we hit a wall matters
    Rect queryRect(getPos(stateIndex), getPos(stateIndex) + delta);
    queryRect.expand(Point(mRadius, mRadius));
 
@@ -466,11 +500,8 @@ BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Poi
 
    findObjects(collideTypes(), fillVector, queryRect);   // Free CPU for finding only the ones we care about
 
-   fillVector.sort(sortBarriersFirst);  // Sort to do Barriers::Collide first, to prevent picking up flag (FlagItem::Collide) through Barriers, especially when client does /maxfps 10
-
-   F32 collisionFraction;
-
-   BfObject *collisionObject = NULL;
+   if(!wallTree)
+      fillVector.sort(sortBarriersFirst);
 
    for(S32 i = 0; i < fillVector.size(); i++)
    {
@@ -479,6 +510,9 @@ BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Poi
       if(!foundObject->isCollisionEnabled())
          continue;
 
+      if(wallTree && foundObject->getObjectTypeNumber() == BarrierTypeNumber)     // Already done
+         continue;
+
       const Vector<Point> *poly = foundObject->getCollisionPoly();
 
       if(poly)
@@ -2084,7 +2118,7 @@ void ResourceItem::renderItemAlpha(const Point &pos, F32 alpha)
 
 void ResourceItem::renderDock()
 {
-   static Vector<Point> points;
+   static thread_local Vector<Point> points;
    points.clear();
    generateOutlinePoints(getActualPos(), 0.4f   , points);
 
@@ -17,6 +17,7 @@
 
 #include "stringUtils.h"
 #include "MathUtils.h"
+#include "GeomUtils.h"
 
 
 namespace Zap 
@@ -77,6 +78,7 @@ void Projectile::initialize(WeaponType type, const Point &pos, const Point &vel,
    mLiveTimeIncreases = 0;
    mShooter = shooter;
    mLastHitObject = NULL;
+   mMovedThisTick = false;
 
    setOwner(NULL);
 
@@ -146,7 +148,7 @@ void Projectile::unpackUpdate(GhostConnection *connection, BitStream *stream)
    bool initial = false;
    if(stream->readFlag())  // Read position, for correcting bouncers, needs to be before inital for getGame()->playSoundEffect
    {
-      static Point pos;    // Reusable container
+      static thread_local Point pos;    // Reusable container
       ((GameConnection *) connection)->readCompressedPoint(pos, stream);
       setPos(pos);
 
@@ -241,166 +243,478 @@ void Projectile::onAddedToGame(Game *game)
    Parent::onAddedToGame(game);
 }
 
-void Projectile::idle(BfObject::IdleCallPath path)
+// What projectiles search for.  Bullets count as weapon-collideable, but have no collision geometry, so can never
+// actually be hit; leaving them out matters in a big fight, where a search can turn up hundreds of them.
+static bool isProjectileTargetType(U8 x)
 {
-   U32 deltaT = mCurrentMove.time;
+   return x != BulletTypeNumber && isWeaponCollideableType(x);
+}
+
+
+// Scratch space for moveAll(), kept from tick to tick so it isn't forever being reallocated.  Paths and collision
+// geometry live in flat arrays, so testing a path against everything near it runs through contiguous memory.  Each
+// thread hosting a game has its own.
+static thread_local Vector<SafePtr<Projectile> > sweepProjectiles;
+static thread_local Vector<F32> sweepStartX, sweepStartY, sweepEndX, sweepEndY;
+static thread_local Vector<S32> sweepNext;             // Next path in the same cell, or -1
+
+static thread_local Vector<U32> cellKeys;              // Hash table of cells with paths in them
+static thread_local Vector<S32> cellFirstSweep;        // First path in each cell, or -1 if the slot is empty
+
+static thread_local DatabaseQuery targetQuery;
+static thread_local Vector<BfObject *> targets;        // Everything near a cell's worth of paths that a projectile might hit
+static thread_local Vector<Rect> targetExtents;
+static thread_local Vector<S32> targetFirstEdge;
+static thread_local Vector<S32> targetEdgeCount;       // 0 for things with a collision circle rather than a polygon
+static thread_local Vector<Point> targetCenters;
+static thread_local Vector<F32> targetRadii;
+static thread_local Vector<F32> edgeX, edgeY, edgeDX, edgeDY;      // Start of each polygon edge, and the vector along it
+
+
+// Collects the collision geometry of everything in rect that a projectile might hit.  Whether collision is enabled is
+// left for findBatchHit() to check, as that can change as the projectiles move.
+static void gatherTargets(const GridDatabase *database, const Rect &rect)
+{
+   targetQuery.clear();
+   targets.clear();
+   targetExtents.clear();
+   targetFirstEdge.clear();
+   targetEdgeCount.clear();
+   targetCenters.clear();
+   targetRadii.clear();
+   edgeX.clear();
+   edgeY.clear();
+   edgeDX.clear();
+   edgeDY.clear();
 
-   if(mAlive)
+   database->findObjects((TestFunc)isProjectileTargetType, targetQuery, rect);
+
+   for(S32 i = 0; i < targetQuery.size(); i++)
    {
-      U32 objAge = getGame()->getCurrentTime() - getCreationTime();  // Age of object, in ms
-      F32 timeLeft = (F32)deltaT;
-      S32 loopcount = 32;
+      BfObject *target = static_cast<BfObject *>(targetQuery[i]);
+      const Vector<Point> *poly = target->getCollisionPoly();
+      Point center;
+      F32 radius = 0;
+
+      if(poly)
+      {
+         if(poly->size() == 0)
+            continue;
+
+         targetFirstEdge.push_back(edgeX.size());
+         targetEdgeCount.push_back(poly->size());
 
-      Point startPos, collisionPoint;
+         // Edges in the same order, and worked out the same way, as polygonIntersectsSegmentDetailed() does
+         Point v1 = poly->last();
+         for(S32 j = 0; j < poly->size(); j++)
+         {
+            Point dv = poly->get(j) - v1;
+
+            edgeX.push_back(v1.x);
+            edgeY.push_back(v1.y);
+            edgeDX.push_back(dv.x);
+            edgeDY.push_back(dv.y);
 
-      while(timeLeft > 0.01f && loopcount != 0)    // This loop is to prevent slow bounce on low frame rate / high time left
+            v1 = poly->get(j);
+         }
+      }
+      else if(target->getCollisionCircle(RenderState, center, radius))
       {
-         loopcount--;
-         
-         startPos = getPos();
+         targetFirstEdge.push_back(edgeX.size());
+         targetEdgeCount.push_back(0);
+      }
+      else
+         continue;
+
+      targets.push_back(target);
+      targetExtents.push_back(target->getExtent());
+      targetCenters.push_back(center);
+      targetRadii.push_back(radius);
+   }
+}
 
-         // Calculate where projectile will be at the end of the current interval
-         Point endPos = startPos + (mVelocity * .001f) * timeLeft;    // mVelocity in units/sec, timeLeft in ms
 
-         // Check for collision along projected route of movement
-         static Vector<BfObject *> disabledList;
+// Finds the closest gathered target along a path.  This is the search findObjectLOS() would do, with the same
+// arithmetic, so gets the same answers.
+void Projectile::findBatchHit(S32 sweep, Projectile *projectile, Hit &hit)
+{
+   Point start(sweepStartX[sweep], sweepStartY[sweep]);
+   Point end(sweepEndX[sweep], sweepEndY[sweep]);
+   Point dp = end - start;
+   Rect sweepRect(start, end);
 
-         Rect queryRect(startPos, endPos);     // Bounding box of our travels
+   // Don't collide with shooter during first 500ms of life
+   U32 objAge = projectile->getGame()->getCurrentTime() - projectile->getCreationTime();
+   BfObject *shooter = (objAge < 500 && !projectile->mBounced) ? projectile->mShooter.getPointer() : NULL;
 
-         disabledList.clear();
+   F32 collisionTime = 1;
+   S32 hitTarget = -1;
+   S32 hitEdge = -1;
 
+   for(S32 i = 0; i < targets.size(); i++)
+   {
+      if(targets[i] == shooter || !targets[i]->isCollisionEnabled() || !targetExtents[i].intersects(sweepRect))
+         continue;
 
-         // Don't collide with shooter during first 500ms of life
-         if(mShooter.isValid() && objAge < 500 && !mBounced)
+      if(targetEdgeCount[i] == 0)
+      {
+         F32 ct;
+         if(circleIntersectsSegment(targetCenters[i], targetRadii[i], start, end, ct) && ct < collisionTime)
          {
-            disabledList.push_back(mShooter);
-            mShooter->disableCollision();
+            collisionTime = ct;
+            hitTarget = i;
+            hitEdge = -1;
          }
 
-         BfObject *hitObject;
+         continue;
+      }
+
+      S32 lastEdge = targetFirstEdge[i] + targetEdgeCount[i];
 
-         F32 collisionTime;
-         Point surfNormal;
+      for(S32 j = targetFirstEdge[i]; j < lastEdge; j++)
+      {
+         F32 denom = dp.y * edgeDX[j] - dp.x * edgeDY[j];
+         if(denom == 0)    // Parallel
+            continue;
 
-         // Do the search
-         while(true)  
+         F32 s = ( (start.x - edgeX[j]) * edgeDY[j] + (edgeY[j] - start.y) * edgeDX[j] ) / denom;
+         F32 t = ( (start.x - edgeX[j]) * dp.y      + (edgeY[j] - start.y) * dp.x      ) / denom;
+
+         if(s >= 0 && s <= 1 && t >= 0 && t <= 1 && s < collisionTime)
          {
-            hitObject = findObjectLOS((TestFunc)isWeaponCollideableType, RenderState, startPos, endPos, collisionTime, surfNormal);
+            collisionTime = s;
+            hitTarget = i;
+            hitEdge = j;
+         }
+      }
+   }
 
-            if((!hitObject || hitObject->collide(this)))
-               break;
+   hit.object = NULL;
+
+   if(hitTarget == -1)
+      return;
+
+   hit.object = targets[hitTarget];
+   hit.time = collisionTime;
+
+   if(hitEdge != -1)
+      hit.normal.set(edgeDY[hitEdge], -edgeDX[hitEdge]);
+   else
+      hit.normal = (start + (end - start) * collisionTime) - targetCenters[hitTarget];
+
+   hit.normal.normalize();
+}
+
+
+// Moves every live projectile, before objects are idled, so that idle() doesn't have to.  Projectiles are grouped by
+// where they are into cells the size of a database bucket, and each cell's worth shares one database search and one
+// copy of the geometry nearby; in a big fight that's far less work than every projectile searching for itself.  All
+// projectiles travel the same way, whatever their weapon, so they're grouped by place rather than type.
+void Projectile::moveAll(const Vector<DatabaseObject *> *projectiles, U32 deltaT)
+{
+   if(projectiles->size() == 0 || deltaT == 0)
+      return;
+
+   const GridDatabase *database = projectiles->get(0)->getDatabase();
+
+   sweepProjectiles.clear();
+   sweepStartX.clear();
+   sweepStartY.clear();
+   sweepEndX.clear();
+   sweepEndY.clear();
+   sweepNext.clear();
+
+   // Hash table of cells, each with a list of the paths that start in it
+   U32 tableSize = 16;
+   while(tableSize < U32(projectiles->size()) * 2)
+      tableSize *= 2;
+
+   cellKeys.resize(tableSize);
+   cellFirstSweep.resize(tableSize);
+
+   for(U32 i = 0; i < tableSize; i++)
+      cellFirstSweep[i] = -1;
+
+   for(S32 i = 0; i < projectiles->size(); i++)
+   {
+      Projectile *projectile = static_cast<Projectile *>(projectiles->get(i));
+
+      if(!projectile->mAlive || projectile->isDeleted())
+         continue;
+
+      // Same as the first leg in move()
+      Point startPos = projectile->getPos();
+      Point endPos = startPos + (projectile->mVelocity * .001f) * (F32)deltaT;
 
-            // Disable collisions with things that don't want to be
-            // collided with (i.e. whose collide methods return false)
-            disabledList.push_back(hitObject);
-            hitObject->disableCollision();
+      U32 cellX = U32(S32(floor(getMin(startPos.x, endPos.x))) >> GridDatabase::BucketWidthBitShift) & 0xFFFF;
+      U32 cellY = U32(S32(floor(getMin(startPos.y, endPos.y))) >> GridDatabase::BucketWidthBitShift) & 0xFFFF;
+      U32 key = cellY << 16 | cellX;
+
+      U32 slot = (key * 2654435761u) & (tableSize - 1);
+      while(cellFirstSweep[slot] != -1 && cellKeys[slot] != key)
+         slot = (slot + 1) & (tableSize - 1);
+
+      cellKeys[slot] = key;
+      sweepNext.push_back(cellFirstSweep[slot]);
+      cellFirstSweep[slot] = sweepProjectiles.size();
+
+      sweepProjectiles.push_back(projectile);
+      sweepStartX.push_back(startPos.x);
+      sweepStartY.push_back(startPos.y);
+      sweepEndX.push_back(endPos.x);
+      sweepEndY.push_back(endPos.y);
+   }
+
+   for(U32 slot = 0; slot < tableSize; slot++)
+   {
+      S32 first = cellFirstSweep[slot];
+
+      if(first == -1)
+         continue;
+
+      // Alone in its cell; nothing to share, so no point in gathering anything
+      if(sweepNext[first] == -1)
+      {
+         Projectile *projectile = sweepProjectiles[first];
+
+         if(projectile && !projectile->isDeleted())
+         {
+            projectile->mMovedThisTick = true;
+            projectile->move(deltaT, NULL);
          }
 
-         // Re-enable collison flag for ship and items in our path that don't want to be collided with
-         // Note that if we hit an object that does want to be collided with, it won't be in disabledList
-         // and thus collisions will not have been disabled, and thus don't need to be re-enabled.
-         // Our collision detection is done, and hitObject contains the first thing that the projectile hit.
-         for(S32 i = 0; i < disabledList.size(); i++)
-            disabledList[i]->enableCollision();
-
-         // This logic lets the Railgun go through ships. It assumes that the
-         // object search will return the same order of objects during this time frame
-         //
-         // If we already hit this object, don't do it again
-         if(hitObject == mLastHitObject)
-            hitObject = NULL;
-         // Otherwise save the one we found for next iteration
-         else
-            mLastHitObject = hitObject;
+         continue;
+      }
 
+      Rect cellRect(Point(sweepStartX[first], sweepStartY[first]), Point(sweepEndX[first], sweepEndY[first]));
+
+      for(S32 sweep = sweepNext[first]; sweep != -1; sweep = sweepNext[sweep])
+         cellRect.unionRect(Rect(Point(sweepStartX[sweep], sweepStartY[sweep]), Point(sweepEndX[sweep], sweepEndY[sweep])));
+
+      bool gathered = false;
+
+      for(S32 sweep = first; sweep != -1; sweep = sweepNext[sweep])
+      {
+         Projectile *projectile = sweepProjectiles[sweep];
 
-         if(hitObject)  // Hit something...  should we bounce?
+         if(!projectile || projectile->isDeleted())     // Hitting something can run scripts, and they can do anything
+            continue;
+
+         if(!gathered)
          {
-            bool bounce = false;
-            bool hitAShip = isShipType(hitObject->getObjectTypeNumber());
+            gatherTargets(database, cellRect);
+            gathered = true;
+         }
 
-            // Bounce off a wall and off a ship that has its shields up
-            if(mStyle == ProjectileStyleBouncer && isWallType(hitObject->getObjectTypeNumber()))
-               bounce = true;
-            else if(hitAShip)
-            {
-               Ship *ship = static_cast<Ship *>(hitObject);
-               if(ship->isModulePrimaryActive(ModuleShield))
-                  bounce = true;
-            }
+         Hit hit;
+         findBatchHit(sweep, projectile, hit);
 
-            if(bounce)
-            {
-               mBounced = true;
+         projectile->mMovedThisTick = true;
 
-               static const U32 MAX_LIVETIME_INCREASES = 6;
-               static const U32 LIVETIME_INCREASE = 250;
+         // Hitting something can change what's nearby -- ships die, flags get dropped -- so look again before the
+         // next projectile goes
+         if(projectile->move(deltaT, &hit))
+            gathered = false;
+      }
+   }
+}
 
-               // Let's extend the projectile life time on each bounce, up to twice the normal
-               // live-time
-               if(mLiveTimeIncreases < MAX_LIVETIME_INCREASES &&
-                     (S32)mTimeRemaining < WeaponInfo::getWeaponInfo(mWeaponType).projLiveTime)
-               {
-                  mTimeRemaining += LIVETIME_INCREASE;
-                  mLiveTimeIncreases++;
-               }
 
-               // We hit something that we should bounce from, so bounce!
-               F32 float1 = surfNormal.dot(mVelocity) * 2;
-               mVelocity -= surfNormal * float1;
+// Finds the first thing between startPos and endPos that's willing to be hit.  found, if we have it, is the closest
+// thing there, willing or not, from a search that's already been done.
+BfObject *Projectile::findFirstHit(const Point &startPos, const Point &endPos, const Hit *found,
+                                   F32 &collisionTime, Point &surfNormal)
+{
+   if(found && (!found->object || found->object->collide(this)))
+   {
+      collisionTime = found->time;
+      surfNormal = found->normal;
+      return found->object;
+   }
 
-               if(float1 > 0)
-                  surfNormal = -surfNormal;      // This is to fix going through polygon barriers
+   static thread_local Vector<BfObject *> disabledList;
 
-               startPos = getPos();
-               collisionPoint = startPos + (endPos - startPos) * collisionTime;
+   disabledList.clear();
 
-               setPos(collisionPoint + surfNormal);
-               timeLeft = timeLeft * (1 - collisionTime);
+   // What we found didn't want to be hit; no need to ask it again
+   if(found)
+   {
+      disabledList.push_back(found->object);
+      found->object->disableCollision();
+   }
 
-               if(hitObject->isMoveObject())
-               {
-                  MoveObject *obj = static_cast<MoveObject *>(hitObject);  
+   U32 objAge = getGame()->getCurrentTime() - getCreationTime();  // Age of object, in ms
 
-                  startPos = getPos();
+   // Don't collide with shooter during first 500ms of life
+   if(mShooter.isValid() && objAge < 500 && !mBounced)
+   {
+      disabledList.push_back(mShooter);
+      mShooter->disableCollision();
+   }
 
-                  float1 = startPos.distanceTo(obj->getRenderPos());
-                  if(float1 < obj->getRadius())
-                  {
-                     float1 = obj->getRadius() * 1.01f / float1;
-                     setVert(startPos * float1 + obj->getRenderPos() * (1 - float1), 0);  // Fix bouncy stuck inside shielded ship
-                  }
-               }
+   BfObject *hitObject;
+
+   // Do the search
+   while(true)  
+   {
+      hitObject = findObjectLOS((TestFunc)isProjectileTargetType, RenderState, startPos, endPos, collisionTime, surfNormal);
+
+      if((!hitObject || hitObject->collide(this)))
+         break;
+
+      // Disable collisions with things that don't want to be
+      // collided with (i.e. whose collide methods return false)
+      disabledList.push_back(hitObject);
+      hitObject->disableCollision();
+   }
+
+   // Re-enable collison flag for ship and items in our path that don't want to be collided with
+   // Note that if we hit an object that does want to be collided with, it won't be in disabledList
+   // and thus collisions will not have been disabled, and thus don't need to be re-enabled.
+   // Our collision detection is done, and hitObject contains the first thing that the projectile hit.
+   for(S32 i = 0; i < disabledList.size(); i++)
+      disabledList[i]->enableCollision();
 
-               // Bouncing off anything can easily get desync'd
-               setMaskBits(PositionMask);
+   return hitObject;
+}
 
-               if(isGhost())
-                  getGame()->playSoundEffect(SFXBounceShield, collisionPoint, surfNormal * surfNormal.dot(mVelocity) * 2);
+
+// Moves us along for deltaT ms, bouncing off or hitting whatever is in the way.  firstHit, if we have it, is what's
+// along the first leg of the trip; moveAll() will have already looked.
+bool Projectile::move(U32 deltaT, const Hit *firstHit)
+{
+   F32 timeLeft = (F32)deltaT;
+   S32 loopcount = 32;
+   bool hitSomething = false;
+
+   Point startPos, collisionPoint;
+
+   while(timeLeft > 0.01f && loopcount != 0)    // This loop is to prevent slow bounce on low frame rate / high time left
+   {
+      loopcount--;
+
+      startPos = getPos();
+
+      // Calculate where projectile will be at the end of the current interval
+      Point endPos = startPos + (mVelocity * .001f) * timeLeft;    // mVelocity in units/sec, timeLeft in ms
+
+      F32 collisionTime;
+      Point surfNormal;
+
+      // Check for collision along projected route of movement; after a bounce, we're on our own
+      BfObject *hitObject = findFirstHit(startPos, endPos, loopcount == 31 ? firstHit : NULL, collisionTime, surfNormal);
+
+      // This logic lets the Railgun go through ships. It assumes that the
+      // object search will return the same order of objects during this time frame
+      //
+      // If we already hit this object, don't do it again
+      if(hitObject == mLastHitObject)
+         hitObject = NULL;
+      // Otherwise save the one we found for next iteration
+      else
+         mLastHitObject = hitObject;
+
+
+      if(hitObject)  // Hit something...  should we bounce?
+      {
+         bool bounce = false;
+         bool hitAShip = isShipType(hitObject->getObjectTypeNumber());
+
+         // Bounce off a wall and off a ship that has its shields up
+         if(mStyle == ProjectileStyleBouncer && isWallType(hitObject->getObjectTypeNumber()))
+            bounce = true;
+         else if(hitAShip)
+         {
+            Ship *ship = static_cast<Ship *>(hitObject);
+            if(ship->isModulePrimaryActive(ModuleShield))
+               bounce = true;
+         }
+
+         if(bounce)
+         {
+            mBounced = true;
+
+            static const U32 MAX_LIVETIME_INCREASES = 6;
+            static const U32 LIVETIME_INCREASE = 250;
+
+            // Let's extend the projectile life time on each bounce, up to twice the normal
+            // live-time
+            if(mLiveTimeIncreases < MAX_LIVETIME_INCREASES &&
+                  (S32)mTimeRemaining < WeaponInfo::getWeaponInfo(mWeaponType).projLiveTime)
+            {
+               mTimeRemaining += LIVETIME_INCREASE;
+               mLiveTimeIncreases++;
             }
-            else  // Not bouncing
+
+            // We hit something that we should bounce from, so bounce!
+            F32 float1 = surfNormal.dot(mVelocity) * 2;
+            mVelocity -= surfNormal * float1;
+
+            if(float1 > 0)
+               surfNormal = -surfNormal;      // This is to fix going through polygon barriers
+
+            startPos = getPos();
+            collisionPoint = startPos + (endPos - startPos) * collisionTime;
+
+            setPos(collisionPoint + surfNormal);
+            timeLeft = timeLeft * (1 - collisionTime);
+
+            if(hitObject->isMoveObject())
             {
-               // Since we didn't bounce, advance to location of collision
-               startPos = getPos();
-               collisionPoint = startPos + (endPos - startPos) * collisionTime;
-               handleCollision(hitObject, collisionPoint);     // What we hit, where we hit it
+               MoveObject *obj = static_cast<MoveObject *>(hitObject);  
 
-               // Advance the railgun through ships
-               if((mWeaponType == WeaponRailgun) && hitAShip)
-                  setPos(endPos);
+               startPos = getPos();
 
-               timeLeft = 0;
+               float1 = startPos.distanceTo(obj->getRenderPos());
+               if(float1 < obj->getRadius())
+               {
+                  float1 = obj->getRadius() * 1.01f / float1;
+                  setVert(startPos * float1 + obj->getRenderPos() * (1 - float1), 0);  // Fix bouncy stuck inside shielded ship
+               }
             }
+
+            // Bouncing off anything can easily get desync'd
+            setMaskBits(PositionMask);
+
+            if(isGhost())
+               getGame()->playSoundEffect(SFXBounceShield, collisionPoint, surfNormal * surfNormal.dot(mVelocity) * 2);
          }
-         else        // Hit nothing, advance projectile to endPos
+         else  // Not bouncing
          {
-            timeLeft = 0;
+            // Since we didn't bounce, advance to location of collision
+            startPos = getPos();
+            collisionPoint = startPos + (endPos - startPos) * collisionTime;
+            handleCollision(hitObject, collisionPoint);     // What we hit, where we hit it
+            hitSomething = true;
 
-            setPos(endPos);
+            // Advance the railgun through ships
+            if((mWeaponType == WeaponRailgun) && hitAShip)
+               setPos(endPos);
+
+            timeLeft = 0;
          }
       }
+      else        // Hit nothing, advance projectile to endPos
+      {
+         timeLeft = 0;
+
+         setPos(endPos);
+      }
    }
 
+   return hitSomething;
+}
+
+
+void Projectile::idle(BfObject::IdleCallPath path)
+{
+   U32 deltaT = mCurrentMove.time;
+
+   if(mAlive && !mMovedThisTick)
+      move(deltaT, NULL);
+
+   mMovedThisTick = false;
+
 
 #ifndef ZAP_DEDICATED
    // Draw trail for Railgun
@@ -1657,7 +1971,7 @@ void Seeker::acquireTarget()
    F32 ourAngle = getActualAngle();
 
    // Used for wall detection
-   static Vector<DatabaseObject *> localFillVector;
+   static thread_local Vector<DatabaseObject *> localFillVector;
 
    Rect queryRect(getPos(), TargetAcquisitionRadius);
    fillVector.clear();
@@ -33,9 +33,23 @@ private:
 
    SafePtr<BfObject> mShooter;
    BfObject *mLastHitObject;    // Last object hit by the projectile
+   bool mMovedThisTick;         // Already moved by moveAll(), so idle() shouldn't move us again
+
+   // The first thing in a projectile's path, and how far along the path it is
+   struct Hit
+   {
+      BfObject *object;         // NULL if the path is clear
+      F32 time;
+      Point normal;
+   };
 
    void initialize(WeaponType type, const Point &pos, const Point &vel, BfObject *shooter);
 
+   BfObject *findFirstHit(const Point &startPos, const Point &endPos, const Hit *found, F32 &collisionTime, Point &surfNormal);
+   bool move(U32 deltaT, const Hit *firstHit);      // Returns true if we hit something that doesn't bounce us
+
+   static void findBatchHit(S32 sweep, Projectile *projectile, Hit &hit);
+
 protected:
    enum MaskBits {
       InitialMask   = Parent::FirstFreeMask << 0,
@@ -77,6 +91,8 @@ public:
    void damageObject(DamageInfo *info);
    void explode(BfObject *hitObject, Point p);
 
+   static void moveAll(const Vector<DatabaseObject *> *projectiles, U32 deltaT);   // Call before idling objects
+
    virtual Point getRenderVel() const;
    virtual Point getActualVel() const;
 
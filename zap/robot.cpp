@@ -130,9 +130,11 @@ Robot::Robot(lua_State *L) : Ship(NULL, TEAM_NEUTRAL, Point(0,0), true),
 
    mHasSpawned = false;
    mObjectTypeNumber = RobotShipTypeNumber;
+   mQueuedWeaponIndex = -1;
 
    mCurrentZone = U16_MAX;
    flightPlanTo = U16_MAX;
+   flightPlanEndZone = U16_MAX;
 
    mPlayerInfo = new RobotPlayerInfo(this);
 
@@ -213,7 +215,7 @@ bool Robot::initialize(Point &pos)
    catch(LuaException &e)
    {
       logError("Robot error during spawn: %s.  Shutting robot down.", e.what());
-      clearStack(L);
+      clearStack(getLuaState());
       return false;
    }
 
@@ -248,9 +250,15 @@ bool Robot::start()
 
 bool Robot::prepareEnvironment()
 {
+   // With worker threads to spare, bots get an interpreter each, so their onTick can run at the same time as others'
+   if(getScriptThreadCount() > 0 && !isIsolated() && !createIsolatedState())
+      return false;
+
    if(!LuaScriptRunner::prepareEnvironment())
       return false;
 
+   lua_State *L = getLuaState();
+
    // Set this first so we have this object available in the helper functions in case we need overrides
    setSelf(L, this, "bot");
 
@@ -266,7 +274,7 @@ static string getNextName()
       "Lillian", "Lucy", "Madison", "Natalie", "Olivia", "Riley", "Samantha", "Zoe"
    };
 
-   static U8 nameIndex = 0;
+   static TNL_THREAD_LOCAL U8 nameIndex = 0;
    return botNames[(nameIndex++) % ARRAYSIZE(botNames)];
 }
 
@@ -274,6 +282,8 @@ static string getNextName()
 // Run bot's getName function, return default name if fn isn't defined
 string Robot::runGetName()
 {
+   lua_State *L = getLuaState();
+
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
    // error will only be true if: 1) getName doesn't exist, which should never happen -- getName is stubbed out in robot_helper_functions.lua
@@ -371,6 +381,76 @@ void Robot::killScript()
 }
 
 
+// Our script is about to run in parallel; it starts with the move we already have
+void Robot::queueActions()
+{
+   mQueuedMove = getCurrentMove();
+   mQueuedWeaponIndex = -1;
+   mQueuedMessages.clear();
+}
+
+
+// Back on the main thread: do what our script asked for while it was running in parallel
+void Robot::applyQueuedActions()
+{
+   setCurrentMove(mQueuedMove);
+
+   if(mQueuedWeaponIndex != -1)
+      selectWeapon(mQueuedWeaponIndex);
+
+   for(S32 i = 0; i < mQueuedMessages.size(); i++)
+      sendMessage(mQueuedMessages[i].type, mQueuedMessages[i].message.c_str(), mQueuedMessages[i].playerName.c_str());
+
+   mQueuedMessages.clear();
+}
+
+
+Move Robot::getScriptMove()
+{
+   return luaW_isRunningInParallel() ? mQueuedMove : getCurrentMove();
+}
+
+
+void Robot::setScriptMove(const Move &move)
+{
+   if(luaW_isRunningInParallel())
+      mQueuedMove = move;
+   else
+      setCurrentMove(move);
+}
+
+
+void Robot::sendMessage(QueuedMessage::Type type, const char *message, const char *playerName)
+{
+   if(luaW_isRunningInParallel())
+   {
+      QueuedMessage queued;
+      queued.type = type;
+      queued.message = message;
+      queued.playerName = playerName;
+
+      mQueuedMessages.push_back(queued);
+      return;
+   }
+
+   if(type == QueuedMessage::PrivateMsg)
+   {
+      mGame->sendPrivateChat(mClientInfo->getName(), playerName, message);
+      return;     // No event fired for private message
+   }
+
+   GameType *gt = getGame()->getGameType();
+   if(gt)
+   {
+      bool global = type == QueuedMessage::GlobalMsg;
+      gt->sendChat(mClientInfo->getName(), mClientInfo, message, global, mClientInfo->getTeamIndex());
+
+      // Fire our event handler
+      EventManager::get()->fireEvent(this, EventManager::MsgReceivedEvent, message, getPlayerInfo(), global);
+   }
+}
+
+
 // Robot just died
 void Robot::kill()
 {
@@ -522,12 +602,12 @@ bool Robot::canSeePoint(Point point, bool wallOnly)
 
    Rect queryRect(thisPoints);
 
-   fillVector.clear();
-   mGame->getGameObjDatabase()->findObjects(wallOnly ? (TestFunc)isWallType : (TestFunc)isCollideableType, fillVector, queryRect);
+   DatabaseQuery query;
+   mGame->getGameObjDatabase()->findObjects(wallOnly ? (TestFunc)isWallType : (TestFunc)isCollideableType, query, queryRect);
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < query.size(); i++)
    {
-      const Vector<Point> *otherPoints = fillVector[i]->getCollisionPoly();
+      const Vector<Point> *otherPoints = query[i]->getCollisionPoly();
       if(otherPoints && polygonsIntersect(thisPoints, *otherPoints))
          return false;
    }
@@ -615,6 +695,23 @@ Robot *Robot::clone() const
 }
 
 
+// Appends the route from startZone towards targetZone to our flightplan, returning false if there isn't one
+bool Robot::addRouteToFlightPlan(U16 startZone, U16 targetZone)
+{
+   // Routes between zones are shared by all bots, so most of the time someone has already done the work
+   const ZoneRoute &route = static_cast<ServerGame *>(getGame())->findZoneRoute(startZone, targetZone);
+
+   if(route.points.size() == 0)
+      return false;
+
+   for(S32 i = 0; i < route.points.size(); i++)
+      flightPlan.push_back(route.points[i]);
+
+   flightPlanEndZone = route.endZone;
+   return true;
+}
+
+
 // Another helper function: returns id of closest zone to a given point
 U16 Robot::findClosestZone(const Point &point)
 {
@@ -728,7 +825,7 @@ S32 Robot::lua_setAngle(lua_State *L)
 {
    S32 profile = checkArgList(L, functionArgs, "Robot", "setAngle");
 
-   Move move = getCurrentMove();
+   Move move = getScriptMove();
 
    if(profile == 0)        // Args: PT    ==> Aim towards point
    {
@@ -739,7 +836,7 @@ S32 Robot::lua_setAngle(lua_State *L)
    else if(profile == 1)   // Args: NUM   ==> Aim at this angle (radians)
       move.angle = getFloat(L, 1);
 
-   setCurrentMove(move);
+   setScriptMove(move);
    return 0;
 }
 
@@ -865,6 +962,12 @@ S32 Robot::lua_getWaypoint(lua_State *L)
       // If we found one, that means we found a visible waypoint, and we can head there...
       if(found)
       {
+         // On big levels our route may stop short of the target.  If we can see where it stops, plan the next
+         // part from there; that part starts at dest, so we're still headed the same way.
+         if(flightPlan.size() == 1 && flightPlanEndZone != flightPlanTo &&
+               addRouteToFlightPlan(flightPlanEndZone, targetZone))
+            return returnPoint(L, dest);
+
          flightPlan.push_back(dest);    // Put dest back at the end of the flightplan
          return returnPoint(L, dest);
       }
@@ -886,6 +989,7 @@ S32 Robot::lua_getWaypoint(lua_State *L)
    {
       Point p;
       flightPlan.push_back(target);
+      flightPlanEndZone = flightPlanTo;      // Nothing left to plan
 
       if(!canSeePoint(target, true))           // Possible, if we're just on a boundary, and a protrusion's blocking a ship edge
       {
@@ -904,21 +1008,10 @@ S32 Robot::lua_getWaypoint(lua_State *L)
    // or the path we had no longer applied to our current location
    flightPlanTo = targetZone;
 
-   // check cache for path first
-   pair<S32,S32> pathIndex = pair<S32,S32>(currentZone, targetZone);
+   flightPlan.push_back(target);       // The route stops at the center of the target's zone; we need to go all the way
 
-   const Vector<BotNavMeshZone *> *zones = static_cast<ServerGame *>(getGame())->getBotZones();  // Our pre-cached list of nav zones
-
-   if(getGame()->getGameType()->cachedBotFlightPlans.find(pathIndex) == getGame()->getGameType()->cachedBotFlightPlans.end())
-   {
-      // Not found so calculate flight plan
-      flightPlan = AStar::findPath(zones, currentZone, targetZone, target);
-
-      // Add to cache
-      getGame()->getGameType()->cachedBotFlightPlans[pathIndex] = flightPlan;
-   }
-   else
-      flightPlan = getGame()->getGameType()->cachedBotFlightPlans[pathIndex];
+   if(!addRouteToFlightPlan(currentZone, targetZone))
+      flightPlan.clear();
 
    if(flightPlan.size() > 0)
       return returnPoint(L, flightPlan.last());
@@ -966,21 +1059,21 @@ S32 Robot::lua_findClosestEnemy(lua_State *L)
    F32 minDist = F32_MAX;
    Ship *closest = NULL;
 
-   fillVector.clear();
+   DatabaseQuery query;
 
    if(useRange)
-      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, fillVector, queryRect);   
+      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, query, queryRect);   
    else
-      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, fillVector);   
+      getGame()->getGameObjDatabase()->findObjects((TestFunc)isShipType, query);   
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < query.size(); i++)
    {
       // Ignore self 
-      if(fillVector[i] == this) 
+      if(query[i] == this) 
          continue;
 
       // Ignore ship/robot if it's dead or cloaked
-      Ship *ship = static_cast<Ship *>(fillVector[i]);
+      Ship *ship = static_cast<Ship *>(query[i]);
       if(ship->mHasExploded || !ship->isVisible(hasModule(ModuleSensor)))
          continue;
 
@@ -1034,12 +1127,12 @@ S32 Robot::lua_setThrust(lua_State *L)
       ang = getAnglePt(point) - 0 * FloatHalfPi;
    }
 
-   Move move = getCurrentMove();
+   Move move = getScriptMove();
 
    move.x = vel * cos(ang);
    move.y = vel * sin(ang);
 
-   setCurrentMove(move);
+   setScriptMove(move);
 
    return 0;
 }
@@ -1065,7 +1158,7 @@ S32 Robot::lua_setThrustToPt(lua_State *L)
 
    F32 ang = getAnglePt(point) - 0 * FloatHalfPi;
 
-   Move move = getCurrentMove();
+   Move move = getScriptMove();
 
    F32 dist = getActualPos().distanceTo(point);
 
@@ -1077,7 +1170,7 @@ S32 Robot::lua_setThrustToPt(lua_State *L)
    move.x = vel * cos(ang);
    move.y = vel * sin(ang);
 
-   setCurrentMove(move);
+   setScriptMove(move);
 
   return 0;
 }
@@ -1102,16 +1195,20 @@ S32 Robot::lua_fireWeapon(lua_State *L)
       if(mLoadout.getWeapon(i) == weapon)
       {
          hasWeapon = true;
-         selectWeapon(i);
+
+         if(luaW_isRunningInParallel())
+            mQueuedWeaponIndex = i;
+         else
+            selectWeapon(i);
          break;
       }
 
    // If weapon was equipped, fire!
    if(hasWeapon)
    {
-      Move move = getCurrentMove();
+      Move move = getScriptMove();
       move.fire = true;
-      setCurrentMove(move);
+      setScriptMove(move);
    }
    else
       THROW_LUA_EXCEPTION(L, "The weapon given to bot:fireWeapon(weapon) is not equipped!");
@@ -1162,7 +1259,10 @@ S32 Robot::lua_fireModule(lua_State *L)
       if(getModule(i) == module)
       {
          hasModule = true;
-         mCurrentMove.modulePrimary[i] = true;
+
+         Move move = getScriptMove();
+         move.modulePrimary[i] = true;
+         setScriptMove(move);
          break;
       }
 
@@ -1264,19 +1364,10 @@ S32 Robot::lua_globalMsg(lua_State *L)
 {
    checkArgList(L, functionArgs, luaClassName, "globalMsg");
 
-   const char *message = getString(L, 1);
-
-   GameType *gt = getGame()->getGameType();
-   if(gt)
-   {
-      gt->sendChat(mClientInfo->getName(), mClientInfo, message, true, mClientInfo->getTeamIndex());
+   string message = getString(L, 1);
+   lua_pop(L, 1);    // Clean up before firing event
 
-      // Clean up before firing event
-      lua_pop(L, 1);
-
-      // Fire our event handler
-      EventManager::get()->fireEvent(this, EventManager::MsgReceivedEvent, message, getPlayerInfo(), true);
-   }
+   sendMessage(QueuedMessage::GlobalMsg, message.c_str(), "");
 
    return 0;
 }
@@ -1294,19 +1385,10 @@ S32 Robot::lua_teamMsg(lua_State *L)
 {
    checkArgList(L, functionArgs, luaClassName, "teamMsg");
 
-   const char *message = getString(L, 1);
-
-   GameType *gt = getGame()->getGameType();
-   if(gt)
-   {
-      gt->sendChat(mClientInfo->getName(), mClientInfo, message, false, mClientInfo->getTeamIndex());
-
-      // Clean up before firing event
-      lua_pop(L, 1);
+   string message = getString(L, 1);
+   lua_pop(L, 1);    // Clean up before firing event
 
-      // Fire our event handler
-      EventManager::get()->fireEvent(this, EventManager::MsgReceivedEvent, message, getPlayerInfo(), false);
-   }
+   sendMessage(QueuedMessage::TeamMsg, message.c_str(), "");
 
    return 0;
 }
@@ -1332,9 +1414,7 @@ S32 Robot::lua_privateMsg(lua_State *L)
    const char *message = getString(L, 1);
    const char *playerName = getString(L, 2);
 
-   mGame->sendPrivateChat(mClientInfo->getName(), playerName, message);
-
-   // No event fired for private message
+   sendMessage(QueuedMessage::PrivateMsg, message, playerName);
 
    return 0;
 }
@@ -1350,6 +1430,11 @@ S32 Robot::lua_privateMsg(lua_State *L)
  * 
  * Can specify multiple types.
  * 
+ * A bot that looks around every tick can pass in a table of its own to be
+ * filled with the results, rather than have a new one made each time.  Whatever
+ * was in it before is replaced.
+ * 
+ * @param results (optional) A table to put the found objects in.
  * @param types One or more \ref ObjTypeEnum specifying what types of objects to
  * find.
  * 
@@ -1361,6 +1446,12 @@ S32 Robot::lua_privateMsg(lua_State *L)
  *     items = bot:findVisibleObjects(objType, ...)
  *     print(#items) -- Print the number of items found
  *   end
+ *
+ *   local ships = {}     -- Reused from tick to tick
+ *
+ *   function onTick()
+ *     bot:findVisibleObjects(ships, ObjType.Ship, ObjType.Robot)
+ *   end
  * @endcode
  */
 S32 Robot::lua_findVisibleObjects(lua_State *L)
@@ -1371,32 +1462,33 @@ S32 Robot::lua_findVisibleObjects(lua_State *L)
    Rect queryRect(pos, pos);
    queryRect.expand(getGame()->computePlayerVisArea(this));
 
-   fillVector.clear();
-   static Vector<U8> types;
+   DatabaseQuery &query = mLuaQuery;
+   Vector<U8> &types = mLuaQueryTypes;
 
+   query.clear();
    types.clear();
 
    // We expect the stack to look like this: -- objType1, objType2, ...
-   // or this, if using the deprecated fill table option -- [fillTable], objType1, objType2, ...
+   // or this, if the script wants the results in a table of its own -- [results], objType1, objType2, ...
    // We'll work our way down from the top of the stack (element -1) until we find something that is not a number.
-   // We expect that when we find something that is not a number, the stack will only contain our fillTable.  If the stack
-   // is empty at that point, we'll add a table.
+   // We expect that when we find something that is not a number, the stack will only contain the results table.  If
+   // the stack is empty at that point, we'll add a table.
    while(lua_gettop(L) > 0 && lua_isnumber(L, -1))
    {
       U8 typenum = (U8)lua_tointeger(L, -1);
 
       // Requests for botzones have to be handled separately; not a problem, we'll just do the search here, and add them to
-      // fillVector, where they'll be merged with the rest of our search results.
+      // query, where they'll be merged with the rest of our search results.
       if(typenum != BotNavMeshZoneTypeNumber)
          types.push_back(typenum);
       else
-         getGame()->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, fillVector, queryRect);
+         getGame()->getBotZoneDatabase()->findObjects(BotNavMeshZoneTypeNumber, query, queryRect);
 
       lua_pop(L, 1);
    }
 
    // Get other objects on screen-visible area only
-   getGame()->getGameObjDatabase()->findObjects(types, fillVector, queryRect);
+   getGame()->getGameObjDatabase()->findObjects(types, query, queryRect);
 
 
    // We are expecting a table to be on top of the stack when we get here.  If not, we can add one.
@@ -1404,38 +1496,36 @@ S32 Robot::lua_findVisibleObjects(lua_State *L)
    {
       TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
 
-      // Create a table, cannot pre-allocate because of filtering objects from
-      // the database
-      lua_newtable(L);
+      // Some of what we found may get filtered out, but allocating a few slots too many beats growing the table
+      lua_createtable(L, query.size(), 0);
    }
-   else
-      logprintf(LogConsumer::LuaScriptMessage, "Usage of a fill table with findVisibleObjects() "
-            "is deprecated and will be removed in the future.  Instead, don't use one");
 
    TNLAssert((lua_gettop(L) == 1 && lua_istable(L, -1)) || dumpStack(L), "Should only have table!");
 
 
    S32 pushed = 0;      // Count of items we put into our table
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < query.size(); i++)
    {
-      if(isShipType(fillVector[i]->getObjectTypeNumber()))
+      if(isShipType(query[i]->getObjectTypeNumber()))
       {
-         if(fillVector[i] == this)  // Don't add this bot to the list of found objects!
+         if(query[i] == this)  // Don't add this bot to the list of found objects!
             continue;
 
          // Ignore ship/robot if it's dead or cloaked (unless bot has sensor)
-         Ship *ship = static_cast<Ship *>(fillVector[i]);
+         Ship *ship = static_cast<Ship *>(query[i]);
          bool callerHasSensor = this->hasModule(ModuleSensor);
          if(!ship->isVisible(callerHasSensor) || ship->mHasExploded)
             continue;
       }
 
-      static_cast<BfObject *>(fillVector[i])->push(L);
+      static_cast<BfObject *>(query[i])->push(L);
       pushed++;      // Increment pushed before using it because Lua uses 1-based arrays
       lua_rawseti(L, 1, pushed);
    }
 
+   luaTableTruncate(L, 1, pushed);     // Anything left over from the last time the table was used
+
    TNLAssert(lua_gettop(L) == 1 || dumpStack(L), "Stack has unexpected items on it!");
 
    return 1;
@@ -1488,17 +1578,21 @@ static bool calcInterceptCourse(BfObject *target, Point aimPos, F32 aimRadius, S
    if(objectInTheWay && objectInTheWay != target)
       return false;
 
-   // See if we're gonna clobber our own stuff...
-   target->disableCollision();
+   // See if we're gonna clobber our own stuff... only worth asking if we care.  Scripts may be running this in parallel
+   // (see LuaScriptRunner::runParallelCmds()), when changing the target's collision state isn't safe.
+   if(ignoreFriendly)
+   {
+      target->disableCollision();
 
-   Point delta2 = delta;
-   delta2.normalize(aimLife * aimVel / 1000);
+      Point delta2 = delta;
+      delta2.normalize(aimLife * aimVel / 1000);
 
-   BfObject *hitObject = target->findObjectLOS((TestFunc)isWithHealthType, 0, aimPos, aimPos + delta2, t, n);
-   target->enableCollision();
+      BfObject *hitObject = target->findObjectLOS((TestFunc)isWithHealthType, 0, aimPos, aimPos + delta2, t, n);
+      target->enableCollision();
 
-   if(ignoreFriendly && hitObject && hitObject->getTeam() == aimTeam)
-      return false;
+      if(hitObject && hitObject->getTeam() == aimTeam)
+         return false;
+   }
 
    interceptAngle = delta.ATAN2();
 
@@ -38,12 +38,33 @@ private:
 
    bool mHasSpawned;
 
+   // When our script runs in parallel with others, what it does to the ship is held back until they have all finished;
+   // see queueActions() and applyQueuedActions()
+   struct QueuedMessage
+   {
+      enum Type { GlobalMsg, TeamMsg, PrivateMsg } type;
+      string message;
+      string playerName;     // Private messages only
+   };
+
+   Move mQueuedMove;
+   S32 mQueuedWeaponIndex;                   // Weapon to select, or -1 to leave it be
+   Vector<QueuedMessage> mQueuedMessages;
+
+   Move getScriptMove();
+   void setScriptMove(const Move &move);
+   void sendMessage(QueuedMessage::Type type, const char *message, const char *playerName);
+
    Point getNextWaypoint();                          // Helper function for getWaypoint()
    U16 findClosestZone(const Point &point);          // Finds zone closest to point, used when robots get off the map
+   bool addRouteToFlightPlan(U16 startZone, U16 targetZone);   // Helper function for getWaypoint()
 
 protected:
    void killScript();
 
+   void queueActions();
+   void applyQueuedActions();
+
 public:
    explicit Robot(lua_State *L = NULL);      // Combined Lua / C++ default constructor
    virtual ~Robot();                // Destructor
@@ -65,6 +86,7 @@ public:
 
    Vector<Point> flightPlan;           // List of points to get from one point to another
    U16 flightPlanTo;                   // Zone our flightplan was calculated to
+   U16 flightPlanEndZone;              // Zone our flightplan actually reaches, if only part of the route is planned
 
    // Some informational functions
    F32 getAnglePt(Point point);
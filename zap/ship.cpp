@@ -303,7 +303,7 @@ F32 Ship::processMove(U32 stateIndex)
 
    F32 time = mCurrentMove.time * 0.001f;
 
-   static Point requestVel, accel;     // Reusable containers
+   static thread_local Point requestVel, accel;     // Reusable containers
 
    // This is what the client requested -- basically requestVel.len() will range from 0 to 1; any higher will be clipped
    requestVel.set(mCurrentMove.x, mCurrentMove.y);
@@ -404,7 +404,7 @@ bool Ship::isOnObject(BfObject *object, U32 stateIndex)
 {
    Point center;
    float radius;
-   static Vector<Point> polyPoints;
+   static thread_local Vector<Point> polyPoints;
    polyPoints.clear();
    Rect rect;
 
@@ -592,7 +592,7 @@ void Ship::idle(IdleCallPath path)
          static const F32 ShipVarNormalizeMultiplier = 128;
          static const F32 ShipVarNormalizeFraction = 1.0 / ShipVarNormalizeMultiplier;
 
-         static Point p;
+         static thread_local Point p;
          
 
          // This rounds the position and velocity to specific bit resolutions
@@ -712,7 +712,7 @@ bool Ship::checkForSpeedzones(U32 stateIndex)
 }
 
 
-static Vector<DatabaseObject *> foundObjects;      // Reusable container
+static thread_local Vector<DatabaseObject *> foundObjects;      // Reusable container
 
 void Ship::findRepairTargets()
 {
@@ -387,7 +387,7 @@ void SpeedZone::fillAttributesVectors(Vector<string> &keys, Vector<string> &valu
 #endif
 
 
-static bool ignoreThisCollision = false;
+static TNL_THREAD_LOCAL bool ignoreThisCollision = false;
 
 // Checks collisions with a SpeedZone
 bool SpeedZone::collide(BfObject *hitObject)
@@ -419,7 +419,7 @@ bool SpeedZone::collided(BfObject *hitObject, U32 stateIndex)
    TNLAssert(dynamic_cast<MoveObject *>(hitObject), "Not a MoveObject");
    MoveObject *ship = static_cast<MoveObject *>(hitObject);
 
-   static Point start, end, impulse, newVel;      // Reusable containers
+   static thread_local Point start, end, impulse, newVel;      // Reusable containers
    start = getVert(0);
    end   = getVert(1);
 
@@ -452,7 +452,7 @@ bool SpeedZone::collided(BfObject *hitObject, U32 stateIndex)
    // within the zone so that their path out will be very predictable.
    if(mSnapLocation)
    {
-      static Point diffpos, thisAngle, newPos, oldPos, oldVel, collisionPoint, p;    // Reusable points
+      static thread_local Point diffpos, thisAngle, newPos, oldPos, oldVel, collisionPoint, p;    // Reusable points
 
       diffpos = ship->getPos(stateIndex) - start;
       thisAngle = end - start;
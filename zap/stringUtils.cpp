@@ -479,6 +479,20 @@ bool fileExists(const string &path)
 }
 
 
+// Returns false if the file can't be found
+bool getFileStats(const string &path, S64 &modTime, S64 &size)
+{
+   struct stat st;
+
+   if(stat(path.c_str(), &st) != 0)
+      return false;
+
+   modTime = S64(st.st_mtime);
+   size = S64(st.st_size);
+   return true;
+}
+
+
 // Checks if specified folder exists; creates it if not
 bool makeSureFolderExists(const string &folder)
 {
@@ -704,7 +718,7 @@ S32 countCharInString(const string &source, char search)
 
 string makeFilenameFromString(const char *levelname, bool allowLastDot)
 {
-   static char filename[MAX_FILE_NAME_LEN + 1];    // Leave room for terminating null
+   static TNL_THREAD_LOCAL char filename[MAX_FILE_NAME_LEN + 1];    // Leave room for terminating null
 
    U32 i = 0;
    U32 lastDotIndex = 0;
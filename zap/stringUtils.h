@@ -88,6 +88,7 @@ bool caseInsensitiveStringCompare(const string &str1, const string &str2);
 // File utils
 string getFileSeparator();
 bool fileExists(const string &path);               // Does file exist?
+bool getFileStats(const string &path, S64 &modTime, S64 &size);   // Last modified (in seconds) and size of file
 bool makeSureFolderExists(const string &dir);      // Like the man said: Make sure folder exists
 bool getFilesFromFolder(const string &dir, Vector<string> &files, const string extensions[] = 0, S32 extensionCount = 0);
 bool safeFilename(const char *str);